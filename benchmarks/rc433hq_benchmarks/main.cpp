@@ -0,0 +1,962 @@
+// Host benchmarks of the edge processing stages. Drives synthetic (RC433HQTrafficGenerator) and recorded
+// edge streams through the individual stages and through the complete receiving chain and reports
+// edges/s, ns/edge and frames/s. The synthetic streams are also scored against their ground truth.
+//
+// Usage: rc433hq_benchmarks [--json] [--edges <file>] [--capture <file>] [--write-capture <file>] [--min-time <seconds>] [--threads <count>]
+//
+// The recorded edge file is a text file with one edge per line: "<time in us> <1 for rising, 0 for falling>".
+// The capture file is recorded by the RC433HQPulseRecorder and replayed memory-mapped. --write-capture stores
+// the noisy synthetic stream as the capture.
+//
+// The pipeline benchmarks decode the noisy stream in 1, 2, 4, ... channels of RC433HQPipeline (up to --threads,
+// by default the count of the CPUs), each with its own source thread, and report the scaling against one channel.
+// The offline benchmarks decode the capture (or a longer noisy synthetic stream recorded in memory) split at idle
+// gaps by RC433HQOfflineDecoder on 1, 2, 4, ... threads and check that the frames match the sequential decoding.
+// The batch benchmarks decode EMOS A and B by RC433HQBatchDecoder with every classification kernel supported by
+// the CPU, decoders_ab is their edge by edge reference. The journal benchmarks write 1M frames into the frame journal
+// in a temporary directory, scan it and search it for short time ranges.
+
+#include "../../rc433hq.h"
+#include "../../rc433hq_emos.h"
+#include "../../host/rc433hq_traffic.h"
+#include "../../host/rc433hq_capture.h"
+#include "../../host/rc433hq_pipeline.h"
+#include "../../host/rc433hq_offline.h"
+#include "../../host/rc433hq_classify.h"
+#include "../../host/rc433hq_journal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#if !defined(RC433HQ_VERSION)
+#   define RC433HQ_VERSION "unknown"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////
+// Edge streams
+//////////////////////////////////////////////////////////////////////////////////
+
+// protocol ids of the generated traffic
+static const int PROTOCOL_EMOS_A = 0;
+static const int PROTOCOL_EMOS_B = 1;
+
+// generate EMOS socket transmissions (4x encoding A followed by 4x encoding B), either clean or with realistic impairments
+static void GenerateEmosStream(RC433HQEdgeStream &stream, RC433HQTrafficFrames &groundTruth, size_t transmissions, bool withNoise)
+{
+    RC433HQEmosSocketsPulseEncoderA encoderA;
+    RC433HQEmosSocketsPulseEncoderB encoderB;
+
+    RC433HQTrafficProtocol protocolB = { &encoderB, PROTOCOL_EMOS_B, 24, 4, 0 };
+    RC433HQTrafficProtocol protocolA = { &encoderA, PROTOCOL_EMOS_A, 24, 4, &protocolB };
+
+    RC433HQTrafficImpairments impairments = RC433HQTrafficGenerator::NoImpairments();
+    if (withNoise) {
+        impairments.jitterSigmaUs = 15;
+        impairments.clockSkewPpmSigma = 2000;
+        impairments.noiseSpikesPerSecond = 20;
+        impairments.noiseSpikeMinUs = 5;
+        impairments.noiseSpikeMaxUs = 40;
+        impairments.agcBurstsPerSecond = 5;
+        impairments.agcBurstDurationUs = 20000;
+        impairments.agcPulseMinUs = 5;
+        impairments.agcPulseMaxUs = 800;
+        impairments.collisionProbability = 0.05;
+    }
+
+    // the seed is fixed, so that the stream is the same in each run
+    RC433HQTrafficGenerator generator(impairments, 12345);
+
+    RC433HQMicroseconds time = 1000;
+    for (size_t i = 0; i < transmissions; i++) {
+        byte data[3] = { byte(i), byte(i >> 8), 0xA5 };
+        time = generator.AddTransmission(time, protocolA, data) + RC433HQMicrosecondsDiff(60000);
+    }
+
+    generator.Generate(stream, groundTruth);
+}
+
+// load the recorded edges from the text file
+static bool LoadEdgeStream(RC433HQEdgeStream &stream, const char *fileName)
+{
+    FILE *file = fopen(fileName, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open the edges file %s.\n", fileName);
+        return false;
+    }
+
+    unsigned long time;
+    int direction;
+    while (fscanf(file, "%lu %d", &time, &direction) == 2) {
+        RC433HQEdge edge = { RC433HQMicroseconds(time), direction != 0 };
+        stream.push_back(edge);
+    }
+
+    fclose(file);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// Sinks
+//////////////////////////////////////////////////////////////////////////////////
+
+class CountingPulseProcessor: public IRC433PulseProcessor {
+public:
+    size_t edges;
+    size_t missedEdgesCalls;
+
+    CountingPulseProcessor():
+        edges(0),
+        missedEdgesCalls(0)
+    {
+    }
+
+    virtual void HandleEdge(RC433HQMicroseconds time, bool direction)
+    {
+        edges++;
+    }
+
+    virtual void HandleMissedEdges()
+    {
+        missedEdgesCalls++;
+    }
+};
+
+class CountingDataReceiver: public IRC433DataReceiver {
+public:
+    size_t frames;
+
+    CountingDataReceiver():
+        frames(0)
+    {
+    }
+
+    virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality)
+    {
+        frames++;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// Benchmarked stages
+//////////////////////////////////////////////////////////////////////////////////
+
+// interface of a single benchmark, processes the whole stream once per Run() call
+class Benchmark {
+public:
+    virtual ~Benchmark() {}
+    virtual const char *GetName() const = 0;
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset) = 0;
+    virtual size_t GetFramesCount() const { return 0; }
+};
+
+// how many edges are stored into the pulse buffer before the ProcessData() is called, emulates the loop latency
+static const size_t EDGES_PER_PROCESS_DATA = 64;
+
+class NoiseFilterBenchmark: public Benchmark {
+private:
+    CountingPulseProcessor sink;
+    RC433HQNoiseFilter filter;
+
+public:
+    NoiseFilterBenchmark(): filter(sink, 50) {}
+    virtual const char *GetName() const { return "noise_filter"; }
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset)
+    {
+        for (size_t i = 0; i < stream.size(); i++) {
+            filter.HandleEdge(stream[i].time + timeOffset, stream[i].direction);
+        }
+    }
+};
+
+class PulseBufferBenchmark: public Benchmark {
+private:
+    CountingPulseProcessor sink;
+    RC433HQPulseBuffer buffer;
+
+public:
+    PulseBufferBenchmark(): buffer(sink, 256) {}
+    virtual const char *GetName() const { return "pulse_buffer"; }
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset)
+    {
+        size_t reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount;
+        for (size_t i = 0; i < stream.size(); i++) {
+            buffer.HandleEdge(stream[i].time + timeOffset, stream[i].direction);
+            if ((i % EDGES_PER_PROCESS_DATA) == (EDGES_PER_PROCESS_DATA - 1)) {
+                buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+            }
+        }
+        buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+    }
+};
+
+class SplitterBenchmark: public Benchmark {
+private:
+    CountingPulseProcessor first, second;
+    RC433PulseSignalSplitter splitter;
+
+public:
+    SplitterBenchmark(): splitter(first, second) {}
+    virtual const char *GetName() const { return "splitter"; }
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset)
+    {
+        for (size_t i = 0; i < stream.size(); i++) {
+            splitter.HandleEdge(stream[i].time + timeOffset, stream[i].direction);
+        }
+    }
+};
+
+// four processors behind the splitters nested two levels deep
+class NestedSplittersBenchmark: public Benchmark {
+private:
+    CountingPulseProcessor processors[4];
+    RC433PulseSignalSplitter first, second, root;
+
+public:
+    NestedSplittersBenchmark():
+        first(processors[0], processors[1]),
+        second(processors[2], processors[3]),
+        root(first, second)
+    {
+    }
+    virtual const char *GetName() const { return "nested_splitters_4"; }
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset)
+    {
+        for (size_t i = 0; i < stream.size(); i++) {
+            root.HandleEdge(stream[i].time + timeOffset, stream[i].direction);
+        }
+    }
+};
+
+// the same four processors behind the flat fan-out
+class FanOutBenchmark: public Benchmark {
+private:
+    CountingPulseProcessor processors[4];
+    RC433HQPulseFanOut<4> fanOut;
+
+public:
+    FanOutBenchmark()
+    {
+        for (size_t i = 0; i < 4; i++) {
+            fanOut.Add(processors[i]);
+        }
+    }
+    virtual const char *GetName() const { return "fanout_4"; }
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset)
+    {
+        for (size_t i = 0; i < stream.size(); i++) {
+            fanOut.HandleEdge(stream[i].time + timeOffset, stream[i].direction);
+        }
+    }
+};
+
+class ProtocolAnalyzerBenchmark: public Benchmark {
+private:
+    RC433HQProtocolAnalyzer analyzer;
+
+public:
+    virtual const char *GetName() const { return "protocol_analyzer"; }
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset)
+    {
+        for (size_t i = 0; i < stream.size(); i++) {
+            analyzer.HandleEdge(stream[i].time + timeOffset, stream[i].direction);
+        }
+    }
+};
+
+template <class TDecoder>
+class DecoderBenchmark: public Benchmark {
+private:
+    const char *name;
+    CountingDataReceiver receiver;
+    TDecoder decoder;
+
+public:
+    DecoderBenchmark(const char *aname): name(aname), decoder(receiver) {}
+    virtual const char *GetName() const { return name; }
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset)
+    {
+        for (size_t i = 0; i < stream.size(); i++) {
+            decoder.HandleEdge(stream[i].time + timeOffset, stream[i].direction);
+        }
+    }
+    virtual size_t GetFramesCount() const { return receiver.frames; }
+};
+
+// splitter -> EMOS decoders A and B, the edge by edge reference of the batch decoders
+class SplitDecodersBenchmark: public Benchmark {
+private:
+    CountingDataReceiver receiverA, receiverB;
+    RC433HQEmosSocketsPulseDecoderA decoderA;
+    RC433HQEmosSocketsPulseDecoderB decoderB;
+    RC433PulseSignalSplitter splitter;
+
+public:
+    SplitDecodersBenchmark():
+        decoderA(receiverA),
+        decoderB(receiverB),
+        splitter(decoderA, decoderB)
+    {
+    }
+    virtual const char *GetName() const { return "decoders_ab"; }
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset)
+    {
+        for (size_t i = 0; i < stream.size(); i++) {
+            splitter.HandleEdge(stream[i].time + timeOffset, stream[i].direction);
+        }
+    }
+    virtual size_t GetFramesCount() const { return receiverA.frames + receiverB.frames; }
+};
+
+// how many pulses are collected before the batch is decoded
+static const size_t PULSES_PER_BATCH = 4096;
+
+// pulse batch collector -> batch decoder of EMOS A and B with the given classification kernel
+class BatchDecoderBenchmark: public Benchmark {
+private:
+    std::string name;
+    CountingDataReceiver receiverA, receiverB;
+    RC433HQEmosSocketsPulseDecoderA decoderA;
+    RC433HQEmosSocketsPulseDecoderB decoderB;
+    RC433HQBatchDecoder decoder;
+    RC433HQPulseBatch batch;
+    RC433HQPulseBatchCollector collector;
+
+public:
+    BatchDecoderBenchmark(RC433HQClassifierKernel kernel):
+        name(std::string("batch_") + RC433HQPulseClassifier::GetKernelName(kernel)),
+        decoderA(receiverA),
+        decoderB(receiverB),
+        collector(batch)
+    {
+        decoder.GetClassifier().SetKernel(kernel);
+        decoder.AddDecoder(decoderA);
+        decoder.AddDecoder(decoderB);
+    }
+    virtual const char *GetName() const { return name.c_str(); }
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset)
+    {
+        for (size_t i = 0; i < stream.size(); i++) {
+            collector.HandleEdge(stream[i].time + timeOffset, stream[i].direction);
+            if (batch.GetSize() == PULSES_PER_BATCH) {
+                decoder.Decode(batch);
+                batch.Clear();
+            }
+        }
+        decoder.Decode(batch);
+        batch.Clear();
+    }
+    virtual size_t GetFramesCount() const { return receiverA.frames + receiverB.frames; }
+};
+
+// receiver -> noise filter -> pulse buffer -> splitter -> EMOS decoders A and B, as in the receiver example
+class EndToEndBenchmark: public Benchmark {
+private:
+    CountingDataReceiver receiverA, receiverB;
+    RC433HQEmosSocketsPulseDecoderA decoderA;
+    RC433HQEmosSocketsPulseDecoderB decoderB;
+    RC433PulseSignalSplitter splitter;
+    RC433HQPulseBuffer buffer;
+    RC433HQNoiseFilter filter;
+
+public:
+    EndToEndBenchmark():
+        decoderA(receiverA),
+        decoderB(receiverB),
+        splitter(decoderA, decoderB),
+        buffer(splitter, 256),
+        filter(buffer, 50)
+    {
+    }
+    virtual const char *GetName() const { return "end_to_end"; }
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset)
+    {
+        size_t reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount;
+        for (size_t i = 0; i < stream.size(); i++) {
+            filter.HandleEdge(stream[i].time + timeOffset, stream[i].direction);
+            if ((i % EDGES_PER_PROCESS_DATA) == (EDGES_PER_PROCESS_DATA - 1)) {
+                buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+            }
+        }
+        buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+    }
+    virtual size_t GetFramesCount() const { return receiverA.frames + receiverB.frames; }
+};
+
+// the same chain composed by the templates, the stages are called without the virtual dispatch
+class StaticEndToEndBenchmark: public Benchmark {
+private:
+    typedef RC433HQStaticSplitter<RC433HQEmosSocketsPulseDecoderA, RC433HQEmosSocketsPulseDecoderB> Splitter;
+    typedef RC433HQStaticPulseBuffer<Splitter> Buffer;
+    typedef RC433HQStaticNoiseFilter<Buffer> Filter;
+
+    CountingDataReceiver receiverA, receiverB;
+    RC433HQEmosSocketsPulseDecoderA decoderA;
+    RC433HQEmosSocketsPulseDecoderB decoderB;
+    Splitter splitter;
+    Buffer buffer;
+    Filter filter;
+
+public:
+    StaticEndToEndBenchmark():
+        decoderA(receiverA),
+        decoderB(receiverB),
+        splitter(decoderA, decoderB),
+        buffer(splitter, 256),
+        filter(buffer, 50)
+    {
+    }
+    virtual const char *GetName() const { return "end_to_end_static"; }
+    virtual void Run(const RC433HQEdgeStream &stream, RC433HQMicrosecondsDiff timeOffset)
+    {
+        size_t reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount;
+        for (size_t i = 0; i < stream.size(); i++) {
+            RC433HQHandleEdge(filter, stream[i].time + timeOffset, stream[i].direction);
+            if ((i % EDGES_PER_PROCESS_DATA) == (EDGES_PER_PROCESS_DATA - 1)) {
+                buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+            }
+        }
+        buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+    }
+    virtual size_t GetFramesCount() const { return receiverA.frames + receiverB.frames; }
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// Benchmark driver
+//////////////////////////////////////////////////////////////////////////////////
+
+static double GetSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return double(now.tv_sec) + double(now.tv_nsec) * 1e-9;
+}
+
+struct Options {
+    bool json;
+    double minTime;
+    const char *edgesFileName;
+    const char *captureFileName;
+    const char *writeCaptureFileName;
+    size_t threads;
+};
+
+static void ReportThroughput(const char *benchmarkName, const char *streamName, double edges, double frames, double elapsed, const Options &options)
+{
+    if (options.json) {
+        printf("{\"version\": \"%s\", \"benchmark\": \"%s\", \"stream\": \"%s\", \"edges\": %.0f, \"frames\": %.0f, \"seconds\": %.6f, "
+               "\"edges_per_sec\": %.1f, \"ns_per_edge\": %.3f, \"frames_per_sec\": %.1f}\n",
+               RC433HQ_VERSION, benchmarkName, streamName, edges, frames, elapsed,
+               edges / elapsed, elapsed * 1e9 / edges, frames / elapsed);
+    } else {
+        printf("%-14s %-16s %12.0f edges/s %10.3f ns/edge %12.1f frames/s\n",
+               benchmarkName, streamName, edges / elapsed, elapsed * 1e9 / edges, frames / elapsed);
+    }
+    fflush(stdout);
+}
+
+static void RunBenchmark(Benchmark &benchmark, const char *streamName, const RC433HQEdgeStream &stream, const Options &options)
+{
+    if (stream.empty()) {
+        return;
+    }
+
+    // each pass continues in time after the previous one, so that the stages see a monotonic time
+    RC433HQMicrosecondsDiff streamDuration = (stream.back().time - stream.front().time) + 100000;
+    RC433HQMicrosecondsDiff timeOffset = 0;
+
+    // warm up
+    benchmark.Run(stream, timeOffset); timeOffset += streamDuration;
+    size_t warmUpFrames = benchmark.GetFramesCount();
+
+    size_t passes = 0;
+    double start = GetSeconds();
+    double elapsed = 0;
+    do {
+        benchmark.Run(stream, timeOffset); timeOffset += streamDuration;
+        passes++;
+        elapsed = GetSeconds() - start;
+    } while (elapsed < options.minTime);
+
+    double edges = double(stream.size()) * passes;
+    double frames = double(benchmark.GetFramesCount() - warmUpFrames);
+
+    ReportThroughput(benchmark.GetName(), streamName, edges, frames, elapsed, options);
+}
+
+// replay the memory-mapped capture into a counting sink (format decoding only) and into the decoders
+static bool RunCaptureBenchmarks(const char *fileName, const Options &options)
+{
+    RC433HQCaptureFile file;
+    if (!file.Open(fileName)) {
+        fprintf(stderr, "Cannot open the capture file %s.\n", fileName);
+        return false;
+    }
+
+    RC433HQCaptureReader reader = file.GetReader();
+    if (!reader.IsValid()) {
+        fprintf(stderr, "Invalid capture file %s.\n", fileName);
+        return false;
+    }
+
+    CountingPulseProcessor sink;
+    CountingDataReceiver receiverA, receiverB;
+    RC433HQEmosSocketsPulseDecoderA decoderA(receiverA);
+    RC433HQEmosSocketsPulseDecoderB decoderB(receiverB);
+    RC433PulseSignalSplitter splitter(decoderA, decoderB);
+    RC433HQNoiseFilter filter(splitter, 50);
+
+    const char *names[] = { "capture_replay", "capture_decode" };
+    IRC433PulseProcessor *processors[] = { &sink, &filter };
+
+    for (size_t i = 0; i < 2; i++) {
+
+        double edges = 0;
+        size_t framesBefore = receiverA.frames + receiverB.frames;
+        double start = GetSeconds();
+        double elapsed = 0;
+        do {
+            edges += reader.Replay(*processors[i]);
+            elapsed = GetSeconds() - start;
+        } while (elapsed < options.minTime);
+
+        ReportThroughput(names[i], "capture", edges, double(receiverA.frames + receiverB.frames - framesBefore), elapsed, options);
+    }
+
+    return true;
+}
+
+// write the stream into the capture file
+static bool WriteCapture(const char *fileName, const RC433HQEdgeStream &stream)
+{
+    RC433HQCaptureFileSink sink;
+    if (!sink.Open(fileName)) {
+        fprintf(stderr, "Cannot create the capture file %s.\n", fileName);
+        return false;
+    }
+
+    RC433HQPulseRecorder recorder(sink, 1000);
+    RC433HQSendEdges(stream, recorder);
+    recorder.Flush();
+    return true;
+}
+
+// decoding chain of one pipeline channel
+class PipelineChannelChain {
+private:
+    RC433HQPipelineFrameReceiver receiverA, receiverB;
+    RC433HQEmosSocketsPulseDecoderA decoderA;
+    RC433HQEmosSocketsPulseDecoderB decoderB;
+    RC433PulseSignalSplitter splitter;
+
+public:
+    RC433HQNoiseFilter filter;
+
+    PipelineChannelChain(RC433HQPipeline &pipeline, size_t channel):
+        receiverA(pipeline, channel, PROTOCOL_EMOS_A),
+        receiverB(pipeline, channel, PROTOCOL_EMOS_B),
+        decoderA(receiverA),
+        decoderB(receiverB),
+        splitter(decoderA, decoderB),
+        filter(splitter, 50)
+    {
+    }
+};
+
+// decode the stream in the given count of the pipeline channels in parallel, returns the edges per second
+static double RunPipelineBenchmark(const char *streamName, const RC433HQEdgeStream &stream, size_t channelsCount, const Options &options)
+{
+    RC433HQPipeline pipeline;
+    std::vector<PipelineChannelChain *> chains;
+    for (size_t i = 0; i < channelsCount; i++) {
+        size_t channel = pipeline.AddChannel(int(i % std::thread::hardware_concurrency()));
+        chains.push_back(new PipelineChannelChain(pipeline, channel));
+        pipeline.SetChannelProcessor(channel, chains.back()->filter);
+    }
+
+    RC433HQMicrosecondsDiff streamDuration = (stream.back().time - stream.front().time) + 100000;
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> sources;
+    std::vector<double> sourceEdges(channelsCount, 0);
+
+    pipeline.Start();
+    double start = GetSeconds();
+
+    // each source replays the stream into its channel until the minimal time elapses
+    for (size_t i = 0; i < channelsCount; i++) {
+        sources.push_back(std::thread([&, i]() {
+            RC433HQPipelineInput &input = pipeline.GetChannelInput(i);
+            RC433HQMicrosecondsDiff timeOffset = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (size_t j = 0; j < stream.size(); j++) {
+                    input.HandleEdge(stream[j].time + timeOffset, stream[j].direction);
+                }
+                timeOffset += streamDuration;
+                sourceEdges[i] += double(stream.size());
+            }
+            input.Flush();
+        }));
+    }
+
+    // consume the decoded frames until the pipeline is stopped
+    std::atomic<bool> stopConsumer(false);
+    double frames = 0;
+    std::thread consumer([&]() {
+        RC433HQPipelineFrame frame;
+        for (;;) {
+            bool stopRequested = stopConsumer.load();
+            if (pipeline.PopFrame(frame)) {
+                frames++;
+            } else if (stopRequested) {
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    while (GetSeconds() - start < options.minTime) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // the sources finish their pass and the pipeline processes all the queued edges
+    stop.store(true);
+    for (size_t i = 0; i < channelsCount; i++) {
+        sources[i].join();
+    }
+    pipeline.Stop();
+    stopConsumer.store(true);
+    consumer.join();
+    double elapsed = GetSeconds() - start;
+
+    double edges = 0;
+    for (size_t i = 0; i < channelsCount; i++) {
+        edges += sourceEdges[i];
+        delete chains[i];
+    }
+
+    char benchmarkName[32];
+    snprintf(benchmarkName, sizeof(benchmarkName), "pipeline_x%lu", (unsigned long)channelsCount);
+    ReportThroughput(benchmarkName, streamName, edges, frames, elapsed, options);
+
+    return edges / elapsed;
+}
+
+// measure the scaling of the pipeline throughput with the count of the channels
+static void RunPipelineBenchmarks(const char *streamName, const RC433HQEdgeStream &stream, const Options &options)
+{
+    if (stream.empty()) {
+        return;
+    }
+
+    double singleChannelThroughput = 0;
+    for (size_t channels = 1; channels <= options.threads; channels *= 2) {
+
+        double throughput = RunPipelineBenchmark(streamName, stream, channels, options);
+        if (channels == 1) {
+            singleChannelThroughput = throughput;
+        }
+
+        double speedup = throughput / singleChannelThroughput;
+        if (options.json) {
+            printf("{\"version\": \"%s\", \"benchmark\": \"pipeline_scaling\", \"stream\": \"%s\", \"channels\": %lu, \"speedup\": %.3f, \"efficiency\": %.3f}\n",
+                   RC433HQ_VERSION, streamName, (unsigned long)channels, speedup, speedup / channels);
+        } else {
+            printf("%-14s %-16s %2lu channels: %6.2fx speedup, %5.1f %% efficiency\n",
+                   "pipeline_scale", streamName, (unsigned long)channels, speedup, 100.0 * speedup / channels);
+        }
+        fflush(stdout);
+    }
+}
+
+// capture kept in the memory
+class MemoryCaptureSink: public IRC433CaptureSink {
+public:
+    std::vector<byte> data;
+
+    virtual void WriteCaptureData(const byte *writtenData, size_t size) { data.insert(data.end(), writtenData, writtenData + size); }
+};
+
+// EMOS decoders created for every chunk of the offline decoding
+class EmosOfflineDecoderFactory: public IRC433OfflineDecoderFactory {
+public:
+    virtual size_t GetDecodersCount() const { return 2; }
+
+    virtual RC433HQBasicSyncPulseDecoder *CreateDecoder(size_t index, IRC433DataReceiver &receiver)
+    {
+        if (index == 0) {
+            return new RC433HQEmosSocketsPulseDecoderA(receiver);
+        }
+        return new RC433HQEmosSocketsPulseDecoderB(receiver);
+    }
+};
+
+// decode the capture on 1, 2, 4, ... threads and report the speedup against the sequential decoding
+static void RunOfflineBenchmarks(const char *streamName, const RC433HQCaptureReader &reader, const Options &options)
+{
+    EmosOfflineDecoderFactory factory;
+    RC433HQOfflineDecoder decoder(factory, 50, 40000, 4096);
+
+    // the reference frames and the throughput of the sequential decoding
+    RC433HQOfflineFrames sequentialFrames;
+    size_t passes = 0;
+    double start = GetSeconds();
+    double elapsed = 0;
+    do {
+        decoder.DecodeSequential(reader, sequentialFrames);
+        passes++;
+        elapsed = GetSeconds() - start;
+    } while (elapsed < options.minTime);
+    double sequentialTime = elapsed / passes;
+
+    for (size_t threads = 1; threads <= options.threads; threads *= 2) {
+
+        RC433HQOfflineFrames frames;
+        passes = 0;
+        start = GetSeconds();
+        do {
+            decoder.DecodeParallel(reader, threads, frames);
+            passes++;
+            elapsed = GetSeconds() - start;
+        } while (elapsed < options.minTime);
+
+        bool identical = (frames == sequentialFrames);
+        double speedup = sequentialTime * passes / elapsed;
+
+        if (options.json) {
+            printf("{\"version\": \"%s\", \"benchmark\": \"offline_scaling\", \"stream\": \"%s\", \"threads\": %lu, \"chunks\": %lu, "
+                   "\"frames\": %lu, \"speedup\": %.3f, \"identical\": %s}\n",
+                   RC433HQ_VERSION, streamName, (unsigned long)threads, (unsigned long)decoder.GetChunksCount(),
+                   (unsigned long)frames.size(), speedup, identical? "true": "false");
+        } else {
+            printf("%-14s %-16s %2lu threads: %6.2fx speedup, %lu chunks, %lu frames, %s\n",
+                   "offline_scale", streamName, (unsigned long)threads, speedup, (unsigned long)decoder.GetChunksCount(),
+                   (unsigned long)frames.size(), identical? "identical": "DIFFERENT from sequential");
+        }
+        fflush(stdout);
+    }
+}
+
+// counts the records read from the journal
+class CountingJournalRecordHandler: public IRC433JournalRecordHandler {
+public:
+    unsigned long long records;
+    unsigned long long bits;
+
+    CountingJournalRecordHandler(): records(0), bits(0) {}
+
+    virtual void HandleRecord(const RC433HQJournalRecord &record) { records++; bits += record.bits; }
+};
+
+static void ReportJournalThroughput(const char *benchmarkName, double operations, const char *unit, double elapsed, const Options &options)
+{
+    if (options.json) {
+        printf("{\"version\": \"%s\", \"benchmark\": \"%s\", \"%s\": %.0f, \"seconds\": %.6f, \"%s_per_sec\": %.1f}\n",
+               RC433HQ_VERSION, benchmarkName, unit, operations, elapsed, unit, operations / elapsed);
+    } else {
+        printf("%-14s %-16s %12.0f %s/s\n", benchmarkName, "journal", operations / elapsed, unit);
+    }
+    fflush(stdout);
+}
+
+// write, scan and search the frame journal of 1M frames (one frame every 100 ms) in a temporary directory
+static void RunJournalBenchmarks(const Options &options)
+{
+    static const size_t JOURNAL_FRAMES = 1000000;
+    static const uint64_t FRAME_PERIOD_US = 100000;
+
+    char directory[] = "/tmp/rc433hq_benchmarksXXXXXX";
+    if (!mkdtemp(directory)) {
+        fprintf(stderr, "Cannot create the journal directory.\n");
+        return;
+    }
+    std::string prefix = std::string(directory) + "/frames";
+
+    RC433HQFrameJournalWriter writer;
+    if (!writer.Open(prefix.c_str())) {
+        fprintf(stderr, "Cannot create the journal %s.\n", prefix.c_str());
+        rmdir(directory);
+        return;
+    }
+    byte data[3] = { 0x38, 0xcb, 0xbe };
+    double start = GetSeconds();
+    for (size_t i = 0; i < JOURNAL_FRAMES; i++) {
+        writer.Append(RC433HQExtendedMicroseconds(uint64_t(i) * FRAME_PERIOD_US), byte(i & 1), data, 24, 90.0);
+    }
+    writer.Close();
+    ReportJournalThroughput("journal_write", double(JOURNAL_FRAMES), "records", GetSeconds() - start, options);
+
+    RC433HQFrameJournalReader reader;
+    if (reader.Open(prefix.c_str())) {
+
+        CountingJournalRecordHandler handler;
+        double elapsed = 0;
+        start = GetSeconds();
+        do {
+            reader.Scan(handler);
+            elapsed = GetSeconds() - start;
+        } while (elapsed < options.minTime);
+        ReportJournalThroughput("journal_scan", double(handler.records), "records", elapsed, options);
+
+        // one minute long ranges spread over the whole journal
+        uint64_t journalDuration = uint64_t(JOURNAL_FRAMES) * FRAME_PERIOD_US;
+        size_t searches = 0;
+        start = GetSeconds();
+        do {
+            uint64_t begin = (uint64_t(searches) * 7919 * 1000003) % journalDuration;
+            reader.Find(RC433HQExtendedMicroseconds(begin), RC433HQExtendedMicroseconds(begin + 60000000), handler);
+            searches++;
+            elapsed = GetSeconds() - start;
+        } while (elapsed < options.minTime);
+        ReportJournalThroughput("journal_find", double(searches), "searches", elapsed, options);
+    }
+    reader.Close();
+
+    char fileName[256];
+    for (unsigned long segment = 0; RC433HQGetJournalSegmentName(prefix.c_str(), segment, fileName, sizeof(fileName)) && (unlink(fileName) == 0); segment++) {
+    }
+    rmdir(directory);
+}
+
+// decode the stream once by the complete chain and compare the decoded frames with the ground truth
+static void ScoreStream(const char *streamName, const RC433HQEdgeStream &stream, const RC433HQTrafficFrames &groundTruth, const Options &options)
+{
+    RC433HQDecodedTrafficFrames decodedFrames;
+    RC433HQTrafficFrameCollector collectorA(decodedFrames, PROTOCOL_EMOS_A);
+    RC433HQTrafficFrameCollector collectorB(decodedFrames, PROTOCOL_EMOS_B);
+    RC433HQEmosSocketsPulseDecoderA decoderA(collectorA);
+    RC433HQEmosSocketsPulseDecoderB decoderB(collectorB);
+    RC433PulseSignalSplitter splitter(decoderA, decoderB);
+    RC433HQNoiseFilter filter(splitter, 50);
+
+    RC433HQSendEdges(stream, filter);
+
+    RC433HQTrafficScore score;
+    score.Evaluate(groundTruth, decodedFrames);
+
+    if (options.json) {
+        printf("{\"version\": \"%s\", \"benchmark\": \"decode_score\", \"stream\": \"%s\", \"frames\": %lu, \"detected_frames\": %lu, "
+               "\"frame_detection_rate\": %.4f, \"repetition_decode_rate\": %.4f, \"false_frames\": %lu}\n",
+               RC433HQ_VERSION, streamName, (unsigned long)score.transmittedFrames, (unsigned long)score.detectedFrames,
+               score.GetFrameDetectionRate(), score.GetRepetitionDecodeRate(), (unsigned long)score.falseFrames);
+    } else {
+        printf("%-14s %-16s %5.1f %% frames detected, %5.1f %% repetitions decoded, %lu false frames\n",
+               "decode_score", streamName, 100.0 * score.GetFrameDetectionRate(), 100.0 * score.GetRepetitionDecodeRate(), (unsigned long)score.falseFrames);
+    }
+    fflush(stdout);
+}
+
+static void RunAllBenchmarks(const char *streamName, const RC433HQEdgeStream &stream, const Options &options)
+{
+    NoiseFilterBenchmark noiseFilter;
+    PulseBufferBenchmark pulseBuffer;
+    SplitterBenchmark splitter;
+    NestedSplittersBenchmark nestedSplitters;
+    FanOutBenchmark fanOut;
+    DecoderBenchmark<RC433HQEmosSocketsPulseDecoderA> decoderA("emos_decoder_a");
+    DecoderBenchmark<RC433HQEmosSocketsPulseDecoderB> decoderB("emos_decoder_b");
+    EndToEndBenchmark endToEnd;
+    StaticEndToEndBenchmark staticEndToEnd;
+    SplitDecodersBenchmark splitDecoders;
+    ProtocolAnalyzerBenchmark protocolAnalyzer;
+
+    Benchmark *benchmarks[] = { &noiseFilter, &pulseBuffer, &splitter, &nestedSplitters, &fanOut, &decoderA, &decoderB, &endToEnd, &staticEndToEnd, &splitDecoders, &protocolAnalyzer };
+
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        RunBenchmark(*benchmarks[i], streamName, stream, options);
+    }
+
+    // the batch decoding with all the classification kernels supported by the CPU
+    RC433HQClassifierKernel kernels[] = { RC433HQ_CLASSIFIER_SCALAR, RC433HQ_CLASSIFIER_SSE2, RC433HQ_CLASSIFIER_AVX2 };
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        if (RC433HQPulseClassifier::IsKernelSupported(kernels[i])) {
+            BatchDecoderBenchmark batchDecoder(kernels[i]);
+            RunBenchmark(batchDecoder, streamName, stream, options);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options options = { false, 0.5, 0, 0, 0, std::thread::hardware_concurrency() };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            options.json = true;
+        } else if ((strcmp(argv[i], "--edges") == 0) && (i + 1 < argc)) {
+            options.edgesFileName = argv[++i];
+        } else if ((strcmp(argv[i], "--capture") == 0) && (i + 1 < argc)) {
+            options.captureFileName = argv[++i];
+        } else if ((strcmp(argv[i], "--write-capture") == 0) && (i + 1 < argc)) {
+            options.writeCaptureFileName = argv[++i];
+        } else if ((strcmp(argv[i], "--min-time") == 0) && (i + 1 < argc)) {
+            options.minTime = atof(argv[++i]);
+        } else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc)) {
+            options.threads = size_t(atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "Usage: %s [--json] [--edges <file>] [--capture <file>] [--write-capture <file>] [--min-time <seconds>] [--threads <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!options.json) {
+        printf("rc433hq benchmarks, version %s\n", RC433HQ_VERSION);
+    }
+
+    RC433HQEdgeStream clean;
+    RC433HQTrafficFrames cleanGroundTruth;
+    GenerateEmosStream(clean, cleanGroundTruth, 100, false);
+    RunAllBenchmarks("synthetic_clean", clean, options);
+    ScoreStream("synthetic_clean", clean, cleanGroundTruth, options);
+
+    RC433HQEdgeStream noisy;
+    RC433HQTrafficFrames noisyGroundTruth;
+    GenerateEmosStream(noisy, noisyGroundTruth, 100, true);
+    RunAllBenchmarks("synthetic_noisy", noisy, options);
+    ScoreStream("synthetic_noisy", noisy, noisyGroundTruth, options);
+    RunPipelineBenchmarks("synthetic_noisy", noisy, options);
+
+    // longer noisy stream recorded in the memory, so that it is split into many chunks
+    RC433HQEdgeStream longNoisy;
+    RC433HQTrafficFrames longNoisyGroundTruth;
+    GenerateEmosStream(longNoisy, longNoisyGroundTruth, 2000, true);
+    MemoryCaptureSink memoryCapture;
+    RC433HQPulseRecorder recorder(memoryCapture, 1000);
+    RC433HQSendEdges(longNoisy, recorder);
+    recorder.Flush();
+    RunOfflineBenchmarks("synthetic_noisy", RC433HQCaptureReader(&memoryCapture.data[0], memoryCapture.data.size()), options);
+    RunJournalBenchmarks(options);
+
+    if (options.writeCaptureFileName && !WriteCapture(options.writeCaptureFileName, noisy)) {
+        return 1;
+    }
+
+    if (options.edgesFileName) {
+        RC433HQEdgeStream recorded;
+        if (!LoadEdgeStream(recorded, options.edgesFileName)) {
+            return 1;
+        }
+        RunAllBenchmarks("recorded", recorded, options);
+    }
+
+    if (options.captureFileName) {
+        if (!RunCaptureBenchmarks(options.captureFileName, options)) {
+            return 1;
+        }
+
+        RC433HQCaptureFile file;
+        if (file.Open(options.captureFileName)) {
+            RunOfflineBenchmarks("capture", file.GetReader(), options);
+        }
+    }
+
+    return 0;
+}
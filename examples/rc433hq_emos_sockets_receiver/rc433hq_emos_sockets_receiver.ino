@@ -136,6 +136,15 @@ ReceivedDataHandler handlerB(recivedDataDumper, "B");
 RC433HQEmosSocketsPulseDecoderA decoderA(handlerA);
 RC433HQEmosSocketsPulseDecoderB decoderB(handlerB);
 
+// the decoded frames are stored into the queue and printed later from the loop, so that the slow serial line does not block
+// the decoding (the handlers above are not called)
+static const byte PROTOCOL_A = 0;
+static const byte PROTOCOL_B = 1;
+RC433HQFrameQueue frameQueue(8);
+
+// latency of the frames of both protocols from the sync edge to the frame queue
+RC433HQLatencyStatistics latencyA, latencyB;
+
 // signal splitter to process the signal by both EMOS Socket processors A and B
 RC433PulseSignalSplitter signalSplitter(decoderA, decoderB);
 
@@ -157,6 +166,40 @@ unsigned long iterationsCount = 0;
 unsigned long totalProcessedCount = 0;
 unsigned long totalMissedCount = 0;
 
+static void PrintDecoderMetrics(RC433HQBasicSyncPulseDecoder &decoder, RC433HQLatencyStatistics &latency, const char *source)
+{
+  RC433HQDecoderMetrics metrics;
+  decoder.TakeMetrics(metrics);
+
+  Serial.print("Decoder ");
+  Serial.print(source);
+  Serial.print(": ");
+  Serial.print(metrics.syncs);
+  Serial.print(" syncs, ");
+  Serial.print(metrics.zeroBits + metrics.oneBits);
+  Serial.print(" bits, ");
+  Serial.print(metrics.outOfTolerancePulses);
+  Serial.print(" pulses out of tolerance, ");
+  Serial.print(metrics.brokenPulses);
+  Serial.print(" broken pulses, ");
+  Serial.print(metrics.missedEdges);
+  Serial.print(" missed edges, ");
+  Serial.print(metrics.shortFrames);
+  Serial.print(" short frames, ");
+  Serial.print(metrics.deliveredFrames);
+  Serial.print(" frames delivered (average quality ");
+  Serial.print(metrics.GetAverageQuality());
+  Serial.print(" %), latency ");
+
+  RC433HQDurationStatistics latencySnapshot;
+  latency.GetSnapshot(latencySnapshot);
+  latency.Reset();
+  Serial.print(latencySnapshot.GetAverageTicks());
+  Serial.print(" us average, ");
+  Serial.print(latencySnapshot.GetMaxTicks());
+  Serial.print(" us max.\n");
+}
+
 
 void setup()
 {
@@ -165,6 +208,14 @@ void setup()
 
   decoderA.SetLogger(logger);
   decoderB.SetLogger(logger);
+  decoderA.SetFrameQueue(frameQueue, PROTOCOL_A);
+  decoderB.SetFrameQueue(frameQueue, PROTOCOL_B);
+  decoderA.SetLatencyStatistics(latencyA);
+  decoderB.SetLatencyStatistics(latencyB);
+
+  // the high parts of the EMOS zero and one differ, so the frames can be delivered without waiting for the next pulse
+  decoderA.EnableEarlyDelivery();
+  decoderB.EnableEarlyDelivery();
 
   startTimeMillis = millis();
   iterationsCount = 0;
@@ -186,6 +237,13 @@ void loop()
   totalProcessedCount += reportedProcessedCount;
   totalMissedCount += reportedMissedCount;
 
+  // print one decoded frame per iteration, the edges keep being processed in between
+  RC433HQFrameView frame;
+  if (frameQueue.Peek(frame)) {
+    recivedDataDumper.DumpData(frame.GetTime(), frame.GetData(), frame.GetBits(), frame.GetQuality(), (frame.GetProtocol() == PROTOCOL_A)? "A": "B");
+    frameQueue.Pop();
+  }
+
   // if we've been processing data at least STATS_PERIOD
   if ((millis() - startTimeMillis) >= STATS_PERIOD) {
 
@@ -196,7 +254,63 @@ void loop()
     Serial.print(totalProcessedCount);
     Serial.print(" edges processed, ");
     Serial.print(totalMissedCount);
-    Serial.print(" edges missed.\n");
+    Serial.print(" edges missed, ");
+    Serial.print(frameQueue.GetDroppedCount());
+    Serial.print(" frames dropped.\n");
+    frameQueue.ResetDroppedCount();
+    // dump the usage of the buffer, the high-water mark shows how large the buffer has to be
+    RC433HQPulseBufferStatistics bufferStatistics;
+    buffer.TakeStatistics(bufferStatistics);
+    Serial.print("Buffer usage: ");
+    Serial.print(bufferStatistics.highWaterMark);
+    Serial.print(" of ");
+    Serial.print(buffer.GetBufferSize());
+    Serial.print(" words max, ");
+    Serial.print(bufferStatistics.relativeEdges);
+    Serial.print(" relative and ");
+    Serial.print(bufferStatistics.absoluteEdges);
+    Serial.print(" absolute edges, ");
+    Serial.print(bufferStatistics.overflowEpisodesCount);
+    Serial.print(" overflows losing ");
+    Serial.print(bufferStatistics.lostEdges);
+    Serial.print(" edges, occupancy histogram:");
+    for (size_t i = 0; i < RC433HQ_OCCUPANCY_HISTOGRAM_BUCKETS; i++) {
+      Serial.print(" ");
+      Serial.print(bufferStatistics.occupancyHistogram[i]);
+    }
+    Serial.print("\n");
+    for (size_t i = 0; i < bufferStatistics.GetStoredOverflowEpisodesCount(); i++) {
+      const RC433HQOverflowEpisode &episode = bufferStatistics.overflowEpisodes[i];
+      Serial.print("  overflow at ");
+      Serial.print(episode.startTime.GetUnsignedLong());
+      Serial.print(" us for ");
+      Serial.print(episode.duration.GetUnsignedLong());
+      Serial.print(" us lost ");
+      Serial.print(episode.lostEdges);
+      Serial.print(" edges\n");
+    }
+
+    PrintDecoderMetrics(decoderA, latencyA, "A");
+    PrintDecoderMetrics(decoderB, latencyB, "B");
+
+#if defined(RC433HQ_PROFILE)
+    // dump the timing of the interrupt handler and of the sections with disabled interrupts
+    RC433HQDurationStatistics interruptStatistics, maskedSectionStatistics;
+    RC433HQProfiler::GetInterruptStatistics(interruptStatistics);
+    RC433HQProfiler::GetMaskedSectionStatistics(maskedSectionStatistics);
+    RC433HQProfiler::Reset();
+
+    double ticksPerMicrosecond = RC433HQTickService::GetTicksPerMillisecond() / 1000.0;
+    Serial.print("Interrupt handler: ");
+    Serial.print(interruptStatistics.GetAverageTicks() / ticksPerMicrosecond);
+    Serial.print(" us average, ");
+    Serial.print(interruptStatistics.GetMaxTicks() / ticksPerMicrosecond);
+    Serial.print(" us max, interrupts disabled: ");
+    Serial.print(maskedSectionStatistics.GetAverageTicks() / ticksPerMicrosecond);
+    Serial.print(" us average, ");
+    Serial.print(maskedSectionStatistics.GetMaxTicks() / ticksPerMicrosecond);
+    Serial.print(" us max.\n");
+#endif // defined(RC433HQ_PROFILE)
 
     startTimeMillis = millis();
     iterationsCount = 0;
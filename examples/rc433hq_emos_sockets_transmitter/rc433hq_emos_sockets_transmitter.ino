@@ -66,6 +66,14 @@ void setup()
 {
   Serial.begin(9600);
   while(!Serial) {} // Portability for Leonardo/Micro
+
+  // measure the clock read duration and the sleep lateness of the board before the first transmission
+  transmitter.Calibrate();
+  Serial.print("Clock read: ");
+  Serial.print(transmitter.GetHybridWait().GetReadDuration().GetUnsignedLong());
+  Serial.print(" us, sleep lateness: ");
+  Serial.print(transmitter.GetHybridWait().GetSleepLateness().GetUnsignedLong());
+  Serial.print(" us.\n");
 }
 
 void SendEmosCode(const byte *data, size_t bits)
@@ -110,6 +118,8 @@ void SendEmosCode(const byte *data, size_t bits)
     Serial.print(transmissionStats.countOfDelayedEdgesOutsideOfTolerance);
     Serial.print(", average delay: ");
     Serial.print(transmissionStats.averageDelay);
+    Serial.print(" us, sleep lateness: ");
+    Serial.print(transmitter.GetHybridWait().GetSleepLateness().GetUnsignedLong());
     Serial.print(" us.\n");
 }
 
@@ -0,0 +1,105 @@
+#line 2 "rc433hq_protocol_analyzer.ino"
+
+#if defined(ARDUINO)
+#	include <rc433hq.h>
+#else
+#	include "../../rc433hq.h"
+#endif // defined(ARDUINO)
+
+// Learns the timing of an unknown remote. Press the buttons of the remote repeatedly close to the receiver, every 10 s the
+// suggested parameters of the RC433HQBasicSyncPulseDecoder and RC433HQBasicSyncPulseEncoder are printed.
+
+// the analyzer of the received pulses
+RC433HQProtocolAnalyzer analyzer;
+
+// buffer for handled data
+RC433HQPulseBuffer buffer(analyzer, 256);
+
+// the instance of noise filter, that ignores all the very short pulses and passes the clean data to the analyzer
+RC433HQNoiseFilter noiseFilter(buffer, 50);
+
+// the 433 MHz receiver instance. Passes data to noise filter.
+RC433HQReceiver receiver(noiseFilter, 2);
+
+// we will dump the suggestion every 10s
+static const unsigned long REPORT_PERIOD = 10*1000;
+
+unsigned long startTimeMillis;
+
+
+void setup()
+{
+  Serial.begin(9600);
+  while(!Serial) {} // Portability for Leonardo/Micro
+
+  startTimeMillis = millis();
+}
+
+static void PrintTiming(const RC433HQProtocolSuggestion &suggestion)
+{
+  Serial.print(suggestion.syncFirstUs);
+  Serial.print(", ");
+  Serial.print(suggestion.syncSecondUs);
+  Serial.print(", ");
+  Serial.print(suggestion.zeroFirstUs);
+  Serial.print(", ");
+  Serial.print(suggestion.zeroSecondUs);
+  Serial.print(", ");
+  Serial.print(suggestion.oneFirstUs);
+  Serial.print(", ");
+  Serial.print(suggestion.oneSecondUs);
+}
+
+void loop()
+{
+  // process the data in the buffer
+  size_t reportedBufferUsedCount = 0;
+  size_t reportedProcessedCount = 0;
+  size_t reportedMissedCount = 0;
+  buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+
+  // if we've been analyzing the data at least REPORT_PERIOD
+  if ((millis() - startTimeMillis) >= REPORT_PERIOD) {
+
+    Serial.print("Analyzed ");
+    Serial.print(analyzer.GetPulsesCount());
+    Serial.print(" pulses, symbol candidates (count high/low us):");
+    for (size_t i = 0; i < RC433HQProtocolAnalyzer::CLUSTERS_COUNT; i++) {
+      word count, highUs, lowUs;
+      if (analyzer.GetCluster(i, count, highUs, lowUs)) {
+        Serial.print(" ");
+        Serial.print(count);
+        Serial.print("x ");
+        Serial.print(highUs);
+        Serial.print("/");
+        Serial.print(lowUs);
+      }
+    }
+    Serial.print("\n");
+
+    RC433HQProtocolSuggestion suggestion;
+    if (analyzer.GetSuggestion(suggestion)) {
+
+      // print the ready to use parameters of the decoder and of the encoder
+      Serial.print("Suggestion based on ");
+      Serial.print(suggestion.framesCount);
+      Serial.print(" frames:\n  RC433HQBasicSyncPulseDecoder decoder(receiver, ");
+      PrintTiming(suggestion);
+      Serial.print(", ");
+      Serial.print(suggestion.toleranceUs);
+      Serial.print(", true, ");
+      Serial.print(suggestion.minBits);
+      Serial.print(", ");
+      Serial.print(suggestion.maxBits);
+      Serial.print(");\n  RC433HQBasicSyncPulseEncoder encoder(");
+      PrintTiming(suggestion);
+      Serial.print(", true);\n");
+
+    } else {
+
+      Serial.print("Not enough frames yet, keep pressing the buttons of the remote.\n");
+    }
+
+    startTimeMillis = millis();
+  }
+}
@@ -0,0 +1,164 @@
+#include "rc433hq_capture.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQCaptureFileSink implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQCaptureFileSink::RC433HQCaptureFileSink():
+    file(0)
+{
+}
+
+RC433HQCaptureFileSink::~RC433HQCaptureFileSink()
+{
+    Close();
+}
+
+bool RC433HQCaptureFileSink::Open(const char *fileName)
+{
+    Close();
+    file = fopen(fileName, "wb");
+    return file != 0;
+}
+
+void RC433HQCaptureFileSink::Close()
+{
+    if (file) {
+        fclose(file);
+        file = 0;
+    }
+}
+
+void RC433HQCaptureFileSink::WriteCaptureData(const byte *data, size_t size)
+{
+    if (file) {
+        fwrite(data, 1, size, file);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQCaptureReader implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQCaptureReader::RC433HQCaptureReader(const byte *adata, size_t asize):
+    data(adata),
+    size(asize),
+    timerResolutionNs(0),
+    valid(false)
+{
+    // check the header
+    if (data && (size >= RC433HQ_CAPTURE_HEADER_SIZE) && (memcmp(data, RC433HQ_CAPTURE_MAGIC, sizeof(RC433HQ_CAPTURE_MAGIC)) == 0) &&
+        (ReadWord(4) == RC433HQ_CAPTURE_VERSION) && (ReadWord(6) == RC433HQ_CAPTURE_HEADER_SIZE)) {
+
+        timerResolutionNs = (unsigned long)ReadWord(8) | ((unsigned long)ReadWord(10) << 16);
+
+        // ignore the incomplete last word
+        size = RC433HQ_CAPTURE_HEADER_SIZE + ((size - RC433HQ_CAPTURE_HEADER_SIZE) & ~size_t(1));
+        valid = true;
+    }
+}
+
+size_t RC433HQCaptureReader::Replay(IRC433PulseProcessor &processor, RC433HQTimeExtender *timeExtender) const
+{
+    return Replay(processor, GetRecordsBegin(), GetRecordsEnd(), timeExtender);
+}
+
+size_t RC433HQCaptureReader::Replay(IRC433PulseProcessor &processor, size_t beginOffset, size_t endOffset, RC433HQTimeExtender *timeExtender) const
+{
+    size_t edges = 0;
+
+    if (!valid) {
+        return edges;
+    }
+
+    if (endOffset > size) {
+        endOffset = size;
+    }
+
+    RC433HQMicroseconds time;
+    RC433HQCaptureRecord record;
+
+    for (size_t offset = beginOffset; ReadRecord(offset, endOffset, time, record); ) {
+
+        if (record.missedEdges) {
+
+            processor.HandleMissedEdges();
+            continue;
+        }
+
+        time = record.time;
+
+        if (timeExtender) {
+            timeExtender->Update(time);
+        }
+
+        processor.HandleEdge(time, record.direction);
+        edges++;
+    }
+
+    return edges;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQCaptureFile implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQCaptureFile::RC433HQCaptureFile():
+    fd(-1),
+    data(0),
+    size(0)
+{
+}
+
+RC433HQCaptureFile::~RC433HQCaptureFile()
+{
+    Close();
+}
+
+bool RC433HQCaptureFile::Open(const char *fileName)
+{
+    Close();
+
+    fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if ((fstat(fd, &fileStat) != 0) || (fileStat.st_size == 0)) {
+        Close();
+        return false;
+    }
+
+    void *mapping = mmap(0, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        Close();
+        return false;
+    }
+
+    // the captures are always read sequentially
+    madvise(mapping, size_t(fileStat.st_size), MADV_SEQUENTIAL);
+
+    data = static_cast<const byte *>(mapping);
+    size = size_t(fileStat.st_size);
+    return true;
+}
+
+void RC433HQCaptureFile::Close()
+{
+    if (data) {
+        munmap(const_cast<byte *>(data), size);
+        data = 0;
+        size = 0;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
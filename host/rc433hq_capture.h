@@ -0,0 +1,138 @@
+#pragma once
+
+// Host only (Linux) part of the library: writing of the edge captures into files and their memory-mapped replay.
+// The captures are recorded by the RC433HQPulseRecorder, see rc433hq.h for the description of the format.
+
+#include "../rc433hq.h"
+
+#include <stdio.h>
+
+/**
+  @file rc433hq_capture.h
+*/
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQCaptureFileSink declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Capture sink writing into a file
+ */
+class RC433HQCaptureFileSink: public IRC433CaptureSink {
+private:
+	FILE *file;
+
+public:
+	RC433HQCaptureFileSink();
+	~RC433HQCaptureFileSink();
+
+	bool Open(const char *fileName);
+	void Close();
+
+	virtual void WriteCaptureData(const byte *data, size_t size);
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQCaptureReader declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// one record of the capture
+struct RC433HQCaptureRecord {
+	bool missedEdges;              // the edges were missed before the next edge, the other values are not used
+	bool absoluteTime;             // the time was stored as absolute (always after a long pause)
+	RC433HQMicroseconds time;
+	bool direction;
+};
+
+/** \brief Replays the capture stored in memory (e.g. memory-mapped file) into the pulse processor without copying it
+ */
+class RC433HQCaptureReader {
+private:
+	const byte *data;
+	size_t size;
+	unsigned long timerResolutionNs;
+	bool valid;
+
+public:
+	RC433HQCaptureReader(const byte *adata, size_t asize);
+
+	// true if the header is valid
+	bool IsValid() const { return valid; }
+
+	unsigned long GetTimerResolutionNs() const { return timerResolutionNs; }
+
+	// offsets of the edge records in the data
+	size_t GetRecordsBegin() const { return RC433HQ_CAPTURE_HEADER_SIZE; }
+	size_t GetRecordsEnd() const { return valid? size: RC433HQ_CAPTURE_HEADER_SIZE; }
+
+	// pass all the edges into the processor, returns the count of the edges. If the time extender is provided,
+	// it is updated with the edge times (the replay is the producer of the edges).
+	size_t Replay(IRC433PulseProcessor &processor, RC433HQTimeExtender *timeExtender = 0) const;
+
+	// pass the edges from the records range into the processor. The range has to start with an absolute time record
+	// (or the missed edges marker), which is always the case at the beginning of the records and after long pauses.
+	size_t Replay(IRC433PulseProcessor &processor, size_t beginOffset, size_t endOffset, RC433HQTimeExtender *timeExtender = 0) const;
+
+	// read the record at the offset and move the offset after it, returns false at the end of the range. The time
+	// of the relative record is calculated from the time of the previous edge.
+	bool ReadRecord(size_t &offset, size_t endOffset, RC433HQMicroseconds previousTime, RC433HQCaptureRecord &record) const
+	{
+		if (offset + 2 > endOffset) {
+			return false;
+		}
+
+		word value = ReadWord(offset);
+		word relative = (value & ~RC433HQ_CAPTURE_DIRECTION_MASK);
+
+		record.missedEdges = (relative == RC433HQ_CAPTURE_MISSED_EDGES);
+		record.absoluteTime = (relative == RC433HQ_CAPTURE_ABSOLUTE_TIME);
+		record.direction = (value & RC433HQ_CAPTURE_DIRECTION_MASK) != 0;
+
+		if (record.absoluteTime) {
+
+			// the absolute time might be truncated at the end of the capture
+			if (offset + 6 > endOffset) {
+				return false;
+			}
+			record.time = RC433HQMicroseconds((uint32_t(ReadWord(offset + 4)) << 16) | ReadWord(offset + 2));
+			offset += 6;
+
+		} else {
+
+			record.time = previousTime + RC433HQMicrosecondsDiff(relative);
+			offset += 2;
+		}
+
+		return true;
+	}
+
+private:
+	word ReadWord(size_t offset) const { return word(data[offset] | (word(data[offset + 1]) << 8)); }
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQCaptureFile declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Read-only memory mapping of the capture file
+ */
+class RC433HQCaptureFile {
+private:
+	int fd;
+	const byte *data;
+	size_t size;
+
+public:
+	RC433HQCaptureFile();
+	~RC433HQCaptureFile();
+
+	bool Open(const char *fileName);
+	void Close();
+
+	// reader of the mapped data, valid until the file is closed
+	RC433HQCaptureReader GetReader() const { return RC433HQCaptureReader(data, size); }
+
+	size_t GetSize() const { return size; }
+};
@@ -0,0 +1,337 @@
+#include "rc433hq_classify.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   define RC433HQ_CLASSIFIER_X86
+#   include <immintrin.h>
+#endif
+
+// the longest duration stored in the batch
+static const unsigned long BATCH_MAX_DURATION_US = 0x7fffffffUL;
+
+// indexes of the windows
+enum {
+    WINDOW_SYNC_FIRST, WINDOW_SYNC_SECOND, WINDOW_ZERO_FIRST, WINDOW_ZERO_SECOND, WINDOW_ONE_FIRST, WINDOW_ONE_SECOND
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPulseBatch implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+void RC433HQPulseBatch::Clear()
+{
+    highDurations.clear();
+    lowDurations.clear();
+    times.clear();
+    kinds.clear();
+}
+
+void RC433HQPulseBatch::Add(byte kind, RC433HQMicrosecondsDiff highDuration, RC433HQMicrosecondsDiff lowDuration, RC433HQMicroseconds time)
+{
+    unsigned long high = highDuration.GetUnsignedLong();
+    unsigned long low = lowDuration.GetUnsignedLong();
+
+    highDurations.push_back(int32_t((high < BATCH_MAX_DURATION_US)? high: BATCH_MAX_DURATION_US));
+    lowDurations.push_back(int32_t((low < BATCH_MAX_DURATION_US)? low: BATCH_MAX_DURATION_US));
+    times.push_back(time);
+    kinds.push_back(kind);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPulseBatchCollector implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+void RC433HQPulseBatchCollector::HandleEdge(RC433HQMicroseconds time, bool direction)
+{
+    if (direction) {
+
+        // the pulse is complete at the next rising edge
+        if (previousRisingEdge && previousFallingEdge) {
+            batch.Add(RC433HQ_BATCH_PULSE, previousFallingEdgeTime - previousRisingEdgeTime, time - previousFallingEdgeTime, previousRisingEdgeTime);
+        } else if (previousRisingEdge) {
+            batch.Add(RC433HQ_BATCH_BROKEN, 0, 0, previousRisingEdgeTime);
+        }
+
+        previousRisingEdge = true;
+        previousFallingEdge = false;
+        previousRisingEdgeTime = time;
+
+    } else {
+
+        previousFallingEdge = true;
+        previousFallingEdgeTime = time;
+    }
+}
+
+void RC433HQPulseBatchCollector::HandleMissedEdges()
+{
+    // the decoder keeps the previous edges over the missed edges, so does the collector
+    batch.Add(RC433HQ_BATCH_MISSED, 0, 0, RC433HQMicroseconds());
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// Classification kernels
+//////////////////////////////////////////////////////////////////////////////////
+
+static bool IsInWindow(const RC433HQPulseClassifier::Windows &windows, int window, int32_t duration)
+{
+    return (windows.lowerBounds[window] <= duration) && (duration <= windows.upperBounds[window]);
+}
+
+static byte ClassifyPulse(const RC433HQPulseClassifier::Windows &windows, int32_t highDuration, int32_t lowDuration)
+{
+    byte symbol = 0;
+    if (IsInWindow(windows, WINDOW_ONE_FIRST, highDuration) && IsInWindow(windows, WINDOW_ONE_SECOND, lowDuration)) {
+        symbol |= RC433HQ_SYMBOL_ONE;
+    }
+    if (IsInWindow(windows, WINDOW_ZERO_FIRST, highDuration) && IsInWindow(windows, WINDOW_ZERO_SECOND, lowDuration)) {
+        symbol |= RC433HQ_SYMBOL_ZERO;
+    }
+    if (IsInWindow(windows, WINDOW_SYNC_FIRST, highDuration) && IsInWindow(windows, WINDOW_SYNC_SECOND, lowDuration)) {
+        symbol |= RC433HQ_SYMBOL_SYNC;
+    }
+    return symbol;
+}
+
+static void ClassifyScalar(const RC433HQPulseClassifier::Windows &windows, const int32_t *highDurations, const int32_t *lowDurations, size_t count, byte *symbols)
+{
+    for (size_t i = 0; i < count; i++) {
+        symbols[i] = ClassifyPulse(windows, highDurations[i], lowDurations[i]);
+    }
+}
+
+#if defined(RC433HQ_CLASSIFIER_X86)
+
+// spreads the bits of the lane mask into the lowest bits of the bytes (bit i into byte i)
+class LaneMaskSpreader {
+public:
+    uint64_t table[256];
+
+    LaneMaskSpreader()
+    {
+        for (unsigned mask = 0; mask < 256; mask++) {
+            table[mask] = 0;
+            for (unsigned bit = 0; bit < 8; bit++) {
+                if (mask & (1 << bit)) {
+                    table[mask] |= uint64_t(1) << (8 * bit);
+                }
+            }
+        }
+    }
+};
+
+static const LaneMaskSpreader laneMaskSpreader;
+
+__attribute__((target("sse2")))
+static inline __m128i OutsideWindowSse2(__m128i durations, __m128i lowerBound, __m128i upperBound)
+{
+    return _mm_or_si128(_mm_cmpgt_epi32(lowerBound, durations), _mm_cmpgt_epi32(durations, upperBound));
+}
+
+__attribute__((target("sse2")))
+static void ClassifySse2(const RC433HQPulseClassifier::Windows &windows, const int32_t *highDurations, const int32_t *lowDurations, size_t count, byte *symbols)
+{
+    __m128i lowerBounds[6], upperBounds[6];
+    for (int i = 0; i < 6; i++) {
+        lowerBounds[i] = _mm_set1_epi32(windows.lowerBounds[i]);
+        upperBounds[i] = _mm_set1_epi32(windows.upperBounds[i]);
+    }
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+
+        __m128i high = _mm_loadu_si128((const __m128i *)(highDurations + i));
+        __m128i low = _mm_loadu_si128((const __m128i *)(lowDurations + i));
+
+        // lanes of the pulses outside the windows of the symbol
+        __m128i notOne = _mm_or_si128(OutsideWindowSse2(high, lowerBounds[WINDOW_ONE_FIRST], upperBounds[WINDOW_ONE_FIRST]),
+                                      OutsideWindowSse2(low, lowerBounds[WINDOW_ONE_SECOND], upperBounds[WINDOW_ONE_SECOND]));
+        __m128i notZero = _mm_or_si128(OutsideWindowSse2(high, lowerBounds[WINDOW_ZERO_FIRST], upperBounds[WINDOW_ZERO_FIRST]),
+                                       OutsideWindowSse2(low, lowerBounds[WINDOW_ZERO_SECOND], upperBounds[WINDOW_ZERO_SECOND]));
+        __m128i notSync = _mm_or_si128(OutsideWindowSse2(high, lowerBounds[WINDOW_SYNC_FIRST], upperBounds[WINDOW_SYNC_FIRST]),
+                                       OutsideWindowSse2(low, lowerBounds[WINDOW_SYNC_SECOND], upperBounds[WINDOW_SYNC_SECOND]));
+
+        unsigned one = ~unsigned(_mm_movemask_ps(_mm_castsi128_ps(notOne))) & 0x0f;
+        unsigned zero = ~unsigned(_mm_movemask_ps(_mm_castsi128_ps(notZero))) & 0x0f;
+        unsigned sync = ~unsigned(_mm_movemask_ps(_mm_castsi128_ps(notSync))) & 0x0f;
+
+        uint32_t packed = uint32_t(laneMaskSpreader.table[one] * RC433HQ_SYMBOL_ONE | laneMaskSpreader.table[zero] * RC433HQ_SYMBOL_ZERO |
+                                   laneMaskSpreader.table[sync] * RC433HQ_SYMBOL_SYNC);
+        memcpy(symbols + i, &packed, sizeof(packed));
+    }
+
+    ClassifyScalar(windows, highDurations + i, lowDurations + i, count - i, symbols + i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i OutsideWindowAvx2(__m256i durations, __m256i lowerBound, __m256i upperBound)
+{
+    return _mm256_or_si256(_mm256_cmpgt_epi32(lowerBound, durations), _mm256_cmpgt_epi32(durations, upperBound));
+}
+
+__attribute__((target("avx2")))
+static void ClassifyAvx2(const RC433HQPulseClassifier::Windows &windows, const int32_t *highDurations, const int32_t *lowDurations, size_t count, byte *symbols)
+{
+    __m256i lowerBounds[6], upperBounds[6];
+    for (int i = 0; i < 6; i++) {
+        lowerBounds[i] = _mm256_set1_epi32(windows.lowerBounds[i]);
+        upperBounds[i] = _mm256_set1_epi32(windows.upperBounds[i]);
+    }
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+
+        __m256i high = _mm256_loadu_si256((const __m256i *)(highDurations + i));
+        __m256i low = _mm256_loadu_si256((const __m256i *)(lowDurations + i));
+
+        // lanes of the pulses outside the windows of the symbol
+        __m256i notOne = _mm256_or_si256(OutsideWindowAvx2(high, lowerBounds[WINDOW_ONE_FIRST], upperBounds[WINDOW_ONE_FIRST]),
+                                         OutsideWindowAvx2(low, lowerBounds[WINDOW_ONE_SECOND], upperBounds[WINDOW_ONE_SECOND]));
+        __m256i notZero = _mm256_or_si256(OutsideWindowAvx2(high, lowerBounds[WINDOW_ZERO_FIRST], upperBounds[WINDOW_ZERO_FIRST]),
+                                          OutsideWindowAvx2(low, lowerBounds[WINDOW_ZERO_SECOND], upperBounds[WINDOW_ZERO_SECOND]));
+        __m256i notSync = _mm256_or_si256(OutsideWindowAvx2(high, lowerBounds[WINDOW_SYNC_FIRST], upperBounds[WINDOW_SYNC_FIRST]),
+                                          OutsideWindowAvx2(low, lowerBounds[WINDOW_SYNC_SECOND], upperBounds[WINDOW_SYNC_SECOND]));
+
+        unsigned one = ~unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(notOne))) & 0xff;
+        unsigned zero = ~unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(notZero))) & 0xff;
+        unsigned sync = ~unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(notSync))) & 0xff;
+
+        uint64_t packed = laneMaskSpreader.table[one] * RC433HQ_SYMBOL_ONE | laneMaskSpreader.table[zero] * RC433HQ_SYMBOL_ZERO |
+                          laneMaskSpreader.table[sync] * RC433HQ_SYMBOL_SYNC;
+        memcpy(symbols + i, &packed, sizeof(packed));
+    }
+
+    ClassifyScalar(windows, highDurations + i, lowDurations + i, count - i, symbols + i);
+}
+
+#endif  // defined(RC433HQ_CLASSIFIER_X86)
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPulseClassifier implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQPulseClassifier::RC433HQPulseClassifier():
+    kernel(RC433HQ_CLASSIFIER_SCALAR),
+    kernelFunction(ClassifyScalar)
+{
+    if (!SetKernel(RC433HQ_CLASSIFIER_AVX2)) {
+        SetKernel(RC433HQ_CLASSIFIER_SSE2);
+    }
+}
+
+size_t RC433HQPulseClassifier::AddProtocol(const RC433HQSyncPulseTiming &timing)
+{
+    const word centers[6] = {
+        timing.syncFirstUs, timing.syncSecondUs, timing.zeroFirstUs, timing.zeroSecondUs, timing.oneFirstUs, timing.oneSecondUs
+    };
+
+    // EqualWithTolerance() compares (duration - tolerance) <= center in the unsigned arithmetic, so the durations below
+    // the tolerance never match
+    Windows windows;
+    for (int i = 0; i < 6; i++) {
+        int32_t lowerBound = int32_t(centers[i]) - int32_t(timing.toleranceUs);
+        windows.lowerBounds[i] = (lowerBound > int32_t(timing.toleranceUs))? lowerBound: int32_t(timing.toleranceUs);
+        windows.upperBounds[i] = int32_t(centers[i]) + int32_t(timing.toleranceUs);
+    }
+
+    protocols.push_back(windows);
+    return protocols.size() - 1;
+}
+
+bool RC433HQPulseClassifier::IsKernelSupported(RC433HQClassifierKernel kernel)
+{
+    switch (kernel) {
+    case RC433HQ_CLASSIFIER_SCALAR:
+        return true;
+#if defined(RC433HQ_CLASSIFIER_X86)
+    case RC433HQ_CLASSIFIER_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case RC433HQ_CLASSIFIER_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif  // defined(RC433HQ_CLASSIFIER_X86)
+    default:
+        return false;
+    }
+}
+
+const char *RC433HQPulseClassifier::GetKernelName(RC433HQClassifierKernel kernel)
+{
+    switch (kernel) {
+    case RC433HQ_CLASSIFIER_SSE2:
+        return "sse2";
+    case RC433HQ_CLASSIFIER_AVX2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+bool RC433HQPulseClassifier::SetKernel(RC433HQClassifierKernel akernel)
+{
+    if (!IsKernelSupported(akernel)) {
+        return false;
+    }
+
+    kernel = akernel;
+    switch (kernel) {
+#if defined(RC433HQ_CLASSIFIER_X86)
+    case RC433HQ_CLASSIFIER_SSE2:
+        kernelFunction = ClassifySse2;
+        break;
+    case RC433HQ_CLASSIFIER_AVX2:
+        kernelFunction = ClassifyAvx2;
+        break;
+#endif  // defined(RC433HQ_CLASSIFIER_X86)
+    default:
+        kernelFunction = ClassifyScalar;
+        break;
+    }
+    return true;
+}
+
+void RC433HQPulseClassifier::Classify(const int32_t *highDurations, const int32_t *lowDurations, size_t count, byte *symbols) const
+{
+    for (size_t p = 0; p < protocols.size(); p++) {
+        kernelFunction(protocols[p], highDurations, lowDurations, count, symbols + p * count);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQBatchDecoder implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+void RC433HQBatchDecoder::AddDecoder(RC433HQBasicSyncPulseDecoder &decoder)
+{
+    classifier.AddProtocol(decoder.GetTiming());
+    decoders.push_back(&decoder);
+}
+
+void RC433HQBatchDecoder::Decode(const RC433HQPulseBatch &batch)
+{
+    size_t count = batch.GetSize();
+    if (count == 0) {
+        return;
+    }
+
+    symbols.resize(count * decoders.size());
+    classifier.Classify(&batch.highDurations[0], &batch.lowDurations[0], count, &symbols[0]);
+
+    for (size_t p = 0; p < decoders.size(); p++) {
+
+        RC433HQBasicSyncPulseDecoder &decoder = *decoders[p];
+        const byte *decoderSymbols = &symbols[p * count];
+
+        for (size_t i = 0; i < count; i++) {
+
+            if (batch.kinds[i] == RC433HQ_BATCH_MISSED) {
+                decoder.HandleMissedEdges();
+            } else if (batch.kinds[i] == RC433HQ_BATCH_BROKEN) {
+                decoder.HandleBrokenPulse();
+            } else if (decoder.IsSyncDetected() || (decoderSymbols[i] & RC433HQ_SYMBOL_SYNC)) {
+                // out of sync (and so without any received bits) the other pulses do not change the decoder
+                decoder.HandlePulse(batch.times[i], (unsigned long)batch.highDurations[i], (unsigned long)batch.lowDurations[i], decoderSymbols[i]);
+            }
+        }
+    }
+}
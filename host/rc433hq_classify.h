@@ -0,0 +1,146 @@
+#pragma once
+
+// Host only (Linux) part of the library: batch decoding of the sync pulse protocols for the bulk (offline or gateway)
+// processing. The edges are collected into arrays of the pulse durations (structure of arrays), all the pulses are
+// classified against the timing windows of several protocols at once by a vectorized kernel (AVX2, SSE2 or scalar,
+// selected at runtime by the CPU detection) and the symbol codes are passed to the pulse step of the decoders
+// (RC433HQBasicSyncPulseDecoder::HandlePulse()), so the frames are identical to the frames decoded from the edges.
+
+#include "../rc433hq.h"
+
+#include <vector>
+
+/**
+  @file rc433hq_classify.h
+*/
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPulseBatch declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// kinds of the batch entries
+static const byte RC433HQ_BATCH_PULSE = 0;      // complete pulse (high followed by low level)
+static const byte RC433HQ_BATCH_BROKEN = 1;     // the falling edge between two rising edges was lost
+static const byte RC433HQ_BATCH_MISSED = 2;     // some edges were missed, durations and time are not used
+
+/** \brief Pulses of the received signal in the structure of arrays layout (the durations are clamped to 31 bits)
+ */
+struct RC433HQPulseBatch {
+	std::vector<int32_t> highDurations;
+	std::vector<int32_t> lowDurations;
+	std::vector<RC433HQMicroseconds> times;     // time of the rising edge of the pulse
+	std::vector<byte> kinds;
+
+	size_t GetSize() const { return kinds.size(); }
+
+	void Clear();
+	void Add(byte kind, RC433HQMicrosecondsDiff highDuration, RC433HQMicrosecondsDiff lowDuration, RC433HQMicroseconds time);
+};
+
+/** \brief Collects the edges into the pulse batch the same way as RC433HQBasicSyncPulseDecoder pairs them (the pulse
+    is complete at the next rising edge)
+ */
+class RC433HQPulseBatchCollector: public IRC433PulseProcessor {
+private:
+	RC433HQPulseBatch &batch;
+	bool previousRisingEdge;
+	RC433HQMicroseconds previousRisingEdgeTime;
+	bool previousFallingEdge;
+	RC433HQMicroseconds previousFallingEdgeTime;
+
+public:
+	RC433HQPulseBatchCollector(RC433HQPulseBatch &abatch):
+		batch(abatch),
+		previousRisingEdge(false),
+		previousFallingEdge(false)
+	{
+	}
+
+	virtual void HandleEdge(RC433HQMicroseconds time, bool direction);
+	virtual void HandleMissedEdges();
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPulseClassifier declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// implementations of the classification kernel
+enum RC433HQClassifierKernel {
+	RC433HQ_CLASSIFIER_SCALAR,
+	RC433HQ_CLASSIFIER_SSE2,
+	RC433HQ_CLASSIFIER_AVX2
+};
+
+/** \brief Classifies the pulse durations against the timing windows of several protocols
+ */
+class RC433HQPulseClassifier {
+public:
+	// inclusive duration windows of one protocol, the same results as EqualWithTolerance()
+	struct Windows {
+		int32_t lowerBounds[6];  // sync first, sync second, zero first, zero second, one first, one second
+		int32_t upperBounds[6];
+	};
+
+	typedef void (*KernelFunction)(const Windows &windows, const int32_t *highDurations, const int32_t *lowDurations, size_t count, byte *symbols);
+
+private:
+	std::vector<Windows> protocols;
+	RC433HQClassifierKernel kernel;
+	KernelFunction kernelFunction;
+
+public:
+	// selects the best kernel supported by the CPU
+	RC433HQPulseClassifier();
+
+	// returns the protocol index
+	size_t AddProtocol(const RC433HQSyncPulseTiming &timing);
+
+	size_t GetProtocolsCount() const { return protocols.size(); }
+
+	RC433HQClassifierKernel GetKernel() const { return kernel; }
+
+	// returns false if the kernel is not supported by the CPU
+	bool SetKernel(RC433HQClassifierKernel akernel);
+
+	static bool IsKernelSupported(RC433HQClassifierKernel kernel);
+	static const char *GetKernelName(RC433HQClassifierKernel kernel);
+
+	// classify the pulses, the symbols of the protocol p are stored at symbols[p * count ... p * count + count - 1]
+	void Classify(const int32_t *highDurations, const int32_t *lowDurations, size_t count, byte *symbols) const;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQBatchDecoder declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Decodes the pulse batches by the classifier followed by the pulse steps of the decoders. The decoders keep all
+    their settings (time extender, soft decision, validator, frame queue, metrics), but receive no edges (no HandleEdge()),
+    so the early delivery happens at the end of the last pulse. The frames of one batch are delivered decoder by decoder
+    (not interleaved in time as by the splitter).
+    Usage:
+       RC433HQPulseBatch batch;
+       RC433HQPulseBatchCollector collector(batch);
+       RC433HQEmosSocketsPulseDecoderA decoderA(receiverA);
+       RC433HQBatchDecoder decoder;
+       decoder.AddDecoder(decoderA);
+       ... pass the edges into the collector (e.g. behind the noise filter)
+       decoder.Decode(batch);
+       batch.Clear();
+ */
+class RC433HQBatchDecoder {
+private:
+	RC433HQPulseClassifier classifier;
+	std::vector<RC433HQBasicSyncPulseDecoder *> decoders;
+	std::vector<byte> symbols;
+
+public:
+	// the pulses are classified by the timing of the decoder
+	void AddDecoder(RC433HQBasicSyncPulseDecoder &decoder);
+
+	RC433HQPulseClassifier &GetClassifier() { return classifier; }
+
+	void Decode(const RC433HQPulseBatch &batch);
+};
@@ -0,0 +1,519 @@
+#include "rc433hq_journal.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameJournal format implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+static const size_t JOURNAL_HASHED_SIZE = RC433HQ_JOURNAL_RECORD_SIZE - 4;
+
+static void WriteWord(byte *data, word value)
+{
+    data[0] = byte(value);
+    data[1] = byte(value >> 8);
+}
+
+static void WriteUint32(byte *data, uint32_t value)
+{
+    WriteWord(data, word(value));
+    WriteWord(data + 2, word(value >> 16));
+}
+
+static word ReadWord(const byte *data)
+{
+    return word(data[0] | (word(data[1]) << 8));
+}
+
+static uint32_t ReadUint32(const byte *data)
+{
+    return uint32_t(ReadWord(data)) | (uint32_t(ReadWord(data + 2)) << 16);
+}
+
+static uint64_t ReadUint64(const byte *data)
+{
+    return uint64_t(ReadUint32(data)) | (uint64_t(ReadUint32(data + 4)) << 32);
+}
+
+static uint32_t HashRecord(const byte *record)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < JOURNAL_HASHED_SIZE; i++) {
+        hash = (hash ^ record[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+static bool IsRecordValid(const byte *record)
+{
+    return ReadUint32(record + JOURNAL_HASHED_SIZE) == HashRecord(record);
+}
+
+static double GetSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return double(now.tv_sec) + double(now.tv_nsec) * 1e-9;
+}
+
+bool RC433HQGetJournalSegmentName(const char *prefix, unsigned long segment, char *fileName, size_t fileNameSize)
+{
+    int length = snprintf(fileName, fileNameSize, "%s.%06lu.rqfj", prefix, segment);
+    return (length > 0) && (size_t(length) < fileNameSize);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameJournalWriter implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQFrameJournalWriter::RC433HQFrameJournalWriter():
+    prefix(0),
+    fd(-1),
+    segment(0),
+    segmentRecords(0),
+    block(0),
+    blockRecords(0),
+    failed(false),
+    recordsCount(0),
+    segmentsCount(0),
+    syncsCount(0),
+    lastSyncSeconds(0),
+    unsynced(false)
+{
+}
+
+RC433HQFrameJournalWriter::~RC433HQFrameJournalWriter()
+{
+    Close();
+}
+
+bool RC433HQFrameJournalWriter::Open(const char *aprefix, const RC433HQFrameJournalOptions &aoptions)
+{
+    Close();
+
+    options = aoptions;
+    if (options.blockRecords == 0) {
+        options.blockRecords = 1;
+    }
+    if (options.segmentRecords == 0) {
+        options.segmentRecords = 1;
+    }
+
+    prefix = new char[strlen(aprefix) + 1];
+    strcpy(prefix, aprefix);
+    block = new byte[options.blockRecords * RC433HQ_JOURNAL_RECORD_SIZE];
+    blockRecords = 0;
+    failed = false;
+    recordsCount = 0;
+    segmentsCount = 0;
+    syncsCount = 0;
+
+    // the new segment follows the existing ones
+    char fileName[4096];
+    for (segment = 0; RC433HQGetJournalSegmentName(prefix, segment, fileName, sizeof(fileName)) && (access(fileName, F_OK) == 0); segment++) {
+    }
+
+    if (!OpenSegment()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void RC433HQFrameJournalWriter::Close()
+{
+    if (fd >= 0) {
+        CloseSegment();
+    }
+    delete [] block; block = 0;
+    delete [] prefix; prefix = 0;
+}
+
+bool RC433HQFrameJournalWriter::OpenSegment()
+{
+    char fileName[4096];
+    if (!RC433HQGetJournalSegmentName(prefix, segment, fileName, sizeof(fileName))) {
+        return false;
+    }
+
+    // never overwrite an existing segment
+    fd = open(fileName, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    // the header is buffered as the first block data
+    byte *header = block;
+    memset(header, 0, RC433HQ_JOURNAL_HEADER_SIZE);
+    memcpy(header, RC433HQ_JOURNAL_MAGIC, sizeof(RC433HQ_JOURNAL_MAGIC));
+    WriteWord(header + 4, RC433HQ_JOURNAL_VERSION);
+    WriteWord(header + 6, word(RC433HQ_JOURNAL_HEADER_SIZE));
+    WriteWord(header + 8, word(RC433HQ_JOURNAL_RECORD_SIZE));
+    WriteUint32(header + 12, uint32_t(segment));
+    ssize_t written = write(fd, header, RC433HQ_JOURNAL_HEADER_SIZE);
+    if (written != ssize_t(RC433HQ_JOURNAL_HEADER_SIZE)) {
+        // do not leave the segment without the header behind
+        close(fd);
+        fd = -1;
+        unlink(fileName);
+        return false;
+    }
+
+    segmentRecords = 0;
+    segmentsCount++;
+    unsynced = true;
+    lastSyncSeconds = GetSeconds();
+    return true;
+}
+
+void RC433HQFrameJournalWriter::CloseSegment()
+{
+    WriteBlock();
+    Sync();
+    close(fd);
+    fd = -1;
+}
+
+bool RC433HQFrameJournalWriter::WriteBlock()
+{
+    // write the whole block, the write might be split by a signal
+    size_t size = blockRecords * RC433HQ_JOURNAL_RECORD_SIZE;
+    size_t offset = 0;
+    while (offset < size) {
+        ssize_t written = write(fd, block + offset, size - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed = true;
+            return false;
+        }
+        offset += size_t(written);
+    }
+
+    if (blockRecords > 0) {
+        unsynced = true;
+    }
+    blockRecords = 0;
+    return true;
+}
+
+bool RC433HQFrameJournalWriter::Sync()
+{
+    if (!unsynced) {
+        return true;
+    }
+    if (fdatasync(fd) != 0) {
+        failed = true;
+        return false;
+    }
+    unsynced = false;
+    syncsCount++;
+    lastSyncSeconds = GetSeconds();
+    return true;
+}
+
+bool RC433HQFrameJournalWriter::Append(RC433HQExtendedMicroseconds time, byte protocol, const byte *data, size_t bits, double quality)
+{
+    if ((fd < 0) || failed) {
+        return false;
+    }
+
+    // encode the record into the block
+    byte *record = block + blockRecords * RC433HQ_JOURNAL_RECORD_SIZE;
+    uint64_t us = time.GetUnsignedLongLong();
+    WriteUint32(record, uint32_t(us));
+    WriteUint32(record + 4, uint32_t(us >> 32));
+    if (bits > RC433HQ_MAX_PULSE_BITS) {
+        bits = RC433HQ_MAX_PULSE_BITS;
+    }
+    record[8] = protocol;
+    record[9] = byte(bits);
+    WriteWord(record + 10, ((quality <= 0.0)? 0: ((quality >= 100.0)? 10000: word(quality * 100.0 + 0.5))));
+    memset(record + 12, 0, RC433HQ_JOURNAL_DATA_SIZE);
+    memcpy(record + 12, data, (bits + 7) / 8);
+    WriteUint32(record + JOURNAL_HASHED_SIZE, HashRecord(record));
+    blockRecords++;
+    segmentRecords++;
+    recordsCount++;
+
+    // the full segment is closed (with a sync) and the next one is started
+    if (segmentRecords == options.segmentRecords) {
+        CloseSegment();
+        segment++;
+        if (failed || !OpenSegment()) {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    // the full block is written, the partial one only if the last sync is older than the interval (rare frames), the
+    // written records are synced if the last sync is older than the interval
+    bool syncDue = IsSyncDue();
+    if ((blockRecords == options.blockRecords) || (syncDue && (options.syncIntervalMs > 0))) {
+        if (!WriteBlock()) {
+            return false;
+        }
+        if (syncDue) {
+            return Sync();
+        }
+    }
+    return true;
+}
+
+bool RC433HQFrameJournalWriter::Update()
+{
+    if ((fd < 0) || failed) {
+        return false;
+    }
+    // without the interval the full blocks are already synced by Append()
+    if ((options.syncIntervalMs == 0) || !IsSyncDue() || ((blockRecords == 0) && !unsynced)) {
+        return true;
+    }
+    return WriteBlock() && Sync();
+}
+
+bool RC433HQFrameJournalWriter::IsSyncDue() const
+{
+    return (GetSeconds() - lastSyncSeconds) * 1000.0 >= double(options.syncIntervalMs);
+}
+
+bool RC433HQFrameJournalWriter::Flush()
+{
+    if ((fd < 0) || failed) {
+        return false;
+    }
+    return WriteBlock() && Sync();
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameJournalSegment implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQFrameJournalSegment::RC433HQFrameJournalSegment():
+    fd(-1),
+    data(0),
+    size(0),
+    recordsCount(0)
+{
+}
+
+RC433HQFrameJournalSegment::~RC433HQFrameJournalSegment()
+{
+    Close();
+}
+
+bool RC433HQFrameJournalSegment::Open(const char *fileName)
+{
+    Close();
+
+    fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if ((fstat(fd, &fileStat) != 0) || (size_t(fileStat.st_size) < RC433HQ_JOURNAL_HEADER_SIZE)) {
+        Close();
+        return false;
+    }
+
+    void *mapping = mmap(0, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    data = static_cast<const byte *>(mapping);
+    size = size_t(fileStat.st_size);
+
+    // check the header
+    if ((memcmp(data, RC433HQ_JOURNAL_MAGIC, sizeof(RC433HQ_JOURNAL_MAGIC)) != 0) || (ReadWord(data + 4) != RC433HQ_JOURNAL_VERSION) ||
+        (ReadWord(data + 6) != RC433HQ_JOURNAL_HEADER_SIZE) || (ReadWord(data + 8) != RC433HQ_JOURNAL_RECORD_SIZE)) {
+        Close();
+        return false;
+    }
+
+    // ignore the incomplete and invalid records at the end (interrupted write)
+    recordsCount = (size - RC433HQ_JOURNAL_HEADER_SIZE) / RC433HQ_JOURNAL_RECORD_SIZE;
+    while ((recordsCount > 0) && !IsRecordValid(GetRecordData(recordsCount - 1))) {
+        recordsCount--;
+    }
+
+    // the sparse index touches only one record of every stride
+    index.clear();
+    for (size_t record = 0; record < recordsCount; record += INDEX_STRIDE) {
+        index.push_back(ReadUint64(GetRecordData(record)));
+    }
+
+    // the records are read sequentially, except of the index lookups
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void RC433HQFrameJournalSegment::Close()
+{
+    if (data) {
+        munmap(const_cast<byte *>(data), size);
+        data = 0;
+        size = 0;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    recordsCount = 0;
+    index.clear();
+}
+
+bool RC433HQFrameJournalSegment::ReadRecord(size_t record, RC433HQJournalRecord &journalRecord) const
+{
+    if (record >= recordsCount) {
+        return false;
+    }
+
+    const byte *recordData = GetRecordData(record);
+    if (!IsRecordValid(recordData)) {
+        return false;
+    }
+
+    journalRecord.time = RC433HQExtendedMicroseconds(ReadUint64(recordData));
+    journalRecord.protocol = recordData[8];
+    journalRecord.bits = recordData[9];
+    journalRecord.quality = ReadWord(recordData + 10) / 100.0;
+    memcpy(journalRecord.data, recordData + 12, RC433HQ_JOURNAL_DATA_SIZE);
+    return true;
+}
+
+RC433HQExtendedMicroseconds RC433HQFrameJournalSegment::GetRecordTime(size_t record) const
+{
+    return RC433HQExtendedMicroseconds(ReadUint64(GetRecordData(record)));
+}
+
+size_t RC433HQFrameJournalSegment::FindRecord(RC433HQExtendedMicroseconds time) const
+{
+    // the first indexed record at or after the time, the searched one is in the stride before it
+    size_t stride = std::lower_bound(index.begin(), index.end(), time.GetUnsignedLongLong()) - index.begin();
+    if (stride == 0) {
+        return 0;
+    }
+
+    size_t record = (stride - 1) * INDEX_STRIDE;
+    size_t end = stride * INDEX_STRIDE;
+    if (end > recordsCount) {
+        end = recordsCount;
+    }
+    while ((record < end) && (GetRecordTime(record) < time)) {
+        record++;
+    }
+    return record;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameJournalReader implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQFrameJournalReader::RC433HQFrameJournalReader():
+    invalidRecordsCount(0),
+    invalidSegmentsCount(0)
+{
+}
+
+RC433HQFrameJournalReader::~RC433HQFrameJournalReader()
+{
+    Close();
+}
+
+bool RC433HQFrameJournalReader::Open(const char *prefix)
+{
+    Close();
+
+    char fileName[4096];
+    for (unsigned long segment = 0; RC433HQGetJournalSegmentName(prefix, segment, fileName, sizeof(fileName)) && (access(fileName, F_OK) == 0); segment++) {
+        // the segment without the valid header (e.g. the writer crashed before writing it) is skipped, the writer
+        // continues after it as well
+        RC433HQFrameJournalSegment *journalSegment = new RC433HQFrameJournalSegment();
+        if (!journalSegment->Open(fileName)) {
+            delete journalSegment;
+            invalidSegmentsCount++;
+            continue;
+        }
+        segments.push_back(journalSegment);
+    }
+    return !segments.empty();
+}
+
+void RC433HQFrameJournalReader::Close()
+{
+    for (size_t i = 0; i < segments.size(); i++) {
+        delete segments[i];
+    }
+    segments.clear();
+    invalidRecordsCount = 0;
+    invalidSegmentsCount = 0;
+}
+
+unsigned long long RC433HQFrameJournalReader::GetRecordsCount() const
+{
+    unsigned long long count = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        count += segments[i]->GetRecordsCount();
+    }
+    return count;
+}
+
+unsigned long long RC433HQFrameJournalReader::Scan(IRC433JournalRecordHandler &handler)
+{
+    unsigned long long count = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        count += ReadRange(*segments[i], 0, false, RC433HQExtendedMicroseconds(), handler);
+    }
+    return count;
+}
+
+unsigned long long RC433HQFrameJournalReader::Find(RC433HQExtendedMicroseconds begin, RC433HQExtendedMicroseconds end, IRC433JournalRecordHandler &handler)
+{
+    unsigned long long count = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        const RC433HQFrameJournalSegment &segment = *segments[i];
+        if (segment.GetRecordsCount() == 0) {
+            continue;
+        }
+
+        // the records of one segment are ordered by time, but a later segment can start earlier (the time extender
+        // starts over after the restart of the writer), so every segment out of the range is skipped
+        if ((segment.GetRecordTime(segment.GetRecordsCount() - 1) < begin) || (end <= segment.GetRecordTime(0))) {
+            continue;
+        }
+
+        count += ReadRange(segment, segment.FindRecord(begin), true, end, handler);
+    }
+    return count;
+}
+
+unsigned long long RC433HQFrameJournalReader::ReadRange(const RC433HQFrameJournalSegment &segment, size_t record, bool limited, RC433HQExtendedMicroseconds end, IRC433JournalRecordHandler &handler)
+{
+    unsigned long long count = 0;
+    RC433HQJournalRecord journalRecord;
+    for (; record < segment.GetRecordsCount(); record++) {
+        if (!segment.ReadRecord(record, journalRecord)) {
+            invalidRecordsCount++;
+            continue;
+        }
+        if (limited && (end <= journalRecord.time)) {
+            break;
+        }
+        handler.HandleRecord(journalRecord);
+        count++;
+    }
+    return count;
+}
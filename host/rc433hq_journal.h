@@ -0,0 +1,263 @@
+#pragma once
+
+// Host only (Linux) part of the library: append-only binary journal of the decoded frames, written in large blocks into
+// rotated segment files and read back from the memory-mapped segments.
+
+#include "../rc433hq.h"
+
+#include <vector>
+
+/**
+  @file rc433hq_journal.h
+*/
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameJournal format
+//////////////////////////////////////////////////////////////////////////////////
+
+// The frame journal is a sequence of segment files <prefix>.<6 digit segment number>.rqfj numbered from 0. Every segment
+// (all values little endian):
+//  - 32 bytes header: magic "RQFJ", word version (1), word header size (32), word record size (32), word reserved (0),
+//    32-bit segment number, 16 bytes reserved (0)
+//  - 32 bytes records: 64-bit time in microseconds, byte protocol, byte count of bits, word quality in 1/100,
+//    16 bytes of data (as stored by the decoder), 32-bit FNV-1a hash of the preceding 28 bytes of the record
+// The records are written in the order of the appends, the time search expects them ordered by time within a segment (as
+// delivered by the decoders of one receiver). Every Open() of the writer starts a new segment, so the segments of the runs
+// of the writer may go back in time (the epoch of the time extender starts over).
+static const byte RC433HQ_JOURNAL_MAGIC[4] = { 'R', 'Q', 'F', 'J' };
+static const word RC433HQ_JOURNAL_VERSION = 1;
+static const size_t RC433HQ_JOURNAL_HEADER_SIZE = 32;
+static const size_t RC433HQ_JOURNAL_RECORD_SIZE = 32;
+static const size_t RC433HQ_JOURNAL_DATA_SIZE = RC433HQ_MAX_PULSE_BITS / 8;
+
+// frame read from the journal
+struct RC433HQJournalRecord {
+	RC433HQExtendedMicroseconds time;
+	byte protocol;
+	byte bits;
+	double quality;
+	byte data[RC433HQ_JOURNAL_DATA_SIZE];
+};
+
+// file name of the journal segment, returns false if it does not fit into the buffer
+bool RC433HQGetJournalSegmentName(const char *prefix, unsigned long segment, char *fileName, size_t fileNameSize);
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameJournalWriter declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+struct RC433HQFrameJournalOptions {
+	size_t blockRecords;             // count of the records buffered before one write (2048 records are 64 KiB)
+	size_t segmentRecords;           // count of the records of one segment before the rotation to the next one
+	unsigned long syncIntervalMs;    // the records are written and synced to the disk at most this long after the last sync
+	                                 // (0 syncs after every full block, the partial block is written by Flush() only)
+
+	RC433HQFrameJournalOptions():
+		blockRecords(2048),
+		segmentRecords(1024 * 1024),
+		syncIntervalMs(1000)
+	{
+	}
+};
+
+/** \brief Appends the decoded frames as fixed size records into the journal. The records are collected in a block buffer,
+    which is written by one write() call when it is full. When the sync interval passed since the last sync, the block
+    (even a partial one) is written and synced (fdatasync) by the next Append() or Update(); Update() has to be called
+    regularly (e.g. from a timer of RC433HQEventLoop), otherwise the last frames before a silence stay in the memory. The
+    segment is also synced at the rotation and at Close(). A segment is rotated after segmentRecords records. Open()
+    always starts a new segment after the existing ones, so the journal is never rewritten. Not thread safe.
+    Usage:
+       RC433HQFrameJournalWriter journal;
+       journal.Open("/var/lib/gateway/frames");
+       RC433HQFrameJournalInput journalA(journal, PROTOCOL_A);
+       RC433HQEmosSocketsPulseDecoderA decoderA(journalA);
+       ... every second: journal.Update();
+ */
+class RC433HQFrameJournalWriter {
+private:
+	RC433HQFrameJournalOptions options;
+	char *prefix;
+	int fd;
+	unsigned long segment;
+	size_t segmentRecords;            // count of the records of the current segment (including the buffered ones)
+	byte *block;
+	size_t blockRecords;
+	bool failed;
+	unsigned long long recordsCount;
+	unsigned long segmentsCount;
+	unsigned long syncsCount;
+	double lastSyncSeconds;
+	bool unsynced;
+
+public:
+	RC433HQFrameJournalWriter();
+	~RC433HQFrameJournalWriter();
+
+	// start the new segment of the journal with the prefix, returns false if it cannot be created
+	bool Open(const char *aprefix, const RC433HQFrameJournalOptions &aoptions = RC433HQFrameJournalOptions());
+
+	// write the buffered records, sync and close the segment
+	void Close();
+
+	bool IsOpen() const { return fd >= 0; }
+
+	// true if a write or the rotation failed (the following records are dropped)
+	bool HasFailed() const { return failed; }
+
+	// append the frame, returns false if the journal is not open or has failed
+	bool Append(RC433HQExtendedMicroseconds time, byte protocol, const byte *data, size_t bits, double quality);
+
+	// append the frame taken from the RC433HQFrameQueue
+	bool Append(const RC433HQFrameView &frame)
+	{
+		return Append(frame.GetExtendedTime(), frame.GetProtocol(), frame.GetData(), frame.GetBits(), frame.GetQuality());
+	}
+
+	// write the buffered records and sync them to the disk
+	bool Flush();
+
+	// write and sync the buffered records if the sync interval passed, returns false if the journal is not open or has failed
+	bool Update();
+
+	unsigned long GetSegment() const { return segment; }
+	unsigned long long GetRecordsCount() const { return recordsCount; }
+	unsigned long GetSegmentsCount() const { return segmentsCount; }
+	unsigned long GetSyncsCount() const { return syncsCount; }
+
+private:
+	bool OpenSegment();
+	void CloseSegment();
+	bool WriteBlock();
+	bool Sync();
+	bool IsSyncDue() const;
+
+	RC433HQFrameJournalWriter(const RC433HQFrameJournalWriter &);
+	RC433HQFrameJournalWriter &operator=(const RC433HQFrameJournalWriter &);
+};
+
+/** \brief Data receiver appending the frames of one protocol into the journal
+ */
+class RC433HQFrameJournalInput: public IRC433DataReceiver {
+private:
+	RC433HQFrameJournalWriter &journal;
+	byte protocol;
+
+public:
+	RC433HQFrameJournalInput(RC433HQFrameJournalWriter &ajournal, byte aprotocol):
+		journal(ajournal),
+		protocol(aprotocol)
+	{
+	}
+
+	virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality)
+	{
+		HandleExtendedData(RC433HQExtendedMicroseconds(0, time), data, bits, quality);
+	}
+
+	virtual void HandleExtendedData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, double quality)
+	{
+		journal.Append(time, protocol, data, bits, quality);
+	}
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameJournalSegment declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Read-only memory mapping of one journal segment with a sparse index of the time of every INDEX_STRIDE-th record.
+    The records are validated by their hash when read; the incomplete or invalid records at the end of the segment
+    (interrupted write) are not counted.
+ */
+class RC433HQFrameJournalSegment {
+public:
+	static const size_t INDEX_STRIDE = 256;
+
+private:
+	int fd;
+	const byte *data;
+	size_t size;
+	size_t recordsCount;
+	std::vector<uint64_t> index;
+
+public:
+	RC433HQFrameJournalSegment();
+	~RC433HQFrameJournalSegment();
+
+	bool Open(const char *fileName);
+	void Close();
+
+	size_t GetRecordsCount() const { return recordsCount; }
+
+	// read the record, returns false if it is out of range or invalid
+	bool ReadRecord(size_t record, RC433HQJournalRecord &journalRecord) const;
+
+	// time of the record without its validation
+	RC433HQExtendedMicroseconds GetRecordTime(size_t record) const;
+
+	// the first record with the time at or after the time (GetRecordsCount() if there is none)
+	size_t FindRecord(RC433HQExtendedMicroseconds time) const;
+
+private:
+	const byte *GetRecordData(size_t record) const { return data + RC433HQ_JOURNAL_HEADER_SIZE + record * RC433HQ_JOURNAL_RECORD_SIZE; }
+
+	RC433HQFrameJournalSegment(const RC433HQFrameJournalSegment &);
+	RC433HQFrameJournalSegment &operator=(const RC433HQFrameJournalSegment &);
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameJournalReader declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// receives the records read from the journal
+class IRC433JournalRecordHandler {
+public:
+	virtual ~IRC433JournalRecordHandler() {}
+
+	virtual void HandleRecord(const RC433HQJournalRecord &record) = 0;
+};
+
+/** \brief Reads all the segments of the journal. Scan() passes all the valid records, Find() only those within the time
+    range: the segments out of the range are skipped by the time of their first and last records and the first record is
+    looked up by the sparse index, so only the records within the range (and at most one index stride before) are read.
+ */
+class RC433HQFrameJournalReader {
+private:
+	std::vector<RC433HQFrameJournalSegment *> segments;
+	unsigned long invalidRecordsCount;
+	unsigned long invalidSegmentsCount;
+
+public:
+	RC433HQFrameJournalReader();
+	~RC433HQFrameJournalReader();
+
+	// open the segments of the journal with the prefix (from the segment 0 up to the first missing one), the segments
+	// without the valid header are skipped. Returns false if there is no valid segment.
+	bool Open(const char *prefix);
+	void Close();
+
+	size_t GetSegmentsCount() const { return segments.size(); }
+	unsigned long long GetRecordsCount() const;
+
+	// count of the records skipped by Scan() and Find() because of the invalid hash
+	unsigned long GetInvalidRecordsCount() const { return invalidRecordsCount; }
+
+	// count of the segments skipped by Open() because of the missing or invalid header
+	unsigned long GetInvalidSegmentsCount() const { return invalidSegmentsCount; }
+
+	// pass all the records to the handler, returns their count
+	unsigned long long Scan(IRC433JournalRecordHandler &handler);
+
+	// pass the records with the time in the range [begin, end) to the handler, returns their count
+	unsigned long long Find(RC433HQExtendedMicroseconds begin, RC433HQExtendedMicroseconds end, IRC433JournalRecordHandler &handler);
+
+private:
+	// pass the valid records from the record up to the end of the segment (or the end time if limited)
+	unsigned long long ReadRange(const RC433HQFrameJournalSegment &segment, size_t record, bool limited, RC433HQExtendedMicroseconds end, IRC433JournalRecordHandler &handler);
+
+	RC433HQFrameJournalReader(const RC433HQFrameJournalReader &);
+	RC433HQFrameJournalReader &operator=(const RC433HQFrameJournalReader &);
+};
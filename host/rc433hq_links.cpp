@@ -0,0 +1,43 @@
+#include "rc433hq_links.h"
+
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQLinkQualityExport implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+static bool IsWeakerLink(const RC433HQLinkQuality &first, const RC433HQLinkQuality &second)
+{
+    if (first.quality != second.quality) {
+        return first.quality < second.quality;
+    }
+    return first.missRatio > second.missRatio;
+}
+
+void RC433HQGetWeakestLinks(const RC433HQLinkQualityTracker &tracker, std::vector<RC433HQLinkQuality> &links)
+{
+    // collect the links in the order of recency, the stable sort keeps it among the equally weak ones
+    links.clear();
+    RC433HQLinkQuality link;
+    for (size_t i = 0; tracker.GetLink(i, link); i++) {
+        links.push_back(link);
+    }
+    std::stable_sort(links.begin(), links.end(), IsWeakerLink);
+}
+
+bool RC433HQWriteLinkQualityCsv(const RC433HQLinkQualityTracker &tracker, FILE *file)
+{
+    std::vector<RC433HQLinkQuality> links;
+    RC433HQGetWeakestLinks(tracker, links);
+
+    bool ok = fprintf(file, "protocol,address,quality,first_seen_us,last_seen_us,frames,transmissions,frames_per_minute,period_ms,missed_transmissions,miss_ratio\n") > 0;
+    for (size_t i = 0; ok && (i < links.size()); i++) {
+        const RC433HQLinkQuality &link = links[i];
+        ok = fprintf(file, "%u,0x%lx,%.2f,%llu,%llu,%lu,%lu,%.3f,%lu,%lu,%.4f\n",
+            unsigned(link.protocol), (unsigned long)link.address, link.quality,
+            (unsigned long long)link.firstSeen.GetUnsignedLongLong(), (unsigned long long)link.lastSeen.GetUnsignedLongLong(),
+            link.framesCount, link.transmissionsCount, link.framesPerMinute, link.periodMs,
+            link.missedTransmissionsCount, link.missRatio) > 0;
+    }
+    return ok;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// Host only (Linux) part of the library: export of the link quality of the devices tracked by the
+// RC433HQLinkQualityTracker (e.g. for a gateway scheduling the retransmissions to the weak links).
+
+#include "../rc433hq.h"
+
+#include <stdio.h>
+#include <vector>
+
+/**
+  @file rc433hq_links.h
+*/
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQLinkQualityExport declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// all the tracked links ordered from the weakest one: by the quality, then by the miss ratio (higher first)
+void RC433HQGetWeakestLinks(const RC433HQLinkQualityTracker &tracker, std::vector<RC433HQLinkQuality> &links);
+
+// write all the tracked links as CSV with a header line, the weakest link first. Returns false if the writing failed.
+bool RC433HQWriteLinkQualityCsv(const RC433HQLinkQualityTracker &tracker, FILE *file);
@@ -0,0 +1,327 @@
+#include "rc433hq_live.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQLiveEdgeSource implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+static const size_t GPIO_V2_EVENT_SIZE = 48;
+static const uint32_t GPIO_V2_RISING_EDGE = 1;
+static const size_t COMPACT_EVENT_SIZE = 8;
+
+size_t RC433HQGetLiveEdgeSize(RC433HQLiveEdgeFormat format)
+{
+    return (format == RC433HQ_LIVE_EDGE_GPIO_V2)? GPIO_V2_EVENT_SIZE: COMPACT_EVENT_SIZE;
+}
+
+void RC433HQEncodeLiveEdge(RC433HQLiveEdgeFormat format, RC433HQMicroseconds time, bool direction, uint32_t sequence, byte *buffer)
+{
+    memset(buffer, 0, RC433HQGetLiveEdgeSize(format));
+    if (format == RC433HQ_LIVE_EDGE_GPIO_V2) {
+        uint64_t timestampNs = uint64_t(time.GetUnsignedLong()) * 1000;
+        uint32_t id = (direction? GPIO_V2_RISING_EDGE: 2);
+        memcpy(buffer, &timestampNs, 8);
+        memcpy(buffer + 8, &id, 4);
+        memcpy(buffer + 16, &sequence, 4);
+        memcpy(buffer + 20, &sequence, 4);
+    } else {
+        uint32_t us = time.GetUnsignedLong();
+        word shortSequence = word(sequence);
+        memcpy(buffer, &us, 4);
+        memcpy(buffer + 4, &shortSequence, 2);
+        buffer[6] = (direction? 1: 0);
+    }
+}
+
+RC433HQLiveEdgeSource::RC433HQLiveEdgeSource(IRC433PulseProcessor &aprocessor, int afd, RC433HQLiveEdgeFormat aformat):
+    processor(aprocessor),
+    fd(afd),
+    format(aformat),
+    edgeSize(RC433HQGetLiveEdgeSize(aformat)),
+    pendingBytes(0),
+    timeExtender(0),
+    receptionEnabled(true),
+    missedEdges(false),
+    sequenceValid(false),
+    lastSequence(0),
+    atEnd(false),
+    failed(false),
+    edgesCount(0),
+    missedEdgesCount(0),
+    readsCount(0)
+{
+    buffer = new byte[BATCH_EDGES * edgeSize];
+}
+
+RC433HQLiveEdgeSource::~RC433HQLiveEdgeSource()
+{
+    delete [] buffer; buffer = 0;
+}
+
+size_t RC433HQLiveEdgeSource::ReadEdges()
+{
+    size_t edges = 0;
+
+    for (size_t batch = 0; (batch < MAX_BATCHES_PER_CALL) && !atEnd; batch++) {
+
+        // read the next batch behind the incomplete event of the previous read
+        size_t requestedBytes = BATCH_EDGES * edgeSize - pendingBytes;
+        ssize_t readBytes = read(fd, buffer + pendingBytes, requestedBytes);
+        if (readBytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                failed = true;
+                atEnd = true;
+            }
+            break;
+        }
+        if (readBytes == 0) {
+            atEnd = true;
+            break;
+        }
+        readsCount++;
+
+        // pass the complete events, keep the incomplete one for the next read
+        size_t availableBytes = pendingBytes + size_t(readBytes);
+        size_t offset = 0;
+        for (; offset + edgeSize <= availableBytes; offset += edgeSize) {
+            HandleEvent(buffer + offset);
+            edges++;
+        }
+        pendingBytes = availableBytes - offset;
+        memmove(buffer, buffer + offset, pendingBytes);
+
+        // the short read means the descriptor is drained
+        if (size_t(readBytes) < requestedBytes) {
+            break;
+        }
+    }
+
+    return edges;
+}
+
+void RC433HQLiveEdgeSource::HandleEvent(const byte *event)
+{
+    // decode the event
+    uint32_t sequence;
+    RC433HQMicroseconds time;
+    bool direction;
+    if (format == RC433HQ_LIVE_EDGE_GPIO_V2) {
+        uint64_t timestampNs;
+        uint32_t id;
+        memcpy(&timestampNs, event, 8);
+        memcpy(&id, event + 8, 4);
+        memcpy(&sequence, event + 20, 4);
+        time = RC433HQMicroseconds(uint32_t(timestampNs / 1000));
+        direction = (id == GPIO_V2_RISING_EDGE);
+    } else {
+        uint32_t us;
+        word shortSequence;
+        memcpy(&us, event, 4);
+        memcpy(&shortSequence, event + 4, 2);
+        sequence = shortSequence;
+        time = RC433HQMicroseconds(us);
+        direction = (event[6] != 0);
+    }
+
+    // the gap of the sequence numbers means the events were lost
+    uint32_t sequenceMask = ((format == RC433HQ_LIVE_EDGE_GPIO_V2)? 0xffffffffUL: 0xffffUL);
+    if (sequenceValid && (sequence != ((lastSequence + 1) & sequenceMask))) {
+        missedEdges = true;
+    }
+    lastSequence = sequence;
+    sequenceValid = true;
+
+    if (!receptionEnabled) {
+        missedEdges = true;
+        return;
+    }
+
+    if (missedEdges) {
+        missedEdgesCount++;
+        processor.HandleMissedEdges();
+        missedEdges = false;
+    }
+
+    if (timeExtender) {
+        timeExtender->Update(time);
+    }
+    processor.HandleEdge(time, direction);
+    edgesCount++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQEventLoop implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQEventLoop::RC433HQEventLoop():
+    sourcesCount(0),
+    activeSourcesCount(0),
+    stopped(false),
+    wakeUpsCount(0)
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    // the stop event is registered without a registration
+    if ((epollFd >= 0) && (stopFd >= 0)) {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = 0;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &event);
+    }
+}
+
+RC433HQEventLoop::~RC433HQEventLoop()
+{
+    // the timers are owned by the loop, the descriptors of the sources are not
+    for (size_t i = 0; i < registrations.size(); i++) {
+        if (registrations[i]->timerHandler) {
+            close(registrations[i]->fd);
+        }
+        delete registrations[i];
+    }
+    registrations.clear();
+
+    if (stopFd >= 0) {
+        close(stopFd);
+    }
+    if (epollFd >= 0) {
+        close(epollFd);
+    }
+}
+
+bool RC433HQEventLoop::Register(Registration *registration)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = registration;
+    if (!IsValid() || (epoll_ctl(epollFd, EPOLL_CTL_ADD, registration->fd, &event) != 0)) {
+        delete registration;
+        return false;
+    }
+    registrations.push_back(registration);
+    return true;
+}
+
+bool RC433HQEventLoop::AddEdgeSource(RC433HQLiveEdgeSource &source)
+{
+    // the source drains the descriptor until it would block
+    int flags = fcntl(source.GetFileDescriptor(), F_GETFL);
+    if ((flags < 0) || (fcntl(source.GetFileDescriptor(), F_SETFL, flags | O_NONBLOCK) != 0)) {
+        return false;
+    }
+
+    Registration *registration = new Registration();
+    registration->fd = source.GetFileDescriptor();
+    registration->source = &source;
+    registration->timerHandler = 0;
+    if (!Register(registration)) {
+        return false;
+    }
+    sourcesCount++;
+    activeSourcesCount++;
+    return true;
+}
+
+bool RC433HQEventLoop::AddTimer(IRC433TimerHandler &handler, RC433HQMicrosecondsDiff period)
+{
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd < 0) {
+        return false;
+    }
+
+    struct itimerspec timerSpec;
+    timerSpec.it_interval.tv_sec = time_t(period.GetUnsignedLong() / 1000000UL);
+    timerSpec.it_interval.tv_nsec = long(period.GetUnsignedLong() % 1000000UL) * 1000L;
+    timerSpec.it_value = timerSpec.it_interval;
+    if (timerfd_settime(timerFd, 0, &timerSpec, 0) != 0) {
+        close(timerFd);
+        return false;
+    }
+
+    Registration *registration = new Registration();
+    registration->fd = timerFd;
+    registration->source = 0;
+    registration->timerHandler = &handler;
+    if (!Register(registration)) {
+        close(timerFd);
+        return false;
+    }
+    return true;
+}
+
+bool RC433HQEventLoop::RunOnce(int timeoutMs)
+{
+    if (stopped || !IsValid()) {
+        return false;
+    }
+
+    static const int MAX_EVENTS = 16;
+    struct epoll_event events[MAX_EVENTS];
+    int count = epoll_wait(epollFd, events, MAX_EVENTS, timeoutMs);
+    if (count < 0) {
+        return (errno == EINTR);
+    }
+    if (count > 0) {
+        wakeUpsCount++;
+    }
+
+    for (int i = 0; i < count; i++) {
+        Registration *registration = static_cast<Registration *>(events[i].data.ptr);
+
+        // the Stop() event
+        if (!registration) {
+            uint64_t value;
+            ssize_t readBytes = read(stopFd, &value, sizeof(value));
+            (void)readBytes;
+            stopped = true;
+            continue;
+        }
+
+        if (registration->source) {
+
+            // drain the source, the source at its end is not waited for any more
+            RC433HQLiveEdgeSource &source = *registration->source;
+            source.ReadEdges();
+            if (source.IsAtEnd()) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, registration->fd, 0);
+                activeSourcesCount--;
+            }
+
+        } else {
+
+            // the expirations missed meanwhile are merged into one call
+            uint64_t expirations;
+            if (read(registration->fd, &expirations, sizeof(expirations)) == ssize_t(sizeof(expirations))) {
+                registration->timerHandler->HandleTimer();
+            }
+        }
+    }
+
+    return !stopped && ((sourcesCount == 0) || (activeSourcesCount > 0));
+}
+
+void RC433HQEventLoop::Run()
+{
+    while (RunOnce(-1)) {
+    }
+}
+
+void RC433HQEventLoop::Stop()
+{
+    uint64_t value = 1;
+    ssize_t written = write(stopFd, &value, sizeof(value));
+    (void)written;
+}
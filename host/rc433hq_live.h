@@ -0,0 +1,168 @@
+#pragma once
+
+// Host only (Linux) part of the library: live edge source reading the edge events from a file descriptor (the GPIO
+// character device, or a pipe or socket fed by a simulator) and the epoll event loop driving the sources and timers.
+
+#include "../rc433hq.h"
+
+#include <vector>
+
+/**
+  @file rc433hq_live.h
+*/
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQLiveEdgeSource declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// format of the edge events read from the file descriptor (native byte order)
+enum RC433HQLiveEdgeFormat {
+	// struct gpio_v2_line_event of the GPIO character device (48 bytes): 64-bit timestamp in ns, 32-bit id (1 rising,
+	// 2 falling), 32-bit offset, 32-bit seqno, 32-bit line_seqno, 6 x 32-bit padding. The gaps of line_seqno are the
+	// events lost by the kernel.
+	RC433HQ_LIVE_EDGE_GPIO_V2,
+
+	// 8 bytes for the simulators: 32-bit time in us, word sequence number, byte direction (1 rising, 0 falling), byte 0
+	RC433HQ_LIVE_EDGE_COMPACT
+};
+
+// size of one event of the format in bytes
+size_t RC433HQGetLiveEdgeSize(RC433HQLiveEdgeFormat format);
+
+// encode the event (e.g. in a simulator feeding the source), the buffer has to have RC433HQGetLiveEdgeSize() bytes.
+// The GPIO event gets the time in ns of the microseconds.
+void RC433HQEncodeLiveEdge(RC433HQLiveEdgeFormat format, RC433HQMicroseconds time, bool direction, uint32_t sequence, byte *buffer);
+
+/** \brief Linux counterpart of the RC433HQReceiver: reads the timestamped edge events from the non-blocking file descriptor
+    in batches and passes them into the processor. The kernel (or the pipe) buffers the events instead of the
+    RC433HQPulseBuffer, ReadEdges() drains them from the loop like ProcessData() does; the events lost by the kernel
+    (a gap in the sequence numbers) are reported as HandleMissedEdges(). The time is taken from the event, so the timing
+    does not depend on the latency of the loop. The file descriptor is not closed by the source.
+    Usage:
+       int fd = ...;   // GPIO line request with the edge detection, or a pipe from the simulator
+       RC433HQLiveEdgeSource source(noiseFilter, fd, RC433HQ_LIVE_EDGE_GPIO_V2);
+       RC433HQEventLoop loop;
+       loop.AddEdgeSource(source);
+       loop.Run();
+ */
+class RC433HQLiveEdgeSource {
+public:
+	static const size_t BATCH_EDGES = 64;         // events read by one read() call
+	static const size_t MAX_BATCHES_PER_CALL = 16; // then the other sources of the loop get their turn
+
+private:
+	IRC433PulseProcessor &processor;
+	int fd;
+	RC433HQLiveEdgeFormat format;
+	size_t edgeSize;
+	byte *buffer;
+	size_t pendingBytes;           // incomplete event read by the previous read()
+	RC433HQTimeExtender *timeExtender;
+	bool receptionEnabled;
+	bool missedEdges;              // the edges were lost or ignored, report it before the next edge
+	bool sequenceValid;
+	uint32_t lastSequence;
+	bool atEnd;
+	bool failed;
+	unsigned long long edgesCount;
+	unsigned long missedEdgesCount;
+	unsigned long readsCount;
+
+public:
+	RC433HQLiveEdgeSource(IRC433PulseProcessor &aprocessor, int afd, RC433HQLiveEdgeFormat aformat);
+	~RC433HQLiveEdgeSource();
+
+	int GetFileDescriptor() const { return fd; }
+
+	// the time extender is updated with the edge times (the source is the producer of the edges)
+	void SetTimeExtender(RC433HQTimeExtender &atimeExtender) { timeExtender = &atimeExtender; }
+
+	// the events read while the reception is disabled are dropped, the processor gets HandleMissedEdges() after enabling
+	void DisableReception() { receptionEnabled = false; }
+	void EnableReception() { receptionEnabled = true; }
+
+	// read the available events (up to MAX_BATCHES_PER_CALL reads) and pass them to the processor, returns their count
+	size_t ReadEdges();
+
+	// the writer closed the pipe or socket (or the read failed), nothing more will come
+	bool IsAtEnd() const { return atEnd; }
+	bool HasFailed() const { return failed; }
+
+	unsigned long long GetEdgesCount() const { return edgesCount; }
+	unsigned long GetMissedEdgesCount() const { return missedEdgesCount; }   // count of the detected gaps
+	unsigned long GetReadsCount() const { return readsCount; }
+
+private:
+	void HandleEvent(const byte *event);
+
+	RC433HQLiveEdgeSource(const RC433HQLiveEdgeSource &);
+	RC433HQLiveEdgeSource &operator=(const RC433HQLiveEdgeSource &);
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQEventLoop declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// called by the event loop when the timer expires
+class IRC433TimerHandler {
+public:
+	virtual ~IRC433TimerHandler() {}
+
+	virtual void HandleTimer() = 0;
+};
+
+/** \brief Single threaded epoll loop of the live edge sources and of the periodic timers (timerfd), e.g. for
+    RC433HQRepetitionCombiner::Update(), the flush of the frame journal or the printing of the metrics. The loop sleeps
+    in epoll_wait() until an event comes, the sources are drained as soon as their descriptor is readable. Run()
+    returns after Stop() (which can be called from any thread) or when all the sources reached their end.
+ */
+class RC433HQEventLoop {
+private:
+	struct Registration {
+		int fd;
+		RC433HQLiveEdgeSource *source;
+		IRC433TimerHandler *timerHandler;
+	};
+
+private:
+	int epollFd;
+	int stopFd;                    // eventfd waking up the loop by Stop()
+	std::vector<Registration *> registrations;
+	size_t sourcesCount;
+	size_t activeSourcesCount;     // sources not at their end yet
+	bool stopped;
+	unsigned long wakeUpsCount;
+
+public:
+	RC433HQEventLoop();
+	~RC433HQEventLoop();
+
+	// false if the epoll instance could not be created
+	bool IsValid() const { return (epollFd >= 0) && (stopFd >= 0); }
+
+	// the source is read when its descriptor is readable, the descriptor is switched to the non-blocking mode
+	bool AddEdgeSource(RC433HQLiveEdgeSource &source);
+
+	// the handler is called every period (the expirations missed while the loop was busy are merged into one call)
+	bool AddTimer(IRC433TimerHandler &handler, RC433HQMicrosecondsDiff period);
+
+	// wait up to the timeout (-1 without the limit) and handle the ready sources and timers, returns false after Stop()
+	// or when all the sources are at their end
+	bool RunOnce(int timeoutMs);
+
+	// handle the events until Stop() or until all the sources are at their end
+	void Run();
+
+	// stop the loop, thread safe
+	void Stop();
+
+	unsigned long GetWakeUpsCount() const { return wakeUpsCount; }
+
+private:
+	bool Register(Registration *registration);
+
+	RC433HQEventLoop(const RC433HQEventLoop &);
+	RC433HQEventLoop &operator=(const RC433HQEventLoop &);
+};
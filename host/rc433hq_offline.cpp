@@ -0,0 +1,275 @@
+#include "rc433hq_offline.h"
+
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+
+// the shortest gap that is always stored as the absolute time in the capture
+static const unsigned long OFFLINE_MIN_GAP_US = RC433HQ_CAPTURE_MISSED_EDGES + 1UL;
+
+// duration of the pulse used to finish the frames pending at the end of the chunk
+static constexpr RC433HQMicrosecondsDiff OFFLINE_FINISHING_PULSE = 1000_ms;
+
+// the first event reaching the decoders in the chunk, decides about the frames pending from the previous chunks
+enum RC433HQOfflineEvent {
+	OFFLINE_EVENT_NONE,
+	OFFLINE_EVENT_RISING_EDGE,      // the pending frames are sent
+	OFFLINE_EVENT_MISSED_EDGES      // the pending frames are dropped
+};
+
+bool RC433HQOfflineFrame::operator==(const RC433HQOfflineFrame &that) const
+{
+    return (decoder == that.decoder) && (time == that.time) && (bits == that.bits) && (quality == that.quality) &&
+           (memcmp(data, that.data, (bits + 7) / 8) == 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQOfflineDecoder implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+struct RC433HQOfflineDecoder::Chunk {
+    size_t beginOffset;
+    size_t endOffset;
+    RC433HQTimeExtender timeExtender;      // state before the first edge of the chunk
+    RC433HQOfflineFrames frames;
+    RC433HQOfflineFrames pendingFrames;    // frames sent by the first rising edge after the chunk
+    RC433HQOfflineEvent firstEvent;
+};
+
+// noise filter followed by the decoders, observes the first event passed into the decoders
+class RC433HQOfflineDecoder::Chain: public IRC433PulseProcessor {
+private:
+    // receiver of one decoder storing the frames
+    class FrameCollector: public IRC433DataReceiver {
+    public:
+        RC433HQOfflineFrames *frames;
+        size_t decoder;
+
+        FrameCollector(size_t adecoder):
+            frames(0),
+            decoder(adecoder)
+        {
+        }
+
+        virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality)
+        {
+            HandleExtendedData(RC433HQExtendedMicroseconds(0, time), data, bits, quality);
+        }
+
+        virtual void HandleExtendedData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, double quality)
+        {
+            RC433HQOfflineFrame frame;
+            frame.decoder = decoder;
+            frame.time = time;
+            memset(frame.data, 0, sizeof(frame.data));
+            memcpy(frame.data, data, (bits + 7) / 8);
+            frame.bits = bits;
+            frame.quality = quality;
+            frames->push_back(frame);
+        }
+    };
+
+private:
+    std::vector<FrameCollector> collectors;
+    std::vector<RC433HQBasicSyncPulseDecoder *> decoders;
+    RC433HQNoiseFilter filter;
+
+public:
+    RC433HQTimeExtender timeExtender;
+    RC433HQOfflineEvent firstEvent;
+
+    Chain(IRC433OfflineDecoderFactory &factory, RC433HQMicrosecondsDiff minPulseDuration):
+        filter(*this, minPulseDuration),
+        firstEvent(OFFLINE_EVENT_NONE)
+    {
+        // the decoders keep the references to the collectors, they must not be reallocated
+        collectors.reserve(factory.GetDecodersCount());
+        for (size_t i = 0; i < factory.GetDecodersCount(); i++) {
+            collectors.push_back(FrameCollector(i));
+            decoders.push_back(factory.CreateDecoder(i, collectors.back()));
+            decoders.back()->SetTimeExtender(timeExtender);
+        }
+    }
+
+    ~Chain()
+    {
+        for (size_t i = 0; i < decoders.size(); i++) {
+            delete decoders[i];
+        }
+    }
+
+    IRC433PulseProcessor &GetInput() { return filter; }
+
+    void SetFrames(RC433HQOfflineFrames &frames)
+    {
+        for (size_t i = 0; i < collectors.size(); i++) {
+            collectors[i].frames = &frames;
+        }
+    }
+
+    virtual void HandleEdge(RC433HQMicroseconds time, bool direction)
+    {
+        if ((firstEvent == OFFLINE_EVENT_NONE) && direction) {
+            firstEvent = OFFLINE_EVENT_RISING_EDGE;
+        }
+        for (size_t i = 0; i < decoders.size(); i++) {
+            decoders[i]->HandleEdge(time, direction);
+        }
+    }
+
+    virtual void HandleMissedEdges()
+    {
+        if (firstEvent == OFFLINE_EVENT_NONE) {
+            firstEvent = OFFLINE_EVENT_MISSED_EDGES;
+        }
+        for (size_t i = 0; i < decoders.size(); i++) {
+            decoders[i]->HandleMissedEdges();
+        }
+    }
+
+    // send the frames waiting for the next rising edge by a long pulse (neither data nor sync) directly into the decoders
+    void FinishPendingFrames(RC433HQMicroseconds time)
+    {
+        for (size_t i = 0; i < decoders.size(); i++) {
+            decoders[i]->HandleEdge(time, false);
+            decoders[i]->HandleEdge(time + OFFLINE_FINISHING_PULSE, true);
+        }
+    }
+};
+
+RC433HQOfflineDecoder::RC433HQOfflineDecoder(IRC433OfflineDecoderFactory &afactory, RC433HQMicrosecondsDiff aminPulseDuration, RC433HQMicrosecondsDiff aminGap, size_t aminChunkSize):
+    factory(afactory),
+    minPulseDuration(aminPulseDuration),
+    minGap(aminGap),
+    minChunkSize(aminChunkSize),
+    chunksCount(0)
+{
+    // the shorter gaps can't be used as the chunk boundaries
+    if (minGap < RC433HQMicrosecondsDiff(OFFLINE_MIN_GAP_US)) {
+        minGap = OFFLINE_MIN_GAP_US;
+    }
+}
+
+void RC433HQOfflineDecoder::DecodeSequential(const RC433HQCaptureReader &reader, RC433HQOfflineFrames &frames)
+{
+    frames.clear();
+
+    Chain chain(factory, minPulseDuration);
+    chain.SetFrames(frames);
+    reader.Replay(chain.GetInput(), &chain.timeExtender);
+}
+
+void RC433HQOfflineDecoder::DecodeParallel(const RC433HQCaptureReader &reader, size_t threads, RC433HQOfflineFrames &frames)
+{
+    frames.clear();
+
+    std::vector<Chunk> chunks;
+    SplitIntoChunks(reader, chunks);
+    chunksCount = chunks.size();
+
+    // at least one worker decodes the chunks
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    // the workers take the chunks in their order
+    std::atomic<size_t> nextChunk(0);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; i++) {
+        workers.push_back(std::thread([&]() {
+            for (size_t chunk = nextChunk++; chunk < chunks.size(); chunk = nextChunk++) {
+                DecodeChunk(reader, chunks[chunk], (chunk + 1 < chunks.size())? &chunks[chunk + 1]: 0);
+            }
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+
+    // the frames pending at the end of the chunk are sent only if a rising edge reaches the decoders before the missed edges
+    std::vector<bool> sendPendingFrames(chunks.size(), false);
+    RC433HQOfflineEvent nextEvent = OFFLINE_EVENT_NONE;
+    for (size_t i = chunks.size(); i-- > 0; ) {
+        sendPendingFrames[i] = (nextEvent == OFFLINE_EVENT_RISING_EDGE);
+        if (chunks[i].firstEvent != OFFLINE_EVENT_NONE) {
+            nextEvent = chunks[i].firstEvent;
+        }
+    }
+
+    // merge the frames in the order of the chunks
+    for (size_t i = 0; i < chunks.size(); i++) {
+        frames.insert(frames.end(), chunks[i].frames.begin(), chunks[i].frames.end());
+        if (sendPendingFrames[i]) {
+            frames.insert(frames.end(), chunks[i].pendingFrames.begin(), chunks[i].pendingFrames.end());
+        }
+    }
+}
+
+void RC433HQOfflineDecoder::SplitIntoChunks(const RC433HQCaptureReader &reader, std::vector<Chunk> &chunks)
+{
+    RC433HQTimeExtender timeExtender;
+    RC433HQMicroseconds previousTime;
+    bool previousTimeValid = false;
+
+    Chunk chunk;
+    chunk.beginOffset = reader.GetRecordsBegin();
+    chunk.timeExtender = timeExtender;
+    chunk.firstEvent = OFFLINE_EVENT_NONE;
+
+    RC433HQCaptureRecord record;
+    size_t offset = reader.GetRecordsBegin();
+    size_t recordOffset = offset;
+
+    while (reader.ReadRecord(offset, reader.GetRecordsEnd(), previousTime, record)) {
+
+        if (!record.missedEdges) {
+
+            // the long gaps are always stored as the absolute time, the chunk starts with the edge after the gap
+            if (record.absoluteTime && previousTimeValid && ((record.time - previousTime) > minGap) && (recordOffset - chunk.beginOffset >= minChunkSize)) {
+
+                chunk.endOffset = recordOffset;
+                chunks.push_back(chunk);
+
+                chunk.beginOffset = recordOffset;
+                chunk.timeExtender = timeExtender;
+            }
+
+            timeExtender.Update(record.time);
+            previousTime = record.time;
+            previousTimeValid = true;
+        }
+
+        recordOffset = offset;
+    }
+
+    chunk.endOffset = reader.GetRecordsEnd();
+    chunks.push_back(chunk);
+}
+
+void RC433HQOfflineDecoder::DecodeChunk(const RC433HQCaptureReader &reader, Chunk &chunk, const Chunk *nextChunk)
+{
+    Chain chain(factory, minPulseDuration);
+    chain.timeExtender = chunk.timeExtender;
+    chain.SetFrames(chunk.frames);
+
+    reader.Replay(chain.GetInput(), chunk.beginOffset, chunk.endOffset, &chain.timeExtender);
+
+    if (nextChunk) {
+
+        // the first edge after the gap decides, whether the last edge of the chunk passes the noise filter
+        RC433HQCaptureRecord record;
+        size_t lookaheadEnd = nextChunk->beginOffset;
+        reader.ReadRecord(lookaheadEnd, nextChunk->endOffset, RC433HQMicroseconds(), record);
+        reader.Replay(chain.GetInput(), nextChunk->beginOffset, lookaheadEnd, &chain.timeExtender);
+
+        // the frame not finished yet is sent by the first rising edge reaching the decoders after the gap
+        chunk.firstEvent = chain.firstEvent;
+        chain.SetFrames(chunk.pendingFrames);
+        chain.FinishPendingFrames(record.time);
+
+    } else {
+
+        chunk.firstEvent = chain.firstEvent;
+    }
+}
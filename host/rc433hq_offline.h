@@ -0,0 +1,79 @@
+#pragma once
+
+// Host only (Linux) part of the library: offline decoding of large edge captures on many threads. The capture is
+// split at idle gaps longer than any pulse of the decoded protocols. The noise filter and the decoders do not carry
+// any state over such a gap (except the frame finished by the first rising edge after it), so the chunks can be
+// decoded independently and the result is identical to the sequential decoding of the whole capture.
+
+#include "../rc433hq.h"
+#include "rc433hq_capture.h"
+
+#include <vector>
+
+/**
+  @file rc433hq_offline.h
+*/
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQOfflineDecoder declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// frame decoded from the capture
+struct RC433HQOfflineFrame {
+	size_t decoder;                        // index of the decoder created by the factory
+	RC433HQExtendedMicroseconds time;      // time of the sync
+	byte data[RC433HQ_MAX_PULSE_BITS / 8];
+	size_t bits;
+	double quality;
+
+	bool operator==(const RC433HQOfflineFrame &that) const;
+	bool operator!=(const RC433HQOfflineFrame &that) const { return !(*this == that); }
+};
+
+typedef std::vector<RC433HQOfflineFrame> RC433HQOfflineFrames;
+
+// creates the decoders of the protocols, one set for every decoded chunk
+class IRC433OfflineDecoderFactory {
+public:
+	virtual ~IRC433OfflineDecoderFactory() {}
+
+	virtual size_t GetDecodersCount() const = 0;
+
+	// create the decoder of the given index delivering the data into the receiver, deleted by the caller
+	virtual RC433HQBasicSyncPulseDecoder *CreateDecoder(size_t index, IRC433DataReceiver &receiver) = 0;
+};
+
+/** \brief Decodes the capture by the noise filter followed by the decoders from the factory, either sequentially or split
+    into chunks decoded on many threads. The frames are returned in the order of their delivery by the sequential decoding.
+ */
+class RC433HQOfflineDecoder {
+private:
+	struct Chunk;
+	class Chain;
+
+private:
+	IRC433OfflineDecoderFactory &factory;
+	RC433HQMicrosecondsDiff minPulseDuration;
+	RC433HQMicrosecondsDiff minGap;
+	size_t minChunkSize;
+	size_t chunksCount;
+
+public:
+	// minPulseDuration is passed to the noise filter, minGap has to be longer than any pulse of the decoded protocols
+	// (at least 32767 us, the shorter gaps are not marked in the capture). The chunks are at least minChunkSize bytes.
+	RC433HQOfflineDecoder(IRC433OfflineDecoderFactory &afactory, RC433HQMicrosecondsDiff aminPulseDuration, RC433HQMicrosecondsDiff aminGap = 100000, size_t aminChunkSize = 65536);
+
+	// decode the whole capture in the calling thread
+	void DecodeSequential(const RC433HQCaptureReader &reader, RC433HQOfflineFrames &frames);
+
+	// split the capture into chunks and decode them by the given count of threads (0 is taken as 1)
+	void DecodeParallel(const RC433HQCaptureReader &reader, size_t threads, RC433HQOfflineFrames &frames);
+
+	// count of the chunks of the last DecodeParallel() call
+	size_t GetChunksCount() const { return chunksCount; }
+
+private:
+	void SplitIntoChunks(const RC433HQCaptureReader &reader, std::vector<Chunk> &chunks);
+	void DecodeChunk(const RC433HQCaptureReader &reader, Chunk &chunk, const Chunk *nextChunk);
+};
@@ -0,0 +1,268 @@
+#include "rc433hq_pipeline.h"
+
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <chrono>
+
+// count of the edges popped from the queue at once by the worker
+static const size_t PIPELINE_WORKER_BATCH_SIZE = 256;
+
+// count of the empty polls before the idle worker starts yielding and sleeping
+static const unsigned PIPELINE_SPIN_POLLS = 64;
+static const unsigned PIPELINE_YIELD_POLLS = 256;
+static const unsigned PIPELINE_IDLE_SLEEP_US = 50;
+
+// wait for the other thread with the increasing back-off
+static void BackOff(unsigned &polls)
+{
+    polls++;
+    if (polls < PIPELINE_SPIN_POLLS) {
+        return;
+    }
+    if (polls < PIPELINE_YIELD_POLLS) {
+        std::this_thread::yield();
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(PIPELINE_IDLE_SLEEP_US));
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPipelineInput implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQPipelineInput::RC433HQPipelineInput(RC433HQSpscQueue<RC433HQPipelineEdge> &aqueue):
+    queue(aqueue),
+    batchUsed(0),
+    dropWhenFull(false),
+    missedPending(false),
+    droppedEdges(0)
+{
+}
+
+void RC433HQPipelineInput::HandleEdge(RC433HQMicroseconds time, bool direction)
+{
+    AddEdge(time, direction? RC433HQ_PIPELINE_EDGE_RISING: 0);
+}
+
+void RC433HQPipelineInput::HandleMissedEdges()
+{
+    AddEdge(RC433HQMicroseconds(), RC433HQ_PIPELINE_EDGE_MISSED);
+}
+
+void RC433HQPipelineInput::Flush()
+{
+    size_t pushed = 0;
+    unsigned polls = 0;
+
+    while (pushed < batchUsed) {
+
+        pushed += queue.Push(batch + pushed, batchUsed - pushed);
+
+        // if the worker does not keep up
+        if (pushed < batchUsed) {
+
+            if (dropWhenFull) {
+
+                // forget the rest of the batch and report it before the next edge
+                droppedEdges += batchUsed - pushed;
+                missedPending = true;
+                break;
+            }
+
+            BackOff(polls);
+        }
+    }
+
+    batchUsed = 0;
+}
+
+void RC433HQPipelineInput::AddEdge(RC433HQMicroseconds time, byte flags)
+{
+    // keep the space for the missed edges marker
+    if (batchUsed >= BATCH_SIZE - 1) {
+        Flush();
+    }
+
+    // the dropped edges are reported to the decoders before the next edge
+    if (missedPending) {
+        missedPending = false;
+        RC433HQPipelineEdge missed = { RC433HQMicroseconds(), RC433HQ_PIPELINE_EDGE_MISSED };
+        batch[batchUsed++] = missed;
+    }
+
+    RC433HQPipelineEdge edge = { time, flags };
+    batch[batchUsed++] = edge;
+
+    if (batchUsed == BATCH_SIZE) {
+        Flush();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPipelineFrameReceiver implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+void RC433HQPipelineFrameReceiver::HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality)
+{
+    RC433HQPipelineFrame frame;
+    frame.channel = channel;
+    frame.protocol = protocol;
+    frame.time = time;
+    memset(frame.data, 0, sizeof(frame.data));
+    memcpy(frame.data, data, (bits + 7) / 8);
+    frame.bits = bits;
+    frame.quality = quality;
+
+    pipeline.PushFrame(frame);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPipeline implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQPipeline::RC433HQPipeline(size_t aedgeQueueCapacity, size_t frameQueueCapacity):
+    edgeQueueCapacity(aedgeQueueCapacity),
+    frames(frameQueueCapacity),
+    stopping(false),
+    running(false)
+{
+}
+
+RC433HQPipeline::~RC433HQPipeline()
+{
+    Stop();
+    for (size_t i = 0; i < channels.size(); i++) {
+        delete channels[i];
+    }
+    channels.clear();
+}
+
+size_t RC433HQPipeline::AddChannel(int cpu)
+{
+    // the channels can't be added to the running pipeline
+    // assert(!running);
+
+    channels.push_back(new Channel(edgeQueueCapacity, cpu));
+    return channels.size() - 1;
+}
+
+void RC433HQPipeline::SetChannelProcessor(size_t channel, IRC433PulseProcessor &processor)
+{
+    channels[channel]->processor = &processor;
+}
+
+void RC433HQPipeline::Start()
+{
+    if (running) {
+        return;
+    }
+
+    stopping.store(false);
+    running = true;
+
+    for (size_t i = 0; i < channels.size(); i++) {
+
+        Channel &channel = *channels[i];
+        channel.finished.store(false);
+        channel.worker = std::thread(&RC433HQPipeline::RunWorker, this, std::ref(channel));
+
+        // pin the worker to the requested CPU
+        if (channel.cpu >= 0) {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(channel.cpu, &cpuSet);
+            pthread_setaffinity_np(channel.worker.native_handle(), sizeof(cpuSet), &cpuSet);
+        }
+    }
+}
+
+void RC433HQPipeline::Stop()
+{
+    if (!running) {
+        return;
+    }
+
+    // the workers finish after their queues are empty
+    stopping.store(true, std::memory_order_release);
+
+    // keep taking the frames out of the output queue, a worker waiting for the free space would never finish
+    unsigned polls = 0;
+    for (size_t i = 0; i < channels.size(); ) {
+        RC433HQPipelineFrame frame;
+        if (frames.Pop(frame)) {
+            stoppedFrames.push_back(frame);
+            polls = 0;
+        } else if (channels[i]->finished.load(std::memory_order_acquire)) {
+            i++;
+        } else {
+            BackOff(polls);
+        }
+    }
+
+    for (size_t i = 0; i < channels.size(); i++) {
+        channels[i]->worker.join();
+    }
+
+    running = false;
+}
+
+bool RC433HQPipeline::PopFrame(RC433HQPipelineFrame &frame)
+{
+    // the frames moved out by Stop() are older than those in the queue
+    if (!stoppedFrames.empty()) {
+        frame = stoppedFrames.front();
+        stoppedFrames.pop_front();
+        return true;
+    }
+    return frames.Pop(frame);
+}
+
+void RC433HQPipeline::PushFrame(const RC433HQPipelineFrame &frame)
+{
+    unsigned polls = 0;
+    while (!frames.Push(frame)) {
+        BackOff(polls);
+    }
+}
+
+void RC433HQPipeline::RunWorker(Channel &channel)
+{
+    RC433HQPipelineEdge edges[PIPELINE_WORKER_BATCH_SIZE];
+    unsigned polls = 0;
+
+    for (;;) {
+
+        // read the stop request before the queue, so that no edge pushed before Stop() is lost
+        bool stopRequested = stopping.load(std::memory_order_acquire);
+
+        size_t count = channel.queue.Pop(edges, PIPELINE_WORKER_BATCH_SIZE);
+
+        if (count == 0) {
+
+            if (stopRequested) {
+                break;
+            }
+
+            BackOff(polls);
+            continue;
+        }
+        polls = 0;
+
+        // pass the edges into the decoding chain
+        if (channel.processor) {
+            for (size_t i = 0; i < count; i++) {
+                if (edges[i].flags & RC433HQ_PIPELINE_EDGE_MISSED) {
+                    channel.processor->HandleMissedEdges();
+                } else {
+                    channel.processor->HandleEdge(edges[i].time, (edges[i].flags & RC433HQ_PIPELINE_EDGE_RISING) != 0);
+                }
+            }
+        }
+
+        channel.processedEdges.store(channel.processedEdges.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+
+    channel.finished.store(true, std::memory_order_release);
+}
@@ -0,0 +1,363 @@
+#pragma once
+
+// Host only (Linux) part of the library: multi-threaded pipeline decoding many edge sources at once. Every channel
+// has its own worker thread (optionally pinned to a CPU) running the single-threaded decoding chain (noise filter,
+// splitter, decoders, ...). The edges are passed from the source into the worker via a lock-free single producer
+// single consumer queue and the decoded frames of all the channels are collected in one multiple producer single
+// consumer queue.
+
+#include "../rc433hq.h"
+
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <thread>
+
+/**
+  @file rc433hq_pipeline.h
+*/
+
+
+// size of the cache line used to separate the data written by different threads
+static const size_t RC433HQ_CACHE_LINE_SIZE = 64;
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQSpscQueue declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Lock-free bounded queue for exactly one producer and one consumer thread. The values are passed in batches to
+    minimize the synchronization per value.
+ */
+template <typename T>
+class RC433HQSpscQueue {
+private:
+	std::vector<T> values;
+	size_t mask;
+
+	// consumer side
+	std::atomic<size_t> head;
+	size_t cachedTail;
+	char consumerPadding[RC433HQ_CACHE_LINE_SIZE];
+
+	// producer side
+	std::atomic<size_t> tail;
+	size_t cachedHead;
+	char producerPadding[RC433HQ_CACHE_LINE_SIZE];
+
+public:
+	// the capacity is rounded up to the power of two
+	explicit RC433HQSpscQueue(size_t capacity):
+		head(0),
+		cachedTail(0),
+		tail(0),
+		cachedHead(0)
+	{
+		size_t size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		values.resize(size);
+		mask = size - 1;
+	}
+
+	size_t GetCapacity() const { return values.size(); }
+
+	// producer: push up to count values, returns the count of the pushed values
+	size_t Push(const T *pushedValues, size_t count)
+	{
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+
+		// refresh the cached head only if there seems to be less space than needed
+		if (currentTail - cachedHead + count > values.size()) {
+			cachedHead = head.load(std::memory_order_acquire);
+		}
+
+		size_t available = values.size() - (currentTail - cachedHead);
+		if (count > available) {
+			count = available;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			values[(currentTail + i) & mask] = pushedValues[i];
+		}
+
+		tail.store(currentTail + count, std::memory_order_release);
+		return count;
+	}
+
+	// consumer: pop up to maxCount values, returns the count of the popped values
+	size_t Pop(T *poppedValues, size_t maxCount)
+	{
+		size_t currentHead = head.load(std::memory_order_relaxed);
+
+		// refresh the cached tail only if there seem to be less values than requested
+		if (cachedTail - currentHead < maxCount) {
+			cachedTail = tail.load(std::memory_order_acquire);
+		}
+
+		size_t count = cachedTail - currentHead;
+		if (count > maxCount) {
+			count = maxCount;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			poppedValues[i] = values[(currentHead + i) & mask];
+		}
+
+		head.store(currentHead + count, std::memory_order_release);
+		return count;
+	}
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQMpscQueue declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Lock-free bounded queue for many producer threads and one consumer thread (every cell carries a sequence number,
+    which tells whether it is free for the producer or ready for the consumer)
+ */
+template <typename T>
+class RC433HQMpscQueue {
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+private:
+	Cell *cells;
+	size_t mask;
+	char padding1[RC433HQ_CACHE_LINE_SIZE];
+	std::atomic<size_t> enqueuePosition;
+	char padding2[RC433HQ_CACHE_LINE_SIZE];
+	size_t dequeuePosition;
+
+public:
+	// the capacity is rounded up to the power of two
+	explicit RC433HQMpscQueue(size_t capacity):
+		enqueuePosition(0),
+		dequeuePosition(0)
+	{
+		size_t size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		cells = new Cell[size];
+		mask = size - 1;
+		for (size_t i = 0; i < size; i++) {
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	~RC433HQMpscQueue()
+	{
+		delete [] cells; cells = 0;
+	}
+
+	size_t GetCapacity() const { return mask + 1; }
+
+	// producer: returns false if the queue is full
+	bool Push(const T &value)
+	{
+		Cell *cell;
+		size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &cells[position & mask];
+			intptr_t difference = intptr_t(cell->sequence.load(std::memory_order_acquire)) - intptr_t(position);
+			if (difference == 0) {
+				// the cell is free, try to reserve it
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (difference < 0) {
+				// the consumer has not released the cell yet
+				return false;
+			} else {
+				// another producer has reserved the cell
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+		cell->value = value;
+		cell->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer: returns false if the queue is empty
+	bool Pop(T &value)
+	{
+		Cell *cell = &cells[dequeuePosition & mask];
+		if (cell->sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+			return false;
+		}
+		value = cell->value;
+		cell->sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+		dequeuePosition++;
+		return true;
+	}
+
+private:
+	RC433HQMpscQueue(const RC433HQMpscQueue &);
+	RC433HQMpscQueue &operator=(const RC433HQMpscQueue &);
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPipeline declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// edge passed from the source into the channel worker
+struct RC433HQPipelineEdge {
+	RC433HQMicroseconds time;
+	byte flags;
+};
+
+static const byte RC433HQ_PIPELINE_EDGE_RISING = 0x01;
+static const byte RC433HQ_PIPELINE_EDGE_MISSED = 0x02;  // the edges before this one were missed, time and direction are not used
+
+// frame decoded by one of the channels
+struct RC433HQPipelineFrame {
+	size_t channel;
+	int protocol;
+	RC433HQMicroseconds time;
+	byte data[RC433HQ_MAX_PULSE_BITS / 8];
+	size_t bits;
+	double quality;
+};
+
+class RC433HQPipeline;
+
+/** \brief Producer side of the channel: the edge source passes the edges here from its own thread. The edges are collected
+    in small batches, call Flush() when the source waits for more data or finishes.
+ */
+class RC433HQPipelineInput: public IRC433PulseProcessor {
+private:
+	static const size_t BATCH_SIZE = 64;
+
+private:
+	RC433HQSpscQueue<RC433HQPipelineEdge> &queue;
+	RC433HQPipelineEdge batch[BATCH_SIZE];
+	size_t batchUsed;
+	bool dropWhenFull;
+	bool missedPending;
+	unsigned long long droppedEdges;
+
+public:
+	RC433HQPipelineInput(RC433HQSpscQueue<RC433HQPipelineEdge> &aqueue);
+
+	// by default the source waits for the free space in the queue (suitable for replays), live sources should rather drop
+	// the edges. The dropped edges are reported to the decoders via HandleMissedEdges().
+	void SetDropWhenFull(bool adropWhenFull) { dropWhenFull = adropWhenFull; }
+
+	unsigned long long GetDroppedEdges() const { return droppedEdges; }
+
+	virtual void HandleEdge(RC433HQMicroseconds time, bool direction);
+	virtual void HandleMissedEdges();
+
+	// pass the collected edges into the queue
+	void Flush();
+
+private:
+	void AddEdge(RC433HQMicroseconds time, byte flags);
+};
+
+/** \brief Data receiver that passes the frames decoded by the channel into the pipeline output queue
+ */
+class RC433HQPipelineFrameReceiver: public IRC433DataReceiver {
+private:
+	RC433HQPipeline &pipeline;
+	size_t channel;
+	int protocol;
+
+public:
+	RC433HQPipelineFrameReceiver(RC433HQPipeline &apipeline, size_t achannel, int aprotocol):
+		pipeline(apipeline),
+		channel(achannel),
+		protocol(aprotocol)
+	{
+	}
+
+	virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality);
+};
+
+/** \brief Runs the decoding chains of many channels in parallel
+    Usage:
+       RC433HQPipeline pipeline;
+       size_t channel = pipeline.AddChannel(cpu);
+       RC433HQPipelineFrameReceiver receiverA(pipeline, channel, PROTOCOL_A);
+       ... build the decoding chain with the receivers
+       pipeline.SetChannelProcessor(channel, noiseFilter);
+       pipeline.Start();
+       ... pass the edges into pipeline.GetChannelInput(channel) from the source thread, call its Flush()
+       ... pop the frames via pipeline.PopFrame() from the consumer thread
+       pipeline.Stop();
+ */
+class RC433HQPipeline {
+private:
+	struct Channel {
+		RC433HQSpscQueue<RC433HQPipelineEdge> queue;
+		RC433HQPipelineInput input;
+		IRC433PulseProcessor *processor;
+		int cpu;
+		std::thread worker;
+		std::atomic<bool> finished;
+		std::atomic<unsigned long long> processedEdges;
+
+		Channel(size_t queueCapacity, int acpu):
+			queue(queueCapacity),
+			input(queue),
+			processor(0),
+			cpu(acpu),
+			finished(false),
+			processedEdges(0)
+		{
+		}
+	};
+
+private:
+	size_t edgeQueueCapacity;
+	std::vector<Channel *> channels;
+	RC433HQMpscQueue<RC433HQPipelineFrame> frames;
+	std::deque<RC433HQPipelineFrame> stoppedFrames;   // frames taken out of the full output queue by Stop()
+	std::atomic<bool> stopping;
+	bool running;
+
+public:
+	RC433HQPipeline(size_t aedgeQueueCapacity = 65536, size_t frameQueueCapacity = 4096);
+	~RC433HQPipeline();
+
+	// add a channel, its worker will be pinned to the given CPU (-1 means no pinning). Returns the channel index.
+	size_t AddChannel(int cpu = -1);
+
+	// the head of the channel decoding chain, has to be set before Start()
+	void SetChannelProcessor(size_t channel, IRC433PulseProcessor &processor);
+
+	// producer side of the channel, used by exactly one source thread
+	RC433HQPipelineInput &GetChannelInput(size_t channel) { return channels[channel]->input; }
+
+	size_t GetChannelsCount() const { return channels.size(); }
+
+	// count of the edges (and missed edges markers) already passed into the channel chain
+	unsigned long long GetProcessedEdges(size_t channel) const { return channels[channel]->processedEdges.load(std::memory_order_relaxed); }
+
+	// start the worker threads
+	void Start();
+
+	// wait until the workers process all the edges in the queues (the inputs have to be flushed) and stop them. Has to be
+	// called from the consumer thread: the frames the workers still deliver are moved out of the output queue meanwhile,
+	// so the workers never wait for the full queue, and PopFrame() returns them after the stop.
+	void Stop();
+
+	// called by the workers for every decoded frame, waits if the output queue is full
+	void PushFrame(const RC433HQPipelineFrame &frame);
+
+	// consumer side of the output queue, returns false if there is no frame
+	bool PopFrame(RC433HQPipelineFrame &frame);
+
+private:
+	void RunWorker(Channel &channel);
+
+	RC433HQPipeline(const RC433HQPipeline &);
+	RC433HQPipeline &operator=(const RC433HQPipeline &);
+};
@@ -0,0 +1,359 @@
+#include "rc433hq_traffic.h"
+
+#include <string.h>
+#include <algorithm>
+
+// time slack used when matching the decoded frames to the ground truth (jitter of the first edge)
+static const int32_t TRAFFIC_SCORE_TIME_SLACK_US = 1000;
+
+void RC433HQSendEdges(const RC433HQEdgeStream &edges, IRC433PulseProcessor &processor)
+{
+    for (size_t i = 0; i < edges.size(); i++) {
+        processor.HandleEdge(edges[i].time, edges[i].direction);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQTrafficGenerator implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQTrafficGenerator::IntervalTransmitter::IntervalTransmitter(std::vector<HighInterval> &aintervals, int64_t astartTime, double atimeScale):
+    intervals(aintervals),
+    time(astartTime),
+    timeScale(atimeScale),
+    high(false)
+{
+}
+
+void RC433HQTrafficGenerator::IntervalTransmitter::TransmitEdge(bool direction, RC433HQMicrosecondsDiff duration)
+{
+    // if the signal goes up
+    if (direction && !high) {
+
+        // start a new interval
+        HighInterval interval = { time, time };
+        intervals.push_back(interval);
+
+    } else if (!direction && high) {
+
+        // finish the last interval
+        intervals.back().end = time;
+    }
+    high = direction;
+
+    // the clock skew of the transmitter scales all the durations
+    time += int64_t(duration.AsDouble() * timeScale + 0.5);
+}
+
+RC433HQTrafficGenerator::RC433HQTrafficGenerator(const RC433HQTrafficImpairments &aimpairments, unsigned seed):
+    impairments(aimpairments),
+    random(seed)
+{
+}
+
+RC433HQTrafficImpairments RC433HQTrafficGenerator::NoImpairments()
+{
+    RC433HQTrafficImpairments impairments;
+    impairments.jitterSigmaUs = 0;
+    impairments.clockSkewPpmSigma = 0;
+    impairments.noiseSpikesPerSecond = 0;
+    impairments.noiseSpikeMinUs = impairments.noiseSpikeMaxUs = 0;
+    impairments.agcBurstsPerSecond = 0;
+    impairments.agcBurstDurationUs = 0;
+    impairments.agcPulseMinUs = impairments.agcPulseMaxUs = 0;
+    impairments.collisionProbability = 0;
+    return impairments;
+}
+
+RC433HQMicroseconds RC433HQTrafficGenerator::AddTransmission(RC433HQMicroseconds startTime, const RC433HQTrafficProtocol &protocol, const byte *data)
+{
+    // generate the clock skew of this transmitter
+    double timeScale = 1.0;
+    if (impairments.clockSkewPpmSigma > 0) {
+        std::normal_distribution<double> skew(0.0, impairments.clockSkewPpmSigma);
+        timeScale += skew(random) * 1e-6;
+    }
+
+    int64_t endTime = AddEncodedTransmission(startTime.GetUnsignedLong(), protocol, data, timeScale);
+    return RC433HQMicroseconds(uint32_t(endTime));
+}
+
+void RC433HQTrafficGenerator::AddRandomTraffic(RC433HQMicroseconds startTime, RC433HQMicrosecondsDiff duration, double transmissionsPerSecond, const RC433HQTrafficProtocol *protocols, size_t protocolsCount)
+{
+    int64_t time = startTime.GetUnsignedLong();
+    int64_t endTime = time + int64_t(duration.GetUnsignedLong());
+
+    while (true) {
+
+        // wait for the next transmission
+        time += int64_t(RandomExponential(transmissionsPerSecond / 1e6));
+        if (time >= endTime) {
+            break;
+        }
+
+        // choose the protocol and the data
+        const RC433HQTrafficProtocol &protocol = protocols[RandomUniform(0, protocolsCount - 1)];
+        byte data[RC433HQ_MAX_PULSE_BITS / 8];
+        for (size_t i = 0; i < sizeof(data); i++) {
+            data[i] = byte(RandomUniform(0, 255));
+        }
+
+        size_t firstFrame = frames.size();
+        RC433HQMicroseconds transmissionEnd = AddTransmission(RC433HQMicroseconds(uint32_t(time)), protocol, data);
+        int64_t transmissionEndTime = time + int64_t((transmissionEnd - RC433HQMicroseconds(uint32_t(time))).GetUnsignedLong());
+
+        // if another transmitter should collide with this one
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        if (uniform(random) < impairments.collisionProbability) {
+
+            // start the colliding transmission somewhere during this one
+            const RC433HQTrafficProtocol &collidingProtocol = protocols[RandomUniform(0, protocolsCount - 1)];
+            byte collidingData[RC433HQ_MAX_PULSE_BITS / 8];
+            for (size_t i = 0; i < sizeof(collidingData); i++) {
+                collidingData[i] = byte(RandomUniform(0, 255));
+            }
+            AddTransmission(RC433HQMicroseconds(uint32_t(RandomUniform(time, transmissionEndTime))), collidingProtocol, collidingData);
+
+            for (size_t i = firstFrame; i < frames.size(); i++) {
+                frames[i].collided = true;
+            }
+        }
+
+        time = transmissionEndTime;
+    }
+}
+
+int64_t RC433HQTrafficGenerator::AddEncodedTransmission(int64_t startTime, const RC433HQTrafficProtocol &protocol, const byte *data, double timeScale)
+{
+    int64_t time = startTime;
+
+    // for the protocol and all the chained ones
+    for (const RC433HQTrafficProtocol *current = &protocol; current != 0; current = current->next) {
+
+        // encode the frame into the ideal intervals
+        std::vector<HighInterval> encoded;
+        IntervalTransmitter transmitter(encoded, time, timeScale);
+        current->encoder->EncodeData(transmitter, data, current->bits, current->repetitions);
+
+        if (encoded.empty()) {
+            continue;
+        }
+
+        // apply the jitter, keeping the order of the edges
+        if (impairments.jitterSigmaUs > 0) {
+            std::normal_distribution<double> jitter(0.0, impairments.jitterSigmaUs);
+            int64_t previousEnd = encoded.front().start - 1;
+            for (size_t i = 0; i < encoded.size(); i++) {
+                encoded[i].start = std::max(previousEnd + 1, encoded[i].start + int64_t(jitter(random)));
+                encoded[i].end = std::max(encoded[i].start + 1, encoded[i].end + int64_t(jitter(random)));
+                previousEnd = encoded[i].end;
+            }
+        }
+
+        intervals.insert(intervals.end(), encoded.begin(), encoded.end());
+
+        Span span = { encoded.front().start, encoded.back().end };
+        transmissionSpans.push_back(span);
+
+        // store the ground truth
+        RC433HQTrafficFrame frame;
+        memset(frame.data, 0, sizeof(frame.data));
+        frame.startTime = RC433HQMicroseconds(uint32_t(span.start));
+        frame.endTime = RC433HQMicroseconds(uint32_t(span.end));
+        frame.protocol = current->protocol;
+        memcpy(frame.data, data, (current->bits + 7) >> 3);
+        frame.bits = current->bits;
+        frame.repetitions = current->repetitions;
+        frame.collided = false;
+        frames.push_back(frame);
+        frameStartTimes.push_back(span.start);
+
+        time = transmitter.GetTime();
+    }
+
+    return time;
+}
+
+void RC433HQTrafficGenerator::Generate(RC433HQEdgeStream &edges, RC433HQTrafficFrames &groundTruth)
+{
+    edges.clear();
+    groundTruth.clear();
+
+    if (intervals.empty()) {
+        return;
+    }
+
+    // sort the transmission spans for the AGC noise detection
+    std::sort(transmissionSpans.begin(), transmissionSpans.end(), [](const Span &a, const Span &b) { return a.start < b.start; });
+
+    // find the total time range and add the noise into it
+    int64_t startTime = intervals.front().start;
+    int64_t endTime = intervals.front().end;
+    for (size_t i = 0; i < intervals.size(); i++) {
+        startTime = std::min(startTime, intervals[i].start);
+        endTime = std::max(endTime, intervals[i].end);
+    }
+    AddNoise(startTime, endTime);
+
+    // merge the overlapping intervals (the receiver sees the high level if any of the transmitters is on)
+    std::sort(intervals.begin(), intervals.end());
+    HighInterval current = intervals.front();
+    for (size_t i = 1; i <= intervals.size(); i++) {
+        if ((i < intervals.size()) && (intervals[i].start <= current.end)) {
+            current.end = std::max(current.end, intervals[i].end);
+        } else {
+            RC433HQEdge rising = { RC433HQMicroseconds(uint32_t(current.start)), true };
+            RC433HQEdge falling = { RC433HQMicroseconds(uint32_t(current.end)), false };
+            edges.push_back(rising);
+            edges.push_back(falling);
+            if (i < intervals.size()) {
+                current = intervals[i];
+            }
+        }
+    }
+
+    // return the ground truth sorted by the start time
+    std::vector<size_t> order(frames.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    const std::vector<int64_t> &startTimes = frameStartTimes;
+    std::stable_sort(order.begin(), order.end(), [&startTimes](size_t a, size_t b) { return startTimes[a] < startTimes[b]; });
+    for (size_t i = 0; i < order.size(); i++) {
+        groundTruth.push_back(frames[order[i]]);
+    }
+}
+
+void RC433HQTrafficGenerator::AddNoise(int64_t startTime, int64_t endTime)
+{
+    // short noise spikes anywhere
+    if (impairments.noiseSpikesPerSecond > 0) {
+        for (int64_t time = startTime + int64_t(RandomExponential(impairments.noiseSpikesPerSecond / 1e6)); time < endTime; time += int64_t(RandomExponential(impairments.noiseSpikesPerSecond / 1e6))) {
+            HighInterval spike = { time, time + RandomUniform(impairments.noiseSpikeMinUs.GetUnsignedLong(), impairments.noiseSpikeMaxUs.GetUnsignedLong()) };
+            intervals.push_back(spike);
+        }
+    }
+
+    // bursts of random pulses while there is no transmission (the receiver AGC increases the gain)
+    if (impairments.agcBurstsPerSecond > 0) {
+        for (int64_t time = startTime + int64_t(RandomExponential(impairments.agcBurstsPerSecond / 1e6)); time < endTime; time += int64_t(RandomExponential(impairments.agcBurstsPerSecond / 1e6))) {
+            int64_t burstEnd = time + int64_t(impairments.agcBurstDurationUs.GetUnsignedLong());
+            for (int64_t pulse = time; pulse < burstEnd; ) {
+                int64_t high = RandomUniform(impairments.agcPulseMinUs.GetUnsignedLong(), impairments.agcPulseMaxUs.GetUnsignedLong());
+                int64_t low = RandomUniform(impairments.agcPulseMinUs.GetUnsignedLong(), impairments.agcPulseMaxUs.GetUnsignedLong());
+                if (!IsInTransmission(pulse) && !IsInTransmission(pulse + high)) {
+                    HighInterval interval = { pulse, pulse + high };
+                    intervals.push_back(interval);
+                }
+                pulse += high + low;
+            }
+        }
+    }
+}
+
+bool RC433HQTrafficGenerator::IsInTransmission(int64_t time) const
+{
+    // find the last span starting before the time
+    std::vector<Span>::const_iterator it = std::upper_bound(transmissionSpans.begin(), transmissionSpans.end(), time, [](int64_t t, const Span &span) { return t < span.start; });
+
+    // check the spans around, the overlapping transmissions might not be sorted by their ends
+    while (it != transmissionSpans.begin()) {
+        --it;
+        if (time <= it->end) {
+            return true;
+        }
+        if (it->end + int64_t(60000000) < time) {
+            break;
+        }
+    }
+    return false;
+}
+
+double RC433HQTrafficGenerator::RandomExponential(double rate)
+{
+    std::exponential_distribution<double> distribution(rate);
+    return distribution(random);
+}
+
+int64_t RC433HQTrafficGenerator::RandomUniform(int64_t min, int64_t max)
+{
+    std::uniform_int_distribution<int64_t> distribution(min, max);
+    return distribution(random);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQTrafficScore implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+void RC433HQTrafficFrameCollector::HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality)
+{
+    RC433HQDecodedTrafficFrame frame;
+    memset(frame.data, 0, sizeof(frame.data));
+    frame.time = time;
+    frame.protocol = protocol;
+    memcpy(frame.data, data, (std::min(bits, RC433HQ_MAX_PULSE_BITS) + 7) >> 3);
+    frame.bits = bits;
+    frame.quality = quality;
+    decodedFrames.push_back(frame);
+}
+
+RC433HQTrafficScore::RC433HQTrafficScore():
+    transmittedFrames(0),
+    transmittedRepetitions(0),
+    detectedFrames(0),
+    decodedRepetitions(0),
+    falseFrames(0)
+{
+}
+
+void RC433HQTrafficScore::Evaluate(const RC433HQTrafficFrames &groundTruth, const RC433HQDecodedTrafficFrames &decodedFrames)
+{
+    std::vector<bool> matched(decodedFrames.size(), false);
+
+    for (size_t i = 0; i < groundTruth.size(); i++) {
+
+        const RC433HQTrafficFrame &frame = groundTruth[i];
+        RC433HQMicroseconds earliest = frame.startTime - RC433HQMicrosecondsDiff(TRAFFIC_SCORE_TIME_SLACK_US);
+        size_t repetitions = 0;
+
+        // find the decoded repetitions of this frame
+        for (size_t j = 0; j < decodedFrames.size(); j++) {
+
+            const RC433HQDecodedTrafficFrame &decoded = decodedFrames[j];
+
+            if (!matched[j] && (decoded.protocol == frame.protocol) && (decoded.bits == frame.bits) &&
+                !decoded.time.IsBefore(earliest) && !decoded.time.IsAfter(frame.endTime) &&
+                (memcmp(decoded.data, frame.data, frame.bits >> 3) == 0) &&
+                (((frame.bits & 7) == 0) || (((decoded.data[frame.bits >> 3] ^ frame.data[frame.bits >> 3]) & ((1 << (frame.bits & 7)) - 1)) == 0))) {
+
+                if (repetitions < frame.repetitions) {
+                    matched[j] = true;
+                    repetitions++;
+                }
+            }
+        }
+
+        transmittedFrames++;
+        transmittedRepetitions += frame.repetitions;
+        decodedRepetitions += repetitions;
+        if (repetitions > 0) {
+            detectedFrames++;
+        }
+    }
+
+    for (size_t j = 0; j < matched.size(); j++) {
+        if (!matched[j]) {
+            falseFrames++;
+        }
+    }
+}
+
+double RC433HQTrafficScore::GetFrameDetectionRate() const
+{
+    return (transmittedFrames > 0)? double(detectedFrames) / transmittedFrames: 0.0;
+}
+
+double RC433HQTrafficScore::GetRepetitionDecodeRate() const
+{
+    return (transmittedRepetitions > 0)? double(decodedRepetitions) / transmittedRepetitions: 0.0;
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+// Host only (Linux) part of the library: synthetic 433 MHz traffic generator. The transmissions are encoded
+// by the regular encoders (e.g. RC433HQEmosSocketsPulseEncoderA/B) and the resulting signal is impaired by
+// the timing jitter, noise spikes, receiver AGC noise bursts, clock skew and overlapping transmissions.
+
+#include "../rc433hq.h"
+
+#include <vector>
+#include <random>
+
+/**
+  @file rc433hq_traffic.h
+*/
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQEdge declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// one rising or falling edge of the received signal
+struct RC433HQEdge {
+	RC433HQMicroseconds time;
+	bool direction;
+};
+
+typedef std::vector<RC433HQEdge> RC433HQEdgeStream;
+
+// pass all the edges of the stream into the processor
+void RC433HQSendEdges(const RC433HQEdgeStream &edges, IRC433PulseProcessor &processor);
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQTrafficGenerator declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// protocol used for the generated transmissions
+struct RC433HQTrafficProtocol {
+	RC433HQBasicSyncPulseEncoder *encoder;
+	int protocol;                          // protocol id reported in the ground truth frames
+	size_t bits;                           // count of data bits of the frame
+	size_t repetitions;                    // count of the frame repetitions in one transmission
+	const RC433HQTrafficProtocol *next;    // optional protocol transmitted right after this one with the same data (e.g. EMOS B after A)
+};
+
+// ground truth of one transmitted frame (with all its repetitions)
+struct RC433HQTrafficFrame {
+	RC433HQMicroseconds startTime;         // time of the first rising edge of the first repetition
+	RC433HQMicroseconds endTime;           // time of the last falling edge of the last repetition
+	int protocol;
+	byte data[RC433HQ_MAX_PULSE_BITS / 8];
+	size_t bits;
+	size_t repetitions;
+	bool collided;                         // the transmission overlapped with another one
+};
+
+typedef std::vector<RC433HQTrafficFrame> RC433HQTrafficFrames;
+
+// signal impairments, all of them are disabled by zero values
+struct RC433HQTrafficImpairments {
+	double jitterSigmaUs;                  // gaussian timing jitter of every edge
+	double clockSkewPpmSigma;              // gaussian deviation of the transmitter clock, generated per transmission
+	double noiseSpikesPerSecond;           // rate of the short random noise pulses
+	RC433HQMicrosecondsDiff noiseSpikeMinUs, noiseSpikeMaxUs;
+	double agcBurstsPerSecond;             // rate of the noise bursts of the receiver AGC during the silence
+	RC433HQMicrosecondsDiff agcBurstDurationUs;
+	RC433HQMicrosecondsDiff agcPulseMinUs, agcPulseMaxUs;
+	double collisionProbability;           // probability, that another transmission overlaps the generated one
+};
+
+class RC433HQTrafficGenerator {
+private:
+	// interval of the high signal level
+	struct HighInterval {
+		int64_t start, end;
+		bool operator<(const HighInterval &that) const { return start < that.start; }
+	};
+
+	// time span of the transmission
+	struct Span {
+		int64_t start, end;
+	};
+
+	// transmitter collecting the high intervals of one encoded frame
+	class IntervalTransmitter: public RC433HQDataTransmitterBase {
+	private:
+		std::vector<HighInterval> &intervals;
+		int64_t time;
+		double timeScale;
+		bool high;
+	public:
+		IntervalTransmitter(std::vector<HighInterval> &aintervals, int64_t astartTime, double atimeScale);
+		virtual void TransmitEdge(bool direction, RC433HQMicrosecondsDiff duration);
+		int64_t GetTime() const { return time; }
+	};
+
+private:
+	RC433HQTrafficImpairments impairments;
+	std::mt19937 random;
+	std::vector<HighInterval> intervals;
+	std::vector<Span> transmissionSpans;
+	RC433HQTrafficFrames frames;
+	std::vector<int64_t> frameStartTimes;
+
+public:
+	RC433HQTrafficGenerator(const RC433HQTrafficImpairments &aimpairments, unsigned seed = 1);
+
+	// clean signal without any impairments
+	static RC433HQTrafficImpairments NoImpairments();
+
+	// add one transmission (including the chained protocols) with given data at given time, returns the time of its end
+	RC433HQMicroseconds AddTransmission(RC433HQMicroseconds startTime, const RC433HQTrafficProtocol &protocol, const byte *data);
+
+	// add transmissions of random data in random intervals (poisson process) into the given time range. The protocols
+	// are chosen randomly from the array. Overlapping transmissions are added according to the collisionProbability.
+	void AddRandomTraffic(RC433HQMicroseconds startTime, RC433HQMicrosecondsDiff duration, double transmissionsPerSecond, const RC433HQTrafficProtocol *protocols, size_t protocolsCount);
+
+	// apply the noise and generate the edge stream and the ground truth frames sorted by the start time
+	void Generate(RC433HQEdgeStream &edges, RC433HQTrafficFrames &groundTruth);
+
+private:
+	int64_t AddEncodedTransmission(int64_t startTime, const RC433HQTrafficProtocol &protocol, const byte *data, double timeScale);
+	void AddNoise(int64_t startTime, int64_t endTime);
+	bool IsInTransmission(int64_t time) const;
+	double RandomExponential(double rate);
+	int64_t RandomUniform(int64_t min, int64_t max);
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQTrafficScore declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// decoded frame collected for the scoring
+struct RC433HQDecodedTrafficFrame {
+	RC433HQMicroseconds time;
+	int protocol;
+	byte data[RC433HQ_MAX_PULSE_BITS / 8];
+	size_t bits;
+	double quality;
+};
+
+typedef std::vector<RC433HQDecodedTrafficFrame> RC433HQDecodedTrafficFrames;
+
+// data receiver that collects the decoded frames of one protocol
+class RC433HQTrafficFrameCollector: public IRC433DataReceiver {
+private:
+	RC433HQDecodedTrafficFrames &decodedFrames;
+	int protocol;
+public:
+	RC433HQTrafficFrameCollector(RC433HQDecodedTrafficFrames &adecodedFrames, int aprotocol):
+		decodedFrames(adecodedFrames),
+		protocol(aprotocol)
+	{
+	}
+
+	virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality);
+};
+
+// comparison of the decoded frames with the ground truth
+struct RC433HQTrafficScore {
+	size_t transmittedFrames;              // count of the ground truth frames
+	size_t transmittedRepetitions;         // total count of the repetitions in the ground truth frames
+	size_t detectedFrames;                 // ground truth frames with at least one correctly decoded repetition
+	size_t decodedRepetitions;             // correctly decoded repetitions
+	size_t falseFrames;                    // decoded frames that do not match any ground truth frame
+
+	RC433HQTrafficScore();
+
+	// score the decoded frames (in any order) against the ground truth frames
+	void Evaluate(const RC433HQTrafficFrames &groundTruth, const RC433HQDecodedTrafficFrames &decodedFrames);
+
+	double GetFrameDetectionRate() const;
+	double GetRepetitionDecodeRate() const;
+};
@@ -13,12 +13,19 @@
 #endif  // defined ARDUINO
 
 
+#if !defined ARDUINO
+#   include <time.h>
+#   if defined __x86_64__ || defined __i386__
+#       include <x86intrin.h>
+#   endif  // defined __x86_64__ || defined __i386__
+#endif  // !defined ARDUINO
+
 #if defined USE_ERCA_GUY_TIMER
 #   include "libraries\eRCaGuy_TimerCounter\eRCaGuy_Timer2_Counter.cpp"
 //#   include <libraries\eRCaGuy_TimerCounter\eRCaGuy_Timer2_Counter.h>
 #endif  // defined USE_ERCA_GUY_TIMER
 
-bool EqualWithTolerance(RC433HQMicrosecondsDiff a, RC433HQMicrosecondsDiff b, RC433HQMicrosecondsDiff tolerance)
+constexpr bool EqualWithTolerance(RC433HQMicrosecondsDiff a, RC433HQMicrosecondsDiff b, RC433HQMicrosecondsDiff tolerance)
 {
     return ((a - tolerance) <= b) && (b <= (a + tolerance));
 }
@@ -79,6 +86,138 @@ void RC433HQTimeService::SleepMicroseconds(RC433HQMicrosecondsDiff delay)
 }
 
 
+// resolution of the time returned by GetTimeInMicroseconds() in nanoseconds
+unsigned long RC433HQTimeService::GetTimerResolutionNs()
+{
+#   if defined USE_ERCA_GUY_TIMER
+
+        // the eRCaGuy's library counts in 0.5 us
+        return 500;
+
+#   elif defined __AVR__ && defined F_CPU
+
+        // the AVR micros() is based on the timer 0 with prescaler 64
+        return (64UL * 1000UL) / (F_CPU / 1000000UL);
+
+#   else   // defined USE_ERCA_GUY_TIMER
+
+        return 1000;
+
+#   endif  // defined USE_ERCA_GUY_TIMER
+}
+
+// the shared instance of the board clock
+RC433HQSystemClock RC433HQSystemClock::instance;
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQProfiler implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+#if !defined ARDUINO
+
+    // monotonic time in nanoseconds on the host
+    static uint64_t GetHostNanoseconds()
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return uint64_t(now.tv_sec) * 1000000000ULL + uint64_t(now.tv_nsec);
+    }
+
+#endif  // !defined ARDUINO
+
+// get the current count of ticks (CPU cycles if available, otherwise microseconds)
+RC433HQTicks RC433HQTickService::GetTicks()
+{
+#   if defined ESP8266 || defined ESP32
+
+        // the cycle counter of the Xtensa CPU
+        return ESP.getCycleCount();
+
+#   elif !defined ARDUINO && (defined __x86_64__ || defined __i386__)
+
+        // time stamp counter of the host CPU
+        return RC433HQTicks(__rdtsc());
+
+#   elif !defined ARDUINO
+
+        return RC433HQTicks(GetHostNanoseconds());
+
+#   else   // defined ESP8266 || defined ESP32
+
+        // fall back to the microseconds
+        return RC433HQTimeService::GetTimeInMicroseconds().GetUnsignedLong();
+
+#   endif  // defined ESP8266 || defined ESP32
+}
+
+// count of ticks per one millisecond
+unsigned long RC433HQTickService::GetTicksPerMillisecond()
+{
+#   if defined ESP8266 || defined ESP32
+
+        return ESP.getCpuFreqMHz() * 1000UL;
+
+#   elif !defined ARDUINO && (defined __x86_64__ || defined __i386__)
+
+        // the frequency of the time stamp counter is not known, measure it once against the monotonic clock
+        static unsigned long ticksPerMillisecond = 0;
+        if (ticksPerMillisecond == 0) {
+
+            uint64_t startNs = GetHostNanoseconds();
+            uint64_t startTicks = __rdtsc();
+            uint64_t endNs = startNs;
+            while (endNs - startNs < 10000000ULL) {
+                endNs = GetHostNanoseconds();
+            }
+            ticksPerMillisecond = (unsigned long)((__rdtsc() - startTicks) * 1000000ULL / (endNs - startNs));
+        }
+        return ticksPerMillisecond;
+
+#   elif !defined ARDUINO
+
+        return 1000000UL;
+
+#   else   // defined ESP8266 || defined ESP32
+
+        return 1000UL;
+
+#   endif  // defined ESP8266 || defined ESP32
+}
+
+void RC433HQDurationStatistics::Reset()
+{
+    count = 0;
+    minTicks = 0;
+    maxTicks = 0;
+    totalTicks = 0;
+    memset(histogram, 0, sizeof(histogram));
+}
+
+void RC433HQDurationStatistics::GetSnapshot(RC433HQDurationStatistics &snapshot) const
+{
+    // the statistics might be updated from the interrupt
+    noInterrupts();
+    snapshot = *this;
+    interrupts();
+}
+
+#if defined RC433HQ_PROFILE
+
+RC433HQDurationStatistics RC433HQProfiler::interruptStatistics;
+RC433HQDurationStatistics RC433HQProfiler::maskedSectionStatistics;
+
+void RC433HQProfiler::Reset()
+{
+    noInterrupts();
+    interruptStatistics.Reset();
+    maskedSectionStatistics.Reset();
+    interrupts();
+}
+
+#endif  // defined RC433HQ_PROFILE
+
+
 //////////////////////////////////////////////////////////////////////////////////
 // RC433HQPulseBuffer implementation
 //////////////////////////////////////////////////////////////////////////////////
@@ -86,12 +225,17 @@ void RC433HQTimeService::SleepMicroseconds(RC433HQMicrosecondsDiff delay)
 RC433HQPulseBuffer::RC433HQPulseBuffer(IRC433PulseProcessor &aconnectedPulseDecoder, size_t abufferSize):
     connectedPulseDecoder(aconnectedPulseDecoder),
     logger(0),
+    timeExtender(0),
     bufferSize(abufferSize),
+    lastSentEdgeTime(0),
     dataIndex(0),
     freeIndex(0),
     usedCount(0),
     missedCount(0),
-    lastSentEdgeTime(0)
+    missedIndexSet(false),
+    missedIndex(0),
+    overflowing(false),
+    overflowIndex(0)
 {
     buffer = new BufferValue[bufferSize];
 }
@@ -103,454 +247,1736 @@ RC433HQPulseBuffer::~RC433HQPulseBuffer()
 
 void RC433HQPulseBuffer::ProcessData(size_t &reportedBufferUsedCount, size_t &reportedProcessedCount, size_t &reportedMissedCount)
 {
-    // initialize the output values
-    reportedBufferUsedCount = 0;
-    reportedProcessedCount = 0;
-    reportedMissedCount = 0;
+    // process all the buffered data
+    ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount, 0, 0);
+}
 
-    bool continueProcessing = false;
-	
-    bool missedIndexSet = false;
-    size_t missedIndex = 0;;
+bool RC433HQPulseBuffer::ProcessData(size_t &reportedBufferUsedCount, size_t &reportedProcessedCount, size_t &reportedMissedCount, size_t maxEdges, RC433HQMicrosecondsDiff maxDuration)
+{
+    return ProcessDataInto(connectedPulseDecoder, reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount, maxEdges, maxDuration);
+}
 
-    do {
+void RC433HQPulseBuffer::TakeStatistics(RC433HQPulseBufferStatistics &snapshot)
+{
+    noInterrupts();
+
+    snapshot = statistics;
+
+    // the unfinished overflow episode continues as the first one of the new statistics (with all its lost edges), the
+    // lost edges of the statistics start from 0 as the other counters
+    RC433HQOverflowEpisode episode = statistics.overflowEpisodes[overflowIndex];
+    statistics.Reset();
+    statistics.highWaterMark = usedCount;
+    if (overflowing) {
+        statistics.overflowEpisodes[0] = episode;
+        overflowIndex = 0;
+    }
 
-        continueProcessing = false;
+    interrupts();
+}
 
-        bool dataAvailable = false;
-        RC433HQMicroseconds time;
-        bool direction;
+void RC433HQPulseBufferStatistics::Reset()
+{
+    highWaterMark = 0;
+    relativeEdges = 0;
+    absoluteEdges = 0;
+    for (size_t i = 0; i < RC433HQ_OCCUPANCY_HISTOGRAM_BUCKETS; i++) {
+        occupancyHistogram[i] = 0;
+    }
+    lostEdges = 0;
+    overflowEpisodesCount = 0;
+    for (size_t i = 0; i < RC433HQ_OVERFLOW_EPISODES; i++) {
+        overflowEpisodes[i].startTime = 0;
+        overflowEpisodes[i].duration = 0;
+        overflowEpisodes[i].lostEdges = 0;
+    }
+}
 
-        bool sendHandleMissedEdges = false;
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPulseRecorder implementation
+//////////////////////////////////////////////////////////////////////////////////
 
-        // disable the interrupts for a while
-        noInterrupts();
-        
-        // if there are some items in the buffer
-        if (usedCount > 0) {
+const byte RC433HQ_CAPTURE_MAGIC[4] = { 'R', 'Q', 'E', 'C' };
 
-            // set the data available flag
-            dataAvailable = true;
+RC433HQPulseRecorder::RC433HQPulseRecorder(IRC433CaptureSink &asink, unsigned long atimerResolutionNs):
+    sink(asink),
+    timerResolutionNs(atimerResolutionNs),
+    headerWritten(false),
+    lastEdgeValid(false),
+    cacheUsed(0)
+{
+}
 
-            // read the first item from the buffer
-            BufferValue value = buffer[dataIndex]; dataIndex = CalculateNext(dataIndex); usedCount--; reportedBufferUsedCount++;
+void RC433HQPulseRecorder::HandleEdge(RC433HQMicroseconds time, bool direction)
+{
+    WriteHeader();
 
-            // calculate the direction
-            direction = (value & 0x8000) != 0;
+    word directionMask = (direction? RC433HQ_CAPTURE_DIRECTION_MASK: 0x0000);
+    RC433HQMicrosecondsDiff relativeEdgeTime = time - lastEdgeTime;
 
-            // if the value is a marker that the absolute time is stored
-            if ((value & 0x7fff) == 0x7fff) {
+    // if the time since the previous edge fits into 15 bits (the two highest values are reserved)
+    if (lastEdgeValid && (relativeEdgeTime < RC433HQ_CAPTURE_MISSED_EDGES)) {
 
-                // there should be two more values
-                // assert(usedCount >= 2);
+        // store the relative edge time
+        WriteWord(directionMask | relativeEdgeTime.GetLoWord());
 
-                // read the absolute time from the buffer
-                unsigned long timeLow = buffer[dataIndex]; dataIndex = CalculateNext(dataIndex); usedCount--; reportedBufferUsedCount++;
-                unsigned long timeHigh = buffer[dataIndex]; dataIndex = CalculateNext(dataIndex); usedCount--; reportedBufferUsedCount++;
+    } else {
 
-                // calculate the time from two words
-                time = (timeHigh << 16) | timeLow;
+        // store the absolute time
+        WriteWord(directionMask | RC433HQ_CAPTURE_ABSOLUTE_TIME);
+        WriteWord(time.GetLoWord());
+        WriteWord(time.GetHiWord());
+    }
 
-            } else {
+    lastEdgeTime = time;
+    lastEdgeValid = true;
+}
 
-                // we will calculate the relative time
-                time = lastSentEdgeTime + (value & 0x7fff);
-            }
+void RC433HQPulseRecorder::HandleMissedEdges()
+{
+    WriteHeader();
 
-            // if the missed index has been set and points to the next
-            if (missedIndexSet && (missedIndex == dataIndex)) {
+    // mark the missed edges, the next edge is stored with the absolute time
+    WriteWord(RC433HQ_CAPTURE_MISSED_EDGES);
+    lastEdgeValid = false;
+}
 
-                // set the flag to call the handle missed edges
-                sendHandleMissedEdges = true;
+void RC433HQPulseRecorder::Flush()
+{
+    if (cacheUsed > 0) {
+        sink.WriteCaptureData(cache, cacheUsed);
+        cacheUsed = 0;
+    }
+}
 
-                // clear the value of the free index
-                missedIndexSet = false;
-                missedIndex = freeIndex;
-            }
+void RC433HQPulseRecorder::WriteHeader()
+{
+    if (!headerWritten) {
+
+        headerWritten = true;
+
+        byte header[RC433HQ_CAPTURE_HEADER_SIZE];
+        memset(header, 0, sizeof(header));
+        memcpy(header, RC433HQ_CAPTURE_MAGIC, sizeof(RC433HQ_CAPTURE_MAGIC));
+        header[4] = byte(RC433HQ_CAPTURE_VERSION & 0xff);
+        header[5] = byte(RC433HQ_CAPTURE_VERSION >> 8);
+        header[6] = byte(RC433HQ_CAPTURE_HEADER_SIZE & 0xff);
+        header[7] = byte(RC433HQ_CAPTURE_HEADER_SIZE >> 8);
+        for (size_t i = 0; i < 4; i++) {
+            header[8 + i] = byte((timerResolutionNs >> (8 * i)) & 0xff);
+        }
+        sink.WriteCaptureData(header, sizeof(header));
+    }
+}
 
-            // if there are still some data
-            if (usedCount > 0) {
+void RC433HQPulseRecorder::WriteWord(word value)
+{
+    if (cacheUsed + 2 > sizeof(cache)) {
+        Flush();
+    }
+    cache[cacheUsed++] = byte(value & 0xff);
+    cache[cacheUsed++] = byte(value >> 8);
+}
 
-                // set the flag to make one more iteration
-                continueProcessing = true;
-            }
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameQueue implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQFrameQueue::RC433HQFrameQueue(size_t acapacity):
+    capacity(acapacity),
+    readyIndex(0),
+    readyCount(0),
+    droppedCount(0)
+{
+    slots = new Slot[capacity];
+    freeSlots = new size_t[capacity];
+    readySlots = new size_t[capacity];
+
+    // all the slots are free, the lowest are used first
+    for (size_t i = 0; i < capacity; i++) {
+        freeSlots[i] = capacity - 1 - i;
+    }
+    freeCount = capacity;
+}
+
+RC433HQFrameQueue::~RC433HQFrameQueue()
+{
+    delete [] readySlots; readySlots = 0;
+    delete [] freeSlots; freeSlots = 0;
+    delete [] slots; slots = 0;
+}
+
+bool RC433HQFrameQueue::Peek(RC433HQFrameView &view) const
+{
+    if (readyCount == 0) {
+        return false;
+    }
+
+    view.slot = &slots[readySlots[readyIndex]];
+    return true;
+}
+
+void RC433HQFrameQueue::Pop()
+{
+    if (readyCount == 0) {
+        return;
+    }
+
+    // return the slot of the oldest frame to the free slots
+    freeSlots[freeCount++] = readySlots[readyIndex];
+    readyIndex = (readyIndex + 1) % capacity;
+    readyCount--;
+}
+
+byte *RC433HQFrameQueue::ReserveSlot(size_t &slot)
+{
+    if (freeCount == 0) {
+        slot = NO_SLOT;
+        return 0;
+    }
+
+    slot = freeSlots[--freeCount];
+    return slots[slot].data;
+}
+
+void RC433HQFrameQueue::CommitSlot(size_t slot, byte protocol, RC433HQExtendedMicroseconds time, size_t bits, double quality)
+{
+    slots[slot].protocol = protocol;
+    slots[slot].time = time;
+    slots[slot].bits = byte(bits);
+    slots[slot].quality = quality;
+
+    // append the slot behind the ready frames
+    readySlots[(readyIndex + readyCount) % capacity] = slot;
+    readyCount++;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameValidators implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+RC433HQCrc::RC433HQCrc(byte awidth, word apolynomial, word ainit, word axorOut):
+    width(awidth),
+    polynomial(apolynomial),
+    init(ainit),
+    xorOut(axorOut),
+    mask(word((1UL << awidth) - 1))
+{
+    // the CRC of every nibble shifted into the top of the register
+    for (word nibble = 0; nibble < 16; nibble++) {
+        word crc = word(nibble << (width - 4));
+        for (byte i = 0; i < 4; i++) {
+            crc = UpdateBit(crc, 0);
+        }
+        table[nibble] = crc;
+    }
+}
+
+word RC433HQCrc::UpdateBit(word crc, byte bit) const
+{
+    crc ^= word(bit << (width - 1));
+    if (crc & (1U << (width - 1))) {
+        return word((crc << 1) ^ polynomial) & mask;
+    }
+    return word(crc << 1) & mask;
+}
+
+word RC433HQCrc::Calculate(const byte *data, size_t bits, size_t count) const
+{
+    word crc = init;
+
+    // the full bytes by the nibbles
+    size_t fullBytesBits = (bits & ~size_t(7));
+    size_t i = 0;
+    for (; (i + 8 <= count) && (i + 8 <= fullBytesBits); i += 8) {
+        byte value = data[i >> 3];
+        crc = word((crc << 4) ^ table[((crc >> (width - 4)) ^ (value >> 4)) & 0x0f]) & mask;
+        crc = word((crc << 4) ^ table[((crc >> (width - 4)) ^ value) & 0x0f]) & mask;
+    }
+
+    // the rest bit by bit
+    for (; i < count; i++) {
+        uint32_t bit;
+        RC433HQGetFrameBits(data, bits, i, 1, bit);
+        crc = UpdateBit(crc, byte(bit));
+    }
+
+    return crc ^ xorOut;
+}
+
+bool RC433HQCrcValidator::ValidateFrame(const byte *data, size_t bits)
+{
+    // the CRC is in the last bits of the frame
+    uint32_t received;
+    if ((bits <= crc.GetWidth()) || !RC433HQGetFrameBits(data, bits, bits - crc.GetWidth(), crc.GetWidth(), received)) {
+        return false;
+    }
+    return crc.Calculate(data, bits, bits - crc.GetWidth()) == received;
+}
+
+bool RC433HQFieldValidator::ValidateFrame(const byte *data, size_t bits)
+{
+    uint32_t field;
+    if (!RC433HQGetFrameBits(data, bits, bitOffset, bitWidth, field)) {
+        return false;
+    }
+    if (!values) {
+        return field == value;
+    }
+    for (size_t i = 0; i < valuesCount; i++) {
+        if (field == values[i]) {
+            return true;
         }
+    }
+    return false;
+}
+
+bool RC433HQParityValidator::ValidateFrame(const byte *data, size_t bits)
+{
+    if (size_t(bitOffset) + bitWidth > bits) {
+        return false;
+    }
+
+    // xor all the bits of the field in chunks of up to 32 bits
+    uint32_t parity = 0;
+    for (size_t offset = bitOffset; offset < size_t(bitOffset) + bitWidth; offset += 32) {
+        size_t width = size_t(bitOffset) + bitWidth - offset;
+        uint32_t chunk;
+        RC433HQGetFrameBits(data, bits, offset, ((width > 32)? 32: width), chunk);
+        parity ^= chunk;
+    }
+    parity ^= (parity >> 16);
+    parity ^= (parity >> 8);
+    parity ^= (parity >> 4);
+    parity ^= (parity >> 2);
+    parity ^= (parity >> 1);
+    return (parity & 1) == (odd? 1U: 0U);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQDecoderMetrics implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+void RC433HQDecoderMetrics::Reset()
+{
+    syncs = 0;
+    zeroBits = 0;
+    oneBits = 0;
+    softBits = 0;
+    outOfTolerancePulses = 0;
+    brokenPulses = 0;
+    missedEdges = 0;
+    shortFrames = 0;
+    rejectedFrames = 0;
+    droppedFrames = 0;
+    deliveredFrames = 0;
+    qualitySum = 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQBasicSyncPulseDecoder implementation
+//////////////////////////////////////////////////////////////////////////////////
 
-        // if there were some missed items
-        if (missedCount > 0) {
-            
-            // if the missed index has not been set
-            if (!missedIndexSet) {
+// the data pulses up to this multiple of the tolerance away from the symbols are decided in the soft decision mode
+static const unsigned long SOFT_DECISION_TOLERANCE_FACTOR = 2;
 
-                // keep the current value of the free index
-                missedIndexSet = true;
-                missedIndex = freeIndex;
+static unsigned long AbsoluteDelta(RC433HQMicrosecondsDiff actual, RC433HQMicrosecondsDiff expected)
+{
+    return ((expected < actual)? (actual - expected): (expected - actual)).GetUnsignedLong();
+}
+
+RC433HQBasicSyncPulseDecoder::~RC433HQBasicSyncPulseDecoder()
+{
+    delete [] bitConfidences; bitConfidences = 0;
+}
+
+void RC433HQBasicSyncPulseDecoder::EnableSoftDecision()
+{
+    if (!bitConfidences) {
+        bitConfidences = new byte[RC433HQ_MAX_PULSE_BITS];
+    }
+}
+
+void RC433HQBasicSyncPulseDecoder::HandleEdge(RC433HQMicroseconds time, bool direction)
+{
+    // if the rising edge is being handled
+    if (direction) {
+
+        LOG_MESSAGE("Handling rising edge.\n");
+
+        // if both last rising and falling edge were syncDetected
+        if (previousRisingEdge && previousFallingEdge) {
+
+            LOG_MESSAGE("Previous rising and falling edge were detected.\n");
+
+            // calcuate the high and low durations
+            RC433HQMicrosecondsDiff highDuration = previousFallingEdgeTime - previousRisingEdgeTime;
+            RC433HQMicrosecondsDiff lowDuration = time - previousFallingEdgeTime;
+
+            // decode the complete pulse
+            HandlePulse(previousRisingEdgeTime, highDuration, lowDuration, ClassifyPulse(highDuration, lowDuration));
+
+        } else if (previousRisingEdge) {
+
+            HandleBrokenPulse();
+        }
+
+        // remeber the current rising edge and clean the previous falling edge
+        previousRisingEdge = true;
+        previousFallingEdge = false;
+        previousRisingEdgeTime = time;
+        previousFallingEdgeTime = 0;
+    
+    } else {
+
+        LOG_MESSAGE("Handling falling edge.\n");
+
+        // keep the falling edge time
+        previousFallingEdge = true;
+        previousFallingEdgeTime = time;
+
+        // in the early delivery mode the frame is complete by the high part of its last pulse
+        if (previousRisingEdge) {
+            DeliverEarly(time - previousRisingEdgeTime);
+        }
+    }
+}
+
+RC433HQSyncPulseTiming RC433HQBasicSyncPulseDecoder::GetTiming() const
+{
+    RC433HQSyncPulseTiming timing = { syncFirstUs, syncSecondUs, zeroFirstUs, zeroSecondUs, oneFirstUs, oneSecondUs, toleranceUs };
+    return timing;
+}
+
+byte RC433HQBasicSyncPulseDecoder::ClassifyPulse(RC433HQMicrosecondsDiff highDuration, RC433HQMicrosecondsDiff lowDuration) const
+{
+    byte symbols = 0;
+    if (EqualWithTolerance(highDuration, oneFirstUs, toleranceUs) && EqualWithTolerance(lowDuration, oneSecondUs, toleranceUs)) {
+        symbols |= RC433HQ_SYMBOL_ONE;
+    }
+    if (EqualWithTolerance(highDuration, zeroFirstUs, toleranceUs) && EqualWithTolerance(lowDuration, zeroSecondUs, toleranceUs)) {
+        symbols |= RC433HQ_SYMBOL_ZERO;
+    }
+    if (EqualWithTolerance(highDuration, syncFirstUs, toleranceUs) && EqualWithTolerance(lowDuration, syncSecondUs, toleranceUs)) {
+        symbols |= RC433HQ_SYMBOL_SYNC;
+    }
+    return symbols;
+}
+
+void RC433HQBasicSyncPulseDecoder::HandlePulse(RC433HQMicroseconds time, RC433HQMicrosecondsDiff highDuration, RC433HQMicrosecondsDiff lowDuration, byte symbols)
+{
+    // the last pulse might not have been delivered early at its falling edge (e.g. the batch decoding has no falling edges)
+    DeliverEarly(highDuration);
+
+    // if the last pulse represented a data bit
+    byte bit = 0, confidence = 0;
+    if (syncDetected && DecodeBit(highDuration, lowDuration, symbols, bit, confidence)) {
+
+        LOG_MESSAGE(bit? "Sync detected and pulse represents bit 1.\n": "Sync detected and pulse represents bit 0.\n");
+
+        // store the bit
+        StoreReceivedBit(bit, confidence);
+
+        // if we reached the higher limit of the received bit
+        if (receivedBits == maxBits) {
+
+            LOG_MESSAGE("Max bits received, sending data.\n");
+
+            // send the data to the data receiver and clear the buffer
+            SendReceivedData();
+
+            // no sync anymore
+            syncDetected = false;
+        }
+
+    } else {
+
+        // no data pulse was detected
+        bool receiving = syncDetected;
+        FinishReceivedData();
+
+        // if the sync pulse was detected
+        if (symbols & RC433HQ_SYMBOL_SYNC) {
+
+            LOG_MESSAGE("Sync pulse deteceted.\n");
+
+            metrics.syncs++;
+
+            // calculate the delta of the sync
+            ClearDelta();
+            CalculateDelta(highDuration, syncFirstUs);
+            CalculateDelta(lowDuration, syncSecondUs);
+
+            // receive the bits directly into the frame queue slot, if there is a free one
+            if (frameQueue && (frameQueueSlot == RC433HQFrameQueue::NO_SLOT)) {
+                byte *slotData = frameQueue->ReserveSlot(frameQueueSlot);
+                receivedBuffer = (slotData? slotData: receivedData);
             }
 
-            // keep the number of missed items
-            reportedMissedCount += missedCount;
+            // start a new sequence after the successfull sync
+            ClearReceivedBits();
+            syncDetected = true;
+            syncTime = time;
+
+            // extend the time of the sync to 64-bits now, the data might be sent much later (e.g. after a long silence)
+            extendedSyncTime = (timeExtender? timeExtender->Extend(syncTime): RC433HQExtendedMicroseconds(0, syncTime));
+
+        } else if (receiving) {
+
+            // the reception was ended by a pulse out of the tolerance
+            metrics.outOfTolerancePulses++;
+        }
+    }
+}
+
+void RC433HQBasicSyncPulseDecoder::HandleBrokenPulse()
+{
+    LOG_MESSAGE("Falling edge between two rising edges was lost.\n");
+
+    metrics.brokenPulses++;
+
+    // the pulse is broken, the same as no data pulse
+    FinishReceivedData();
+}
 
-            // clear the original missed items counter
-            missedCount = 0;
+bool RC433HQBasicSyncPulseDecoder::DecodeBit(RC433HQMicrosecondsDiff highDuration, RC433HQMicrosecondsDiff lowDuration, byte symbols, byte &bit, byte &confidence)
+{
+    // if the pulse represents a 1
+    if (symbols & RC433HQ_SYMBOL_ONE) {
+        bit = 1;
+        metrics.oneBits++;
+
+    // if the pulse represents a 0
+    } else if (symbols & RC433HQ_SYMBOL_ZERO) {
+        bit = 0;
+        metrics.zeroBits++;
+
+    } else if (bitConfidences) {
+
+        // decide by the nearest symbol, if it is not too far away
+        unsigned long oneError = AbsoluteDelta(highDuration, oneFirstUs);
+        unsigned long oneLowError = AbsoluteDelta(lowDuration, oneSecondUs);
+        if (oneLowError > oneError) {
+            oneError = oneLowError;
         }
+        unsigned long zeroError = AbsoluteDelta(highDuration, zeroFirstUs);
+        unsigned long zeroLowError = AbsoluteDelta(lowDuration, zeroSecondUs);
+        if (zeroLowError > zeroError) {
+            zeroError = zeroLowError;
+        }
+        bit = ((oneError < zeroError)? 1: 0);
+        if (((bit? oneError: zeroError) > SOFT_DECISION_TOLERANCE_FACTOR * toleranceUs) || (oneError == zeroError)) {
+            return false;
+        }
+        metrics.softBits++;
+
+    } else {
+        return false;
+    }
+
+    // calculate the delta
+    CalculateDelta(highDuration, (bit? oneFirstUs: zeroFirstUs));
+    CalculateDelta(lowDuration, (bit? oneSecondUs: zeroSecondUs));
+
+    if (bitConfidences) {
+        confidence = CalculateConfidence(AbsoluteDelta(highDuration, (bit? oneFirstUs: zeroFirstUs)), AbsoluteDelta(lowDuration, (bit? oneSecondUs: zeroSecondUs)));
+    }
+    return true;
+}
+
+bool RC433HQBasicSyncPulseDecoder::DecodeLastBit(RC433HQMicrosecondsDiff highDuration, byte &bit, byte &confidence)
+{
+    // the high duration has to match exactly one of the symbols
+    bool one = EqualWithTolerance(highDuration, oneFirstUs, toleranceUs);
+    bool zero = EqualWithTolerance(highDuration, zeroFirstUs, toleranceUs);
+    if (one == zero) {
+        return false;
+    }
+    bit = (one? 1: 0);
+    if (one) {
+        metrics.oneBits++;
+    } else {
+        metrics.zeroBits++;
+    }
+
+    // calculate the delta of the known part of the pulse
+    CalculateDelta(highDuration, (one? oneFirstUs: zeroFirstUs));
+    if (bitConfidences) {
+        confidence = CalculateConfidence(AbsoluteDelta(highDuration, (one? oneFirstUs: zeroFirstUs)), 0);
+    }
+    return true;
+}
+
+byte RC433HQBasicSyncPulseDecoder::CalculateConfidence(unsigned long highError, unsigned long lowError) const
+{
+    // the confidence falls linearly from 255 (exact timing) through 127 (at the tolerance) to 0 (at the soft decision limit)
+    unsigned long limit = SOFT_DECISION_TOLERANCE_FACTOR * toleranceUs;
+    unsigned long error = ((highError > lowError)? highError: lowError);
+    if (limit == 0) {
+        return 255;
+    }
+    if (error >= limit) {
+        return 0;
+    }
+    return byte((255UL * (limit - error)) / limit);
+}
+
+bool RC433HQBasicSyncPulseDecoder::DeliverEarly(RC433HQMicrosecondsDiff highDuration)
+{
+    // only the maxBits-th pulse decided by its high duration
+    byte bit = 0, confidence = 0;
+    if (!earlyDelivery || !syncDetected || ((receivedBits + 1) != maxBits) || !DecodeLastBit(highDuration, bit, confidence)) {
+        return false;
+    }
+
+    LOG_MESSAGE("Last bit received, sending data early.\n");
+
+    StoreReceivedBit(bit, confidence);
+    SendReceivedData();
+
+    // no sync anymore, the next rising edge does not decode the pulse again
+    syncDetected = false;
+    return true;
+}
+
+void RC433HQBasicSyncPulseDecoder::TakeMetrics(RC433HQDecoderMetrics &snapshot)
+{
+    noInterrupts();
+    snapshot = metrics;
+    metrics.Reset();
+    interrupts();
+}
+
+void RC433HQBasicSyncPulseDecoder::HandleMissedEdges()
+{
+    LOG_MESSAGE("Handling missed edges call.\n");
+
+    metrics.missedEdges++;
+
+    // ignore the currently cached data, we will start over from the looking for the next sync
+    ClearDelta();
+    ClearReceivedBits();
+    syncDetected = false;
+}
+
+void RC433HQBasicSyncPulseDecoder::FinishReceivedData()
+{
+    // if some data were received before and is above the minimal length
+    if (receivedBits >= minBits) {
+
+        LOG_MESSAGE("Min bits received before non data pulse, sending data.\n");
 
-        // re-enable interrupts
-        interrupts();
+        // send the data to the data receiver and clear the buffer
+        SendReceivedData();
 
-        // if some data was removed from the buffer
-        if (dataAvailable) {
+    } else if (receivedBits > 0) {
+
+        // the received bits are not enough for the data, forget them
+        metrics.shortFrames++;
+        ClearReceivedBits();
+    }
 
-            // send the data to the connected decoder
-            connectedPulseDecoder.HandleEdge(time, direction);
-            lastSentEdgeTime = time;
+    // we are out of sync now
+    syncDetected = false;
+}
 
-            // increase the reported user count
-            reportedProcessedCount++;
+void RC433HQBasicSyncPulseDecoder::CalculateDelta(RC433HQMicrosecondsDiff expected, RC433HQMicrosecondsDiff actual)
+{
+    if (toleranceUs != 0) {
+        double delta;
+        if (expected < actual) {
+            delta = (actual - expected).AsDouble();
+        } else {
+            delta = (expected - actual).AsDouble();
         }
+        deltaPowerSum += (delta * delta);
+    }
+}
+
+void RC433HQBasicSyncPulseDecoder::ClearDelta()
+{
+    LOG_MESSAGE("Clearing delta sum.\n");
+    deltaPowerSum = 0;
+}
 
-        // if we should send the handle missed edges
-        if (sendHandleMissedEdges) {
+void RC433HQBasicSyncPulseDecoder::StoreReceivedBit(byte bit, byte confidence)
+{
+    if (receivedBits < RC433HQ_MAX_PULSE_BITS) {
+    
+        LOG_MESSAGE("Storing bit.\n");
 
-            // call it
-            connectedPulseDecoder.HandleMissedEdges();
-            sendHandleMissedEdges = false;
+        // store the bit
+        size_t offset = (receivedBits >> 3);
+        receivedBuffer[offset] = (receivedBuffer[offset] << 1) | bit;
+        if (bitConfidences) {
+            bitConfidences[receivedBits] = confidence;
         }
 
-    } while (continueProcessing);
+        // increase the number of stored bits
+        receivedBits++;
+    }
 }
 
-void RC433HQPulseBuffer::HandleEdge(RC433HQMicroseconds time, bool direction)
+void RC433HQBasicSyncPulseDecoder::ClearReceivedBits()
 {
-    // this method is typically called from an interrupt, so we use a simple mutual exclution 
-    // just by disabling the interrupts from the method that reads the data written here.
+    LOG_MESSAGE("Clearing recevied bits cache.\n");
 
-    // assert(buffer != 0);
+    memset(receivedBuffer, 0, RC433HQ_MAX_PULSE_BITS >> 3);
+    receivedBits = 0;
+}
 
-    bool successfullyStored = false;
+void RC433HQBasicSyncPulseDecoder::SendReceivedData()
+{
+    // drop the frame rejected by the validator, the reserved slot of the frame queue is reused for the next one
+    if (frameValidator && !frameValidator->ValidateFrame(receivedBuffer, receivedBits)) {
 
-    // if the buffer is valid
-    if (buffer != 0) {
+        LOG_MESSAGE("Frame rejected by the validator.\n");
 
-        // calculate the direction mask
-        word directionMask = (direction? 0x8000: 0x0000);
+        metrics.rejectedFrames++;
+        ClearReceivedBits();
+        return;
+    }
 
-        // if there are no items in the buffer
-        if (usedCount == 0) {
+    // data quality is 100% - totalDelta / tolerance. The range is 0% (always at tolerance) to 100% (always exact)
+    double quality;
+    
+    if (toleranceUs != 0) {
 
-            // store the absolut time of the edge
-            StoreAbsolutTime(time, directionMask);
-            lastStoredEdgeTime = time;
-            successfullyStored = true;
+        // calcutate the precission out of the average of the squares of the deltas for all edges
+        double totalDelta = sqrt(deltaPowerSum / (2 *  (receivedBits + 1)));
+        quality = 100.0 * (1.0 - (totalDelta / toleranceUs));
+
+        // the pulses decided in the soft decision mode can be out of the tolerance
+        if (quality < 0) {
+            quality = 0;
+        }
+
+#       if defined DEBUG && !defined ARDUINO
+
+        char buf[128];
+        sprintf(buf, "Calculating quality with tolerace = %i, delta sq sum = %f, quality = %f.\n", int(toleranceUs), deltaPowerSum, quality);
+        LOG_MESSAGE(buf);
+
+#       endif // defined DEBUG
+
+    } else {
+
+        LOG_MESSAGE("Setting quality as 100 per cent.\n");
 
+        quality = 100.0;
+    }
+
+    // the time of the delivery for the latency from the capture of the sync edge
+    RC433HQMicroseconds deliveryTime = (latencyStatistics? RC433HQTimeService::GetTimeInMicroseconds(): RC433HQMicroseconds(0));
+
+    if (frameQueue) {
+
+        // pass the slot with the received bits to the application, the next sync reserves a new one
+        if (frameQueueSlot != RC433HQFrameQueue::NO_SLOT) {
+            frameQueue->CommitSlot(frameQueueSlot, frameQueueProtocol, extendedSyncTime, receivedBits, quality);
+            frameQueueSlot = RC433HQFrameQueue::NO_SLOT;
+            receivedBuffer = receivedData;
         } else {
+            frameQueue->DropFrame();
+            metrics.droppedFrames++;
+            ClearReceivedBits();
+            return;
+        }
+
+    } else {
+
+        // send the data to the data receiver
+        if (bitConfidences) {
+            dataReceiver.HandleSoftData(extendedSyncTime, receivedBuffer, receivedBits, bitConfidences, quality);
+        } else {
+            dataReceiver.HandleExtendedData(extendedSyncTime, receivedBuffer, receivedBits, quality);
+        }
+    }
+
+    metrics.deliveredFrames++;
+    metrics.qualitySum += quality;
+    if (latencyStatistics) {
+        latencyStatistics->Add(RC433HQTicks((deliveryTime - syncTime).GetUnsignedLong()));
+    }
+
+    ClearReceivedBits();
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQRepetitionCombiner implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+// the bit of the frame in the decoder layout: the full bytes from the highest bit, the last partial byte right aligned
+static byte GetFrameBit(const byte *data, size_t bits, size_t index)
+{
+    size_t offset = (index >> 3);
+    size_t byteBits = (((offset + 1) << 3) <= bits)? 8: (bits & 7);
+    return (data[offset] >> (byteBits - 1 - (index & 7))) & 1;
+}
+
+RC433HQRepetitionCombiner::RC433HQRepetitionCombiner(IRC433DataReceiver &areceiver, size_t amaxBits, RC433HQMicrosecondsDiff amaxGap, size_t aexpectedRepetitions):
+    receiver(areceiver),
+    maxBits(amaxBits),
+    maxGap(amaxGap),
+    expectedRepetitions(aexpectedRepetitions),
+    bits(0),
+    repetitions(0),
+    lastRepetitions(0)
+{
+    votes = new int16_t[maxBits];
+    combinedData = new byte[(maxBits + 7) / 8];
+    combinedConfidences = new byte[maxBits];
+}
+
+RC433HQRepetitionCombiner::~RC433HQRepetitionCombiner()
+{
+    delete [] votes; votes = 0;
+    delete [] combinedData; combinedData = 0;
+    delete [] combinedConfidences; combinedConfidences = 0;
+}
+
+void RC433HQRepetitionCombiner::HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality)
+{
+    HandleSoftData(RC433HQExtendedMicroseconds(0, time), data, bits, 0, quality);
+}
+
+void RC433HQRepetitionCombiner::HandleExtendedData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, double quality)
+{
+    HandleSoftData(time, data, bits, 0, quality);
+}
+
+void RC433HQRepetitionCombiner::HandleSoftData(RC433HQExtendedMicroseconds time, const byte *data, size_t abits, const byte *confidences, double quality)
+{
+    // the frames that can't be combined are passed as they are
+    if ((abits == 0) || (abits > maxBits)) {
+        Flush();
+        receiver.HandleSoftData(time, data, abits, confidences, quality);
+        return;
+    }
+
+    // if the frame is not a repetition of the combined one, finish the combined one first
+    if ((repetitions > 0) && ((abits != bits) || (time > lastTime + maxGap))) {
+        Flush();
+    }
+
+    if (repetitions == 0) {
+        bits = abits;
+        firstTime = time;
+        memset(votes, 0, bits * sizeof(votes[0]));
+    }
+
+    // the frames without the confidences vote by their quality
+    int16_t frameConfidence = int16_t(((quality < 0)? 0: ((quality > 100)? 100: quality)) * 255 / 100);
+
+    for (size_t i = 0; i < bits; i++) {
+        int16_t confidence = (confidences? int16_t(confidences[i]): frameConfidence);
+        votes[i] += (GetFrameBit(data, bits, i)? confidence: -confidence);
+    }
+    repetitions++;
+    lastTime = time;
+
+    if (((expectedRepetitions != 0) && (repetitions >= expectedRepetitions)) || (repetitions >= MAX_REPETITIONS)) {
+        Flush();
+    }
+}
+
+void RC433HQRepetitionCombiner::Update(RC433HQMicroseconds now)
+{
+    if ((repetitions > 0) && ((now - lastTime.GetMicroseconds()) > maxGap)) {
+        Flush();
+    }
+}
+
+void RC433HQRepetitionCombiner::Flush()
+{
+    if (repetitions == 0) {
+        return;
+    }
+
+    // every bit is decided by the sign of its votes, the confidence is the average vote
+    unsigned long confidencesSum = 0;
+    memset(combinedData, 0, (bits + 7) / 8);
+    for (size_t i = 0; i < bits; i++) {
+        byte bit = ((votes[i] > 0)? 1: 0);
+        size_t offset = (i >> 3);
+        combinedData[offset] = (combinedData[offset] << 1) | bit;
+        combinedConfidences[i] = byte(((votes[i] < 0)? -votes[i]: votes[i]) / int16_t(repetitions));
+        confidencesSum += combinedConfidences[i];
+    }
+    double quality = (100.0 * confidencesSum) / (255.0 * bits);
+
+    // the receiver may pass the next frame into the combiner
+    lastRepetitions = repetitions;
+    repetitions = 0;
+
+    receiver.HandleSoftData(firstTime, combinedData, bits, combinedConfidences, quality);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQDiversityCombiner implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+void RC433HQDiversityStatistics::Reset()
+{
+    receivedFrames = 0;
+    contributedFrames = 0;
+    bestFrames = 0;
+    exclusiveFrames = 0;
+    qualitySum = 0.0;
+}
+
+RC433HQDiversityCombiner::RC433HQDiversityCombiner(IRC433DataReceiver &areceiver, size_t areceiversCount, size_t amaxBits, RC433HQMicrosecondsDiff awindow,
+    RC433HQMicrosecondsDiff amaxWait, RC433HQDiversityMode amode, size_t amaxPending):
+    receiver(areceiver),
+    receiversCount((areceiversCount > MAX_RECEIVERS)? MAX_RECEIVERS: areceiversCount),
+    maxBits(amaxBits),
+    window(awindow),
+    maxWait(amaxWait),
+    mode(amode),
+    maxDifferentBits(0),
+    pendingCount((amaxPending == 0)? 1: amaxPending),
+    deliveredFrames(0),
+    suppressedFrames(0)
+{
+    size_t maxBytes = (maxBits + 7) / 8;
+    pending = new Pending[pendingCount];
+    pendingData = new byte[pendingCount * maxBytes];
+    pendingVotes = ((mode == RC433HQ_DIVERSITY_MERGE)? new int16_t[pendingCount * maxBits]: 0);
+    for (size_t i = 0; i < pendingCount; i++) {
+        pending[i].used = false;
+        pending[i].data = pendingData + i * maxBytes;
+        pending[i].votes = (pendingVotes? pendingVotes + i * maxBits: 0);
+    }
+    combinedData = new byte[maxBytes];
+    combinedConfidences = new byte[maxBits];
+    statistics = new RC433HQDiversityStatistics[receiversCount];
+}
+
+RC433HQDiversityCombiner::~RC433HQDiversityCombiner()
+{
+    delete [] pending; pending = 0;
+    delete [] pendingData; pendingData = 0;
+    delete [] pendingVotes; pendingVotes = 0;
+    delete [] combinedData; combinedData = 0;
+    delete [] combinedConfidences; combinedConfidences = 0;
+    delete [] statistics; statistics = 0;
+}
+
+void RC433HQDiversityCombiner::HandleFrame(size_t receiverIndex, RC433HQExtendedMicroseconds time, const byte *data, size_t bits, const byte *confidences, double quality)
+{
+    // the frames that can't be combined are passed as they are
+    if ((bits == 0) || (bits > maxBits) || (receiverIndex >= receiversCount)) {
+        receiver.HandleSoftData(time, data, bits, confidences, quality);
+        return;
+    }
+
+    statistics[receiverIndex].receivedFrames++;
+    statistics[receiverIndex].qualitySum += quality;
+
+    // the frames not completed within the max wait are delivered first, in the order of their time
+    for (Pending *oldest = FindOldest(); oldest && (oldest->time + maxWait < time); oldest = FindOldest()) {
+        Deliver(*oldest);
+    }
 
-            // calculate the relative edge time from the current and last edge times
-            RC433HQMicrosecondsDiff relativeEdgeTime = time - lastStoredEdgeTime;
+    // the same frame received by another receiver, or a free entry (the oldest one is delivered if there is none)
+    Pending *frame = FindPending(receiverIndex, time, data, bits);
+    if (frame) {
+        suppressedFrames++;
+    } else {
+        for (size_t i = 0; (i < pendingCount) && !frame; i++) {
+            if (!pending[i].used) {
+                frame = &pending[i];
+            }
+        }
+        if (!frame) {
+            frame = FindOldest();
+            Deliver(*frame);
+        }
+        frame->used = true;
+        frame->bits = byte(bits);
+        frame->contributors = 0;
+        frame->bestQuality = -1.0;
+        frame->time = time;
+        if (frame->votes) {
+            memset(frame->votes, 0, bits * sizeof(frame->votes[0]));
+        }
+    }
+
+    // add the contribution of the receiver
+    frame->contributors |= word(1U << receiverIndex);
+    if (time < frame->time) {
+        frame->time = time;
+    }
+    if (quality > frame->bestQuality) {
+        frame->bestQuality = quality;
+        frame->bestReceiver = byte(receiverIndex);
+        memcpy(frame->data, data, (bits + 7) / 8);
+    }
+    if (frame->votes) {
+
+        // the frames without the confidences vote by their quality
+        int16_t frameConfidence = int16_t(((quality < 0)? 0: ((quality > 100)? 100: quality)) * 255 / 100);
+        for (size_t i = 0; i < bits; i++) {
+            int16_t confidence = (confidences? int16_t(confidences[i]): frameConfidence);
+            frame->votes[i] += (GetFrameBit(data, bits, i)? confidence: -confidence);
+        }
+    }
+
+    // nothing more can come when all the receivers contributed
+    if (frame->contributors == word((1UL << receiversCount) - 1)) {
+        Deliver(*frame);
+    }
+}
+
+RC433HQDiversityCombiner::Pending *RC433HQDiversityCombiner::FindPending(size_t receiverIndex, RC433HQExtendedMicroseconds time, const byte *data, size_t bits)
+{
+    Pending *found = 0;
+    uint64_t foundDistance = 0;
+    for (size_t i = 0; i < pendingCount; i++) {
+        Pending &frame = pending[i];
+
+        // the receiver contributes to the frame once, the frames of the receiver within the window are the repetitions
+        if (!frame.used || (frame.bits != bits) || (frame.contributors & (1U << receiverIndex)) ||
+            (time + window < frame.time) || (frame.time + window < time)) {
+            continue;
+        }
+
+        // the payload has to match up to the allowed count of the different bits
+        size_t differentBits = 0;
+        for (size_t j = 0; (j < bits) && (differentBits <= maxDifferentBits); j++) {
+            differentBits += (GetFrameBit(data, bits, j) != GetFrameBit(frame.data, bits, j));
+        }
+        if (differentBits > maxDifferentBits) {
+            continue;
+        }
+
+        // the closest one in time
+        uint64_t distance = ((time < frame.time)? (frame.time.GetUnsignedLongLong() - time.GetUnsignedLongLong()):
+            (time.GetUnsignedLongLong() - frame.time.GetUnsignedLongLong()));
+        if (!found || (distance < foundDistance)) {
+            found = &frame;
+            foundDistance = distance;
+        }
+    }
+    return found;
+}
+
+RC433HQDiversityCombiner::Pending *RC433HQDiversityCombiner::FindOldest()
+{
+    Pending *oldest = 0;
+    for (size_t i = 0; i < pendingCount; i++) {
+        if (pending[i].used && (!oldest || (pending[i].time < oldest->time))) {
+            oldest = &pending[i];
+        }
+    }
+    return oldest;
+}
+
+void RC433HQDiversityCombiner::Update(RC433HQMicroseconds now)
+{
+    for (Pending *oldest = FindOldest(); oldest && ((now - oldest->time.GetMicroseconds()) > maxWait); oldest = FindOldest()) {
+        Deliver(*oldest);
+    }
+}
+
+void RC433HQDiversityCombiner::Flush()
+{
+    for (Pending *oldest = FindOldest(); oldest; oldest = FindOldest()) {
+        Deliver(*oldest);
+    }
+}
+
+void RC433HQDiversityCombiner::Deliver(Pending &frame)
+{
+    // update the contribution statistics
+    size_t contributorsCount = 0;
+    for (size_t i = 0; i < receiversCount; i++) {
+        if (frame.contributors & (1U << i)) {
+            statistics[i].contributedFrames++;
+            contributorsCount++;
+        }
+    }
+    statistics[frame.bestReceiver].bestFrames++;
+    if (contributorsCount == 1) {
+        statistics[frame.bestReceiver].exclusiveFrames++;
+    }
+    deliveredFrames++;
+
+    // the receiver may pass the next frame into the combiner
+    frame.used = false;
+
+    if (!frame.votes) {
+        memcpy(combinedData, frame.data, (frame.bits + 7) / 8);
+        receiver.HandleSoftData(frame.time, combinedData, frame.bits, 0, frame.bestQuality);
+        return;
+    }
+
+    // every bit is decided by the sign of its votes, the confidence is the average vote
+    size_t bits = frame.bits;
+    unsigned long confidencesSum = 0;
+    memset(combinedData, 0, (bits + 7) / 8);
+    for (size_t i = 0; i < bits; i++) {
+        byte bit = ((frame.votes[i] > 0)? 1: 0);
+        size_t offset = (i >> 3);
+        combinedData[offset] = (combinedData[offset] << 1) | bit;
+        combinedConfidences[i] = byte(((frame.votes[i] < 0)? -frame.votes[i]: frame.votes[i]) / int16_t(contributorsCount));
+        confidencesSum += combinedConfidences[i];
+    }
+    double quality = (100.0 * confidencesSum) / (255.0 * bits);
+
+    receiver.HandleSoftData(frame.time, combinedData, bits, combinedConfidences, quality);
+}
+
+void RC433HQDiversityCombiner::ResetStatistics()
+{
+    for (size_t i = 0; i < receiversCount; i++) {
+        statistics[i].Reset();
+    }
+    deliveredFrames = 0;
+    suppressedFrames = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQDeviceRouter implementation
+//////////////////////////////////////////////////////////////////////////////////
+
+bool RC433HQGetFrameBits(const byte *data, size_t bits, size_t offset, size_t width, uint32_t &value)
+{
+    if ((width > 32) || (offset + width > bits)) {
+        return false;
+    }
+
+    // the decoder shifts the bits into the bytes from the right, so the last incomplete byte keeps its bits at the bottom
+    size_t fullBytesBits = (bits & ~size_t(7));
+    value = 0;
+    for (size_t i = offset; i < offset + width; i++) {
+        size_t bitsInByte = ((i < fullBytesBits)? 8: (bits & 7));
+        byte bit = (data[i >> 3] >> (bitsInByte - 1 - (i & 7))) & 1;
+        value = (value << 1) | bit;
+    }
+    return true;
+}
 
-            // if the time is smaller than what fits into 15 bits
-            if (relativeEdgeTime < 0x7fff) {
 
-                // if there is one item available in the buffer
-                if (usedCount < bufferSize) {
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQLinkQualityTracker implementation
+//////////////////////////////////////////////////////////////////////////////////
 
-                    // store the relative edge time
-                    buffer[freeIndex] = directionMask | BufferValue(relativeEdgeTime.GetLoWord()); freeIndex = CalculateNext(freeIndex);  // direction and 15 bits
-                    usedCount++;
-                    lastStoredEdgeTime = time;
-                    successfullyStored = true;
-                }
+RC433HQLinkQualityTracker::RC433HQLinkQualityTracker(size_t acapacity, RC433HQMicrosecondsDiff arepetitionGap):
+    capacity((acapacity > MAX_CAPACITY)? MAX_CAPACITY: acapacity),
+    repetitionGap(arepetitionGap),
+    evictedCount(0)
+{
+    // the hash table is a power of two at least twice the capacity, so it is at most half full
+    size_t tableSize = 1;
+    while (tableSize < 2 * capacity) {
+        tableSize <<= 1;
+    }
+    tableMask = tableSize - 1;
 
-            } else {
+    entries = new Entry[capacity];
+    table = new word[tableSize];
+    Reset();
+}
 
-                // we need to store the absolute time. If there are at least 3 items in the buffer
-                if (usedCount <= (bufferSize - 3)) {
+RC433HQLinkQualityTracker::~RC433HQLinkQualityTracker()
+{
+    delete [] table; table = 0;
+    delete [] entries; entries = 0;
+}
 
-                    // store the absolut time of the edge
-                    StoreAbsolutTime(time, directionMask);
-                    lastStoredEdgeTime = time;
-                    successfullyStored = true;
-                }
-            }
-        }
+void RC433HQLinkQualityTracker::Reset()
+{
+    for (size_t i = 0; i <= tableMask; i++) {
+        table[i] = NO_ENTRY;
     }
+    count = 0;
+    newest = NO_ENTRY;
+    oldest = NO_ENTRY;
+}
 
-    // if we could not successfully store the incoming value
-    if (!successfullyStored) {
+size_t RC433HQLinkQualityTracker::Bucket(byte protocol, uint32_t address) const
+{
+    // multiplicative hashing of the address mixed with the protocol
+    return size_t(uint32_t((address ^ (uint32_t(protocol) << 24)) * 2654435761UL) >> 16) & tableMask;
+}
 
-        // increase the missedCount
-        missedCount++;
+size_t RC433HQLinkQualityTracker::FindBucket(byte protocol, uint32_t address) const
+{
+    // linear probing up to the device or the free bucket, where it should be stored (the table is never full)
+    size_t bucket = Bucket(protocol, address);
+    while ((table[bucket] != NO_ENTRY) && ((entries[table[bucket]].address != address) || (entries[table[bucket]].protocol != protocol))) {
+        bucket = (bucket + 1) & tableMask;
     }
+    return bucket;
 }
 
-void RC433HQPulseBuffer::StoreAbsolutTime(RC433HQMicroseconds time, BufferValue directionMask)
+void RC433HQLinkQualityTracker::Unlink(word index)
 {
-    buffer[freeIndex] = directionMask | 0x7fff; freeIndex = CalculateNext(freeIndex);      // direction and marker
-    buffer[freeIndex] = BufferValue(time.GetLoWord()); freeIndex = CalculateNext(freeIndex);  // lower 2 bytes
-    buffer[freeIndex] = BufferValue(time.GetHiWord()); freeIndex = CalculateNext(freeIndex);  // higher 2 bytes
-    usedCount += 3;
+    Entry &entry = entries[index];
+    if (entry.previous != NO_ENTRY) {
+        entries[entry.previous].next = entry.next;
+    } else {
+        newest = entry.next;
+    }
+    if (entry.next != NO_ENTRY) {
+        entries[entry.next].previous = entry.previous;
+    } else {
+        oldest = entry.previous;
+    }
 }
 
-size_t RC433HQPulseBuffer::CalculateNext(size_t index)
+void RC433HQLinkQualityTracker::LinkNewest(word index)
 {
-    if (index < bufferSize) {
-        return index + 1;
+    Entry &entry = entries[index];
+    entry.previous = NO_ENTRY;
+    entry.next = newest;
+    if (newest != NO_ENTRY) {
+        entries[newest].previous = index;
     } else {
-        return 0;
+        oldest = index;
     }
+    newest = index;
 }
 
-//////////////////////////////////////////////////////////////////////////////////
-// RC433HQNoiseFilter implementation
-//////////////////////////////////////////////////////////////////////////////////
+void RC433HQLinkQualityTracker::RemoveFromTable(word index)
+{
+    // the following entries of the probing run are shifted back into the hole (no tombstones are needed)
+    size_t hole = FindBucket(entries[index].protocol, entries[index].address);
+    size_t bucket = hole;
+    for (;;) {
+        bucket = (bucket + 1) & tableMask;
+        if (table[bucket] == NO_ENTRY) {
+            break;
+        }
+        size_t home = Bucket(entries[table[bucket]].protocol, entries[table[bucket]].address);
+        if (((bucket - home) & tableMask) >= ((bucket - hole) & tableMask)) {
+            table[hole] = table[bucket];
+            hole = bucket;
+        }
+    }
+    table[hole] = NO_ENTRY;
+}
 
-void RC433HQNoiseFilter::HandleEdge(RC433HQMicroseconds time, bool direction)
+void RC433HQLinkQualityTracker::Update(byte protocol, uint32_t address, RC433HQExtendedMicroseconds time, double quality)
 {
-    // if we have some edge in the memory
-	if (lastEdgeValid) {
+    if (capacity == 0) {
+        return;
+    }
 
-        // if this edge in the same direction as the last edge
-        if (lastEdgeDirection == direction) {
+    // the quality (0 to 100) in 1/100
+    long newQuality = ((quality <= 0.0)? 0: ((quality >= 100.0)? 10000: long(quality * 100.0 + 0.5)));
+    size_t bucket = FindBucket(protocol, address);
 
-            // ignore the first edge, keep the currect edge in the memory and quit
-            lastEdgeTime = time;
-            lastEdgeDirection = direction;
-            lastEdgeValid = true;
-            return;
+    // the new device takes a free entry or the entry of the least recently heard one
+    if (table[bucket] == NO_ENTRY) {
+        word index;
+        if (count < capacity) {
+            index = word(count++);
+        } else {
+            // evict the least recently heard device
+            index = oldest;
+            Unlink(index);
+            RemoveFromTable(index);
+            evictedCount++;
+
+            // the hash table has changed
+            bucket = FindBucket(protocol, address);
         }
+        table[bucket] = index;
+
+        Entry &entry = entries[index];
+        entry.address = address;
+        entry.protocol = protocol;
+        entry.regularIntervals = 0;
+        entry.quality = word(newQuality);
+        entry.missRatio = 0;
+        entry.periodMs = 0;
+        entry.firstSeen = time;
+        entry.lastSeen = time;
+        entry.transmissionStart = time;
+        entry.framesCount = 1;
+        entry.transmissionsCount = 1;
+        entry.missedCount = 0;
+        LinkNewest(index);
+        return;
+    }
 
-        // calculate the duration of the last pulse
-        RC433HQMicrosecondsDiff duration = (time - lastEdgeTime);
+    word index = table[bucket];
+    Entry &entry = entries[index];
 
-        // if the last pulse was to short
-        if (duration < minPulseDuration) {
+    // the frame after the repetition gap (or out of order) starts a new transmission
+    if ((time < entry.lastSeen) || ((entry.lastSeen + repetitionGap) < time)) {
+        UpdateTransmissions(entry, time);
+    }
+    entry.lastSeen = time;
+    entry.framesCount++;
+    entry.quality = word(long(entry.quality) + (newQuality - long(entry.quality)) / (1 << EWMA_SHIFT));
+
+    // the device becomes the most recently heard one
+    if (index != newest) {
+        Unlink(index);
+        LinkNewest(index);
+    }
+}
 
-            // ignore the last pulse and also the one currently obtained
-            lastEdgeValid = false;
-            return;
-        }
+void RC433HQLinkQualityTracker::UpdateTransmissions(Entry &entry, RC433HQExtendedMicroseconds time)
+{
+    entry.transmissionsCount++;
+
+    // out of order time (e.g. the 32-bit time wrapped around) restarts the detection of the period
+    if (time < entry.transmissionStart) {
+        entry.transmissionStart = time;
+        entry.periodMs = 0;
+        entry.regularIntervals = 0;
+        return;
+    }
+    unsigned long intervalMs = (unsigned long)((time.GetUnsignedLongLong() - entry.transmissionStart.GetUnsignedLongLong()) / 1000);
+    entry.transmissionStart = time;
+
+    // the interval should be a multiple of the period (the transmissions in between were missed) within 1/8 of it
+    unsigned long periods = ((entry.periodMs > 0)? ((intervalMs + entry.periodMs / 2) / entry.periodMs): 0);
+    unsigned long expectedMs = periods * entry.periodMs;
+    unsigned long deviationMs = ((intervalMs > expectedMs)? (intervalMs - expectedMs): (expectedMs - intervalMs));
+    if ((periods == 0) || (deviationMs > expectedMs / 8)) {
+
+        // irregular interval, it is the new candidate of the period
+        entry.periodMs = intervalMs;
+        entry.regularIntervals = 0;
+        return;
+    }
 
-        // send the last edge into the connected decoder
-        decoder.HandleEdge(lastEdgeTime, lastEdgeDirection);
+    // count the missed transmissions only of the device already detected as periodic
+    if (entry.regularIntervals >= PERIODIC_INTERVALS) {
+        entry.missedCount += periods - 1;
+        long missRatio = long((65535UL * (periods - 1)) / periods);
+        entry.missRatio = word(long(entry.missRatio) + (missRatio - long(entry.missRatio)) / (1 << EWMA_SHIFT));
+    }
+    if ((periods == 1) && (entry.regularIntervals < 0xff)) {
+        entry.regularIntervals++;
     }
 
-    // keep the currect edge in the memory
-    lastEdgeTime = time;
-    lastEdgeDirection = direction;
-    lastEdgeValid = true;
+    // follow the drift of the period
+    long periodMs = long(intervalMs / periods);
+    entry.periodMs = (unsigned long)(long(entry.periodMs) + (periodMs - long(entry.periodMs)) / (1 << EWMA_SHIFT));
 }
 
-void RC433HQNoiseFilter::HandleMissedEdges()
+void RC433HQLinkQualityTracker::FillLink(const Entry &entry, RC433HQLinkQuality &link) const
 {
-    // ignore the last pulse and also the one currently obtained
-    lastEdgeValid = false;
+    bool periodic = (entry.regularIntervals >= PERIODIC_INTERVALS);
+    uint64_t seenUs = entry.lastSeen.GetUnsignedLongLong() - entry.firstSeen.GetUnsignedLongLong();
+
+    link.protocol = entry.protocol;
+    link.address = entry.address;
+    link.quality = entry.quality / 100.0;
+    link.firstSeen = entry.firstSeen;
+    link.lastSeen = entry.lastSeen;
+    link.framesCount = entry.framesCount;
+    link.transmissionsCount = entry.transmissionsCount;
+    link.framesPerMinute = ((seenUs > 0)? ((entry.framesCount - 1) * 60000000.0 / double(seenUs)): 0.0);
+    link.periodMs = (periodic? entry.periodMs: 0);
+    link.missedTransmissionsCount = entry.missedCount;
+    link.missRatio = entry.missRatio / 65535.0;
+}
+
+bool RC433HQLinkQualityTracker::FindLink(byte protocol, uint32_t address, RC433HQLinkQuality &link) const
+{
+    if (capacity == 0) {
+        return false;
+    }
 
-    // inform the attached processor we are losing some data
-    decoder.HandleMissedEdges();    
+    size_t bucket = FindBucket(protocol, address);
+    if (table[bucket] == NO_ENTRY) {
+        return false;
+    }
+    FillLink(entries[table[bucket]], link);
+    return true;
+}
+
+bool RC433HQLinkQualityTracker::GetLink(size_t index, RC433HQLinkQuality &link) const
+{
+    if (index >= count) {
+        return false;
+    }
+
+    word entry = newest;
+    for (size_t i = 0; i < index; i++) {
+        entry = entries[entry].next;
+    }
+    FillLink(entries[entry], link);
+    return true;
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////
-// RC433HQBasicSyncPulseDecoder implementation
+// RC433HQProtocolAnalyzer implementation
 //////////////////////////////////////////////////////////////////////////////////
 
-void RC433HQBasicSyncPulseDecoder::HandleEdge(RC433HQMicroseconds time, bool direction)
-{
-    // if the rising edge is being handled
-    if (direction) {
+// marks no cluster
+static const byte ANALYZER_NO_CLUSTER = 0xff;
 
-        LOG_MESSAGE("Handling rising edge.\n");
+// the pulse belongs to the cluster, if both durations differ at most by 1/4 of the cluster durations + 20 us
+static const word ANALYZER_CLUSTER_MIN_DIFFERENCE_US = 20;
 
-        // if both last rising and falling edge were syncDetected
-        if (previousRisingEdge && previousFallingEdge) {
+// minimal count of the pulses of each data symbol and count of the frames to suggest the protocol
+static const word ANALYZER_MIN_DATA_SYMBOLS = 16;
+static const word ANALYZER_MIN_FRAMES = 2;
 
-            LOG_MESSAGE("Previous rising and falling edge were detected.\n");
+// the suggested tolerance is 4x the average absolute deviation (about 3 sigma) rounded up to 10 us
+static const word ANALYZER_TOLERANCE_DEVIATIONS = 4;
+static const word ANALYZER_MIN_TOLERANCE_US = 10;
 
-            // calcuate the high and low durations
-            RC433HQMicrosecondsDiff highDuration = previousFallingEdgeTime - previousRisingEdgeTime;
-            RC433HQMicrosecondsDiff lowDuration = time - previousFallingEdgeTime;
+// the durations are stored in 1/16 us
+static const byte ANALYZER_FRACTION_BITS = 4;
 
-            // if the last pulse represented a 1
-            if (syncDetected && EqualWithTolerance(highDuration, oneFirstUs, toleranceUs) && EqualWithTolerance(lowDuration, oneSecondUs, toleranceUs)) {
+static word AbsoluteDifference(uint32_t a, uint32_t b)
+{
+    uint32_t difference = ((a < b)? (b - a): (a - b));
+    return word((difference < 0xffff)? difference: 0xffff);
+}
 
-                LOG_MESSAGE("Sync detected and pulse represents bit 1.\n");
+// the highest tolerance, for which a pulse can't match both symbols
+static word GetSeparatingTolerance(word firstHigh, word firstLow, word secondHigh, word secondLow)
+{
+    word highDifference = AbsoluteDifference(firstHigh, secondHigh);
+    word lowDifference = AbsoluteDifference(firstLow, secondLow);
+    word difference = ((highDifference > lowDifference)? highDifference: lowDifference);
+    return ((difference > 0)? word((difference - 1) / 2): 0);
+}
 
-                // calculate the delta
-                CalculateDelta(highDuration, oneFirstUs);
-                CalculateDelta(lowDuration, oneSecondUs);
+RC433HQProtocolAnalyzer::RC433HQProtocolAnalyzer()
+{
+    Reset();
+}
 
-                // store the bit
-                StoreReceivedBit(1);
+void RC433HQProtocolAnalyzer::Reset()
+{
+    memset(highHistogram, 0, sizeof(highHistogram));
+    memset(lowHistogram, 0, sizeof(lowHistogram));
+    memset(clusters, 0, sizeof(clusters));
+    memset(frameBitsCounts, 0, sizeof(frameBitsCounts));
+    pulsesCount = 0;
+    previousRisingEdge = false;
+    previousFallingEdge = false;
+    previousCluster = ANALYZER_NO_CLUSTER;
+    runBits = 0;
+}
 
-                // if we reached the higher limit of the received bit
-                if (receivedBits == maxBits) {
+void RC433HQProtocolAnalyzer::HandleEdge(RC433HQMicroseconds time, bool direction)
+{
+    // the pulses are paired the same way as by the RC433HQBasicSyncPulseDecoder
+    if (direction) {
 
-                    LOG_MESSAGE("Max bits received, sending data.\n");
+        if (previousRisingEdge && previousFallingEdge) {
+            HandlePulse(previousFallingEdgeTime - previousRisingEdgeTime, time - previousFallingEdgeTime);
+        } else if (previousRisingEdge) {
+            // the falling edge was lost, the run of the data symbols is broken
+            EndRun();
+            previousCluster = ANALYZER_NO_CLUSTER;
+        }
 
-                    // send the data to the data receiver and clear the buffer
-                    SendReceivedData();
-                    syncDetected = false;
-                }
+        previousRisingEdge = true;
+        previousFallingEdge = false;
+        previousRisingEdgeTime = time;
+
+    } else {
 
-            } else {
+        previousFallingEdge = true;
+        previousFallingEdgeTime = time;
+    }
+}
 
-                // if the last pulse represented a 1
-                if (syncDetected && EqualWithTolerance(highDuration, zeroFirstUs, toleranceUs) && EqualWithTolerance(lowDuration, zeroSecondUs, toleranceUs)) {
+void RC433HQProtocolAnalyzer::HandleMissedEdges()
+{
+    // the current run is not complete
+    runBits = 0;
+    previousCluster = ANALYZER_NO_CLUSTER;
+}
 
-                    LOG_MESSAGE("Sync detected and pulse represents bit 0.\n");
+unsigned long RC433HQProtocolAnalyzer::GetHistogramBinMinUs(size_t bin)
+{
+    // 4 bins per octave starting at 64 us
+    return (64UL << (bin / 4)) * (4 + (bin % 4)) / 4;
+}
 
-                    // calculate the delta
-                    CalculateDelta(highDuration, zeroFirstUs);
-                    CalculateDelta(lowDuration, zeroSecondUs);
+void RC433HQProtocolAnalyzer::AddToHistogram(word *histogram, word duration)
+{
+    size_t bin = 0;
+    if (duration >= 64) {
 
-                    // store the bit
-                    StoreReceivedBit(0);
+        // the octave and the next two bits of the duration
+        size_t octave = 0;
+        while ((duration >> octave) >= 128) {
+            octave++;
+        }
+        bin = 4 * octave + ((duration >> octave) - 64) / 16;
+        if (bin >= HISTOGRAM_BINS) {
+            bin = HISTOGRAM_BINS - 1;
+        }
+    }
 
-                    // if we reached the higher limit of the received bit
-                    if (receivedBits == maxBits) {
+    // keep the proportions when the counter saturates
+    if (histogram[bin] == 0xffff) {
+        for (size_t i = 0; i < HISTOGRAM_BINS; i++) {
+            histogram[i] /= 2;
+        }
+    }
+    histogram[bin]++;
+}
 
-                        LOG_MESSAGE("Max bits received, sending data.\n");
+void RC433HQProtocolAnalyzer::HandlePulse(RC433HQMicrosecondsDiff highDuration, RC433HQMicrosecondsDiff lowDuration)
+{
+    pulsesCount++;
 
-                        // send the data to the data receiver and clear the buffer
-                        SendReceivedData();
+    // too long pulses are the gaps between the transmissions
+    if ((highDuration.GetUnsignedLong() > 0xffff) || (lowDuration.GetUnsignedLong() > 0xffff)) {
+        EndRun();
+        previousCluster = ANALYZER_NO_CLUSTER;
+        return;
+    }
 
-                        // no sync anymore
-                        syncDetected = false;
-                    }
+    word high = word(highDuration.GetUnsignedLong());
+    word low = word(lowDuration.GetUnsignedLong());
+    AddToHistogram(highHistogram, high);
+    AddToHistogram(lowHistogram, low);
 
-                } else {
+    size_t cluster = FindCluster(high, low);
+    if (cluster == CLUSTERS_COUNT) {
 
-                    // no data pulse was detected
+        // replace the least frequent symbol candidate
+        cluster = 0;
+        for (size_t i = 1; i < CLUSTERS_COUNT; i++) {
+            if (clusters[i].count < clusters[cluster].count) {
+                cluster = i;
+            }
+        }
+        memset(&clusters[cluster], 0, sizeof(clusters[cluster]));
+        if (previousCluster == cluster) {
+            previousCluster = ANALYZER_NO_CLUSTER;
+        }
+    }
 
-                    // if some data were received before and is above the minimal length
-                    if (receivedBits >= minBits) {
+    AddToCluster(clusters[cluster], high, low);
 
-                        LOG_MESSAGE("Min bits received before non data pulse, sending data.\n");
+    // the data symbols extend the run, any other symbol ends it and might be the sync of the next frame
+    size_t firstDataCluster, secondDataCluster;
+    FindDataClusters(firstDataCluster, secondDataCluster);
+    if ((cluster == firstDataCluster) || (cluster == secondDataCluster)) {
+        if (runBits < 0xffff) {
+            runBits++;
+        }
+    } else {
+        EndRun();
+        previousCluster = byte(cluster);
+    }
+}
 
-                        // send the data to the data receiver and clear the buffer
-                        SendReceivedData();
+size_t RC433HQProtocolAnalyzer::FindCluster(word high, word low) const
+{
+    size_t bestCluster = CLUSTERS_COUNT;
+    uint32_t bestDistance = 0;
 
-                        // we are out of sync now
-                        syncDetected = false;
-                    }
+    for (size_t i = 0; i < CLUSTERS_COUNT; i++) {
 
-                    // if the sync pulse was detected
-                    if (EqualWithTolerance(highDuration, syncFirstUs, toleranceUs) && EqualWithTolerance(lowDuration, syncSecondUs, toleranceUs)) {
+        if (clusters[i].count == 0) {
+            continue;
+        }
 
-                        LOG_MESSAGE("Sync pulse deteceted.\n");
+        word clusterHigh = word(clusters[i].high >> ANALYZER_FRACTION_BITS);
+        word clusterLow = word(clusters[i].low >> ANALYZER_FRACTION_BITS);
+        word highDifference = AbsoluteDifference(high, clusterHigh);
+        word lowDifference = AbsoluteDifference(low, clusterLow);
 
-                        // calculate the delta of the sync
-                        ClearDelta();
-                        CalculateDelta(highDuration, syncFirstUs);
-                        CalculateDelta(lowDuration, syncSecondUs);
+        if ((highDifference <= (clusterHigh / 4) + ANALYZER_CLUSTER_MIN_DIFFERENCE_US) &&
+            (lowDifference <= (clusterLow / 4) + ANALYZER_CLUSTER_MIN_DIFFERENCE_US)) {
 
-                        // start a new sequence after the successfull sync
-                        ClearReceivedBits();
-                        syncDetected = true;
-                        syncTime = previousRisingEdgeTime;
-                    }
-                }
+            uint32_t distance = uint32_t(highDifference) + lowDifference;
+            if ((bestCluster == CLUSTERS_COUNT) || (distance < bestDistance)) {
+                bestCluster = i;
+                bestDistance = distance;
             }
-        }	
+        }
+    }
 
-        // remeber the current rising edge and clean the previous falling edge
-        previousRisingEdge = true;
-        previousFallingEdge = false;
-        previousRisingEdgeTime = time;
-        previousFallingEdgeTime = 0;
-    
-    } else {
+    return bestCluster;
+}
 
-        LOG_MESSAGE("Handling falling edge.\n");
+void RC433HQProtocolAnalyzer::AddToCluster(Cluster &cluster, word high, word low)
+{
+    // keep the proportions when the counter saturates
+    if (cluster.count == 0xffff) {
+        for (size_t i = 0; i < CLUSTERS_COUNT; i++) {
+            clusters[i].count /= 2;
+            clusters[i].frameStarts /= 2;
+        }
+    }
+    cluster.count++;
 
-        // keep the falling edge time
-        previousFallingEdge = true;
-        previousFallingEdgeTime = time;
+    uint32_t fixedHigh = uint32_t(high) << ANALYZER_FRACTION_BITS;
+    uint32_t fixedLow = uint32_t(low) << ANALYZER_FRACTION_BITS;
+
+    if (cluster.count == 1) {
+        cluster.high = fixedHigh;
+        cluster.low = fixedLow;
+        return;
     }
-}
 
-void RC433HQBasicSyncPulseDecoder::HandleMissedEdges()
-{
-    LOG_MESSAGE("Handling missed edges call.\n");
+    // the weight of the new pulse is 1/2, 1/4, ... 1/16 as the count grows
+    byte shift = 1;
+    while ((shift < 4) && ((word(1) << (shift + 1)) <= cluster.count)) {
+        shift++;
+    }
 
-    // ignore the currently cached data, we will start over from the looking for the next sync
-    ClearDelta();
-    ClearReceivedBits();
-    syncDetected = true;
+    cluster.highDeviation = cluster.highDeviation - (cluster.highDeviation >> shift) + (uint32_t(AbsoluteDifference(fixedHigh, cluster.high)) >> shift);
+    cluster.lowDeviation = cluster.lowDeviation - (cluster.lowDeviation >> shift) + (uint32_t(AbsoluteDifference(fixedLow, cluster.low)) >> shift);
+    cluster.high = cluster.high - (cluster.high >> shift) + (fixedHigh >> shift);
+    cluster.low = cluster.low - (cluster.low >> shift) + (fixedLow >> shift);
 }
 
-void RC433HQBasicSyncPulseDecoder::CalculateDelta(RC433HQMicrosecondsDiff expected, RC433HQMicrosecondsDiff actual)
+void RC433HQProtocolAnalyzer::FindDataClusters(size_t &first, size_t &second) const
 {
-    if (toleranceUs != 0) {
-        double delta;
-        if (expected < actual) {
-            delta = (actual - expected).AsDouble();
-        } else {
-            delta = (expected - actual).AsDouble();
+    first = CLUSTERS_COUNT;
+    second = CLUSTERS_COUNT;
+    for (size_t i = 0; i < CLUSTERS_COUNT; i++) {
+        if (clusters[i].count == 0) {
+            continue;
+        }
+        if ((first == CLUSTERS_COUNT) || (clusters[i].count > clusters[first].count)) {
+            second = first;
+            first = i;
+        } else if ((second == CLUSTERS_COUNT) || (clusters[i].count > clusters[second].count)) {
+            second = i;
         }
-        deltaPowerSum += (delta * delta);
     }
 }
 
-void RC433HQBasicSyncPulseDecoder::ClearDelta()
-{
-    LOG_MESSAGE("Clearing delta sum.\n");
-    deltaPowerSum = 0;
-}
-
-void RC433HQBasicSyncPulseDecoder::StoreReceivedBit(byte bit)
+void RC433HQProtocolAnalyzer::EndRun()
 {
-    if (receivedBits < RC433HQ_MAX_PULSE_BITS) {
-    
-        LOG_MESSAGE("Storing bit.\n");
+    // the long enough run of the data symbols after a symbol is a frame candidate
+    if ((runBits >= MIN_FRAME_BITS) && (previousCluster != ANALYZER_NO_CLUSTER)) {
 
-        // store the bit
-        size_t offset = (receivedBits >> 3);
-        receivedData[offset] = (receivedData[offset] << 1) | bit;
+        Cluster &sync = clusters[previousCluster];
+        if (sync.frameStarts < 0xffff) {
+            sync.frameStarts++;
+        }
 
-        // increase the number of stored bits
-        receivedBits++;
+        size_t index = ((runBits < MAX_FRAME_BITS)? runBits: MAX_FRAME_BITS) - MIN_FRAME_BITS;
+        if (frameBitsCounts[index] == 0xff) {
+            for (size_t i = 0; i < sizeof(frameBitsCounts); i++) {
+                frameBitsCounts[i] /= 2;
+            }
+        }
+        frameBitsCounts[index]++;
     }
+
+    runBits = 0;
 }
 
-void RC433HQBasicSyncPulseDecoder::ClearReceivedBits()
+bool RC433HQProtocolAnalyzer::GetCluster(size_t index, word &count, word &highUs, word &lowUs) const
 {
-    LOG_MESSAGE("Clearing recevied bits cache.\n");
+    if ((index >= CLUSTERS_COUNT) || (clusters[index].count == 0)) {
+        return false;
+    }
 
-    memset(receivedData, 0, RC433HQ_MAX_PULSE_BITS >> 3);
-    receivedBits = 0;
+    count = clusters[index].count;
+    highUs = word(clusters[index].high >> ANALYZER_FRACTION_BITS);
+    lowUs = word(clusters[index].low >> ANALYZER_FRACTION_BITS);
+    return true;
 }
 
-void RC433HQBasicSyncPulseDecoder::SendReceivedData()
+bool RC433HQProtocolAnalyzer::GetSuggestion(RC433HQProtocolSuggestion &suggestion) const
 {
-    // data quality is 100% - totalDelta / tolerance. The range is 0% (always at tolerance) to 100% (always exact)
-    double quality;
-    
-    if (toleranceUs != 0) {
-
-        // calcutate the precission out of the average of the squares of the deltas for all edges
-        double totalDelta = sqrt(deltaPowerSum / (2 *  (receivedBits + 1)));
-        quality = 100.0 * (1.0 - (totalDelta / toleranceUs));
-
-#       if defined DEBUG && !defined ARDUINO
-
-        char buf[128];
-        sprintf(buf, "Calculating quality with tolerace = %i, delta sq sum = %f, quality = %f.\n", int(toleranceUs), deltaPowerSum, quality);
-        LOG_MESSAGE(buf);
+    // the data symbols
+    size_t first, second;
+    FindDataClusters(first, second);
+    if ((second == CLUSTERS_COUNT) || (clusters[second].count < ANALYZER_MIN_DATA_SYMBOLS)) {
+        return false;
+    }
 
-#       endif // defined DEBUG
+    // the zero is the data symbol with the shorter high level
+    const Cluster &zero = ((clusters[first].high <= clusters[second].high)? clusters[first]: clusters[second]);
+    const Cluster &one = ((clusters[first].high <= clusters[second].high)? clusters[second]: clusters[first]);
 
-    } else {
+    // the sync is the symbol starting most of the frames
+    size_t syncIndex = CLUSTERS_COUNT;
+    for (size_t i = 0; i < CLUSTERS_COUNT; i++) {
+        if ((i != first) && (i != second) && (clusters[i].count > 0) &&
+            ((syncIndex == CLUSTERS_COUNT) || (clusters[i].frameStarts > clusters[syncIndex].frameStarts))) {
+            syncIndex = i;
+        }
+    }
+    if ((syncIndex == CLUSTERS_COUNT) || (clusters[syncIndex].frameStarts < ANALYZER_MIN_FRAMES)) {
+        return false;
+    }
+    const Cluster &sync = clusters[syncIndex];
+
+    suggestion.syncFirstUs = word((sync.high + 8) >> ANALYZER_FRACTION_BITS);
+    suggestion.syncSecondUs = word((sync.low + 8) >> ANALYZER_FRACTION_BITS);
+    suggestion.zeroFirstUs = word((zero.high + 8) >> ANALYZER_FRACTION_BITS);
+    suggestion.zeroSecondUs = word((zero.low + 8) >> ANALYZER_FRACTION_BITS);
+    suggestion.oneFirstUs = word((one.high + 8) >> ANALYZER_FRACTION_BITS);
+    suggestion.oneSecondUs = word((one.low + 8) >> ANALYZER_FRACTION_BITS);
+    suggestion.framesCount = sync.frameStarts;
+
+    // the tolerance covers the deviation of all the symbols
+    uint32_t deviation = 0;
+    const Cluster *symbols[] = { &sync, &zero, &one };
+    for (size_t i = 0; i < 3; i++) {
+        if (symbols[i]->highDeviation > deviation) {
+            deviation = symbols[i]->highDeviation;
+        }
+        if (symbols[i]->lowDeviation > deviation) {
+            deviation = symbols[i]->lowDeviation;
+        }
+    }
+    uint32_t tolerance = (ANALYZER_TOLERANCE_DEVIATIONS * deviation) >> ANALYZER_FRACTION_BITS;
+    tolerance = ((tolerance + 9) / 10) * 10;
+    if (tolerance < ANALYZER_MIN_TOLERANCE_US) {
+        tolerance = ANALYZER_MIN_TOLERANCE_US;
+    }
 
-        LOG_MESSAGE("Setting quality as 100 per cent.\n");
+    // but no pulse may match two symbols
+    word separatingTolerances[] = {
+        GetSeparatingTolerance(suggestion.zeroFirstUs, suggestion.zeroSecondUs, suggestion.oneFirstUs, suggestion.oneSecondUs),
+        GetSeparatingTolerance(suggestion.syncFirstUs, suggestion.syncSecondUs, suggestion.zeroFirstUs, suggestion.zeroSecondUs),
+        GetSeparatingTolerance(suggestion.syncFirstUs, suggestion.syncSecondUs, suggestion.oneFirstUs, suggestion.oneSecondUs)
+    };
+    for (size_t i = 0; i < 3; i++) {
+        if (tolerance > separatingTolerances[i]) {
+            tolerance = separatingTolerances[i];
+        }
+    }
+    suggestion.toleranceUs = word(tolerance);
 
-        quality = 100.0;
+    // the most frequent length of the frames, the lengths at least half as frequent give the range
+    size_t mostFrequent = 0;
+    for (size_t i = 1; i < sizeof(frameBitsCounts); i++) {
+        if (frameBitsCounts[i] > frameBitsCounts[mostFrequent]) {
+            mostFrequent = i;
+        }
+    }
+    size_t minIndex = mostFrequent, maxIndex = mostFrequent;
+    for (size_t i = 0; i < sizeof(frameBitsCounts); i++) {
+        if (2 * frameBitsCounts[i] >= frameBitsCounts[mostFrequent]) {
+            if (i < minIndex) {
+                minIndex = i;
+            }
+            if (i > maxIndex) {
+                maxIndex = i;
+            }
+        }
     }
+    suggestion.minBits = word(MIN_FRAME_BITS + minIndex);
+    suggestion.maxBits = word(MIN_FRAME_BITS + maxIndex);
 
-    // send the data to the data receiver
-    dataReceiver.HandleData(syncTime, receivedData, receivedBits, quality);
-    ClearReceivedBits();
+    return true;
 }
 
+
 //////////////////////////////////////////////////////////////////////////////////
 // RC433HQBasicSyncPulseEncoder implementation
 //////////////////////////////////////////////////////////////////////////////////
@@ -615,12 +2041,25 @@ RC433HQReceiver::RC433HQReceiver(IRC433PulseProcessor &adecoder, int areceiverGp
     decoder(adecoder),
     iAmActiveInstance(false),
 	receiverGpioPin(areceiverGpioPin)
+{
+    Activate(RC433HQReceiver::HandleInterrupt);
+}
+
+RC433HQReceiver::RC433HQReceiver(IRC433PulseProcessor &adecoder, int areceiverGpioPin, void (*interruptHandler)()):
+    decoder(adecoder),
+    iAmActiveInstance(false),
+    receiverGpioPin(areceiverGpioPin)
+{
+    Activate(interruptHandler);
+}
+
+void RC433HQReceiver::Activate(void (*interruptHandler)())
 {
     if (activeInstance == 0) {
         activeInstance = this;
         iAmActiveInstance = true;
         pinMode(receiverGpioPin, INPUT_PULLUP);
-        attachInterrupt(digitalPinToInterrupt(receiverGpioPin), RC433HQReceiver::HandleInterrupt, CHANGE);
+        attachInterrupt(digitalPinToInterrupt(receiverGpioPin), interruptHandler, CHANGE);
     }
 }
 
@@ -637,7 +2076,11 @@ void RC433HQReceiver::HandleInterrupt()
     // if the active instance is defined
     // assert(activeInstance != 0);
 
+    RC433HQ_PROFILE_START(interruptStart);
+
     activeInstance->HandleInterruptInternal();
+
+    RC433HQ_PROFILE_STOP(interruptStart, AddInterruptDuration);
 }
 
 void RC433HQReceiver::HandleInterruptInternal()
@@ -656,11 +2099,92 @@ void RC433HQReceiver::HandleInterruptInternal()
 }
 
 //////////////////////////////////////////////////////////////////////////////////
-// RC433HQReceiver implementation
+// RC433HQTransmitter implementation
 //////////////////////////////////////////////////////////////////////////////////
 
+// count of the clock reads measuring the read duration and the sleeps measuring their lateness
+static const unsigned long HYBRID_WAIT_CALIBRATION_READS = 16;
+static const unsigned long HYBRID_WAIT_CALIBRATION_SLEEPS[] = { 16, 64, 256, 16, 64, 256 };
+
+void RC433HQHybridWait::Calibrate()
+{
+    // the duration of one clock read
+    RC433HQMicroseconds start = clock.GetTimeInMicroseconds();
+    for (unsigned long i = 0; i < HYBRID_WAIT_CALIBRATION_READS; i++) {
+        clock.GetTimeInMicroseconds();
+    }
+    RC433HQMicroseconds end = clock.GetTimeInMicroseconds();
+    readDuration = RC433HQMicrosecondsDiff(((end - start).GetUnsignedLong() + HYBRID_WAIT_CALIBRATION_READS) / (HYBRID_WAIT_CALIBRATION_READS + 1));
+
+    // the worst lateness of the sleeps of several lengths is the initial average
+    unsigned long maxLateness = 0;
+    for (size_t i = 0; i < sizeof(HYBRID_WAIT_CALIBRATION_SLEEPS) / sizeof(HYBRID_WAIT_CALIBRATION_SLEEPS[0]); i++) {
+        start = clock.GetTimeInMicroseconds();
+        clock.SleepMicroseconds(HYBRID_WAIT_CALIBRATION_SLEEPS[i]);
+        end = clock.GetTimeInMicroseconds();
+        unsigned long duration = (end - start).GetUnsignedLong();
+        if (duration > HYBRID_WAIT_CALIBRATION_SLEEPS[i] && (duration - HYBRID_WAIT_CALIBRATION_SLEEPS[i]) > maxLateness) {
+            maxLateness = duration - HYBRID_WAIT_CALIBRATION_SLEEPS[i];
+        }
+    }
+    sleepLatenessX4 = 4 * maxLateness;
+
+    calibrated = true;
+}
+
+void RC433HQHybridWait::AddSleepLateness(unsigned long latenessUs)
+{
+    // exponential moving average with the weight 1/4 of the new value
+    sleepLatenessX4 = sleepLatenessX4 - (sleepLatenessX4 >> 2) + latenessUs;
+}
+
+RC433HQMicroseconds RC433HQHybridWait::WaitUntil(RC433HQMicroseconds time)
+{
+    RC433HQMicroseconds now = clock.GetTimeInMicroseconds();
+
+    // coarse sleeps finishing early enough even if they are late as usual (the lead also covers a sleep running slower than
+    // the clock by up to 1/32 of its length, a long sleep that ends too early is followed by a shorter one)
+    while (now.IsBefore(time)) {
+        unsigned long remaining = (time - now).GetUnsignedLong();
+        unsigned long lead = ((2 * sleepLatenessX4 + 3) >> 2) + SLEEP_MARGIN_US + readDuration.GetUnsignedLong() + (remaining >> 5);
+        if (remaining <= lead) {
+            break;
+        }
+        RC433HQMicrosecondsDiff sleep = remaining - lead;
+        clock.SleepMicroseconds(sleep);
+        RC433HQMicroseconds wakeUp = now + sleep;
+        now = clock.GetTimeInMicroseconds();
+
+        // learn the lateness of the sleep (excluding the clock read after it)
+        unsigned long lateness = (now.IsBefore(wakeUp)? 0: (now - wakeUp).GetUnsignedLong());
+        AddSleepLateness((lateness > readDuration.GetUnsignedLong())? (lateness - readDuration.GetUnsignedLong()): 0);
+    }
+
+    // spin until the time (minus half of the read duration, the time is passed in the middle of the last read on average)
+    RC433HQMicroseconds spinEnd = time - RC433HQMicrosecondsDiff(readDuration.GetUnsignedLong() / 2);
+    for (unsigned long reads = 0; now.IsBefore(spinEnd) && (reads < MAX_SPIN_READS); reads++) {
+        now = clock.GetTimeInMicroseconds();
+    }
+
+    return now;
+}
+
 RC433HQTransmitter::RC433HQTransmitter(int atransmitterGpioPin):
     transmitterGpioPin(atransmitterGpioPin),
+    wait(RC433HQSystemClock::instance),
+    inTransitionMode(false),
+    maxDelayTolerance(0),
+    totalDelayedEdgesDelayTime(0),
+    transmissionQualityStatistics(0),
+    durationFinishTimeValid(false)
+{
+    // initialize the GPIO pin for output
+    pinMode(transmitterGpioPin, OUTPUT);
+}
+
+RC433HQTransmitter::RC433HQTransmitter(int atransmitterGpioPin, IRC433Clock &aclock):
+    transmitterGpioPin(atransmitterGpioPin),
+    wait(aclock),
     inTransitionMode(false),
     maxDelayTolerance(0),
     totalDelayedEdgesDelayTime(0),
@@ -680,6 +2204,11 @@ void RC433HQTransmitter::StartTransmission(RC433HQMicrosecondsDiff quietPeriodDu
 {
     // assert(inTransitionMode == false);
 
+    // measure the timing of the clock before the first transmission
+    if (!wait.IsCalibrated()) {
+        wait.Calibrate();
+    }
+
     // initialize the transmission
     inTransitionMode = true;
     maxDelayTolerance = amaxDelayTolerance;
@@ -785,7 +2314,7 @@ void RC433HQTransmitter::PlanWaitForDuration(RC433HQMicrosecondsDiff duration)
     if (!durationFinishTimeValid) {
 
         // initialize with the current time
-        durationFinishTime = RC433HQTimeService::GetTimeInMicroseconds();
+        durationFinishTime = wait.GetClock().GetTimeInMicroseconds();
 
         // valid since now
         durationFinishTimeValid = true;
@@ -804,28 +2333,13 @@ void RC433HQTransmitter::WaitForThePreviousDurationToFinish()
     // if we are waiting for the duration after the previous edge to finish
     if (durationFinishTimeValid) {
 
-        // get the current time in us
-        RC433HQMicroseconds now = RC433HQTimeService::GetTimeInMicroseconds();
-
-        // calculate time left till end of the duration
-        RC433HQMicrosecondsDiff durationLeftTime = durationFinishTime - now;
-
-        // if the time difference is smaller than 1 minute, then we have not yet passed the target time and the subtraction did not overflow
-        if (durationLeftTime < RC433HQMicrosecondsDiff(60000000)) {
+        // wait for the target time, the time the wait finished is close to the time the edge is written
+        RC433HQMicroseconds now = wait.WaitUntil(durationFinishTime);
 
-            // if there is still some time to wait
-            if (durationLeftTime > 0) {
-
-                // wait 
-                RC433HQTimeService::SleepMicroseconds(durationLeftTime);
-
-                // get the current time again (just for case the delay was not exact and we need to report delay in edge)
-                now = RC433HQTimeService::GetTimeInMicroseconds();
-            }
+        // calculate how much we are delayed (the wait might have also finished a bit earlier)
+        if (!now.IsBefore(durationFinishTime)) {
+            delay = now - durationFinishTime;
         }
-
-        // calculate how much we are delayed
-        delay = now - durationFinishTime;
     }
 
     // report the delay to the statistics
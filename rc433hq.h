@@ -1,6 +1,9 @@
 #pragma once
 
-#define DEBUG
+// define NDEBUG to disable the debug logging (e.g. for the benchmarks)
+#if !defined(NDEBUG)
+#	define DEBUG
+#endif // !defined(NDEBUG)
 
 #if defined(ARDUINO)
 #	include <Arduino.h>
@@ -38,6 +41,10 @@
 #	define LOG_MESSAGE(message)
 #endif
 
+// if RC433HQ_PROFILE is defined, the duration of the receiver interrupt handler and of the sections with disabled
+// interrupts is measured, see RC433HQProfiler. Without it the instrumentation is compiled out completely.
+//#define RC433HQ_PROFILE
+
 /**
   @file rc433hq.h
 */
@@ -50,75 +57,147 @@
 // forward definition
 class RC433HQMicroseconds;
 
+// The time types are trivially copyable constexpr value types (no user-provided copy constructors or assignments), so
+// they are passed in registers through HandleEdge() and the expressions of constants fold at compile time.
 class RC433HQMicrosecondsDiff {
 private:
 	friend class RC433HQMicroseconds;
 	
-	unsigned long us;
+	uint32_t us;
 
 public:
-	RC433HQMicrosecondsDiff(): us(0) {}
-	RC433HQMicrosecondsDiff(unsigned long aus): us(aus) {}
-	RC433HQMicrosecondsDiff(const RC433HQMicrosecondsDiff &that): us(that.us) {}
-	RC433HQMicrosecondsDiff &operator=(const RC433HQMicrosecondsDiff &that) { if (this != &that) { us = that.us; } return *this; }
+	constexpr RC433HQMicrosecondsDiff(): us(0) {}
+	constexpr RC433HQMicrosecondsDiff(unsigned long aus): us(uint32_t(aus)) {}
 
 	// comparison with the same type
-	bool operator==(const RC433HQMicrosecondsDiff &that) { return us == that.us; }
-	bool operator!=(const RC433HQMicrosecondsDiff &that) { return us != that.us; }
-	bool operator<(const RC433HQMicrosecondsDiff &that) const { return us < that.us; }
-	bool operator<=(const RC433HQMicrosecondsDiff &that) const { return us <= that.us; }
-	bool operator>(const RC433HQMicrosecondsDiff &that) const { return us > that.us; }
-	bool operator>=(const RC433HQMicrosecondsDiff &that) const { return us >= that.us; }
+	constexpr bool operator==(const RC433HQMicrosecondsDiff &that) const { return us == that.us; }
+	constexpr bool operator!=(const RC433HQMicrosecondsDiff &that) const { return us != that.us; }
+	constexpr bool operator<(const RC433HQMicrosecondsDiff &that) const { return us < that.us; }
+	constexpr bool operator<=(const RC433HQMicrosecondsDiff &that) const { return us <= that.us; }
+	constexpr bool operator>(const RC433HQMicrosecondsDiff &that) const { return us > that.us; }
+	constexpr bool operator>=(const RC433HQMicrosecondsDiff &that) const { return us >= that.us; }
 
 	// aritmetic operators
 	RC433HQMicrosecondsDiff &operator+=(const RC433HQMicrosecondsDiff &diff) { us += diff.us; return *this; }
-	const RC433HQMicrosecondsDiff operator+(const RC433HQMicrosecondsDiff &diff) const { RC433HQMicrosecondsDiff result = *this; result += diff; return result; }
-	const RC433HQMicrosecondsDiff operator-(const RC433HQMicrosecondsDiff &that) const { RC433HQMicrosecondsDiff result; result.us = us - that.us; return result; }
+	constexpr const RC433HQMicrosecondsDiff operator+(const RC433HQMicrosecondsDiff &diff) const { return RC433HQMicrosecondsDiff(uint32_t(us + diff.us)); }
+	constexpr const RC433HQMicrosecondsDiff operator-(const RC433HQMicrosecondsDiff &that) const { return RC433HQMicrosecondsDiff(uint32_t(us - that.us)); }
 	
 	// conversions 
-	word GetLoWord() const { return (us & 0xffff); }
-	word GetHiWord() const { return (us >> 16); }
-	double AsDouble() const { return double(us); }
-	unsigned long GetUnsignedLong() const { return us; }
+	constexpr word GetLoWord() const { return word(us & 0xffff); }
+	constexpr word GetHiWord() const { return word(us >> 16); }
+	constexpr double AsDouble() const { return double(us); }
+	constexpr unsigned long GetUnsignedLong() const { return us; }
 
 };
 
 class RC433HQMicroseconds {
 private:
-	unsigned long us;
+	// kept at 32 bits on all platforms, so the wrap-around (~71 minutes) behaves the same on the host and on the board
+	uint32_t us;
 public:
 	// default constructor
-	RC433HQMicroseconds(): us(0) {}
+	constexpr RC433HQMicroseconds(): us(0) {}
 
 	// initialization constructor
-	RC433HQMicroseconds(unsigned long aus): us(aus) {}
-
-	// copy constructor
-	RC433HQMicroseconds(const RC433HQMicroseconds &that): us(that.us) {}
-
-	// asignment operator
-	RC433HQMicroseconds &operator=(const RC433HQMicroseconds &that) { if (this != &that) { us = that.us; } return *this; }
+	constexpr RC433HQMicroseconds(unsigned long aus): us(uint32_t(aus)) {}
 
 	// comparison with the same type
-	bool operator==(const RC433HQMicroseconds &that) const { return us == that.us; }
-	bool operator!=(const RC433HQMicroseconds &that) const { return !(*this == that); }
+	constexpr bool operator==(const RC433HQMicroseconds &that) const { return us == that.us; }
+	constexpr bool operator!=(const RC433HQMicroseconds &that) const { return us != that.us; }
+
+	// wrap-safe ordering, valid for times that are less than ~35 minutes apart
+	constexpr bool IsBefore(const RC433HQMicroseconds &that) const { return int32_t(us - that.us) < 0; }
+	constexpr bool IsAfter(const RC433HQMicroseconds &that) const { return int32_t(us - that.us) > 0; }
 
 	// addition of absolute time and difference via +=
 	RC433HQMicroseconds &operator+=(const RC433HQMicrosecondsDiff &diff) { us += diff.us; return *this; }
 
 	// addition of absolute time and difference via binary + operator
-	const RC433HQMicroseconds operator+(const RC433HQMicrosecondsDiff &diff) const { RC433HQMicroseconds result = *this; result += diff; return result; }
+	constexpr const RC433HQMicroseconds operator+(const RC433HQMicrosecondsDiff &diff) const { return RC433HQMicroseconds(uint32_t(us + diff.us)); }
 
 	// subtraction of the same type produces difference
-	const RC433HQMicrosecondsDiff operator-(const RC433HQMicroseconds &that) const { RC433HQMicrosecondsDiff result; result.us = us - that.us; return result; }
+	constexpr const RC433HQMicrosecondsDiff operator-(const RC433HQMicroseconds &that) const { return RC433HQMicrosecondsDiff(uint32_t(us - that.us)); }
 
 	// subtraction of the difference produces absolut time
-	const RC433HQMicroseconds operator-(const RC433HQMicrosecondsDiff &that) const { RC433HQMicroseconds result; result.us = us - that.us; return result; }
+	constexpr const RC433HQMicroseconds operator-(const RC433HQMicrosecondsDiff &that) const { return RC433HQMicroseconds(uint32_t(us - that.us)); }
 
 	// conversions 
-	word GetLoWord() const { return (us & 0xffff); }
-	word GetHiWord() const { return (us >> 16); }
-	unsigned long GetUnsignedLong() const { return us; }
+	constexpr word GetLoWord() const { return word(us & 0xffff); }
+	constexpr word GetHiWord() const { return word(us >> 16); }
+	constexpr unsigned long GetUnsignedLong() const { return us; }
+};
+
+// duration literals, e.g. 272_us or 10_ms
+constexpr RC433HQMicrosecondsDiff operator"" _us(unsigned long long us) { return RC433HQMicrosecondsDiff((unsigned long)us); }
+constexpr RC433HQMicrosecondsDiff operator"" _ms(unsigned long long ms) { return RC433HQMicrosecondsDiff((unsigned long)(ms * 1000)); }
+
+// 64-bit time that does not wrap around in practice. It is produced out of the 32-bit RC433HQMicroseconds
+// by the RC433HQTimeExtender only when the frame is being delivered, the edge handling stays 32-bit.
+class RC433HQExtendedMicroseconds {
+private:
+	uint64_t us;
+public:
+	// default constructor
+	constexpr RC433HQExtendedMicroseconds(): us(0) {}
+
+	// initialization constructors
+	constexpr RC433HQExtendedMicroseconds(uint64_t aus): us(aus) {}
+	constexpr RC433HQExtendedMicroseconds(uint32_t aepoch, RC433HQMicroseconds time): us((uint64_t(aepoch) << 32) | time.GetUnsignedLong()) {}
+
+	// comparison with the same type
+	constexpr bool operator==(const RC433HQExtendedMicroseconds &that) const { return us == that.us; }
+	constexpr bool operator!=(const RC433HQExtendedMicroseconds &that) const { return us != that.us; }
+	constexpr bool operator<(const RC433HQExtendedMicroseconds &that) const { return us < that.us; }
+	constexpr bool operator<=(const RC433HQExtendedMicroseconds &that) const { return us <= that.us; }
+	constexpr bool operator>(const RC433HQExtendedMicroseconds &that) const { return us > that.us; }
+	constexpr bool operator>=(const RC433HQExtendedMicroseconds &that) const { return us >= that.us; }
+
+	// addition of absolute time and difference
+	constexpr const RC433HQExtendedMicroseconds operator+(const RC433HQMicrosecondsDiff &diff) const { return RC433HQExtendedMicroseconds(us + diff.GetUnsignedLong()); }
+
+	// conversions
+	constexpr RC433HQMicroseconds GetMicroseconds() const { return RC433HQMicroseconds(uint32_t(us)); }
+	constexpr uint32_t GetEpoch() const { return uint32_t(us >> 32); }
+	constexpr uint64_t GetUnsignedLongLong() const { return us; }
+};
+
+// Keeps the count of the 32-bit time wrap-arounds (epoch). It is maintained by the producer of the edges (typically
+// the RC433HQPulseBuffer from the loop) and used by the decoders to extend the frame time when the frame is delivered.
+class RC433HQTimeExtender {
+private:
+	bool lastTimeValid;
+	RC433HQMicroseconds lastTime;
+	uint32_t epoch;
+
+public:
+	RC433HQTimeExtender():
+		lastTimeValid(false),
+		lastTime(0),
+		epoch(0)
+	{
+	}
+
+	// advance the extender to the given time. Needs to be called at least once per wrap period (~71 minutes),
+	// times older than the last update are ignored.
+	void Update(RC433HQMicroseconds now)
+	{
+		if (!lastTimeValid) {
+			lastTime = now;
+			lastTimeValid = true;
+		} else if (!now.IsBefore(lastTime)) {
+			if (now.GetUnsignedLong() < lastTime.GetUnsignedLong()) {
+				epoch++;
+			}
+			lastTime = now;
+		}
+	}
+
+	// extend the time that is close (less than ~35 minutes) to the time of the last update
+	RC433HQExtendedMicroseconds Extend(RC433HQMicroseconds time) const
+	{
+		int32_t delta = int32_t(time.GetUnsignedLong() - lastTime.GetUnsignedLong());
+		return RC433HQExtendedMicroseconds(RC433HQExtendedMicroseconds(epoch, lastTime).GetUnsignedLongLong() + int64_t(delta));
+	}
 };
 
 class RC433HQTimeService {
@@ -130,8 +209,162 @@ public:
 	// delay in microseconds
 	static void SleepMicroseconds(RC433HQMicrosecondsDiff delay);
 
+	// resolution of the time returned by GetTimeInMicroseconds() in nanoseconds
+	static unsigned long GetTimerResolutionNs();
+
+};
+
+/** \brief Source of the time and of the sleeps for the code waiting for the exact time (the transmitter), replaceable by
+    a simulated clock in the tests
+ */
+class IRC433Clock {
+public:
+	virtual ~IRC433Clock() {}
+
+	virtual RC433HQMicroseconds GetTimeInMicroseconds() = 0;
+
+	virtual void SleepMicroseconds(RC433HQMicrosecondsDiff delay) = 0;
+};
+
+// the clock of the board via RC433HQTimeService
+class RC433HQSystemClock: public IRC433Clock {
+public:
+	virtual RC433HQMicroseconds GetTimeInMicroseconds() { return RC433HQTimeService::GetTimeInMicroseconds(); }
+
+	virtual void SleepMicroseconds(RC433HQMicrosecondsDiff delay) { RC433HQTimeService::SleepMicroseconds(delay); }
+
+	// the shared instance
+	static RC433HQSystemClock instance;
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQProfiler declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// ticks of the cheapest available counter, used to measure short durations (the differences are wrap safe)
+typedef uint32_t RC433HQTicks;
+
+class RC433HQTickService {
+public:
+
+	// get the current count of ticks (CPU cycles if available, otherwise microseconds)
+	static RC433HQTicks GetTicks();
+
+	// count of ticks per one millisecond
+	static unsigned long GetTicksPerMillisecond();
+};
+
+#if !defined(RC433HQ_DURATION_HISTOGRAM_BUCKETS)
+#	if defined(ARDUINO)
+#		define RC433HQ_DURATION_HISTOGRAM_BUCKETS 16
+#	else
+#		define RC433HQ_DURATION_HISTOGRAM_BUCKETS 32
+#	endif // defined(ARDUINO)
+#endif // !defined(RC433HQ_DURATION_HISTOGRAM_BUCKETS)
+
+/** \brief Min/max/average and log2 histogram of the durations in ticks kept in the fixed storage. Add() is cheap enough to be called from the interrupt.
+ */
+class RC433HQDurationStatistics {
+private:
+	byte histogramShift;  // the histogram counts the durations in the units of 2^histogramShift ticks
+	unsigned long count;
+	RC433HQTicks minTicks;
+	RC433HQTicks maxTicks;
+	uint64_t totalTicks;
+	// the bucket i contains the durations with i significant bits (i.e. 2^(i-1) <= duration < 2^i), the last one also the longer durations
+	unsigned long histogram[RC433HQ_DURATION_HISTOGRAM_BUCKETS];
+
+public:
+	// the long durations need the coarser histogram units, RC433HQ_DURATION_HISTOGRAM_BUCKETS is only 16 on the board
+	RC433HQDurationStatistics(byte ahistogramShift = 0):
+		histogramShift(ahistogramShift)
+	{
+		Reset();
+	}
+
+	void Reset();
+
+	void Add(RC433HQTicks ticks)
+	{
+		if ((count == 0) || (ticks < minTicks)) {
+			minTicks = ticks;
+		}
+		if (ticks > maxTicks) {
+			maxTicks = ticks;
+		}
+		count++;
+		totalTicks += ticks;
+		histogram[GetBucket(ticks >> histogramShift)]++;
+	}
+
+	// copy the statistics updated from the interrupt with the interrupts disabled
+	void GetSnapshot(RC433HQDurationStatistics &snapshot) const;
+
+	unsigned long GetCount() const { return count; }
+	RC433HQTicks GetMinTicks() const { return minTicks; }
+	RC433HQTicks GetMaxTicks() const { return maxTicks; }
+	double GetAverageTicks() const { return (count > 0)? double(totalTicks) / count: 0.0; }
+
+	size_t GetHistogramSize() const { return RC433HQ_DURATION_HISTOGRAM_BUCKETS; }
+	unsigned long GetHistogramCount(size_t bucket) const { return histogram[bucket]; }
+
+	// the shortest duration stored in the bucket
+	RC433HQTicks GetBucketMinTicks(size_t bucket) const { return ((bucket == 0)? 0: (RC433HQTicks(1) << (bucket - 1))) << histogramShift; }
+
+	// the bucket of the duration in the histogram units
+	static size_t GetBucket(RC433HQTicks units)
+	{
+		size_t bucket = (units == 0)? 0: size_t(sizeof(unsigned long) * 8 - __builtin_clzl(units));
+		return (bucket < RC433HQ_DURATION_HISTOGRAM_BUCKETS)? bucket: (RC433HQ_DURATION_HISTOGRAM_BUCKETS - 1);
+	}
+};
+
+// the latency histogram counts in 1024 us (~1 ms), so the frames of tens of milliseconds fit below the last bucket
+static const byte RC433HQ_LATENCY_HISTOGRAM_SHIFT = 10;
+
+/** \brief Latency of the frames in microseconds (not ticks, GetMinTicks() etc. return microseconds) with the histogram in
+    1024 us units: the bucket i holds the latencies from 2^(i-1) to 2^i ms, up to ~16 s with 16 buckets on the board
+ */
+class RC433HQLatencyStatistics: public RC433HQDurationStatistics {
+public:
+	RC433HQLatencyStatistics():
+		RC433HQDurationStatistics(RC433HQ_LATENCY_HISTOGRAM_SHIFT)
+	{
+	}
+};
+
+#if defined(RC433HQ_PROFILE)
+
+/** \brief Statistics of the receive path timing collected if RC433HQ_PROFILE is defined: the duration of the receiver interrupt
+    handler (including the connected noise filter, pulse buffer etc.) and of the sections with disabled interrupts in
+    RC433HQPulseBuffer::ProcessData(). The longest masked section delays the interrupt handling, so the sum of both maximums
+    is the shortest pulse that can be received without missing the edges.
+ */
+class RC433HQProfiler {
+private:
+	static RC433HQDurationStatistics interruptStatistics;
+	static RC433HQDurationStatistics maskedSectionStatistics;
+
+public:
+	// called by the instrumented code
+	static void AddInterruptDuration(RC433HQTicks ticks) { interruptStatistics.Add(ticks); }
+	static void AddMaskedSectionDuration(RC433HQTicks ticks) { maskedSectionStatistics.Add(ticks); }
+
+	// call from the loop to get the consistent copy of the statistics
+	static void GetInterruptStatistics(RC433HQDurationStatistics &snapshot) { interruptStatistics.GetSnapshot(snapshot); }
+	static void GetMaskedSectionStatistics(RC433HQDurationStatistics &snapshot) { maskedSectionStatistics.GetSnapshot(snapshot); }
+
+	static void Reset();
 };
 
+#	define RC433HQ_PROFILE_START(start) RC433HQTicks start = RC433HQTickService::GetTicks()
+#	define RC433HQ_PROFILE_STOP(start, add) RC433HQProfiler::add(RC433HQTickService::GetTicks() - start)
+#else
+#	define RC433HQ_PROFILE_START(start)
+#	define RC433HQ_PROFILE_STOP(start, add)
+#endif // defined(RC433HQ_PROFILE)
+
+
 //////////////////////////////////////////////////////////////////////////////////
 // IRC433Logger declaration
 //////////////////////////////////////////////////////////////////////////////////
@@ -145,6 +378,19 @@ public:
 };
 
 
+//////////////////////////////////////////////////////////////////////////////////
+// IRC433CaptureSink declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Output of the recorded edge captures (e.g. a file on SD card or the serial line)
+ */
+class IRC433CaptureSink {
+public:
+	virtual void WriteCaptureData(const byte *data, size_t size) = 0;
+
+};
+
+
 //////////////////////////////////////////////////////////////////////////////////
 // IRC433DataReceiver declaration
 //////////////////////////////////////////////////////////////////////////////////
@@ -153,11 +399,43 @@ public:
  */
 class IRC433DataReceiver {
 public:
+	virtual ~IRC433DataReceiver() {}
+
 	virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality) = 0;
+
+	// called by the decoders with the wrap-safe 64-bit time of the frame. Forwards to HandleData() by default, 
+	// override to get monotonic frame timestamps
+	virtual void HandleExtendedData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, double quality)
+	{
+		HandleData(time.GetMicroseconds(), data, bits, quality);
+	}
+
+	// called by the decoders in the soft decision mode with the confidence of every bit (0 - a guess, 255 - exact timing).
+	// Forwards to HandleExtendedData() by default.
+	virtual void HandleSoftData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, const byte * /*confidences*/, double quality)
+	{
+		HandleExtendedData(time, data, bits, quality);
+	}
 	
 };
 
 
+//////////////////////////////////////////////////////////////////////////////////
+// IRC433FrameValidator declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Protocol specific check of the decoded frame (checksum, fixed bits, known addresses), called by the decoder
+    before the frame is delivered, so the frames produced by the noise are dropped early
+ */
+class IRC433FrameValidator {
+public:
+	virtual ~IRC433FrameValidator() {}
+
+	// returns false if the frame is not valid and has to be dropped
+	virtual bool ValidateFrame(const byte *data, size_t bits) = 0;
+};
+
+
 //////////////////////////////////////////////////////////////////////////////////
 // IRC433PulseProcessor declaration
 //////////////////////////////////////////////////////////////////////////////////
@@ -166,6 +444,8 @@ public:
  */
 class IRC433PulseProcessor {
 public:
+	virtual ~IRC433PulseProcessor() {}
+
 	// handle one rising or falling edge that was detected at specified time
 	virtual void HandleEdge(RC433HQMicroseconds time, bool direction) = 0;
 
@@ -175,6 +455,32 @@ public:
 	}
 };
 
+// Static dispatch into the processor of the type known at compile time, used by the statically composed stages
+// (RC433HQStaticNoiseFilter, RC433HQStaticSplitter, RC433HQStaticPulseBuffer, RC433HQStaticReceiver). The qualified call
+// is not virtual, so the compiler can inline the whole chain. TProcessor must be the exact (most derived) type of the
+// processor, the processors known only as IRC433PulseProcessor are called virtually.
+template <class TProcessor>
+inline void RC433HQHandleEdge(TProcessor &processor, RC433HQMicroseconds time, bool direction)
+{
+	processor.TProcessor::HandleEdge(time, direction);
+}
+
+inline void RC433HQHandleEdge(IRC433PulseProcessor &processor, RC433HQMicroseconds time, bool direction)
+{
+	processor.HandleEdge(time, direction);
+}
+
+template <class TProcessor>
+inline void RC433HQHandleMissedEdges(TProcessor &processor)
+{
+	processor.TProcessor::HandleMissedEdges();
+}
+
+inline void RC433HQHandleMissedEdges(IRC433PulseProcessor &processor)
+{
+	processor.HandleMissedEdges();
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////
 // RC433HQDataTransmitterBase declaration
@@ -208,31 +514,180 @@ public:
 // RC433PulseSignalSplitter declaration
 //////////////////////////////////////////////////////////////////////////////////
 
-/** \brief Signal splitter allows two proessors to be connected to a single signal source
+/** \brief Signal splitter allows two processors of the types known at compile time to be connected to a single signal source
  */
-class RC433PulseSignalSplitter: public IRC433PulseProcessor {
+template <class TFirst, class TSecond>
+class RC433HQStaticSplitter: public IRC433PulseProcessor {
 private:
-	IRC433PulseProcessor &first;
-	IRC433PulseProcessor &second;
+	TFirst &first;
+	TSecond &second;
 public:
-	RC433PulseSignalSplitter(IRC433PulseProcessor &afirst, IRC433PulseProcessor &asecond):
+	RC433HQStaticSplitter(TFirst &afirst, TSecond &asecond):
 		first(afirst),
 		second(asecond)
 	{
 	}
-	
+
 	virtual void HandleEdge(RC433HQMicroseconds time, bool direction)
 	{
 		// handle the edge in both attached processors
-		first.HandleEdge(time, direction);
-		second.HandleEdge(time, direction);
+		RC433HQHandleEdge(first, time, direction);
+		RC433HQHandleEdge(second, time, direction);
 	}
 
 	virtual void HandleMissedEdges()
 	{
 		// inform both attached processors
-		first.HandleMissedEdges();
-		second.HandleMissedEdges();
+		RC433HQHandleMissedEdges(first);
+		RC433HQHandleMissedEdges(second);
+	}
+};
+
+/** \brief Signal splitter allows two proessors to be connected to a single signal source
+ */
+class RC433PulseSignalSplitter: public RC433HQStaticSplitter<IRC433PulseProcessor, IRC433PulseProcessor> {
+public:
+	RC433PulseSignalSplitter(IRC433PulseProcessor &afirst, IRC433PulseProcessor &asecond):
+		RC433HQStaticSplitter<IRC433PulseProcessor, IRC433PulseProcessor>(afirst, asecond)
+	{
+	}
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPulseFanOut declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Connects up to MAX_PROCESSORS processors to a single signal source, every edge is passed to all the attached
+    processors in one loop (instead of the tree of the nested splitters). The processors can be detached and attached
+    again at runtime, e.g. to disable a protocol. The re-attached processor receives HandleMissedEdges() before its next
+    edge to forget the state from before the detaching. Call Detach() and Attach() from the same context as the edges
+    are passed in (e.g. from the loop when connected behind the pulse buffer).
+    Usage:
+       RC433HQPulseFanOut<3> fanOut;
+       fanOut.Add(decoderA);
+       fanOut.Add(decoderB);
+       fanOut.Add(decoderC, false);   // disabled until Attach(decoderC)
+       RC433HQPulseBuffer buffer(fanOut, 256);
+ */
+template <size_t MAX_PROCESSORS>
+class RC433HQPulseFanOut: public IRC433PulseProcessor {
+private:
+	IRC433PulseProcessor *processors[MAX_PROCESSORS];      // in the order of adding
+	bool attached[MAX_PROCESSORS];
+	size_t processorsCount;
+	IRC433PulseProcessor *activeProcessors[MAX_PROCESSORS];  // the attached processors, the dispatch loop
+	size_t activeCount;
+	IRC433PulseProcessor *resetProcessors[MAX_PROCESSORS];   // attached again, waiting for HandleMissedEdges()
+	size_t resetCount;
+
+public:
+	RC433HQPulseFanOut():
+		processorsCount(0),
+		activeCount(0),
+		resetCount(0)
+	{
+	}
+
+	// returns false if there are already MAX_PROCESSORS processors
+	bool Add(IRC433PulseProcessor &processor, bool aattached = true)
+	{
+		if (processorsCount >= MAX_PROCESSORS) {
+			return false;
+		}
+		processors[processorsCount] = &processor;
+		attached[processorsCount] = aattached;
+		processorsCount++;
+		UpdateActiveProcessors();
+		return true;
+	}
+
+	size_t GetProcessorsCount() const { return processorsCount; }
+
+	// return false if the processor was not added
+	bool Detach(IRC433PulseProcessor &processor)
+	{
+		size_t index = Find(processor);
+		if (index >= processorsCount) {
+			return false;
+		}
+		if (attached[index]) {
+			attached[index] = false;
+
+			// the processor is not reset if it was detached before its next edge
+			size_t i = 0;
+			while ((i < resetCount) && (resetProcessors[i] != &processor)) {
+				i++;
+			}
+			if (i < resetCount) {
+				resetProcessors[i] = resetProcessors[--resetCount];
+			}
+			UpdateActiveProcessors();
+		}
+		return true;
+	}
+
+	bool Attach(IRC433PulseProcessor &processor)
+	{
+		size_t index = Find(processor);
+		if (index >= processorsCount) {
+			return false;
+		}
+		if (!attached[index]) {
+			attached[index] = true;
+			resetProcessors[resetCount++] = &processor;
+			UpdateActiveProcessors();
+		}
+		return true;
+	}
+
+	bool IsAttached(IRC433PulseProcessor &processor) const
+	{
+		size_t index = Find(processor);
+		return (index < processorsCount) && attached[index];
+	}
+
+	virtual void HandleEdge(RC433HQMicroseconds time, bool direction)
+	{
+		// the re-attached processors missed all the edges since they were detached
+		if (resetCount > 0) {
+			for (size_t i = 0; i < resetCount; i++) {
+				resetProcessors[i]->HandleMissedEdges();
+			}
+			resetCount = 0;
+		}
+
+		for (size_t i = 0; i < activeCount; i++) {
+			activeProcessors[i]->HandleEdge(time, direction);
+		}
+	}
+
+	virtual void HandleMissedEdges()
+	{
+		resetCount = 0;
+		for (size_t i = 0; i < activeCount; i++) {
+			activeProcessors[i]->HandleMissedEdges();
+		}
+	}
+
+private:
+	size_t Find(IRC433PulseProcessor &processor) const
+	{
+		size_t index = 0;
+		while ((index < processorsCount) && (processors[index] != &processor)) {
+			index++;
+		}
+		return index;
+	}
+
+	void UpdateActiveProcessors()
+	{
+		activeCount = 0;
+		for (size_t i = 0; i < processorsCount; i++) {
+			if (attached[i]) {
+				activeProcessors[activeCount++] = processors[i];
+			}
+		}
 	}
 };
 
@@ -241,6 +696,44 @@ public:
 // RC433HQPulseBuffer declaration
 //////////////////////////////////////////////////////////////////////////////////
 
+#if !defined(RC433HQ_OVERFLOW_EPISODES)
+#	define RC433HQ_OVERFLOW_EPISODES 4
+#endif // !defined(RC433HQ_OVERFLOW_EPISODES)
+
+#define RC433HQ_OCCUPANCY_HISTOGRAM_BUCKETS 8
+
+// continuous sequence of the edges, that could not be stored into the full RC433HQPulseBuffer
+struct RC433HQOverflowEpisode {
+	RC433HQMicroseconds startTime;       // time of the first lost edge
+	RC433HQMicrosecondsDiff duration;    // from the first lost edge to the next stored edge
+	unsigned long lostEdges;
+};
+
+/** \brief Usage of the RC433HQPulseBuffer since the last RC433HQPulseBuffer::TakeStatistics() for the sizing of the buffer
+ */
+struct RC433HQPulseBufferStatistics {
+	size_t highWaterMark;                // max count of the used items (words)
+	unsigned long relativeEdges;         // edges stored as one word with the relative time
+	unsigned long absoluteEdges;         // edges stored as three words with the absolute time (empty buffer or too long delay)
+	// count of the ProcessData() calls by the occupancy of the buffer found by the call, the bucket i counts the occupancy
+	// from i/8 to (i+1)/8 of the buffer size (the full buffer is in the last bucket)
+	unsigned long occupancyHistogram[RC433HQ_OCCUPANCY_HISTOGRAM_BUCKETS];
+	unsigned long lostEdges;             // edges lost since the last snapshot (the episode carried over keeps its total)
+	unsigned long overflowEpisodesCount; // finished overflow episodes (ended by the next stored edge)
+	// the last finished episodes, the newest one at (overflowEpisodesCount - 1) % RC433HQ_OVERFLOW_EPISODES
+	RC433HQOverflowEpisode overflowEpisodes[RC433HQ_OVERFLOW_EPISODES];
+
+	RC433HQPulseBufferStatistics() { Reset(); }
+
+	void Reset();
+
+	// count of the valid items of overflowEpisodes
+	size_t GetStoredOverflowEpisodesCount() const
+	{
+		return (overflowEpisodesCount < RC433HQ_OVERFLOW_EPISODES)? size_t(overflowEpisodesCount): RC433HQ_OVERFLOW_EPISODES;
+	}
+};
+
 /** \brief PulseBuffer implements the IRC433PulseProcessor, minimizes the time in the interrupt and passes the buffered data into the connected pulse decoder from the Process() method that needs to be periodically called from the loop
  */
 class RC433HQPulseBuffer: public IRC433PulseProcessor {
@@ -254,6 +747,7 @@ private:
 private:
 	IRC433PulseProcessor &connectedPulseDecoder;
 	IRC433Logger *logger;
+	RC433HQTimeExtender *timeExtender;
 	size_t bufferSize;
 	BufferValue *buffer;
 	RC433HQMicroseconds lastStoredEdgeTime;  // valid, if there is at least one edge in the buffer
@@ -262,6 +756,11 @@ private:
 	size_t freeIndex;
 	size_t usedCount;	// count of the items (not edges) already stored into the buffer
 	size_t missedCount; // count of the missed items, that could not be stored into the buffer
+	bool missedIndexSet;  // the missed edges should be reported when the data index reaches the missed index
+	size_t missedIndex;   // (kept between the ProcessData() calls limited by the time or edges budget)
+	RC433HQPulseBufferStatistics statistics;
+	bool overflowing;     // the last edge was lost, the statistics.overflowEpisodes[overflowIndex] is being recorded
+	size_t overflowIndex;
 
 public:
 	RC433HQPulseBuffer(IRC433PulseProcessor &aconnectedPulseDecoder, size_t abufferSize);
@@ -272,91 +771,877 @@ public:
 	// because the buffer was full.
 	void ProcessData(size_t &reportedBufferUsedCount, size_t &reportedProcessedCount, size_t &reportedMissedCount);
 
+	// the same as above, but stops after maxEdges processed edges or after maxDuration (zero means unlimited), so that a burst
+	// of noise does not block the loop. The rest stays in the buffer for the next call and the missed edges are still reported
+	// in the right place of the edge sequence. Returns true if some data remain in the buffer.
+	bool ProcessData(size_t &reportedBufferUsedCount, size_t &reportedProcessedCount, size_t &reportedMissedCount, size_t maxEdges, RC433HQMicrosecondsDiff maxDuration);
+
+	// the time extender will be kept up to date with the current time and the times of the processed edges
+	void SetTimeExtender(RC433HQTimeExtender &atimeExtender)
+	{
+		timeExtender = &atimeExtender;
+	}
+
 	virtual void HandleEdge(RC433HQMicroseconds time, bool direction);
 
+	size_t GetBufferSize() const { return bufferSize; }
+
+	// copy the statistics and reset them, call from the loop (the interrupts are disabled while copying)
+	void TakeStatistics(RC433HQPulseBufferStatistics &snapshot);
+
+protected:
+	// the processing loop of ProcessData() passing the edges into the processor of the type known at compile time
+	template <class TProcessor>
+	bool ProcessDataInto(TProcessor &processor, size_t &reportedBufferUsedCount, size_t &reportedProcessedCount, size_t &reportedMissedCount, size_t maxEdges, RC433HQMicrosecondsDiff maxDuration);
+
 private:
 	void StoreAbsolutTime(RC433HQMicroseconds time, BufferValue directionMask);
 	size_t CalculateNext(size_t index);
 };
 
-
-//////////////////////////////////////////////////////////////////////////////////
-// RC433HQNoiseFilter declaration
-//////////////////////////////////////////////////////////////////////////////////
-
-/** \brief RC433HQNoiseFilter implements the IRC433PulseProcessor, eliminates fast edge changes from the data and forwards (slightly delayed) edges into the connected decoder
+/** \brief Pulse buffer passing the buffered data into the connected processor of the type known at compile time, so that the
+    whole loop side chain can be inlined into ProcessData()
  */
-class RC433HQNoiseFilter: public IRC433PulseProcessor {
+template <class TProcessor>
+class RC433HQStaticPulseBuffer: public RC433HQPulseBuffer {
 private:
-	IRC433PulseProcessor &decoder;
-	RC433HQMicrosecondsDiff minPulseDuration;
-	bool lastEdgeValid;
-	RC433HQMicroseconds lastEdgeTime;
-	bool lastEdgeDirection;
+	TProcessor &processor;
+
 public:
-	RC433HQNoiseFilter(IRC433PulseProcessor &adecoder, RC433HQMicrosecondsDiff aminPulseDuration):
-		decoder(adecoder), 
-		minPulseDuration(aminPulseDuration), 
-		lastEdgeValid(false) 
+	RC433HQStaticPulseBuffer(TProcessor &aprocessor, size_t abufferSize):
+		RC433HQPulseBuffer(aprocessor, abufferSize),
+		processor(aprocessor)
 	{
 	}
 
-	virtual void HandleEdge(RC433HQMicroseconds time, bool direction);
+	void ProcessData(size_t &reportedBufferUsedCount, size_t &reportedProcessedCount, size_t &reportedMissedCount)
+	{
+		ProcessDataInto(processor, reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount, 0, 0);
+	}
 
-	virtual void HandleMissedEdges();
+	bool ProcessData(size_t &reportedBufferUsedCount, size_t &reportedProcessedCount, size_t &reportedMissedCount, size_t maxEdges, RC433HQMicrosecondsDiff maxDuration)
+	{
+		return ProcessDataInto(processor, reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount, maxEdges, maxDuration);
+	}
 };
 
+// the inline parts of RC433HQPulseBuffer (the interrupt side and the processing loop), inlined into the static chains
 
-//////////////////////////////////////////////////////////////////////////////////
-// RC433HQBasicSyncPulseDecoder declaration
-//////////////////////////////////////////////////////////////////////////////////
+template <class TProcessor>
+bool RC433HQPulseBuffer::ProcessDataInto(TProcessor &processor, size_t &reportedBufferUsedCount, size_t &reportedProcessedCount, size_t &reportedMissedCount, size_t maxEdges, RC433HQMicrosecondsDiff maxDuration)
+{
+	// initialize the output values
+	reportedBufferUsedCount = 0;
+	reportedProcessedCount = 0;
+	reportedMissedCount = 0;
 
-static const size_t RC433HQ_MAX_PULSE_BITS = 128;
+	// the start of the processing is needed for both the time budget and the epoch update
+	RC433HQMicroseconds startTime;
+	if (timeExtender || (maxDuration != 0)) {
+		startTime = RC433HQTimeService::GetTimeInMicroseconds();
+	}
 
-/** \brief Basic sync protocol decoder
- */
-class RC433HQBasicSyncPulseDecoder: public IRC433PulseProcessor {
-private:
-	IRC433DataReceiver &dataReceiver;
-	IRC433Logger *logger;
-	word syncFirstUs, syncSecondUs, zeroFirstUs, zeroSecondUs, oneFirstUs, oneSecondUs;
-	word toleranceUs; // max tolerance of rising or falling edges timing in us
-	bool highFirst;
-	word minBits, maxBits;
-	bool syncDetected;
-	RC433HQMicroseconds syncTime; 
-	byte receivedData[RC433HQ_MAX_PULSE_BITS / 8];
-	size_t receivedBits;
-	bool previousRisingEdge;
-	RC433HQMicroseconds previousRisingEdgeTime;
-	bool previousFallingEdge;
-	RC433HQMicroseconds previousFallingEdgeTime;
-	double deltaPowerSum;  // sum of delta^2 for individual edges
-	
-public:	
-	RC433HQBasicSyncPulseDecoder(IRC433DataReceiver &adataReceiver, word asyncFirstUs, word asyncSecondUs, word azeroFirstUs, word azeroSecondUs, word aoneFirstUs, word aoneSecondUs, word atoleranceUs, bool ahighFirst, word aminBits, word amaxBits):
-		dataReceiver(adataReceiver),
-		logger(0),
-		syncFirstUs(asyncFirstUs),
-		syncSecondUs(asyncSecondUs), 
-		zeroFirstUs(azeroFirstUs), 
-		zeroSecondUs(azeroSecondUs), 
-		oneFirstUs(aoneFirstUs), 
-		oneSecondUs(aoneSecondUs), 
-		toleranceUs(atoleranceUs),
-		highFirst(ahighFirst),
-		minBits(aminBits), maxBits(amaxBits),
+	// keep the epoch up to date even if there are no edges
+	if (timeExtender) {
+		timeExtender->Update(startTime);
+	}
+
+	bool continueProcessing = false;
+	bool dataRemaining = false;
+	bool occupancySampled = false;
+
+	do {
+
+		continueProcessing = false;
+
+		bool dataAvailable = false;
+		RC433HQMicroseconds time;
+		bool direction;
+
+		bool sendHandleMissedEdges = false;
+
+		// disable the interrupts for a while
+		noInterrupts();
+		RC433HQ_PROFILE_START(maskedStart);
+
+		// sample the occupancy found by this call
+		if (!occupancySampled) {
+			size_t bucket = (usedCount * RC433HQ_OCCUPANCY_HISTOGRAM_BUCKETS) / bufferSize;
+			statistics.occupancyHistogram[(bucket < RC433HQ_OCCUPANCY_HISTOGRAM_BUCKETS)? bucket: (RC433HQ_OCCUPANCY_HISTOGRAM_BUCKETS - 1)]++;
+			occupancySampled = true;
+		}
+
+		// if there are some items in the buffer
+		if (usedCount > 0) {
+
+			// set the data available flag
+			dataAvailable = true;
+
+			// read the first item from the buffer
+			BufferValue value = buffer[dataIndex]; dataIndex = CalculateNext(dataIndex); usedCount--; reportedBufferUsedCount++;
+
+			// calculate the direction
+			direction = (value & 0x8000) != 0;
+
+			// if the value is a marker that the absolute time is stored
+			if ((value & 0x7fff) == 0x7fff) {
+
+				// there should be two more values
+				// assert(usedCount >= 2);
+
+				// read the absolute time from the buffer
+				unsigned long timeLow = buffer[dataIndex]; dataIndex = CalculateNext(dataIndex); usedCount--; reportedBufferUsedCount++;
+				unsigned long timeHigh = buffer[dataIndex]; dataIndex = CalculateNext(dataIndex); usedCount--; reportedBufferUsedCount++;
+
+				// calculate the time from two words
+				time = (timeHigh << 16) | timeLow;
+
+			} else {
+
+				// we will calculate the relative time
+				time = lastSentEdgeTime + (value & 0x7fff);
+			}
+
+			// if the missed index has been set and points to the next
+			if (missedIndexSet && (missedIndex == dataIndex)) {
+
+				// set the flag to call the handle missed edges
+				sendHandleMissedEdges = true;
+
+				// clear the value of the free index
+				missedIndexSet = false;
+				missedIndex = freeIndex;
+			}
+
+			// if there are still some data
+			if (usedCount > 0) {
+
+				// set the flag to make one more iteration
+				continueProcessing = true;
+			}
+		}
+
+		// if there were some missed items
+		if (missedCount > 0) {
+			
+			// if the missed index has not been set
+			if (!missedIndexSet) {
+
+				// if the buffer is empty, the edges were missed right after the last read edge
+				if (usedCount == 0) {
+
+					sendHandleMissedEdges = true;
+
+				} else {
+
+					// keep the current value of the free index
+					missedIndexSet = true;
+					missedIndex = freeIndex;
+				}
+			}
+
+			// keep the number of missed items
+			reportedMissedCount += missedCount;
+
+			// clear the original missed items counter
+			missedCount = 0;
+		}
+
+		// remember, whether some data stay in the buffer if the processing is stopped by the budget
+		dataRemaining = continueProcessing;
+
+		// re-enable interrupts
+		RC433HQ_PROFILE_STOP(maskedStart, AddMaskedSectionDuration);
+		interrupts();
+
+		// if some data was removed from the buffer
+		if (dataAvailable) {
+
+			// send the data to the connected decoder
+			RC433HQHandleEdge(processor, time, direction);
+			lastSentEdgeTime = time;
+
+			if (timeExtender) {
+				timeExtender->Update(time);
+			}
+
+			// increase the reported user count
+			reportedProcessedCount++;
+		}
+
+		// if we should send the handle missed edges
+		if (sendHandleMissedEdges) {
+
+			// call it
+			RC433HQHandleMissedEdges(processor);
+			sendHandleMissedEdges = false;
+		}
+
+		// if the count of edges processed in this call reached the limit
+		if ((maxEdges != 0) && (reportedProcessedCount >= maxEdges)) {
+
+			// stop the processing
+			continueProcessing = false;
+		}
+
+		// if the time budget of this call has been exhausted
+		if (continueProcessing && (maxDuration != 0) && ((RC433HQTimeService::GetTimeInMicroseconds() - startTime) >= maxDuration)) {
+
+			// stop the processing
+			continueProcessing = false;
+		}
+
+	} while (continueProcessing);
+
+	return dataRemaining;
+}
+
+inline void RC433HQPulseBuffer::HandleEdge(RC433HQMicroseconds time, bool direction)
+{
+	// this method is typically called from an interrupt, so we use a simple mutual exclution 
+	// just by disabling the interrupts from the method that reads the data written here.
+
+	// assert(buffer != 0);
+
+	bool successfullyStored = false;
+
+	// if the buffer is valid
+	if (buffer != 0) {
+
+		// calculate the direction mask
+		word directionMask = (direction? 0x8000: 0x0000);
+
+		// if there are no items in the buffer
+		if (usedCount == 0) {
+
+			// store the absolut time of the edge
+			StoreAbsolutTime(time, directionMask);
+			lastStoredEdgeTime = time;
+			successfullyStored = true;
+
+		} else {
+
+			// calculate the relative edge time from the current and last edge times
+			RC433HQMicrosecondsDiff relativeEdgeTime = time - lastStoredEdgeTime;
+
+			// if the time is smaller than what fits into 15 bits
+			if (relativeEdgeTime < 0x7fff_us) {
+
+				// if there is one item available in the buffer
+				if (usedCount < bufferSize) {
+
+					// store the relative edge time
+					buffer[freeIndex] = directionMask | BufferValue(relativeEdgeTime.GetLoWord()); freeIndex = CalculateNext(freeIndex);  // direction and 15 bits
+					usedCount++;
+					statistics.relativeEdges++;
+					lastStoredEdgeTime = time;
+					successfullyStored = true;
+				}
+
+			} else {
+
+				// we need to store the absolute time. If there are at least 3 items in the buffer
+				if (usedCount <= (bufferSize - 3)) {
+
+					// store the absolut time of the edge
+					StoreAbsolutTime(time, directionMask);
+					lastStoredEdgeTime = time;
+					successfullyStored = true;
+				}
+			}
+		}
+	}
+
+	// if we could not successfully store the incoming value
+	if (!successfullyStored) {
+
+		// increase the missedCount
+		missedCount++;
+
+		// start or continue the overflow episode
+		if (!overflowing) {
+			overflowing = true;
+			overflowIndex = size_t(statistics.overflowEpisodesCount % RC433HQ_OVERFLOW_EPISODES);
+			statistics.overflowEpisodes[overflowIndex].startTime = time;
+			statistics.overflowEpisodes[overflowIndex].lostEdges = 0;
+		}
+		statistics.overflowEpisodes[overflowIndex].lostEdges++;
+		statistics.lostEdges++;
+
+	} else {
+
+		// keep the peak occupancy
+		if (usedCount > statistics.highWaterMark) {
+			statistics.highWaterMark = usedCount;
+		}
+
+		// the stored edge finishes the overflow episode
+		if (overflowing) {
+			overflowing = false;
+			statistics.overflowEpisodes[overflowIndex].duration = time - statistics.overflowEpisodes[overflowIndex].startTime;
+			statistics.overflowEpisodesCount++;
+		}
+	}
+}
+
+inline void RC433HQPulseBuffer::StoreAbsolutTime(RC433HQMicroseconds time, BufferValue directionMask)
+{
+	buffer[freeIndex] = directionMask | 0x7fff; freeIndex = CalculateNext(freeIndex);      // direction and marker
+	buffer[freeIndex] = BufferValue(time.GetLoWord()); freeIndex = CalculateNext(freeIndex);  // lower 2 bytes
+	buffer[freeIndex] = BufferValue(time.GetHiWord()); freeIndex = CalculateNext(freeIndex);  // higher 2 bytes
+	usedCount += 3;
+	statistics.absoluteEdges++;
+}
+
+inline size_t RC433HQPulseBuffer::CalculateNext(size_t index)
+{
+	if ((index + 1) < bufferSize) {
+		return index + 1;
+	} else {
+		return 0;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPulseRecorder declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// The edge capture format (all values little endian):
+//  - 16 bytes header: magic "RQEC", word version (1), word header size (16), 32-bit timer resolution in ns, 32-bit reserved (0)
+//  - sequence of words in the RC433HQPulseBuffer format: the highest bit 0x8000 is the direction of the edge, the lower 15 bits
+//    are the delay since the previous edge in microseconds. 0x7fff means the next two words are the absolute time in microseconds
+//    (lower word first) and 0x7ffe marks the edges missed before the next edge.
+extern const byte RC433HQ_CAPTURE_MAGIC[4];
+static const word RC433HQ_CAPTURE_VERSION = 1;
+static const size_t RC433HQ_CAPTURE_HEADER_SIZE = 16;
+static const word RC433HQ_CAPTURE_DIRECTION_MASK = 0x8000;
+static const word RC433HQ_CAPTURE_ABSOLUTE_TIME = 0x7fff;
+static const word RC433HQ_CAPTURE_MISSED_EDGES = 0x7ffe;
+
+/** \brief PulseRecorder implements the IRC433PulseProcessor and writes the edges into the compact capture (use it from the loop, e.g. after the RC433HQPulseBuffer)
+ */
+class RC433HQPulseRecorder: public IRC433PulseProcessor {
+private:
+	IRC433CaptureSink &sink;
+	unsigned long timerResolutionNs;
+	bool headerWritten;
+	bool lastEdgeValid;
+	RC433HQMicroseconds lastEdgeTime;
+	byte cache[32];         // the data are written to the sink in blocks
+	size_t cacheUsed;
+
+public:
+	RC433HQPulseRecorder(IRC433CaptureSink &asink, unsigned long atimerResolutionNs = RC433HQTimeService::GetTimerResolutionNs());
+
+	virtual void HandleEdge(RC433HQMicroseconds time, bool direction);
+
+	virtual void HandleMissedEdges();
+
+	// write the cached data into the sink
+	void Flush();
+
+private:
+	void WriteHeader();
+	void WriteWord(word value);
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQNoiseFilter declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief RC433HQStaticNoiseFilter eliminates fast edge changes from the data and forwards (slightly delayed) edges into the
+    connected decoder of the type known at compile time
+ */
+template <class TProcessor>
+class RC433HQStaticNoiseFilter: public IRC433PulseProcessor {
+private:
+	TProcessor &decoder;
+	RC433HQMicrosecondsDiff minPulseDuration;
+	bool lastEdgeValid;
+	RC433HQMicroseconds lastEdgeTime;
+	bool lastEdgeDirection;
+public:
+	RC433HQStaticNoiseFilter(TProcessor &adecoder, RC433HQMicrosecondsDiff aminPulseDuration):
+		decoder(adecoder), 
+		minPulseDuration(aminPulseDuration), 
+		lastEdgeValid(false) 
+	{
+	}
+
+	virtual void HandleEdge(RC433HQMicroseconds time, bool direction)
+	{
+		// if we have some edge in the memory
+		if (lastEdgeValid) {
+
+			// if this edge in the same direction as the last edge
+			if (lastEdgeDirection == direction) {
+
+				// ignore the first edge, keep the currect edge in the memory and quit
+				lastEdgeTime = time;
+				lastEdgeDirection = direction;
+				lastEdgeValid = true;
+				return;
+			}
+
+			// calculate the duration of the last pulse
+			RC433HQMicrosecondsDiff duration = (time - lastEdgeTime);
+
+			// if the last pulse was to short
+			if (duration < minPulseDuration) {
+
+				// ignore the last pulse and also the one currently obtained
+				lastEdgeValid = false;
+				return;
+			}
+
+			// send the last edge into the connected decoder
+			RC433HQHandleEdge(decoder, lastEdgeTime, lastEdgeDirection);
+		}
+
+		// keep the currect edge in the memory
+		lastEdgeTime = time;
+		lastEdgeDirection = direction;
+		lastEdgeValid = true;
+	}
+
+	virtual void HandleMissedEdges()
+	{
+		// ignore the last pulse and also the one currently obtained
+		lastEdgeValid = false;
+
+		// inform the attached processor we are losing some data
+		RC433HQHandleMissedEdges(decoder);
+	}
+};
+
+/** \brief RC433HQNoiseFilter implements the IRC433PulseProcessor, eliminates fast edge changes from the data and forwards (slightly delayed) edges into the connected decoder
+ */
+class RC433HQNoiseFilter: public RC433HQStaticNoiseFilter<IRC433PulseProcessor> {
+public:
+	RC433HQNoiseFilter(IRC433PulseProcessor &adecoder, RC433HQMicrosecondsDiff aminPulseDuration):
+		RC433HQStaticNoiseFilter<IRC433PulseProcessor>(adecoder, aminPulseDuration)
+	{
+	}
+};
+
+
+static const size_t RC433HQ_MAX_PULSE_BITS = 128;
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameQueue declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Read only view of one decoded frame stored in the RC433HQFrameQueue, valid until the frame is popped
+ */
+class RC433HQFrameView {
+private:
+	friend class RC433HQFrameQueue;
+
+	struct Slot {
+		RC433HQExtendedMicroseconds time;
+		double quality;
+		byte data[RC433HQ_MAX_PULSE_BITS / 8];
+		byte bits;
+		byte protocol;
+	};
+
+	const Slot *slot;
+
+public:
+	RC433HQFrameView(): slot(0) {}
+
+	RC433HQExtendedMicroseconds GetExtendedTime() const { return slot->time; }
+	RC433HQMicroseconds GetTime() const { return slot->time.GetMicroseconds(); }
+	byte GetProtocol() const { return slot->protocol; }
+	size_t GetBits() const { return slot->bits; }
+	const byte *GetData() const { return slot->data; }
+	double GetQuality() const { return slot->quality; }
+};
+
+/** \brief Fixed capacity queue of the decoded frames. The decoders attached by SetFrameQueue() receive the bits directly
+    into the queue slots, so the frames are only stored during ProcessData() and the application consumes them later
+    (e.g. prints them to the slow serial line) without blocking the edge processing. Every attached decoder keeps one
+    slot reserved for the frame being received. If there is no free slot, the frame is dropped and counted.
+    The queue is not interrupt safe, use it from the loop only.
+    Usage:
+       RC433HQFrameQueue frames(8);
+       decoderA.SetFrameQueue(frames, PROTOCOL_A);
+       ...
+       buffer.ProcessData(...);
+       RC433HQFrameView frame;
+       while (frames.Peek(frame)) {
+           ... use frame.GetData(), frame.GetBits(), ...
+           frames.Pop();
+       }
+ */
+class RC433HQFrameQueue {
+public:
+	static const size_t NO_SLOT = size_t(-1);
+
+private:
+	typedef RC433HQFrameView::Slot Slot;
+
+	size_t capacity;
+	Slot *slots;
+	size_t *freeSlots;         // stack of the free slots
+	size_t freeCount;
+	size_t *readySlots;        // ring of the slots with the frames ready for the application
+	size_t readyIndex;
+	size_t readyCount;
+	unsigned long droppedCount;
+
+public:
+	RC433HQFrameQueue(size_t acapacity);
+	~RC433HQFrameQueue();
+
+	size_t GetCapacity() const { return capacity; }
+
+	// count of the frames ready for the application
+	size_t GetCount() const { return readyCount; }
+	bool IsEmpty() const { return readyCount == 0; }
+
+	// count of the frames dropped because there was no free slot
+	unsigned long GetDroppedCount() const { return droppedCount; }
+	void ResetDroppedCount() { droppedCount = 0; }
+
+	// view of the oldest frame, returns false if there is none
+	bool Peek(RC433HQFrameView &view) const;
+
+	// release the oldest frame
+	void Pop();
+
+	// decoder side: reserve a free slot for the next frame, returns its data buffer and sets the slot (NO_SLOT and 0 if none is free)
+	byte *ReserveSlot(size_t &slot);
+
+	// decoder side: the frame in the reserved slot is complete
+	void CommitSlot(size_t slot, byte protocol, RC433HQExtendedMicroseconds time, size_t bits, double quality);
+
+	// decoder side: the frame was decoded without a reserved slot
+	void DropFrame() { droppedCount++; }
+
+private:
+	RC433HQFrameQueue(const RC433HQFrameQueue &);
+	RC433HQFrameQueue &operator=(const RC433HQFrameQueue &);
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameValidators declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Table driven CRC (4 to 16 bits wide, not reflected) of the leading bits of the decoded frame. The table has 16 entries
+    (one nibble per step), so it takes only 32 bytes of RAM.
+ */
+class RC433HQCrc {
+private:
+	byte width;
+	word polynomial;
+	word init;
+	word xorOut;
+	word mask;
+	word table[16];
+
+public:
+	RC433HQCrc(byte awidth, word apolynomial, word ainit, word axorOut);
+
+	byte GetWidth() const { return width; }
+
+	// CRC of the first count bits of the frame of the given length (in the decoder bit layout)
+	word Calculate(const byte *data, size_t bits, size_t count) const;
+
+private:
+	word UpdateBit(word crc, byte bit) const;
+};
+
+// CRC-8 (by default the polynomial x^8 + x^2 + x + 1, no init and final xor)
+class RC433HQCrc8: public RC433HQCrc {
+public:
+	RC433HQCrc8(byte apolynomial = 0x07, byte ainit = 0, byte axorOut = 0):
+		RC433HQCrc(8, apolynomial, ainit, axorOut)
+	{
+	}
+};
+
+// CRC-16 (by default CRC-16/CCITT-FALSE)
+class RC433HQCrc16: public RC433HQCrc {
+public:
+	RC433HQCrc16(word apolynomial = 0x1021, word ainit = 0xffff, word axorOut = 0):
+		RC433HQCrc(16, apolynomial, ainit, axorOut)
+	{
+	}
+};
+
+/** \brief Accepts the frames ending with the CRC of all the preceding bits
+    Usage:
+       RC433HQCrc8 crc8;
+       RC433HQCrcValidator crcValidator(crc8);
+       decoder.SetFrameValidator(crcValidator);
+ */
+class RC433HQCrcValidator: public IRC433FrameValidator {
+private:
+	RC433HQCrc crc;
+
+public:
+	RC433HQCrcValidator(const RC433HQCrc &acrc): crc(acrc) {}
+
+	virtual bool ValidateFrame(const byte *data, size_t bits);
+};
+
+/** \brief Accepts the frames with one of the known values of the bit field (fixed bits, known address prefixes)
+    Usage:
+       static const uint32_t knownPrefixes[] = { 0x5a, 0x3c };
+       RC433HQFieldValidator prefixValidator(0, 8, knownPrefixes, 2);
+ */
+class RC433HQFieldValidator: public IRC433FrameValidator {
+private:
+	word bitOffset;
+	byte bitWidth;
+	uint32_t value;             // the only value, if no values array is given
+	const uint32_t *values;
+	size_t valuesCount;
+
+public:
+	RC433HQFieldValidator(word abitOffset, byte abitWidth, uint32_t avalue):
+		bitOffset(abitOffset), bitWidth(abitWidth), value(avalue), values(0), valuesCount(1)
+	{
+	}
+
+	// the values array has to outlive the validator
+	RC433HQFieldValidator(word abitOffset, byte abitWidth, const uint32_t *avalues, size_t avaluesCount):
+		bitOffset(abitOffset), bitWidth(abitWidth), value(0), values(avalues), valuesCount(avaluesCount)
+	{
+	}
+
+	virtual bool ValidateFrame(const byte *data, size_t bits);
+};
+
+/** \brief Accepts the frames with the even (or odd) count of ones within the bit field including its parity bit
+ */
+class RC433HQParityValidator: public IRC433FrameValidator {
+private:
+	word bitOffset;
+	word bitWidth;
+	bool odd;
+
+public:
+	RC433HQParityValidator(word abitOffset, word abitWidth, bool aodd = false):
+		bitOffset(abitOffset), bitWidth(abitWidth), odd(aodd)
+	{
+	}
+
+	virtual bool ValidateFrame(const byte *data, size_t bits);
+};
+
+/** \brief Accepts the frames accepted by all its validators. They are called in the order of Add() (put the cheapest
+    first) and the rejections are counted per validator.
+    Usage:
+       RC433HQFrameValidatorChain<2> validator;
+       validator.Add(prefixValidator);
+       validator.Add(crcValidator);
+       decoder.SetFrameValidator(validator);
+ */
+template <size_t MAX_VALIDATORS>
+class RC433HQFrameValidatorChain: public IRC433FrameValidator {
+private:
+	IRC433FrameValidator *validators[MAX_VALIDATORS];
+	unsigned long rejectedCounts[MAX_VALIDATORS];
+	size_t validatorsCount;
+
+public:
+	RC433HQFrameValidatorChain(): validatorsCount(0) {}
+
+	// returns false if there are already MAX_VALIDATORS validators
+	bool Add(IRC433FrameValidator &validator)
+	{
+		if (validatorsCount == MAX_VALIDATORS) {
+			return false;
+		}
+		validators[validatorsCount] = &validator;
+		rejectedCounts[validatorsCount] = 0;
+		validatorsCount++;
+		return true;
+	}
+
+	size_t GetValidatorsCount() const { return validatorsCount; }
+
+	// count of the frames rejected by the validator (in the order of Add())
+	unsigned long GetRejectedCount(size_t index) const { return rejectedCounts[index]; }
+
+	virtual bool ValidateFrame(const byte *data, size_t bits)
+	{
+		for (size_t i = 0; i < validatorsCount; i++) {
+			if (!validators[i]->ValidateFrame(data, bits)) {
+				rejectedCounts[i]++;
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQDecoderMetrics declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Counters of the decoder explaining why the frames are (not) received. They are only incremented while decoding,
+    take the snapshot from the loop by RC433HQBasicSyncPulseDecoder::TakeMetrics().
+ */
+struct RC433HQDecoderMetrics {
+	unsigned long syncs;                 // detected sync pulses
+	unsigned long zeroBits;              // data pulses matching the zero symbol within the tolerance
+	unsigned long oneBits;               // data pulses matching the one symbol within the tolerance
+	unsigned long softBits;              // data pulses out of the tolerance decided in the soft decision mode
+	unsigned long outOfTolerancePulses;  // pulses after the sync matching neither a data symbol nor the sync (end the reception)
+	unsigned long brokenPulses;          // pulses with the lost falling edge
+	unsigned long missedEdges;           // notifications of the missed edges (the frame being received is lost)
+	unsigned long shortFrames;           // receptions ended before minBits
+	unsigned long rejectedFrames;        // frames rejected by the frame validator
+	unsigned long droppedFrames;         // frames dropped, because the frame queue was full
+	unsigned long deliveredFrames;       // frames passed to the data receiver or to the frame queue
+	double qualitySum;                   // sum of the quality of the delivered frames
+
+	RC433HQDecoderMetrics() { Reset(); }
+
+	void Reset();
+
+	double GetAverageQuality() const { return (deliveredFrames > 0)? qualitySum / deliveredFrames: 0.0; }
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQBasicSyncPulseDecoder declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// timing of the sync pulse protocol in microseconds, the parameters of RC433HQBasicSyncPulseDecoder
+struct RC433HQSyncPulseTiming {
+	word syncFirstUs, syncSecondUs, zeroFirstUs, zeroSecondUs, oneFirstUs, oneSecondUs;
+	word toleranceUs;
+};
+
+// symbol codes of the classified pulse, the pulse may match more symbols at once
+static const byte RC433HQ_SYMBOL_ONE = 0x01;
+static const byte RC433HQ_SYMBOL_ZERO = 0x02;
+static const byte RC433HQ_SYMBOL_SYNC = 0x04;
+
+/** \brief Basic sync protocol decoder
+ */
+class RC433HQBasicSyncPulseDecoder: public IRC433PulseProcessor {
+private:
+	IRC433DataReceiver &dataReceiver;
+	IRC433Logger *logger;
+	const RC433HQTimeExtender *timeExtender;
+	word syncFirstUs, syncSecondUs, zeroFirstUs, zeroSecondUs, oneFirstUs, oneSecondUs;
+	word toleranceUs; // max tolerance of rising or falling edges timing in us
+	bool highFirst;
+	word minBits, maxBits;
+	bool syncDetected;
+	RC433HQMicroseconds syncTime; 
+	RC433HQExtendedMicroseconds extendedSyncTime;
+	byte receivedData[RC433HQ_MAX_PULSE_BITS / 8];
+	byte *receivedBuffer;     // either the receivedData or the reserved slot of the frame queue
+	size_t receivedBits;
+	RC433HQFrameQueue *frameQueue;
+	size_t frameQueueSlot;
+	byte frameQueueProtocol;
+	bool previousRisingEdge;
+	RC433HQMicroseconds previousRisingEdgeTime;
+	bool previousFallingEdge;
+	RC433HQMicroseconds previousFallingEdgeTime;
+	double deltaPowerSum;  // sum of delta^2 for individual edges
+	byte *bitConfidences;  // confidences of the received bits in the soft decision mode, otherwise 0
+	IRC433FrameValidator *frameValidator;
+	RC433HQDecoderMetrics metrics;
+	RC433HQLatencyStatistics *latencyStatistics;
+	bool earlyDelivery;
+	
+public:	
+	RC433HQBasicSyncPulseDecoder(IRC433DataReceiver &adataReceiver, word asyncFirstUs, word asyncSecondUs, word azeroFirstUs, word azeroSecondUs, word aoneFirstUs, word aoneSecondUs, word atoleranceUs, bool ahighFirst, word aminBits, word amaxBits):
+		dataReceiver(adataReceiver),
+		logger(0),
+		timeExtender(0),
+		syncFirstUs(asyncFirstUs),
+		syncSecondUs(asyncSecondUs), 
+		zeroFirstUs(azeroFirstUs), 
+		zeroSecondUs(azeroSecondUs), 
+		oneFirstUs(aoneFirstUs), 
+		oneSecondUs(aoneSecondUs), 
+		toleranceUs(atoleranceUs),
+		highFirst(ahighFirst),
+		minBits(aminBits), maxBits(amaxBits),
 		syncDetected(false),
+		receivedBuffer(receivedData),
 		receivedBits(0),
+		frameQueue(0),
+		frameQueueSlot(RC433HQFrameQueue::NO_SLOT),
+		frameQueueProtocol(0),
 		previousRisingEdge(false),
-		previousFallingEdge(false)
+		previousFallingEdge(false),
+		bitConfidences(0),
+		frameValidator(0),
+		latencyStatistics(0),
+		earlyDelivery(false)
+	{
+		ClearReceivedBits();
+	}
+
+	~RC433HQBasicSyncPulseDecoder();
+
+	void SetLogger(IRC433Logger &alogger)
+	{ 
+		logger = &alogger;
+	}
+
+	// the time extender is used to calculate the 64-bit time of the delivered frames. Without it the epoch is always 0.
+	void SetTimeExtender(const RC433HQTimeExtender &atimeExtender)
+	{
+		timeExtender = &atimeExtender;
+	}
+
+	// the decoded frames are stored into the queue (tagged by the protocol) instead of being passed to the data receiver.
+	// Has to be called before the first edge is handled.
+	void SetFrameQueue(RC433HQFrameQueue &aframeQueue, byte aprotocol)
+	{
+		frameQueue = &aframeQueue;
+		frameQueueProtocol = aprotocol;
+	}
+
+	// in the soft decision mode the confidence of every bit is calculated from the timing deltas of its pulse and the frame
+	// is passed to IRC433DataReceiver::HandleSoftData(). The data pulses up to 2x tolerance away from the symbols are not
+	// considered the end of the frame, they are decided by the nearest symbol with a low confidence. The confidences are
+	// not stored into the frame queue. Has to be called before the first edge is handled.
+	void EnableSoftDecision();
+
+	// the complete frames are delivered only if accepted by the validator (use RC433HQFrameValidatorChain for more checks)
+	void SetFrameValidator(IRC433FrameValidator &aframeValidator)
+	{
+		frameValidator = &aframeValidator;
+	}
+
+	// the counters since the last TakeMetrics()
+	const RC433HQDecoderMetrics &GetMetrics() const { return metrics; }
+
+	// copy the counters and reset them, call from the loop (the interrupts are disabled while copying, so the decoder
+	// can be called from the interrupt as well)
+	void TakeMetrics(RC433HQDecoderMetrics &snapshot);
+
+	// the latency of every delivered frame (in microseconds from the capture of its sync edge by the receiver to the call of
+	// the data receiver or to the commit into the frame queue) is added to the statistics. Use one statistics per protocol
+	// and read them by RC433HQDurationStatistics::GetSnapshot().
+	void SetLatencyStatistics(RC433HQLatencyStatistics &alatencyStatistics)
 	{
-		ClearReceivedBits();
+		latencyStatistics = &alatencyStatistics;
 	}
 
-	void SetLogger(IRC433Logger &alogger)
-	{ 
-		logger = &alogger;
+	// deliver the frame already at the falling edge of its maxBits-th pulse, the last bit is decided by its high duration
+	// only. Without it the frame waits for the next rising edge (after the low part of the last pulse), which can come much
+	// later after the last repetition. Only for the protocols with different high durations of zero and one.
+	void EnableEarlyDelivery()
+	{
+		earlyDelivery = true;
 	}
 
 	void LogMessage(const char *message)
@@ -370,10 +1655,33 @@ public:
 
 	virtual void HandleMissedEdges();
 
+	RC433HQSyncPulseTiming GetTiming() const;
+
+	// the symbols (RC433HQ_SYMBOL_*) the pulse matches within the tolerance
+	byte ClassifyPulse(RC433HQMicrosecondsDiff highDuration, RC433HQMicrosecondsDiff lowDuration) const;
+
+	// the pulse step of HandleEdge() for the complete pulse starting at the time and already classified by ClassifyPulse()
+	// (or by the vectorized RC433HQPulseClassifier of the host batch decoding). Do not mix with HandleEdge().
+	void HandlePulse(RC433HQMicroseconds time, RC433HQMicrosecondsDiff highDuration, RC433HQMicrosecondsDiff lowDuration, byte symbols);
+
+	// the pulse step of HandleEdge() for the pulse with the lost falling edge
+	void HandleBrokenPulse();
+
+	// out of sync only the sync pulses change the state of the decoder
+	bool IsSyncDetected() const { return syncDetected; }
+
 protected:
+	// decode the data pulse by its symbols, returns false for a non data pulse
+	bool DecodeBit(RC433HQMicrosecondsDiff highDuration, RC433HQMicrosecondsDiff lowDuration, byte symbols, byte &bit, byte &confidence);
+	bool DecodeLastBit(RC433HQMicrosecondsDiff highDuration, byte &bit, byte &confidence);
+	byte CalculateConfidence(unsigned long highError, unsigned long lowError) const;
+
+	// in the early delivery mode deliver the frame by the high duration of its last pulse, returns true if delivered
+	bool DeliverEarly(RC433HQMicrosecondsDiff highDuration);
+
 	// bits operations
 	void ClearReceivedBits();
-	void StoreReceivedBit(byte bit);
+	void StoreReceivedBit(byte bit, byte confidence);
 
 	// quality calculations
 	void CalculateDelta(RC433HQMicrosecondsDiff expected, RC433HQMicrosecondsDiff actual);
@@ -381,6 +1689,587 @@ protected:
 
 	// sending of the cached data
 	void SendReceivedData();
+
+	// end of the data sequence (a non data pulse): send the data if there are at least minBits and stop the reception until the next sync
+	void FinishReceivedData();
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQRepetitionCombiner declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+/** \brief Merges the repetitions of a frame (e.g. the 4 EMOS A and 4 EMOS B repetitions, connect all the decoders to it)
+    into one frame by the weighted voting of the bits. Every repetition votes for its bits by their confidences (see
+    RC433HQBasicSyncPulseDecoder::EnableSoftDecision(), the frames without the confidences vote by their quality), so a bit
+    corrupted in one repetition is outvoted by the others. The repetitions are the frames of the same length starting at most
+    maxGap after the start of the previous one. The combined frame (with the time of the first repetition and the confidence
+    of every bit) is passed to HandleSoftData() of the receiver when expectedRepetitions are received, when a frame of another
+    group arrives, or from Update() when no repetition came for maxGap.
+    Usage:
+       RC433HQRepetitionCombiner combiner(handler, 24, 200_ms, 8);
+       RC433HQEmosSocketsPulseDecoderA decoderA(combiner);
+       RC433HQEmosSocketsPulseDecoderB decoderB(combiner);
+       decoderA.EnableSoftDecision();
+       decoderB.EnableSoftDecision();
+       ... in the loop: combiner.Update(RC433HQTimeService::GetTimeInMicroseconds());
+ */
+class RC433HQRepetitionCombiner: public IRC433DataReceiver {
+public:
+	static const size_t MAX_REPETITIONS = 127;   // the votes of one bit fit into 16 bits
+
+private:
+	IRC433DataReceiver &receiver;
+	size_t maxBits;
+	RC433HQMicrosecondsDiff maxGap;
+	size_t expectedRepetitions;
+	int16_t *votes;                    // sum of the confidences of ones minus the sum of the confidences of zeros
+	byte *combinedData;
+	byte *combinedConfidences;
+	size_t bits;
+	size_t repetitions;
+	size_t lastRepetitions;
+	RC433HQExtendedMicroseconds firstTime;
+	RC433HQExtendedMicroseconds lastTime;
+
+public:
+	// expectedRepetitions 0 means the frame is combined until the gap
+	RC433HQRepetitionCombiner(IRC433DataReceiver &areceiver, size_t amaxBits, RC433HQMicrosecondsDiff amaxGap, size_t aexpectedRepetitions = 0);
+	~RC433HQRepetitionCombiner();
+
+	virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality);
+	virtual void HandleExtendedData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, double quality);
+	virtual void HandleSoftData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, const byte *confidences, double quality);
+
+	// call regularly from the loop, passes the combined frame to the receiver if no repetition came for maxGap
+	void Update(RC433HQMicroseconds now);
+
+	// passes the frame combined so far to the receiver
+	void Flush();
+
+	// count of the repetitions of the last combined frame
+	size_t GetLastRepetitionsCount() const { return lastRepetitions; }
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQDiversityCombiner declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+enum RC433HQDiversityMode {
+	RC433HQ_DIVERSITY_BEST,    // the frame is delivered as received by the receiver with the best quality
+	RC433HQ_DIVERSITY_MERGE    // the bits are decided by the confidence weighted voting of all the receivers
+};
+
+// contribution of one receiver to the frames delivered by the RC433HQDiversityCombiner
+struct RC433HQDiversityStatistics {
+	unsigned long receivedFrames;       // frames passed by the decoders of the receiver
+	unsigned long contributedFrames;    // delivered frames the receiver contributed to
+	unsigned long bestFrames;           // delivered frames with the best quality from the receiver
+	unsigned long exclusiveFrames;      // delivered frames received only by the receiver (the coverage it adds)
+	double qualitySum;                  // sum of the quality of the received frames
+
+	RC433HQDiversityStatistics() { Reset(); }
+
+	void Reset();
+
+	double GetAverageQuality() const { return (receivedFrames > 0)? (qualitySum / receivedFrames): 0.0; }
+};
+
+/** \brief Combines the frames of one protocol decoded by several receivers (e.g. receiver modules on the opposite sides of
+    the building, each with its own pulse buffer, noise filter and decoder sharing the same time base), so that every frame
+    reaches the receiver once. The frames of the different receivers are the same frame if their bits match (up to
+    maxDifferentBits differences) and their times differ at most by the window. The frame is delivered as soon as all the
+    receivers contributed, otherwise after maxWait (when a later frame comes, or from Update()). RC433HQ_DIVERSITY_BEST
+    delivers the frame of the receiver with the best quality, RC433HQ_DIVERSITY_MERGE votes every bit by the confidences
+    (see RC433HQBasicSyncPulseDecoder::EnableSoftDecision()) and passes the confidences on (e.g. into the
+    RC433HQRepetitionCombiner). The statistics show the contribution of every receiver.
+    Usage:
+       RC433HQDiversityCombiner combinerA(handler, 2, 24, 2_ms, 100_ms);
+       RC433HQDiversityInput northA(combinerA, 0), southA(combinerA, 1);
+       RC433HQEmosSocketsPulseDecoderA northDecoderA(northA);
+       RC433HQEmosSocketsPulseDecoderA southDecoderA(southA);
+       ... in the loop: combinerA.Update(RC433HQTimeService::GetTimeInMicroseconds());
+ */
+class RC433HQDiversityCombiner {
+public:
+	static const size_t MAX_RECEIVERS = 16;
+
+private:
+	// frame waiting for the other receivers
+	struct Pending {
+		bool used;
+		byte bits;
+		word contributors;               // mask of the receivers
+		byte bestReceiver;
+		double bestQuality;
+		RC433HQExtendedMicroseconds time;   // the earliest time of the contributions
+		byte *data;                      // the bits of the best contribution
+		int16_t *votes;                  // RC433HQ_DIVERSITY_MERGE only, as in the RC433HQRepetitionCombiner
+	};
+
+private:
+	IRC433DataReceiver &receiver;
+	size_t receiversCount;
+	size_t maxBits;
+	RC433HQMicrosecondsDiff window;
+	RC433HQMicrosecondsDiff maxWait;
+	RC433HQDiversityMode mode;
+	size_t maxDifferentBits;
+	size_t pendingCount;
+	Pending *pending;
+	byte *pendingData;
+	int16_t *pendingVotes;
+	byte *combinedData;
+	byte *combinedConfidences;
+	RC433HQDiversityStatistics *statistics;
+	unsigned long deliveredFrames;
+	unsigned long suppressedFrames;
+
+public:
+	// up to MAX_RECEIVERS receivers, up to maxPending frames wait for the other receivers at once
+	RC433HQDiversityCombiner(IRC433DataReceiver &areceiver, size_t areceiversCount, size_t amaxBits, RC433HQMicrosecondsDiff awindow,
+		RC433HQMicrosecondsDiff amaxWait, RC433HQDiversityMode amode = RC433HQ_DIVERSITY_BEST, size_t amaxPending = 8);
+	~RC433HQDiversityCombiner();
+
+	// count of the bits, in which the frames of the different receivers may differ (0 by default)
+	void SetMaxDifferentBits(size_t amaxDifferentBits) { maxDifferentBits = amaxDifferentBits; }
+
+	// the frame decoded by the receiver (see RC433HQDiversityInput)
+	void HandleFrame(size_t receiverIndex, RC433HQExtendedMicroseconds time, const byte *data, size_t bits, const byte *confidences, double quality);
+
+	// call regularly from the loop, delivers the frames waiting for maxWait
+	void Update(RC433HQMicroseconds now);
+
+	// delivers all the waiting frames
+	void Flush();
+
+	size_t GetReceiversCount() const { return receiversCount; }
+	const RC433HQDiversityStatistics &GetStatistics(size_t receiverIndex) const { return statistics[receiverIndex]; }
+	unsigned long GetDeliveredFramesCount() const { return deliveredFrames; }
+	unsigned long GetSuppressedFramesCount() const { return suppressedFrames; }   // the duplicates not delivered
+	void ResetStatistics();
+
+private:
+	Pending *FindPending(size_t receiverIndex, RC433HQExtendedMicroseconds time, const byte *data, size_t bits);
+	Pending *FindOldest();
+	void Deliver(Pending &frame);
+
+	RC433HQDiversityCombiner(const RC433HQDiversityCombiner &);
+	RC433HQDiversityCombiner &operator=(const RC433HQDiversityCombiner &);
+};
+
+/** \brief Data receiver passing the frames of the decoders of one receiver into the RC433HQDiversityCombiner
+ */
+class RC433HQDiversityInput: public IRC433DataReceiver {
+private:
+	RC433HQDiversityCombiner &combiner;
+	size_t receiverIndex;
+
+public:
+	RC433HQDiversityInput(RC433HQDiversityCombiner &acombiner, size_t areceiverIndex):
+		combiner(acombiner),
+		receiverIndex(areceiverIndex)
+	{
+	}
+
+	virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality)
+	{
+		combiner.HandleFrame(receiverIndex, RC433HQExtendedMicroseconds(0, time), data, bits, 0, quality);
+	}
+
+	virtual void HandleExtendedData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, double quality)
+	{
+		combiner.HandleFrame(receiverIndex, time, data, bits, 0, quality);
+	}
+
+	virtual void HandleSoftData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, const byte *confidences, double quality)
+	{
+		combiner.HandleFrame(receiverIndex, time, data, bits, confidences, quality);
+	}
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQDeviceRouter declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// read width (up to 32) bits of the decoded frame starting at the offset (0 is the first received bit) into the value, the first
+// read bit is the highest one. Returns false if the field is not within the frame.
+bool RC433HQGetFrameBits(const byte *data, size_t bits, size_t offset, size_t width, uint32_t &value);
+
+// position of the device address within the frames of one protocol
+struct RC433HQAddressField {
+	word bitOffset;
+	byte bitWidth;
+};
+
+// smallest power of two that is at least 2 * N (the hash table is at most half full)
+template <size_t N, size_t SIZE = 1, bool DONE = (SIZE >= 2 * N)>
+struct RC433HQRoutingTableSize {
+	static const size_t value = RC433HQRoutingTableSize<N, 2 * SIZE>::value;
+};
+
+template <size_t N, size_t SIZE>
+struct RC433HQRoutingTableSize<N, SIZE, true> {
+	static const size_t value = SIZE;
+};
+
+/** \brief Routes the decoded frames of one protocol to the receivers of the individual devices by the address field of the
+    frame. The addresses are kept in the open addressing hash table for up to MAX_DEVICES devices (sized at compile time),
+    so the dispatch of the frame does not depend on the count of the devices. The frames of the unknown devices (or too
+    short to contain the address) are counted and passed to the optional unknown device receiver.
+    Usage:
+       RC433HQAddressField addressField = { 0, 20 };
+       RC433HQDeviceRouter<16> router(addressField);
+       router.AddDevice(0x12345, livingRoomSocket);
+       RC433HQEmosSocketsPulseDecoderA decoderA(router);
+ */
+template <size_t MAX_DEVICES>
+class RC433HQDeviceRouter: public IRC433DataReceiver {
+private:
+	static const size_t TABLE_SIZE = RC433HQRoutingTableSize<MAX_DEVICES>::value;
+
+	struct Entry {
+		uint32_t address;
+		IRC433DataReceiver *receiver;  // 0 for the free entry
+	};
+
+private:
+	RC433HQAddressField addressField;
+	Entry table[TABLE_SIZE];
+	size_t devicesCount;
+	IRC433DataReceiver *unknownDeviceReceiver;
+	unsigned long unknownFramesCount;
+
+public:
+	RC433HQDeviceRouter(const RC433HQAddressField &aaddressField):
+		addressField(aaddressField),
+		devicesCount(0),
+		unknownDeviceReceiver(0),
+		unknownFramesCount(0)
+	{
+		for (size_t i = 0; i < TABLE_SIZE; i++) {
+			table[i].receiver = 0;
+		}
+	}
+
+	// add the device or replace its receiver, returns false if there are already MAX_DEVICES devices
+	bool AddDevice(uint32_t address, IRC433DataReceiver &receiver)
+	{
+		Entry *entry = FindEntry(address);
+		if (!entry->receiver) {
+			if (devicesCount == MAX_DEVICES) {
+				return false;
+			}
+			devicesCount++;
+			entry->address = address;
+		}
+		entry->receiver = &receiver;
+		return true;
+	}
+
+	// receiver of the device or 0 if the device is unknown
+	IRC433DataReceiver *FindDevice(uint32_t address)
+	{
+		return FindEntry(address)->receiver;
+	}
+
+	size_t GetDevicesCount() const { return devicesCount; }
+
+	// the frames of the unknown devices are passed here, otherwise they are dropped
+	void SetUnknownDeviceReceiver(IRC433DataReceiver &areceiver) { unknownDeviceReceiver = &areceiver; }
+
+	unsigned long GetUnknownFramesCount() const { return unknownFramesCount; }
+
+	virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality)
+	{
+		HandleExtendedData(RC433HQExtendedMicroseconds(0, time), data, bits, quality);
+	}
+
+	virtual void HandleExtendedData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, double quality)
+	{
+		IRC433DataReceiver *receiver = Route(data, bits);
+		if (receiver) {
+			receiver->HandleExtendedData(time, data, bits, quality);
+		}
+	}
+
+	// route the frame taken from the RC433HQFrameQueue
+	void HandleFrame(const RC433HQFrameView &frame)
+	{
+		HandleExtendedData(frame.GetExtendedTime(), frame.GetData(), frame.GetBits(), frame.GetQuality());
+	}
+
+private:
+	IRC433DataReceiver *Route(const byte *data, size_t bits)
+	{
+		uint32_t address;
+		IRC433DataReceiver *receiver = 0;
+		if (RC433HQGetFrameBits(data, bits, addressField.bitOffset, addressField.bitWidth, address)) {
+			receiver = FindEntry(address)->receiver;
+		}
+
+		// unknown devices are dropped early
+		if (!receiver) {
+			unknownFramesCount++;
+			receiver = unknownDeviceReceiver;
+		}
+		return receiver;
+	}
+
+	// entry of the address or the free entry, where it should be stored (the table is never full)
+	Entry *FindEntry(uint32_t address)
+	{
+		// multiplicative hashing, linear probing
+		size_t index = size_t(uint32_t(address * 2654435761UL) >> 16) & (TABLE_SIZE - 1);
+		while (table[index].receiver && (table[index].address != address)) {
+			index = (index + 1) & (TABLE_SIZE - 1);
+		}
+		return &table[index];
+	}
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQLinkQualityTracker declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// link quality of one device as tracked by the RC433HQLinkQualityTracker
+struct RC433HQLinkQuality {
+	byte protocol;
+	uint32_t address;
+	double quality;                          // moving average of the quality of the frames (0 to 100)
+	RC433HQExtendedMicroseconds firstSeen;   // time of the first and of the last frame of the device
+	RC433HQExtendedMicroseconds lastSeen;
+	unsigned long framesCount;
+	unsigned long transmissionsCount;        // the repetitions of one transmission are counted once
+	double framesPerMinute;                  // average rate of the frames between the first and the last one (0 after one frame)
+	unsigned long periodMs;                  // period of the transmissions of a periodic device (0 until it is detected)
+	unsigned long missedTransmissionsCount;  // estimated count of the periodic transmissions that were not received
+	double missRatio;                        // moving average of the share of the missed periodic transmissions
+};
+
+/** \brief Keeps the link quality of up to the capacity devices, so the weak links can be found before they drop out. The
+    devices are keyed by the protocol and the address, looked up in the open addressing hash table and kept in the least
+    recently used order, so every frame is handled in a constant time and the device not heard for the longest time is
+    evicted for the new one. The frames of one device closer than the repetition gap are the repetitions of one transmission.
+    A device sending the transmissions regularly is detected as periodic and the gaps of several periods are counted as the
+    missed transmissions. The tracker is not interrupt safe, update and query it from the loop only.
+    Usage:
+       RC433HQLinkQualityTracker links(16);
+       RC433HQAddressField addressField = { 0, 20 };
+       RC433HQLinkQualityInput linksA(links, PROTOCOL_A, addressField, receiver);
+       RC433HQEmosSocketsPulseDecoderA decoderA(linksA);
+       ...
+       RC433HQLinkQuality link;
+       if (links.FindLink(PROTOCOL_A, 0x12345, link) && (link.quality < 50.0)) { ... }
+ */
+class RC433HQLinkQualityTracker {
+public:
+	static const word NO_ENTRY = 0xffff;
+
+	// the word indexes of the entries and the hash table (twice the capacity) stay below NO_ENTRY
+	static const size_t MAX_CAPACITY = 0x7fff;
+
+	// weight of the new value in the moving averages is 1 / 2^EWMA_SHIFT
+	static const byte EWMA_SHIFT = 3;
+
+	// count of the consecutive regular intervals of the transmissions, after which the device is considered periodic
+	static const byte PERIODIC_INTERVALS = 2;
+
+private:
+	struct Entry {
+		uint32_t address;
+		byte protocol;
+		byte regularIntervals;          // count of the consecutive intervals matching the period (saturated)
+		word quality;                   // moving average in 1/100
+		word missRatio;                 // moving average in 1/65535
+		word previous, next;            // neighbours in the least recently used order
+		unsigned long periodMs;
+		RC433HQExtendedMicroseconds firstSeen;
+		RC433HQExtendedMicroseconds lastSeen;
+		RC433HQExtendedMicroseconds transmissionStart;
+		unsigned long framesCount;
+		unsigned long transmissionsCount;
+		unsigned long missedCount;
+	};
+
+private:
+	size_t capacity;
+	RC433HQMicrosecondsDiff repetitionGap;
+	Entry *entries;
+	word *table;                        // hash table of the entry indexes (NO_ENTRY for the free bucket)
+	size_t tableMask;
+	size_t count;
+	word newest, oldest;                // ends of the least recently used order
+	unsigned long evictedCount;
+
+public:
+	// capacity is clamped to MAX_CAPACITY devices, the frames closer than the repetition gap belong to one transmission
+	RC433HQLinkQualityTracker(size_t acapacity, RC433HQMicrosecondsDiff arepetitionGap = 200000);
+	~RC433HQLinkQualityTracker();
+
+	size_t GetCapacity() const { return capacity; }
+	size_t GetLinksCount() const { return count; }
+
+	// count of the devices evicted to make space for the new ones
+	unsigned long GetEvictedCount() const { return evictedCount; }
+
+	// account the frame of the device
+	void Update(byte protocol, uint32_t address, RC433HQExtendedMicroseconds time, double quality);
+
+	// link quality of the device, returns false if it is not tracked
+	bool FindLink(byte protocol, uint32_t address, RC433HQLinkQuality &link) const;
+
+	// link quality of the index-th device from the most recently heard one, returns false if the index is out of range
+	bool GetLink(size_t index, RC433HQLinkQuality &link) const;
+
+	// forget all the devices
+	void Reset();
+
+private:
+	size_t Bucket(byte protocol, uint32_t address) const;
+	size_t FindBucket(byte protocol, uint32_t address) const;
+	void Unlink(word index);
+	void LinkNewest(word index);
+	void RemoveFromTable(word index);
+	void UpdateTransmissions(Entry &entry, RC433HQExtendedMicroseconds time);
+	void FillLink(const Entry &entry, RC433HQLinkQuality &link) const;
+
+	RC433HQLinkQualityTracker(const RC433HQLinkQualityTracker &);
+	RC433HQLinkQualityTracker &operator=(const RC433HQLinkQualityTracker &);
+};
+
+/** \brief Data receiver feeding the frames of one protocol into the RC433HQLinkQualityTracker (the address is read from the
+    address field of the frame) and passing them on to the optional next receiver.
+ */
+class RC433HQLinkQualityInput: public IRC433DataReceiver {
+private:
+	RC433HQLinkQualityTracker &tracker;
+	byte protocol;
+	RC433HQAddressField addressField;
+	IRC433DataReceiver *nextReceiver;
+
+public:
+	RC433HQLinkQualityInput(RC433HQLinkQualityTracker &atracker, byte aprotocol, const RC433HQAddressField &aaddressField):
+		tracker(atracker),
+		protocol(aprotocol),
+		addressField(aaddressField),
+		nextReceiver(0)
+	{
+	}
+
+	RC433HQLinkQualityInput(RC433HQLinkQualityTracker &atracker, byte aprotocol, const RC433HQAddressField &aaddressField, IRC433DataReceiver &anextReceiver):
+		tracker(atracker),
+		protocol(aprotocol),
+		addressField(aaddressField),
+		nextReceiver(&anextReceiver)
+	{
+	}
+
+	virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality)
+	{
+		HandleExtendedData(RC433HQExtendedMicroseconds(0, time), data, bits, quality);
+	}
+
+	virtual void HandleExtendedData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, double quality)
+	{
+		uint32_t address;
+		if (RC433HQGetFrameBits(data, bits, addressField.bitOffset, addressField.bitWidth, address)) {
+			tracker.Update(protocol, address, time, quality);
+		}
+		if (nextReceiver) {
+			nextReceiver->HandleExtendedData(time, data, bits, quality);
+		}
+	}
+
+	// account the frame taken from the RC433HQFrameQueue
+	void HandleFrame(const RC433HQFrameView &frame)
+	{
+		HandleExtendedData(frame.GetExtendedTime(), frame.GetData(), frame.GetBits(), frame.GetQuality());
+	}
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQProtocolAnalyzer declaration
+//////////////////////////////////////////////////////////////////////////////////
+
+// timing of the unknown protocol learned by the RC433HQProtocolAnalyzer, the parameters of the RC433HQBasicSyncPulseDecoder
+// and RC433HQBasicSyncPulseEncoder (highFirst is always true). The zero is the data symbol with the shorter high level, the
+// real meaning of the bits might be inverted.
+struct RC433HQProtocolSuggestion {
+	word syncFirstUs, syncSecondUs, zeroFirstUs, zeroSecondUs, oneFirstUs, oneSecondUs;
+	word toleranceUs;
+	word minBits, maxBits;
+	unsigned long framesCount;       // count of the frames (sync followed by the data) the suggestion is based on
+};
+
+/** \brief Learns the timing of an unknown sync pulse protocol from the received signal (connect it behind the noise filter
+    and press the remote buttons repeatedly). The analyzer keeps the histograms of the high and low durations and clusters
+    the (high, low) pulses into at most CLUSTERS_COUNT symbols. The two most frequent symbols are the data symbols, the sync is
+    the symbol most often followed by a run of data symbols and the length of the most frequent run gives the count of bits.
+    Uses a few hundred bytes of RAM and no dynamic memory.
+ */
+class RC433HQProtocolAnalyzer: public IRC433PulseProcessor {
+public:
+	static const size_t CLUSTERS_COUNT = 8;
+	static const size_t HISTOGRAM_BINS = 32;       // quarter octave bins from 64 us
+	static const size_t MIN_FRAME_BITS = 8;        // shorter runs of the data symbols are not considered frames
+	static const size_t MAX_FRAME_BITS = MIN_FRAME_BITS + 63;
+
+private:
+	// symbol candidate, the durations are averaged by the moving average (in 1/16 us) to avoid the divisions on the MCU
+	struct Cluster {
+		word count;
+		uint32_t high, low;
+		uint32_t highDeviation, lowDeviation;   // moving average of the absolute deviation
+		word frameStarts;                       // count of the data runs following the symbol
+	};
+
+private:
+	word highHistogram[HISTOGRAM_BINS];
+	word lowHistogram[HISTOGRAM_BINS];
+	Cluster clusters[CLUSTERS_COUNT];
+	byte frameBitsCounts[MAX_FRAME_BITS - MIN_FRAME_BITS + 1];
+	unsigned long pulsesCount;
+	bool previousRisingEdge;
+	RC433HQMicroseconds previousRisingEdgeTime;
+	bool previousFallingEdge;
+	RC433HQMicroseconds previousFallingEdgeTime;
+	byte previousCluster;        // cluster of the last pulse, that was not a data symbol
+	word runBits;                // count of the data symbols since the previousCluster
+
+public:
+	RC433HQProtocolAnalyzer();
+
+	// forget everything learned so far
+	void Reset();
+
+	virtual void HandleEdge(RC433HQMicroseconds time, bool direction);
+	virtual void HandleMissedEdges();
+
+	unsigned long GetPulsesCount() const { return pulsesCount; }
+
+	// histograms of the pulse durations, the bin contains the durations from GetHistogramBinMinUs(bin) to GetHistogramBinMinUs(bin + 1) - 1
+	static unsigned long GetHistogramBinMinUs(size_t bin);
+	word GetHighHistogramCount(size_t bin) const { return highHistogram[bin]; }
+	word GetLowHistogramCount(size_t bin) const { return lowHistogram[bin]; }
+
+	// the symbol candidates, returns false for an unused cluster
+	bool GetCluster(size_t index, word &count, word &highUs, word &lowUs) const;
+
+	// returns false if there are not enough data to suggest the protocol
+	bool GetSuggestion(RC433HQProtocolSuggestion &suggestion) const;
+
+private:
+	void HandlePulse(RC433HQMicrosecondsDiff highDuration, RC433HQMicrosecondsDiff lowDuration);
+	static void AddToHistogram(word *histogram, word duration);
+	size_t FindCluster(word high, word low) const;
+	void FindDataClusters(size_t &first, size_t &second) const;
+	void AddToCluster(Cluster &cluster, word high, word low);
+	void EndRun();
 };
 
 
@@ -426,6 +2315,14 @@ public:
 	RC433HQReceiver(IRC433PulseProcessor &adecoder, int areceiverGpioPin);
 	~RC433HQReceiver();
 
+protected:
+	// registers the given static interrupt handler instead of HandleInterrupt()
+	RC433HQReceiver(IRC433PulseProcessor &adecoder, int areceiverGpioPin, void (*interruptHandler)());
+
+	static RC433HQReceiver *GetActiveInstance() { return activeInstance; }
+
+	int GetReceiverGpioPin() const { return receiverGpioPin; }
+
 public:
 	// disables receiving of the data (call before the transmission, if the reception of the transmitted data is not welcome)
 	// Note: it's recommended to use an instance of class RC433HQReceptionDisabler for a temporary disabling and automated enabling
@@ -440,6 +2337,50 @@ protected:
 
 	// internal interrupt handler, called from the static method
 	void HandleInterruptInternal();
+
+private:
+	void Activate(void (*interruptHandler)());
+};
+
+/** \brief Receiver passing the edges from the interrupt handler directly into the processor of the type known at compile
+    time, so that the whole interrupt side chain (e.g. the noise filter and the pulse buffer) is inlined into the handler.
+    Only one receiver (static or not) can be active.
+    Usage:
+       RC433HQStaticPulseBuffer<Decoders> buffer(decoders, 256);
+       RC433HQStaticNoiseFilter<RC433HQStaticPulseBuffer<Decoders> > noiseFilter(buffer, 50);
+       RC433HQStaticReceiver<RC433HQStaticNoiseFilter<RC433HQStaticPulseBuffer<Decoders> > > receiver(noiseFilter, 2);
+ */
+template <class TProcessor>
+class RC433HQStaticReceiver: public RC433HQReceiver {
+private:
+	TProcessor &processor;
+
+public:
+	RC433HQStaticReceiver(TProcessor &aprocessor, int areceiverGpioPin):
+		RC433HQReceiver(aprocessor, areceiverGpioPin, RC433HQStaticReceiver::HandleInterrupt),
+		processor(aprocessor)
+	{
+	}
+
+protected:
+	static void HandleInterrupt()
+	{
+		// if the active instance is defined
+		// assert(GetActiveInstance() != 0);
+
+		RC433HQ_PROFILE_START(interruptStart);
+
+		RC433HQStaticReceiver *receiver = static_cast<RC433HQStaticReceiver *>(GetActiveInstance());
+
+		// get the current time and the status of the pin (true = rising, false = falling edge)
+		RC433HQMicroseconds now = RC433HQTimeService::GetTimeInMicroseconds();
+		bool direction = (digitalRead(receiver->GetReceiverGpioPin()) == HIGH);
+
+		// call the processor to handle the receiver edge change
+		RC433HQHandleEdge(receiver->processor, now, direction);
+
+		RC433HQ_PROFILE_STOP(interruptStart, AddInterruptDuration);
+	}
 };
 
 // use an instance of this helper class to automatically disable and enable signal reception, when this class is being destroyed
@@ -485,9 +2426,53 @@ struct RC433HQTransmissionQualityStatistics {
 	double averageDelay;                           // average delay in microseconds calculated for the delayed edges
 };
 
+/** \brief Waits for the exact time by a coarse sleep followed by a short spin on the clock. The sleep finishes early enough
+    to cover its usual lateness, which is measured by Calibrate() and then learned from every sleep, and a sleep running
+    slower than the clock by up to 1/32 of its length. The spin stops half of
+    the clock read duration before the time, so that the caller continues on average exactly at the time.
+ */
+class RC433HQHybridWait {
+private:
+	IRC433Clock &clock;
+	bool calibrated;
+	RC433HQMicrosecondsDiff readDuration;    // duration of one clock read
+	unsigned long sleepLatenessX4;           // average lateness of the sleep in 1/4 us
+
+public:
+	// the margin of the coarse sleep on top of twice its average lateness
+	static const unsigned long SLEEP_MARGIN_US = 4;
+
+	// max count of the clock reads of one spin, only protects against a clock that does not run (the host stubs)
+	static const unsigned long MAX_SPIN_READS = 0xffff;
+
+	RC433HQHybridWait(IRC433Clock &aclock):
+		clock(aclock),
+		calibrated(false),
+		readDuration(0),
+		sleepLatenessX4(0)
+	{
+	}
+
+	IRC433Clock &GetClock() { return clock; }
+
+	// measure the duration of the clock read and the lateness of the sleeps (takes about 1 ms)
+	void Calibrate();
+	bool IsCalibrated() const { return calibrated; }
+
+	RC433HQMicrosecondsDiff GetReadDuration() const { return readDuration; }
+	RC433HQMicrosecondsDiff GetSleepLateness() const { return RC433HQMicrosecondsDiff((sleepLatenessX4 + 2) / 4); }
+
+	// wait until the time (returns immediately if it has already passed), returns the time the wait finished
+	RC433HQMicroseconds WaitUntil(RC433HQMicroseconds time);
+
+private:
+	void AddSleepLateness(unsigned long latenessUs);
+};
+
 class RC433HQTransmitter: public RC433HQDataTransmitterBase {
 private:
 	int transmitterGpioPin;
+	RC433HQHybridWait wait;
 	bool inTransitionMode;
 	RC433HQMicrosecondsDiff maxDelayTolerance;
 	RC433HQMicrosecondsDiff totalDelayedEdgesDelayTime;
@@ -497,8 +2482,16 @@ private:
 
 public:
 	RC433HQTransmitter(int atransmitterGpioPin);
+
+	// the transmitter timing the edges by the given clock (e.g. a simulated one)
+	RC433HQTransmitter(int atransmitterGpioPin, IRC433Clock &aclock);
+
 	~RC433HQTransmitter();
 
+	// the edges are timed by the hybrid wait, calibrated by the first StartTransmission() (or by calling this at the start up)
+	void Calibrate() { wait.Calibrate(); }
+	const RC433HQHybridWait &GetHybridWait() const { return wait; }
+
 	// initializes the data transmission. Data can be sent only if the transmission is started
 	void StartTransmission(RC433HQMicrosecondsDiff quietPeriodDurationBefore = 0, RC433HQMicrosecondsDiff amaxDelayTolerance = 0, RC433HQTransmissionQualityStatistics *atransmissionQualityStatistics = 0);
 
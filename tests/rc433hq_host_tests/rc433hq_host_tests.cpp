@@ -0,0 +1,1625 @@
+#include <string.h>
+#include <ArduinoUnit.h>
+
+#include "../../rc433hq.h"
+#include "../../rc433hq_emos.h"
+#include "../../host/rc433hq_traffic.h"
+#include "../../host/rc433hq_capture.h"
+#include "../../host/rc433hq_pipeline.h"
+#include "../../host/rc433hq_offline.h"
+#include "../../host/rc433hq_classify.h"
+#include "../../host/rc433hq_links.h"
+#include "../../host/rc433hq_journal.h"
+#include "../../host/rc433hq_live.h"
+
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <unistd.h>
+#include <sys/socket.h>
+
+// the time types are passed by value through every stage and copied through the lock-free queues
+static_assert(std::is_trivially_copyable<RC433HQMicroseconds>::value, "RC433HQMicroseconds must be trivially copyable");
+static_assert(std::is_trivially_copyable<RC433HQMicrosecondsDiff>::value, "RC433HQMicrosecondsDiff must be trivially copyable");
+static_assert(std::is_trivially_copyable<RC433HQExtendedMicroseconds>::value, "RC433HQExtendedMicroseconds must be trivially copyable");
+
+//////////////////////////////////////////////////////////////////////////////////
+// Utility classes
+//////////////////////////////////////////////////////////////////////////////////
+
+// EMOS protocols A and B as sent by the sockets remote (4x A followed by 4x B)
+class EmosTrafficProtocols {
+public:
+  RC433HQEmosSocketsPulseEncoderA encoderA;
+  RC433HQEmosSocketsPulseEncoderB encoderB;
+  RC433HQTrafficProtocol protocolB;
+  RC433HQTrafficProtocol protocolA;
+
+  EmosTrafficProtocols()
+  {
+    RC433HQTrafficProtocol b = { &encoderB, 1, 24, 4, 0 };
+    RC433HQTrafficProtocol a = { &encoderA, 0, 24, 4, &protocolB };
+    protocolB = b;
+    protocolA = a;
+  }
+};
+
+// EMOS decoders collecting the decoded frames
+class EmosTrafficDecoders {
+public:
+  RC433HQDecodedTrafficFrames decodedFrames;
+  RC433HQTrafficFrameCollector collectorA, collectorB;
+  RC433HQEmosSocketsPulseDecoderA decoderA;
+  RC433HQEmosSocketsPulseDecoderB decoderB;
+  RC433PulseSignalSplitter splitter;
+  RC433HQNoiseFilter filter;
+
+  EmosTrafficDecoders():
+    collectorA(decodedFrames, 0),
+    collectorB(decodedFrames, 1),
+    decoderA(collectorA),
+    decoderB(collectorB),
+    splitter(decoderA, decoderB),
+    filter(splitter, 50)
+  {
+  }
+};
+
+// capture sink storing the data in memory
+class MemoryCaptureSink: public IRC433CaptureSink {
+public:
+  std::vector<byte> data;
+
+  virtual void WriteCaptureData(const byte *adata, size_t size)
+  {
+    data.insert(data.end(), adata, adata + size);
+  }
+};
+
+// pulse processor storing the edges
+class EdgeCollector: public IRC433PulseProcessor {
+public:
+  RC433HQEdgeStream edges;
+  size_t missedEdgesCalls;
+
+  EdgeCollector():
+    missedEdgesCalls(0)
+  {
+  }
+
+  virtual void HandleEdge(RC433HQMicroseconds time, bool direction)
+  {
+    RC433HQEdge edge = { time, direction };
+    edges.push_back(edge);
+  }
+
+  virtual void HandleMissedEdges()
+  {
+    missedEdgesCalls++;
+  }
+
+  void AssertEdges(const RC433HQEdgeStream &expectedEdges)
+  {
+    assertEqual(edges.size(), expectedEdges.size());
+    for (size_t i = 0; i < edges.size(); i++) {
+      assertEqual(edges[i].time, expectedEdges[i].time);
+      assertEqual(edges[i].direction, expectedEdges[i].direction);
+    }
+  }
+};
+
+// EMOS decoders of one pipeline channel
+class EmosPipelineDecoders {
+public:
+  RC433HQPipelineFrameReceiver receiverA, receiverB;
+  RC433HQEmosSocketsPulseDecoderA decoderA;
+  RC433HQEmosSocketsPulseDecoderB decoderB;
+  RC433PulseSignalSplitter splitter;
+  RC433HQNoiseFilter filter;
+
+  EmosPipelineDecoders(RC433HQPipeline &pipeline, size_t channel):
+    receiverA(pipeline, channel, 0),
+    receiverB(pipeline, channel, 1),
+    decoderA(receiverA),
+    decoderB(receiverB),
+    splitter(decoderA, decoderB),
+    filter(splitter, 50)
+  {
+  }
+};
+
+// EMOS B decoder accepting 16 to 32 bits, so that the frame is sent only by the next non data pulse, and EMOS A decoder
+class VariableLengthEmosDecoderFactory: public IRC433OfflineDecoderFactory {
+public:
+  virtual size_t GetDecodersCount() const { return 2; }
+
+  virtual RC433HQBasicSyncPulseDecoder *CreateDecoder(size_t index, IRC433DataReceiver &receiver)
+  {
+    if (index == 0) {
+      return new RC433HQBasicSyncPulseDecoder(receiver, 2948, 7302, 401, 1134, 918, 617, 50, true, 16, 32);
+    }
+    return new RC433HQEmosSocketsPulseDecoderA(receiver);
+  }
+};
+
+// record the edges into the capture in memory, optionally with the missed edges before the given edge
+static void RecordCapture(MemoryCaptureSink &sink, const RC433HQEdgeStream &edges, size_t missedEdgesBefore = 0)
+{
+  RC433HQPulseRecorder recorder(sink, 1000);
+  for (size_t i = 0; i < edges.size(); i++) {
+    if ((missedEdgesBefore != 0) && (i == missedEdgesBefore)) {
+      recorder.HandleMissedEdges();
+    }
+    recorder.HandleEdge(edges[i].time, edges[i].direction);
+  }
+  recorder.Flush();
+}
+
+static void AssertSameFrames(const RC433HQOfflineFrames &frames, const RC433HQOfflineFrames &expectedFrames)
+{
+  assertEqual(frames.size(), expectedFrames.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    assertTrue(frames[i] == expectedFrames[i]);
+  }
+}
+
+// generate a noisy EMOS traffic
+static void GenerateNoisyTraffic(RC433HQEdgeStream &edges, RC433HQTrafficFrames &groundTruth, RC433HQMicrosecondsDiff duration)
+{
+  EmosTrafficProtocols protocols;
+  RC433HQTrafficImpairments impairments = RC433HQTrafficGenerator::NoImpairments();
+  impairments.jitterSigmaUs = 10;
+  impairments.agcBurstsPerSecond = 5;
+  impairments.agcBurstDurationUs = 20000;
+  impairments.agcPulseMinUs = 5;
+  impairments.agcPulseMaxUs = 800;
+  RC433HQTrafficGenerator generator(impairments);
+  generator.AddRandomTraffic(0, duration, 2.0, &protocols.protocolA, 1);
+  generator.Generate(edges, groundTruth);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQTrafficGenerator tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(TrafficGenerator_ShouldGenerateDecodableCleanTransmission)
+{
+  // given
+  EmosTrafficProtocols protocols;
+  EmosTrafficDecoders decoders;
+  RC433HQTrafficGenerator generator(RC433HQTrafficGenerator::NoImpairments());
+  const byte data[] = { 0x38, 0xCB, 0xBE };
+
+  // when
+  generator.AddTransmission(1000, protocols.protocolA, data);
+  generator.AddTransmission(500000, protocols.protocolA, data);
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  generator.Generate(edges, groundTruth);
+  RC433HQSendEdges(edges, decoders.filter);
+
+  // then
+  RC433HQTrafficScore score;
+  score.Evaluate(groundTruth, decoders.decodedFrames);
+  assertEqual(groundTruth.size(), 4);
+  assertEqual(score.detectedFrames, 4);
+  assertEqual(score.falseFrames, 0);
+  assertEqual(groundTruth[0].startTime, RC433HQMicroseconds(1000));
+}
+
+test(TrafficGenerator_ShouldNotDecodeTransmissionWithJitterAboveTolerance)
+{
+  // given
+  EmosTrafficProtocols protocols;
+  EmosTrafficDecoders decoders;
+  RC433HQTrafficImpairments impairments = RC433HQTrafficGenerator::NoImpairments();
+  impairments.jitterSigmaUs = 200;
+  RC433HQTrafficGenerator generator(impairments);
+  const byte data[] = { 0x38, 0xCB, 0xBE };
+
+  // when
+  generator.AddTransmission(1000, protocols.protocolA, data);
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  generator.Generate(edges, groundTruth);
+  RC433HQSendEdges(edges, decoders.filter);
+
+  // then
+  RC433HQTrafficScore score;
+  score.Evaluate(groundTruth, decoders.decodedFrames);
+  assertEqual(score.decodedRepetitions, 0);
+}
+
+test(TrafficGenerator_ShouldMarkCollidedTransmissions)
+{
+  // given
+  EmosTrafficProtocols protocols;
+  RC433HQTrafficImpairments impairments = RC433HQTrafficGenerator::NoImpairments();
+  impairments.collisionProbability = 1.0;
+  RC433HQTrafficGenerator generator(impairments);
+
+  // when
+  generator.AddRandomTraffic(0, 10000000, 2.0, &protocols.protocolA, 1);
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  generator.Generate(edges, groundTruth);
+
+  // then
+  ASSERT_LE_3(size_t(4), groundTruth.size(), "at least one transmission and its collision");
+  for (size_t i = 0; i < groundTruth.size(); i++) {
+    assertEqual(groundTruth[i].collided, true);
+  }
+  for (size_t i = 1; i < edges.size(); i++) {
+    assertEqual(edges[i].direction, !edges[i - 1].direction);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQCaptureReader tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(CaptureReader_ShouldReplayRecordedEdges)
+{
+  // given
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  GenerateNoisyTraffic(edges, groundTruth, 5000000);
+  MemoryCaptureSink sink;
+  RC433HQPulseRecorder recorder(sink, 1000);
+  RC433HQSendEdges(edges, recorder);
+  recorder.Flush();
+
+  // when
+  EdgeCollector collector;
+  RC433HQCaptureReader reader(&sink.data[0], sink.data.size());
+  size_t replayedEdges = reader.Replay(collector);
+
+  // then
+  assertEqual(reader.IsValid(), true);
+  assertEqual(reader.GetTimerResolutionNs(), 1000);
+  assertEqual(replayedEdges, edges.size());
+  collector.AssertEdges(edges);
+}
+
+test(CaptureReader_ShouldReplayMissedEdges)
+{
+  // given
+  MemoryCaptureSink sink;
+  RC433HQPulseRecorder recorder(sink, 1000);
+  recorder.HandleEdge(100, true);
+  recorder.HandleMissedEdges();
+  recorder.HandleEdge(200, false);
+  recorder.Flush();
+
+  // when
+  EdgeCollector collector;
+  RC433HQCaptureReader reader(&sink.data[0], sink.data.size());
+  reader.Replay(collector);
+
+  // then
+  RC433HQEdgeStream expectedEdges;
+  RC433HQEdge first = { 100, true }, second = { 200, false };
+  expectedEdges.push_back(first);
+  expectedEdges.push_back(second);
+  collector.AssertEdges(expectedEdges);
+  assertEqual(collector.missedEdgesCalls, 1);
+}
+
+test(CaptureReader_ShouldRejectInvalidHeader)
+{
+  // given
+  const byte data[] = { 'R', 'Q', 'E', 'X', 0x01, 0x00, 0x10, 0x00, 0xe8, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x10, 0x00, 0x00, 0x00 };
+
+  // when
+  EdgeCollector collector;
+  RC433HQCaptureReader reader(data, sizeof(data));
+
+  // then
+  assertEqual(reader.IsValid(), false);
+  assertEqual(reader.Replay(collector), 0);
+}
+
+test(CaptureFile_ShouldReplayMappedFile)
+{
+  // given
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  GenerateNoisyTraffic(edges, groundTruth, 5000000);
+  char fileName[] = "/tmp/rc433hq_capture_XXXXXX";
+  close(mkstemp(fileName));
+  RC433HQCaptureFileSink sink;
+  sink.Open(fileName);
+  RC433HQPulseRecorder recorder(sink);
+  RC433HQSendEdges(edges, recorder);
+  recorder.Flush();
+  sink.Close();
+
+  // when
+  RC433HQCaptureFile file;
+  bool opened = file.Open(fileName);
+  EdgeCollector collector;
+  file.GetReader().Replay(collector);
+  file.Close();
+  unlink(fileName);
+
+  // then
+  assertEqual(opened, true);
+  collector.AssertEdges(edges);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPipeline tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(SpscQueue_ShouldPassValuesInOrderAcrossWrapAround)
+{
+  // given
+  RC433HQSpscQueue<int> queue(4);
+  int values[] = { 1, 2, 3, 4, 5, 6 };
+  int popped[6];
+
+  // when
+  size_t firstPushed = queue.Push(values, 3);
+  size_t firstPopped = queue.Pop(popped, 2);
+  size_t secondPushed = queue.Push(values + 3, 3);
+  size_t secondPopped = queue.Pop(popped + 2, 6);
+
+  // then
+  assertEqual(firstPushed, 3);
+  assertEqual(firstPopped, 2);
+  assertEqual(secondPushed, 3);
+  assertEqual(secondPopped, 4);
+  for (int i = 0; i < 6; i++) {
+    assertEqual(popped[i], values[i]);
+  }
+}
+
+test(Pipeline_ShouldDecodeTheSameFramesAsSingleThreadedChain)
+{
+  // given
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  GenerateNoisyTraffic(edges, groundTruth, 10000000);
+  EmosTrafficDecoders reference;
+  RC433HQSendEdges(edges, reference.filter);
+
+  RC433HQPipeline pipeline(1024, 16);
+  EmosPipelineDecoders decoders0(pipeline, pipeline.AddChannel());
+  EmosPipelineDecoders decoders1(pipeline, pipeline.AddChannel());
+  pipeline.SetChannelProcessor(0, decoders0.filter);
+  pipeline.SetChannelProcessor(1, decoders1.filter);
+
+  // when
+  pipeline.Start();
+  std::thread source0([&]() { RC433HQSendEdges(edges, pipeline.GetChannelInput(0)); pipeline.GetChannelInput(0).Flush(); });
+  std::thread source1([&]() { RC433HQSendEdges(edges, pipeline.GetChannelInput(1)); pipeline.GetChannelInput(1).Flush(); });
+  std::vector<RC433HQPipelineFrame> frames[2];
+  while ((pipeline.GetProcessedEdges(0) < edges.size()) || (pipeline.GetProcessedEdges(1) < edges.size()) || (frames[0].size() + frames[1].size() < 2 * reference.decodedFrames.size())) {
+    RC433HQPipelineFrame frame;
+    if (pipeline.PopFrame(frame)) {
+      frames[frame.channel].push_back(frame);
+    }
+  }
+  source0.join();
+  source1.join();
+  pipeline.Stop();
+
+  // then
+  assertMore(reference.decodedFrames.size(), 0);
+  for (size_t channel = 0; channel < 2; channel++) {
+    assertEqual(frames[channel].size(), reference.decodedFrames.size());
+    for (size_t i = 0; i < frames[channel].size(); i++) {
+      assertEqual(frames[channel][i].time, reference.decodedFrames[i].time);
+      assertEqual(frames[channel][i].protocol, reference.decodedFrames[i].protocol);
+      assertEqual(frames[channel][i].bits, reference.decodedFrames[i].bits);
+      assertEqual(memcmp(frames[channel][i].data, reference.decodedFrames[i].data, (frames[channel][i].bits + 7) / 8), 0);
+    }
+  }
+}
+
+test(PipelineInput_ShouldReportDroppedEdgesAsMissed)
+{
+  // given
+  RC433HQPipeline pipeline(4);
+  EdgeCollector collector;
+  size_t channel = pipeline.AddChannel();
+  pipeline.SetChannelProcessor(channel, collector);
+  RC433HQPipelineInput &input = pipeline.GetChannelInput(channel);
+  input.SetDropWhenFull(true);
+
+  // when
+  for (unsigned long i = 0; i < 6; i++) {
+    input.HandleEdge(i * 100, (i % 2) == 0);
+  }
+  input.Flush();
+  pipeline.Start();
+  while (pipeline.GetProcessedEdges(channel) < 4) {
+    std::this_thread::yield();
+  }
+  input.HandleEdge(600, true);
+  input.Flush();
+  pipeline.Stop();
+
+  // then
+  assertEqual(input.GetDroppedEdges(), 2);
+  assertEqual(collector.edges.size(), 5);
+  assertEqual(collector.missedEdgesCalls, 1);
+  assertEqual(collector.edges[4].time, RC433HQMicroseconds(600));
+}
+
+test(Pipeline_ShouldStopWithFullFrameQueue)
+{
+  // given
+  EmosTrafficProtocols protocols;
+  RC433HQTrafficGenerator generator(RC433HQTrafficGenerator::NoImpairments());
+  const byte data[] = { 0x38, 0xCB, 0xBE };
+  generator.AddTransmission(1000, protocols.protocolA, data);
+  generator.AddTransmission(500000, protocols.protocolA, data);
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  generator.Generate(edges, groundTruth);
+  EmosTrafficDecoders reference;
+  RC433HQSendEdges(edges, reference.filter);
+
+  RC433HQPipeline pipeline(1024, 2);
+  EmosPipelineDecoders decoders(pipeline, pipeline.AddChannel());
+  pipeline.SetChannelProcessor(0, decoders.filter);
+
+  // when
+  pipeline.Start();
+  RC433HQSendEdges(edges, pipeline.GetChannelInput(0));
+  pipeline.GetChannelInput(0).Flush();
+  pipeline.Stop();        // nothing popped so far, the workers wait for the space in the frame queue
+
+  // then
+  std::vector<RC433HQPipelineFrame> frames;
+  RC433HQPipelineFrame frame;
+  while (pipeline.PopFrame(frame)) {
+    frames.push_back(frame);
+  }
+  assertMore(reference.decodedFrames.size(), 2);
+  assertEqual(pipeline.GetProcessedEdges(0), edges.size());
+  assertEqual(frames.size(), reference.decodedFrames.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    assertEqual(frames[i].time, reference.decodedFrames[i].time);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQOfflineDecoder tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(OfflineDecoder_ShouldDecodeChunksIdenticallyToSequentialDecoding)
+{
+  // given
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  GenerateNoisyTraffic(edges, groundTruth, 20000000);
+  MemoryCaptureSink sink;
+  RecordCapture(sink, edges);
+  RC433HQCaptureReader reader(&sink.data[0], sink.data.size());
+  VariableLengthEmosDecoderFactory factory;
+  RC433HQOfflineDecoder decoder(factory, 50, 100000, 0);
+
+  // when
+  RC433HQOfflineFrames sequentialFrames, parallelFrames, defaultThreadFrames;
+  decoder.DecodeSequential(reader, sequentialFrames);
+  decoder.DecodeParallel(reader, 3, parallelFrames);
+  decoder.DecodeParallel(reader, 0, defaultThreadFrames);   // decoded by one thread
+
+  // then
+  assertMore(sequentialFrames.size(), 0);
+  assertMore(decoder.GetChunksCount(), 1);
+  AssertSameFrames(parallelFrames, sequentialFrames);
+  AssertSameFrames(defaultThreadFrames, sequentialFrames);
+}
+
+test(OfflineDecoder_ShouldSendFramePendingBeforeGapOnlyIfNotMissed)
+{
+  // given
+  EmosTrafficProtocols protocols;
+  RC433HQTrafficProtocol protocol = { &protocols.encoderB, 0, 20, 1, 0 };
+  byte data[3] = { 0x12, 0x34, 0x50 };
+  RC433HQTrafficGenerator generator(RC433HQTrafficGenerator::NoImpairments());
+  generator.AddTransmission(1000, protocol, data);
+  generator.AddTransmission(1000000, protocol, data);
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  generator.Generate(edges, groundTruth);
+  MemoryCaptureSink sink, sinkWithMissedEdges;
+  RecordCapture(sink, edges);
+  RecordCapture(sinkWithMissedEdges, edges, edges.size() / 2);
+  VariableLengthEmosDecoderFactory factory;
+  RC433HQOfflineDecoder decoder(factory, 50, 100000, 0);
+
+  // when
+  RC433HQOfflineFrames sequentialFrames, parallelFrames, sequentialFramesWithMissedEdges, parallelFramesWithMissedEdges;
+  decoder.DecodeSequential(RC433HQCaptureReader(&sink.data[0], sink.data.size()), sequentialFrames);
+  decoder.DecodeParallel(RC433HQCaptureReader(&sink.data[0], sink.data.size()), 2, parallelFrames);
+  decoder.DecodeSequential(RC433HQCaptureReader(&sinkWithMissedEdges.data[0], sinkWithMissedEdges.data.size()), sequentialFramesWithMissedEdges);
+  decoder.DecodeParallel(RC433HQCaptureReader(&sinkWithMissedEdges.data[0], sinkWithMissedEdges.data.size()), 2, parallelFramesWithMissedEdges);
+
+  // then
+  // the last bit is not complete without the rising edge after its low level
+  assertEqual(sequentialFrames.size(), 1);
+  assertEqual(sequentialFrames[0].bits, 19);
+  assertEqual(sequentialFrames[0].time.GetMicroseconds(), RC433HQMicroseconds(1000));
+  AssertSameFrames(parallelFrames, sequentialFrames);
+  assertEqual(sequentialFramesWithMissedEdges.size(), 0);
+  AssertSameFrames(parallelFramesWithMissedEdges, sequentialFramesWithMissedEdges);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQBatchDecoder tests
+//////////////////////////////////////////////////////////////////////////////////
+
+static unsigned AbsoluteDifference(unsigned a, unsigned b)
+{
+  return (a < b)? (b - a): (a - b);
+}
+
+test(PulseClassifier_ShouldMatchDecoderWindowsInAllKernels)
+{
+  // given
+  RC433HQDecodedTrafficFrames frames;
+  RC433HQTrafficFrameCollector receiver(frames, 0);
+  RC433HQBasicSyncPulseDecoder decoder(receiver, 40, 2381, 299, 1235, 1076, 480, 50, true, 24, 24);
+  RC433HQEmosSocketsPulseDecoderB decoderB(receiver);
+  std::vector<int32_t> highDurations, lowDurations;
+  for (int32_t duration = 0; duration < 2500; duration++) {
+    highDurations.push_back(duration);
+    lowDurations.push_back(2431 - duration % 110);
+  }
+  highDurations.push_back(0x7fffffff);
+  lowDurations.push_back(2381);
+  RC433HQClassifierKernel kernels[] = { RC433HQ_CLASSIFIER_SCALAR, RC433HQ_CLASSIFIER_SSE2, RC433HQ_CLASSIFIER_AVX2 };
+
+  for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+
+    RC433HQPulseClassifier classifier;
+    if (!classifier.SetKernel(kernels[k])) {
+      continue;
+    }
+    classifier.AddProtocol(decoder.GetTiming());
+    classifier.AddProtocol(decoderB.GetTiming());
+
+    // when
+    std::vector<byte> symbols(highDurations.size() * 2);
+    classifier.Classify(&highDurations[0], &lowDurations[0], highDurations.size(), &symbols[0]);
+
+    // then
+    for (size_t i = 0; i < highDurations.size(); i++) {
+      RC433HQMicrosecondsDiff high = (unsigned long)highDurations[i];
+      RC433HQMicrosecondsDiff low = (unsigned long)lowDurations[i];
+      assertEqual(symbols[i], decoder.ClassifyPulse(high, low));
+      assertEqual(symbols[highDurations.size() + i], decoderB.ClassifyPulse(high, low));
+    }
+  }
+}
+
+test(BatchDecoder_ShouldDecodeTheSameFramesAsDecoders)
+{
+  // given
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  GenerateNoisyTraffic(edges, groundTruth, 20000000);
+  RC433HQDecodedTrafficFrames expectedFrames;
+  RC433HQTrafficFrameCollector expectedCollectorA(expectedFrames, 0), expectedCollectorB(expectedFrames, 1);
+  RC433HQEmosSocketsPulseDecoderA decoderA(expectedCollectorA);
+  RC433HQBasicSyncPulseDecoder decoderB(expectedCollectorB, 2948, 7302, 401, 1134, 918, 617, 50, true, 16, 32);
+  RC433PulseSignalSplitter splitter(decoderA, decoderB);
+  RC433HQNoiseFilter filter(splitter, 50);
+  for (size_t i = 0; i < edges.size(); i++) {
+    if (i % 1000 == 999) {
+      filter.HandleMissedEdges();
+    }
+    filter.HandleEdge(edges[i].time, edges[i].direction);
+  }
+  std::stable_sort(expectedFrames.begin(), expectedFrames.end(), [](const RC433HQDecodedTrafficFrame &a, const RC433HQDecodedTrafficFrame &b) { return a.protocol < b.protocol; });
+  RC433HQClassifierKernel kernels[] = { RC433HQ_CLASSIFIER_SCALAR, RC433HQ_CLASSIFIER_SSE2, RC433HQ_CLASSIFIER_AVX2 };
+
+  for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+
+    RC433HQDecodedTrafficFrames frames;
+    RC433HQTrafficFrameCollector collectorA(frames, 0), collectorB(frames, 1);
+    RC433HQEmosSocketsPulseDecoderA batchDecoderA(collectorA);
+    RC433HQBasicSyncPulseDecoder batchDecoderB(collectorB, 2948, 7302, 401, 1134, 918, 617, 50, true, 16, 32);
+    RC433HQBatchDecoder batchDecoder;
+    if (!batchDecoder.GetClassifier().SetKernel(kernels[k])) {
+      continue;
+    }
+    batchDecoder.AddDecoder(batchDecoderA);
+    batchDecoder.AddDecoder(batchDecoderB);
+    RC433HQPulseBatch batch;
+    RC433HQPulseBatchCollector batchCollector(batch);
+    RC433HQNoiseFilter batchFilter(batchCollector, 50);
+
+    // when
+    for (size_t i = 0; i < edges.size(); i++) {
+      if (i % 1000 == 999) {
+        batchFilter.HandleMissedEdges();
+      }
+      batchFilter.HandleEdge(edges[i].time, edges[i].direction);
+      if (batch.GetSize() == 500) {
+        batchDecoder.Decode(batch);
+        batch.Clear();
+      }
+    }
+    batchDecoder.Decode(batch);
+    std::stable_sort(frames.begin(), frames.end(), [](const RC433HQDecodedTrafficFrame &a, const RC433HQDecodedTrafficFrame &b) { return a.protocol < b.protocol; });
+
+    // then
+    assertMore(expectedFrames.size(), 0);
+    assertEqual(frames.size(), expectedFrames.size());
+    for (size_t i = 0; i < frames.size(); i++) {
+      assertEqual(frames[i].protocol, expectedFrames[i].protocol);
+      assertEqual(frames[i].time, expectedFrames[i].time);
+      assertEqual(frames[i].bits, expectedFrames[i].bits);
+      assertEqual(memcmp(frames[i].data, expectedFrames[i].data, sizeof(frames[i].data)), 0);
+      assertEqual(frames[i].quality, expectedFrames[i].quality);
+    }
+  }
+}
+
+// frame delivered by the decoder with its 64-bit time and the confidences of the bits
+struct SoftTrafficFrame {
+  RC433HQExtendedMicroseconds time;
+  std::vector<byte> data;
+  std::vector<byte> confidences;
+  double quality;
+};
+
+class SoftTrafficFrameCollector: public IRC433DataReceiver {
+public:
+  std::vector<SoftTrafficFrame> frames;
+
+  virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality)
+  {
+    HandleSoftData(RC433HQExtendedMicroseconds(0, time), data, bits, 0, quality);
+  }
+
+  virtual void HandleSoftData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, const byte *confidences, double quality)
+  {
+    SoftTrafficFrame frame;
+    frame.time = time;
+    frame.data.assign(data, data + (bits + 7) / 8);
+    if (confidences) {
+      frame.confidences.assign(confidences, confidences + bits);
+    }
+    frame.quality = quality;
+    frames.push_back(frame);
+  }
+};
+
+// EMOS A (delivered early) and the longer B decoding in the soft decision mode with the time extender and the validator
+class SoftEmosDecoders {
+public:
+  RC433HQTimeExtender timeExtender;
+  RC433HQFieldValidator validator;
+  SoftTrafficFrameCollector collectorA, collectorB;
+  RC433HQEmosSocketsPulseDecoderA decoderA;
+  RC433HQBasicSyncPulseDecoder decoderB;
+
+  SoftEmosDecoders():
+    validator(0, 1, 1),
+    decoderA(collectorA),
+    decoderB(collectorB, 2948, 7302, 401, 1134, 918, 617, 50, true, 16, 32)
+  {
+    decoderA.SetTimeExtender(timeExtender);
+    decoderB.SetTimeExtender(timeExtender);
+    decoderA.EnableSoftDecision();
+    decoderB.EnableSoftDecision();
+    decoderA.SetFrameValidator(validator);
+    decoderB.SetFrameValidator(validator);
+    decoderA.EnableEarlyDelivery();
+  }
+};
+
+static void AssertSameSoftFrames(const std::vector<SoftTrafficFrame> &frames, const std::vector<SoftTrafficFrame> &expectedFrames)
+{
+  assertEqual(frames.size(), expectedFrames.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    assertEqual(frames[i].time.GetUnsignedLongLong(), expectedFrames[i].time.GetUnsignedLongLong());
+    assertTrue(frames[i].data == expectedFrames[i].data);
+    assertTrue(frames[i].confidences == expectedFrames[i].confidences);
+    assertEqual(frames[i].quality, expectedFrames[i].quality);
+  }
+}
+
+static void AssertSameMetrics(const RC433HQDecoderMetrics &metrics, const RC433HQDecoderMetrics &expectedMetrics)
+{
+  assertEqual(metrics.syncs, expectedMetrics.syncs);
+  assertEqual(metrics.zeroBits, expectedMetrics.zeroBits);
+  assertEqual(metrics.oneBits, expectedMetrics.oneBits);
+  assertEqual(metrics.softBits, expectedMetrics.softBits);
+  assertEqual(metrics.outOfTolerancePulses, expectedMetrics.outOfTolerancePulses);
+  assertEqual(metrics.brokenPulses, expectedMetrics.brokenPulses);
+  assertEqual(metrics.missedEdges, expectedMetrics.missedEdges);
+  assertEqual(metrics.shortFrames, expectedMetrics.shortFrames);
+  assertEqual(metrics.rejectedFrames, expectedMetrics.rejectedFrames);
+  assertEqual(metrics.deliveredFrames, expectedMetrics.deliveredFrames);
+  assertEqual(metrics.qualitySum, expectedMetrics.qualitySum);
+}
+
+test(BatchDecoder_ShouldDecodeTheSameSoftFramesAsDecodersAcrossTimeWrap)
+{
+  // given
+  EmosTrafficProtocols protocols;
+  RC433HQTrafficImpairments impairments = RC433HQTrafficGenerator::NoImpairments();
+  impairments.jitterSigmaUs = 30;
+  impairments.agcBurstsPerSecond = 5;
+  impairments.agcBurstDurationUs = 20000;
+  impairments.agcPulseMinUs = 5;
+  impairments.agcPulseMaxUs = 800;
+  RC433HQTrafficGenerator generator(impairments);
+  generator.AddRandomTraffic(0, 20000000, 2.0, &protocols.protocolA, 1);
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  generator.Generate(edges, groundTruth);
+  RC433HQMicrosecondsDiff wrapOffset = 0xffffffffUL - 10000000UL;   // the time wraps in the middle of the traffic
+  SoftEmosDecoders expected;
+  RC433PulseSignalSplitter splitter(expected.decoderA, expected.decoderB);
+  RC433HQNoiseFilter filter(splitter, 50);
+  SoftEmosDecoders actual;
+  RC433HQBatchDecoder batchDecoder;
+  batchDecoder.AddDecoder(actual.decoderA);
+  batchDecoder.AddDecoder(actual.decoderB);
+  RC433HQPulseBatch batch;
+  RC433HQPulseBatchCollector batchCollector(batch);
+  RC433HQNoiseFilter batchFilter(batchCollector, 50);
+
+  // when
+  for (size_t i = 0; i < edges.size(); i++) {
+    RC433HQMicroseconds time = edges[i].time + wrapOffset;
+    if (i % 1000 == 999) {
+      filter.HandleMissedEdges();
+      batchFilter.HandleMissedEdges();
+    }
+    expected.timeExtender.Update(time);
+    filter.HandleEdge(time, edges[i].direction);
+    actual.timeExtender.Update(time);
+    batchFilter.HandleEdge(time, edges[i].direction);
+    if (batch.GetSize() == 500) {
+      batchDecoder.Decode(batch);
+      batch.Clear();
+    }
+  }
+  batchDecoder.Decode(batch);
+
+  // then
+  const RC433HQDecoderMetrics &expectedMetrics = expected.decoderA.GetMetrics();
+  ASSERT_LE_3(1UL, expectedMetrics.softBits, "soft decisions");
+  ASSERT_LE_3(1UL, expectedMetrics.rejectedFrames, "rejected frames");
+  ASSERT_LE_3(1UL, expectedMetrics.deliveredFrames, "delivered frames");
+  assertEqual(expected.collectorA.frames.back().time.GetEpoch(), 1U);
+  AssertSameSoftFrames(actual.collectorA.frames, expected.collectorA.frames);
+  AssertSameSoftFrames(actual.collectorB.frames, expected.collectorB.frames);
+  AssertSameMetrics(actual.decoderA.GetMetrics(), expected.decoderA.GetMetrics());
+  AssertSameMetrics(actual.decoderB.GetMetrics(), expected.decoderB.GetMetrics());
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQProtocolAnalyzer tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(ProtocolAnalyzer_ShouldLearnDecodableEmosTimingFromNoisyTraffic)
+{
+  // given
+  EmosTrafficProtocols protocols;
+  RC433HQTrafficProtocol protocolA = { &protocols.encoderA, 0, 24, 4, 0 };
+  RC433HQTrafficImpairments impairments = RC433HQTrafficGenerator::NoImpairments();
+  impairments.jitterSigmaUs = 10;
+  impairments.noiseSpikesPerSecond = 20;
+  impairments.noiseSpikeMinUs = 5;
+  impairments.noiseSpikeMaxUs = 40;
+  impairments.agcBurstsPerSecond = 5;
+  impairments.agcBurstDurationUs = 20000;
+  impairments.agcPulseMinUs = 5;
+  impairments.agcPulseMaxUs = 800;
+  RC433HQTrafficGenerator generator(impairments);
+  generator.AddRandomTraffic(0, 20000000, 2.0, &protocolA, 1);
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  generator.Generate(edges, groundTruth);
+  RC433HQProtocolAnalyzer analyzer;
+  RC433HQNoiseFilter filter(analyzer, 50);
+
+  // when
+  RC433HQSendEdges(edges, filter);
+  RC433HQProtocolSuggestion suggestion;
+  bool suggested = analyzer.GetSuggestion(suggestion);
+
+  // then
+  assertTrue(suggested);
+  assertLessOrEqual(AbsoluteDifference(suggestion.syncFirstUs, 272), 20);
+  assertLessOrEqual(AbsoluteDifference(suggestion.syncSecondUs, 2381), 20);
+  assertLessOrEqual(AbsoluteDifference(suggestion.zeroFirstUs, 299), 20);
+  assertLessOrEqual(AbsoluteDifference(suggestion.zeroSecondUs, 1235), 20);
+  assertLessOrEqual(AbsoluteDifference(suggestion.oneFirstUs, 1076), 20);
+  assertLessOrEqual(AbsoluteDifference(suggestion.oneSecondUs, 480), 20);
+  assertEqual(suggestion.minBits, 24);
+  assertEqual(suggestion.maxBits, 24);
+
+  // the learned decoder decodes the traffic
+  RC433HQDecodedTrafficFrames decodedFrames;
+  RC433HQTrafficFrameCollector collector(decodedFrames, 0);
+  RC433HQBasicSyncPulseDecoder decoder(collector, suggestion.syncFirstUs, suggestion.syncSecondUs, suggestion.zeroFirstUs, suggestion.zeroSecondUs,
+                                       suggestion.oneFirstUs, suggestion.oneSecondUs, suggestion.toleranceUs, true, suggestion.minBits, suggestion.maxBits);
+  RC433HQNoiseFilter decoderFilter(decoder, 50);
+  RC433HQSendEdges(edges, decoderFilter);
+  RC433HQTrafficScore score;
+  score.Evaluate(groundTruth, decodedFrames);
+  assertMore(score.GetFrameDetectionRate(), 0.9);
+  assertEqual(score.falseFrames, 0);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Frame latency tests
+//////////////////////////////////////////////////////////////////////////////////
+
+// keeps the time of the last edge passed on, i.e. the time of the delivery of the frames decoded behind it
+class EdgeClock: public IRC433PulseProcessor {
+public:
+  IRC433PulseProcessor &processor;
+  RC433HQMicroseconds time;
+
+  EdgeClock(IRC433PulseProcessor &aprocessor): processor(aprocessor), time(0) {}
+
+  virtual void HandleEdge(RC433HQMicroseconds atime, bool direction)
+  {
+    time = atime;
+    processor.HandleEdge(atime, direction);
+  }
+};
+
+// the count and the max latency of the frames from their sync to the edge delivering them
+class FrameLatencyCollector: public IRC433DataReceiver {
+public:
+  const EdgeClock *clock;
+  size_t framesCount;
+  unsigned long maxLatencyUs;
+
+  FrameLatencyCollector(): clock(0), framesCount(0), maxLatencyUs(0) {}
+
+  virtual void HandleData(RC433HQMicroseconds time, const byte *data, size_t bits, double quality)
+  {
+    unsigned long latencyUs = (clock->time - time).GetUnsignedLong();
+    if (latencyUs > maxLatencyUs) {
+      maxLatencyUs = latencyUs;
+    }
+    framesCount++;
+  }
+};
+
+// EMOS decoders measuring the latency of the frames (without the noise filter, which holds every edge until the next one)
+class EmosLatencyDecoders {
+public:
+  FrameLatencyCollector collector;
+  RC433HQEmosSocketsPulseDecoderA decoderA;
+  RC433HQEmosSocketsPulseDecoderB decoderB;
+  RC433PulseSignalSplitter splitter;
+  EdgeClock clock;
+
+  EmosLatencyDecoders():
+    decoderA(collector),
+    decoderB(collector),
+    splitter(decoderA, decoderB),
+    clock(splitter)
+  {
+    collector.clock = &clock;
+  }
+};
+
+test(EarlyDelivery_ShouldDeliverLastRepetitionWithoutWaitingForNextPulse)
+{
+  // given
+  EmosTrafficProtocols protocols;
+  RC433HQTrafficGenerator generator(RC433HQTrafficGenerator::NoImpairments());
+  generator.AddRandomTraffic(0, 60000000, 1.0, &protocols.protocolA, 1);
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  generator.Generate(edges, groundTruth);
+  EmosLatencyDecoders regularDecoders;
+  EmosLatencyDecoders earlyDecoders;
+  earlyDecoders.decoderA.EnableEarlyDelivery();
+  earlyDecoders.decoderB.EnableEarlyDelivery();
+
+  // when
+  RC433HQSendEdges(edges, regularDecoders.clock);
+  RC433HQSendEdges(edges, earlyDecoders.clock);
+
+  // then
+  // the low part of the last bit of the transmission ends by the next transmission, so the regular decoders drop the last
+  // repetition of B as too short, the early ones deliver it at the end of the frame
+  size_t transmissionsCount = groundTruth.size() / 2;
+  ASSERT_LE_3(size_t(20), transmissionsCount, "enough transmissions");
+  assertEqual(earlyDecoders.collector.framesCount, regularDecoders.collector.framesCount + transmissionsCount);
+  assertEqual(earlyDecoders.collector.framesCount, transmissionsCount * 8);
+  ASSERT_LE_3(earlyDecoders.collector.maxLatencyUs, 50000UL, "early delivery at the end of the frame");
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQRepetitionCombiner tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(RepetitionCombiner_ShouldDecodeMarginalTransmissionsLostByHardDecisions)
+{
+  // given
+  EmosTrafficProtocols protocols;
+  RC433HQTrafficImpairments impairments = RC433HQTrafficGenerator::NoImpairments();
+  impairments.jitterSigmaUs = 24;
+  RC433HQTrafficGenerator generator(impairments);
+  generator.AddRandomTraffic(0, 60000000, 0.5, &protocols.protocolA, 1);
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  generator.Generate(edges, groundTruth);
+  RC433HQTrafficFrames groundTruthA;
+  for (size_t i = 0; i < groundTruth.size(); i++) {
+    if (groundTruth[i].protocol == 0) {
+      groundTruthA.push_back(groundTruth[i]);
+    }
+  }
+  EmosTrafficDecoders hardDecoders;
+  RC433HQDecodedTrafficFrames combinedFrames;
+  RC433HQTrafficFrameCollector collector(combinedFrames, 0);
+  RC433HQRepetitionCombiner combiner(collector, 24, 200_ms);
+  RC433HQEmosSocketsPulseDecoderA decoderA(combiner);
+  RC433HQEmosSocketsPulseDecoderB decoderB(combiner);
+  decoderA.EnableSoftDecision();
+  decoderB.EnableSoftDecision();
+  RC433PulseSignalSplitter splitter(decoderA, decoderB);
+  RC433HQNoiseFilter filter(splitter, 50);
+
+  // when
+  RC433HQSendEdges(edges, hardDecoders.filter);
+  RC433HQSendEdges(edges, filter);
+  combiner.Flush();
+
+  // then
+  RC433HQTrafficScore hardScore;
+  hardScore.Evaluate(groundTruth, hardDecoders.decodedFrames);
+  RC433HQTrafficScore combinedScore;
+  combinedScore.Evaluate(groundTruthA, combinedFrames);
+  ASSERT_LE_3(size_t(20), groundTruthA.size(), "enough transmissions");
+  assertLess(hardScore.GetFrameDetectionRate(), 0.5);
+  assertMore(combinedScore.GetFrameDetectionRate(), 0.95);
+  assertEqual(combinedScore.falseFrames, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQDiversityCombiner tests
+//////////////////////////////////////////////////////////////////////////////////
+
+// EMOS decoders of one receiver passing the frames into the diversity combiners of the protocols
+class EmosDiversityDecoders {
+public:
+  RC433HQDiversityInput inputA, inputB;
+  RC433HQEmosSocketsPulseDecoderA decoderA;
+  RC433HQEmosSocketsPulseDecoderB decoderB;
+  RC433PulseSignalSplitter splitter;
+  RC433HQNoiseFilter filter;
+
+  EmosDiversityDecoders(RC433HQDiversityCombiner &combinerA, RC433HQDiversityCombiner &combinerB, size_t receiverIndex):
+    inputA(combinerA, receiverIndex),
+    inputB(combinerB, receiverIndex),
+    decoderA(inputA),
+    decoderB(inputB),
+    splitter(decoderA, decoderB),
+    filter(splitter, 50)
+  {
+  }
+};
+
+// the same transmissions every second as received by a receiver with its own noise
+static void GenerateReceivedTraffic(unsigned seed, RC433HQEdgeStream &edges, RC433HQTrafficFrames &groundTruth)
+{
+  EmosTrafficProtocols protocols;
+  RC433HQTrafficImpairments impairments = RC433HQTrafficGenerator::NoImpairments();
+  impairments.jitterSigmaUs = 13;
+  impairments.agcBurstsPerSecond = 6;
+  impairments.agcBurstDurationUs = 30000;
+  impairments.agcPulseMinUs = 5;
+  impairments.agcPulseMaxUs = 800;
+  RC433HQTrafficGenerator generator(impairments, seed);
+  for (unsigned i = 0; i < 60; i++) {
+    const byte data[] = { byte(0x38 + i), 0xCB, byte(0xBE - i) };
+    generator.AddTransmission(1000 + i * 1000000UL, protocols.protocolA, data);
+  }
+  generator.Generate(edges, groundTruth);
+}
+
+test(DiversityCombiner_ShouldDeliverRepetitionsOfAnyReceiverOnce)
+{
+  // given
+  RC433HQEdgeStream northEdges, southEdges;
+  RC433HQTrafficFrames groundTruth, southGroundTruth;
+  GenerateReceivedTraffic(1, northEdges, groundTruth);
+  GenerateReceivedTraffic(2, southEdges, southGroundTruth);
+  EmosTrafficDecoders northDecoders, southDecoders;
+  RC433HQDecodedTrafficFrames combinedFrames;
+  RC433HQTrafficFrameCollector collectorA(combinedFrames, 0), collectorB(combinedFrames, 1);
+  RC433HQDiversityCombiner combinerA(collectorA, 2, 24, 2_ms, 100_ms);
+  RC433HQDiversityCombiner combinerB(collectorB, 2, 24, 2_ms, 100_ms);
+  EmosDiversityDecoders north(combinerA, combinerB, 0), south(combinerA, combinerB, 1);
+
+  // when
+  RC433HQSendEdges(northEdges, northDecoders.filter);
+  RC433HQSendEdges(southEdges, southDecoders.filter);
+  size_t southEdge = 0;
+  for (size_t northEdge = 0; northEdge < northEdges.size(); northEdge++) {
+    for (; (southEdge < southEdges.size()) && (southEdges[southEdge].time.GetUnsignedLong() <= northEdges[northEdge].time.GetUnsignedLong()); southEdge++) {
+      south.filter.HandleEdge(southEdges[southEdge].time, southEdges[southEdge].direction);
+    }
+    north.filter.HandleEdge(northEdges[northEdge].time, northEdges[northEdge].direction);
+  }
+  for (; southEdge < southEdges.size(); southEdge++) {
+    south.filter.HandleEdge(southEdges[southEdge].time, southEdges[southEdge].direction);
+  }
+  combinerA.Flush();
+  combinerB.Flush();
+
+  // then
+  RC433HQTrafficScore northScore, southScore, combinedScore;
+  northScore.Evaluate(groundTruth, northDecoders.decodedFrames);
+  southScore.Evaluate(groundTruth, southDecoders.decodedFrames);
+  combinedScore.Evaluate(groundTruth, combinedFrames);
+  assertEqual(groundTruth.size(), southGroundTruth.size());
+  assertLess(northScore.GetRepetitionDecodeRate(), 0.75);
+  assertLess(southScore.GetRepetitionDecodeRate(), 0.75);
+  assertMore(combinedScore.GetRepetitionDecodeRate(), 0.8);
+  assertEqual(combinedScore.falseFrames, 0);
+
+  // every repetition is delivered once
+  assertEqual(combinedFrames.size(), combinedScore.decodedRepetitions);
+  assertLess(combinedFrames.size(), northDecoders.decodedFrames.size() + southDecoders.decodedFrames.size());
+  const RC433HQDiversityStatistics &northStatistics = combinerA.GetStatistics(0);
+  const RC433HQDiversityStatistics &southStatistics = combinerA.GetStatistics(1);
+  assertMore(northStatistics.exclusiveFrames, 0UL);
+  assertMore(southStatistics.exclusiveFrames, 0UL);
+  assertEqual(northStatistics.contributedFrames + southStatistics.contributedFrames - combinerA.GetDeliveredFramesCount(),
+    combinerA.GetSuppressedFramesCount());
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQTransmitter tests
+//////////////////////////////////////////////////////////////////////////////////
+
+// clock of a board with a coarse time and an inaccurate sleep: every read takes readCostUs, the time is read in steps of
+// resolutionUs and the sleep is late by a fixed overhead plus a per mille of its length
+class SimulatedClock: public IRC433Clock {
+public:
+  unsigned long time;
+  unsigned long readCostUs;
+  unsigned long resolutionUs;
+  unsigned long sleepOverheadUs;
+  unsigned long sleepSlowdownPerMille;
+
+  SimulatedClock(unsigned long areadCostUs, unsigned long aresolutionUs, unsigned long asleepOverheadUs, unsigned long asleepSlowdownPerMille):
+    time(1000),
+    readCostUs(areadCostUs),
+    resolutionUs(aresolutionUs),
+    sleepOverheadUs(asleepOverheadUs),
+    sleepSlowdownPerMille(asleepSlowdownPerMille)
+  {
+  }
+
+  virtual RC433HQMicroseconds GetTimeInMicroseconds()
+  {
+    time += readCostUs;
+    return RC433HQMicroseconds((time / resolutionUs) * resolutionUs);
+  }
+
+  virtual void SleepMicroseconds(RC433HQMicrosecondsDiff delay)
+  {
+    time += delay.GetUnsignedLong() + sleepOverheadUs + (delay.GetUnsignedLong() * sleepSlowdownPerMille) / 1000;
+  }
+};
+
+static void TransmitEmosFrames(RC433HQTransmitter &transmitter, RC433HQTransmissionQualityStatistics &statistics)
+{
+  static const byte data[] = { 0x38, 0xcb, 0xbe };
+  RC433HQEmosSocketsPulseEncoderA encoderA;
+  RC433HQEmosSocketsPulseEncoderB encoderB;
+  transmitter.StartTransmission(0, 10, &statistics);
+  encoderA.EncodeData(transmitter, data, 24, 4);
+  encoderB.EncodeData(transmitter, data, 24, 4);
+  transmitter.EndTransmission(0);
+}
+
+test(HybridWait_ShouldSendEdgesInToleranceDespiteLateSleep)
+{
+  // given
+  // AVR like micros() (4 us steps) and delayMicroseconds() late by 12 us + 2 %
+  SimulatedClock clock(3, 4, 12, 20);
+  RC433HQTransmitter transmitter(10, clock);
+  RC433HQTransmissionQualityStatistics statistics;
+
+  // when
+  unsigned long sleepStart = clock.time;
+  clock.SleepMicroseconds(100);
+  unsigned long plainSleepLateness = clock.time - sleepStart - 100;
+  TransmitEmosFrames(transmitter, statistics);
+
+  // then
+  ASSERT_LE_3(11UL, plainSleepLateness, "the plain sleep alone misses the tolerance");
+  assertEqual(statistics.countOfTransmittedEdges, 2 * 4 * 2 * 25 + 1);
+  assertEqual(statistics.countOfDelayedEdgesOutsideOfTolerance, 0);
+}
+
+test(HybridWait_ShouldLearnSleepLatenessChangedAfterCalibration)
+{
+  // given
+  SimulatedClock clock(3, 4, 12, 20);
+  RC433HQTransmitter transmitter(10, clock);
+  transmitter.Calibrate();
+  clock.sleepOverheadUs = 40;
+  RC433HQTransmissionQualityStatistics firstStatistics, secondStatistics;
+
+  // when
+  TransmitEmosFrames(transmitter, firstStatistics);
+  TransmitEmosFrames(transmitter, secondStatistics);
+
+  // then
+  ASSERT_LE_3(firstStatistics.countOfDelayedEdgesOutsideOfTolerance, size_t(8), "only the first edges are late");
+  assertEqual(secondStatistics.countOfDelayedEdgesOutsideOfTolerance, 0);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQLinkQualityTracker tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(LinkQualityTracker_ShouldClampCapacityToWordIndexes)
+{
+  // given
+  RC433HQLinkQualityTracker links(100000);
+
+  // when
+  for (uint32_t address = 0; address < 0x8000; address++) {
+    links.Update(0, address, RC433HQExtendedMicroseconds(uint64_t(address) * 1000000), 90.0);
+  }
+
+  // then
+  RC433HQLinkQuality link;
+  assertEqual(links.GetCapacity(), RC433HQLinkQualityTracker::MAX_CAPACITY);
+  assertEqual(links.GetLinksCount(), RC433HQLinkQualityTracker::MAX_CAPACITY);
+  assertEqual(links.GetEvictedCount(), 1UL);
+  assertFalse(links.FindLink(0, 0, link));
+  assertTrue(links.FindLink(0, 0x7fff, link));
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQLinkQualityExport tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(LinkQualityExport_ShouldWriteWeakestLinkFirst)
+{
+  // given
+  RC433HQLinkQualityTracker links(4);
+  for (uint64_t second = 0; second < 10; second++) {
+    links.Update(0, 0x111, RC433HQExtendedMicroseconds(second * 1000000), 90.0);
+    links.Update(1, 0x222, RC433HQExtendedMicroseconds(second * 1000000 + 1000), 30.0);
+    links.Update(0, 0x333, RC433HQExtendedMicroseconds(second * 1000000 + 2000), 60.0);
+  }
+  FILE *file = tmpfile();
+
+  // when
+  bool written = RC433HQWriteLinkQualityCsv(links, file);
+
+  // then
+  assertTrue(written);
+  rewind(file);
+  std::vector<std::string> lines;
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    lines.push_back(line);
+  }
+  fclose(file);
+  assertEqual(lines.size(), size_t(4));
+  assertEqual(lines[0].compare(0, 26, "protocol,address,quality,f"), 0);
+  assertEqual(lines[1], std::string("1,0x222,30.00,1000,9001000,10,10,60.000,1000,0,0.0000\n"));
+  assertEqual(lines[2].compare(0, 14, "0,0x333,60.00,"), 0);
+  assertEqual(lines[3].compare(0, 14, "0,0x111,90.00,"), 0);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameJournal tests
+//////////////////////////////////////////////////////////////////////////////////
+
+// collects the records read from the journal
+class JournalRecordCollector: public IRC433JournalRecordHandler {
+public:
+  std::vector<RC433HQJournalRecord> records;
+
+  virtual void HandleRecord(const RC433HQJournalRecord &record) { records.push_back(record); }
+};
+
+// temporary directory of the journal segments, removed with them at the end of the test
+class JournalDirectory {
+public:
+  char directory[64];
+  std::string prefix;
+
+  JournalDirectory()
+  {
+    strcpy(directory, "/tmp/rc433hq_journalXXXXXX");
+    if (mkdtemp(directory)) {
+      prefix = std::string(directory) + "/frames";
+    }
+  }
+
+  ~JournalDirectory()
+  {
+    char fileName[256];
+    for (unsigned long segment = 0; RC433HQGetJournalSegmentName(prefix.c_str(), segment, fileName, sizeof(fileName)) && (unlink(fileName) == 0); segment++) {
+    }
+    rmdir(directory);
+  }
+};
+
+// frame i of the journal tests: 24 bits, the time grows by 10 ms
+static void WriteJournalFrames(RC433HQFrameJournalWriter &journal, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    byte data[3] = { byte(i >> 16), byte(i >> 8), byte(i) };
+    journal.Append(RC433HQExtendedMicroseconds(uint64_t(i) * 10000 + 5000000000ULL), byte(i & 1), data, 24, double(i % 101));
+  }
+}
+
+test(FrameJournal_ShouldRotateSegmentsAndReadAllRecords)
+{
+  // given
+  JournalDirectory directory;
+  RC433HQFrameJournalOptions options;
+  options.blockRecords = 1000;
+  options.segmentRecords = 30000;
+  options.syncIntervalMs = 0;
+  RC433HQFrameJournalWriter journal;
+
+  // when
+  assertTrue(journal.Open(directory.prefix.c_str(), options));
+  WriteJournalFrames(journal, 100000);
+  journal.Close();
+  RC433HQFrameJournalReader reader;
+  assertTrue(reader.Open(directory.prefix.c_str()));
+  JournalRecordCollector collector;
+  unsigned long long count = reader.Scan(collector);
+
+  // then
+  assertEqual(journal.GetSegmentsCount(), 4UL);
+  assertFalse(journal.HasFailed());
+  assertMoreOrEqual(journal.GetSyncsCount(), 100UL);
+  assertEqual(reader.GetSegmentsCount(), size_t(4));
+  assertEqual(count, 100000ULL);
+  assertEqual(reader.GetInvalidRecordsCount(), 0UL);
+  for (size_t i = 0; i < collector.records.size(); i++) {
+    const RC433HQJournalRecord &record = collector.records[i];
+    assertEqual(record.time.GetUnsignedLongLong(), uint64_t(i) * 10000 + 5000000000ULL);
+    assertEqual(record.protocol, byte(i & 1));
+    assertEqual(record.bits, 24);
+    assertEqual(record.quality, double(i % 101));
+    assertEqual(record.data[0], byte(i >> 16));
+    assertEqual(record.data[1], byte(i >> 8));
+    assertEqual(record.data[2], byte(i));
+  }
+}
+
+// count of the records of the journal readable from the disk
+static unsigned long long CountJournalRecords(const char *prefix)
+{
+  RC433HQFrameJournalReader reader;
+  JournalRecordCollector collector;
+  return reader.Open(prefix)? reader.Scan(collector): 0;
+}
+
+test(FrameJournal_ShouldWritePartialBlockAfterSyncInterval)
+{
+  // given
+  JournalDirectory directory;
+  RC433HQFrameJournalOptions options;
+  options.syncIntervalMs = 20;
+  RC433HQFrameJournalWriter journal;
+  assertTrue(journal.Open(directory.prefix.c_str(), options));
+
+  // when
+  WriteJournalFrames(journal, 1);
+  unsigned long long bufferedCount = CountJournalRecords(directory.prefix.c_str());
+  usleep(30000);
+  WriteJournalFrames(journal, 1);
+  unsigned long long appendedCount = CountJournalRecords(directory.prefix.c_str());
+  unsigned long appendedSyncsCount = journal.GetSyncsCount();
+  WriteJournalFrames(journal, 1);
+  usleep(30000);
+  assertTrue(journal.Update());
+  unsigned long long updatedCount = CountJournalRecords(directory.prefix.c_str());
+
+  // then
+  assertEqual(bufferedCount, 0ULL);
+  assertEqual(appendedCount, 2ULL);
+  assertEqual(appendedSyncsCount, 1UL);
+  assertEqual(updatedCount, 3ULL);
+  assertEqual(journal.GetSyncsCount(), 2UL);
+}
+
+test(FrameJournal_ShouldFindTimeRangeAcrossSegments)
+{
+  // given
+  JournalDirectory directory;
+  RC433HQFrameJournalOptions options;
+  options.segmentRecords = 30000;
+  RC433HQFrameJournalWriter journal;
+  assertTrue(journal.Open(directory.prefix.c_str(), options));
+  WriteJournalFrames(journal, 100000);
+  journal.Close();
+  RC433HQFrameJournalReader reader;
+  assertTrue(reader.Open(directory.prefix.c_str()));
+
+  // when
+  // the frames 29990 (in the first segment) up to 30999 (in the second segment), the end is exclusive
+  JournalRecordCollector collector;
+  unsigned long long count = reader.Find(RC433HQExtendedMicroseconds(29990ULL * 10000 + 5000000000ULL - 1),
+                                         RC433HQExtendedMicroseconds(31000ULL * 10000 + 5000000000ULL), collector);
+  JournalRecordCollector emptyCollector;
+  unsigned long long emptyCount = reader.Find(RC433HQExtendedMicroseconds(uint64_t(0)), RC433HQExtendedMicroseconds(5000000000ULL), emptyCollector);
+
+  // then
+  assertEqual(count, 1010ULL);
+  assertEqual(collector.records.front().time.GetUnsignedLongLong(), 29990ULL * 10000 + 5000000000ULL);
+  assertEqual(collector.records.back().time.GetUnsignedLongLong(), 30999ULL * 10000 + 5000000000ULL);
+  assertEqual(emptyCount, 0ULL);
+}
+
+test(FrameJournal_ShouldIgnoreInterruptedLastRecordAndStartNewSegment)
+{
+  // given
+  JournalDirectory directory;
+  RC433HQFrameJournalWriter journal;
+  assertTrue(journal.Open(directory.prefix.c_str()));
+  WriteJournalFrames(journal, 10);
+  journal.Close();
+
+  // the last record is cut in the middle (interrupted write)
+  char fileName[256];
+  RC433HQGetJournalSegmentName(directory.prefix.c_str(), 0, fileName, sizeof(fileName));
+  assertEqual(truncate(fileName, RC433HQ_JOURNAL_HEADER_SIZE + 9 * RC433HQ_JOURNAL_RECORD_SIZE + 20), 0);
+
+  // when
+  assertTrue(journal.Open(directory.prefix.c_str()));
+  WriteJournalFrames(journal, 5);
+  journal.Close();
+  RC433HQFrameJournalReader reader;
+  assertTrue(reader.Open(directory.prefix.c_str()));
+  JournalRecordCollector collector;
+  unsigned long long count = reader.Scan(collector);
+
+  // then
+  assertEqual(journal.GetSegment(), 1UL);
+  assertEqual(reader.GetSegmentsCount(), size_t(2));
+  assertEqual(count, 14ULL);
+  assertEqual(reader.GetInvalidRecordsCount(), 0UL);
+}
+
+test(FrameJournal_ShouldSkipSegmentWithoutHeader)
+{
+  // given
+  JournalDirectory directory;
+  RC433HQFrameJournalWriter journal;
+  assertTrue(journal.Open(directory.prefix.c_str()));
+  WriteJournalFrames(journal, 10);
+  journal.Close();
+
+  // the writer crashed after creating the segment 1 and before writing its header
+  char fileName[256];
+  RC433HQGetJournalSegmentName(directory.prefix.c_str(), 1, fileName, sizeof(fileName));
+  FILE *file = fopen(fileName, "wb");
+  assertTrue(file != 0);
+  fclose(file);
+
+  // when
+  assertTrue(journal.Open(directory.prefix.c_str()));
+  WriteJournalFrames(journal, 5);
+  journal.Close();
+  RC433HQFrameJournalReader reader;
+  assertTrue(reader.Open(directory.prefix.c_str()));
+  JournalRecordCollector collector;
+  unsigned long long count = reader.Scan(collector);
+
+  // then
+  assertEqual(journal.GetSegment(), 2UL);
+  assertEqual(reader.GetSegmentsCount(), size_t(2));
+  assertEqual(reader.GetInvalidSegmentsCount(), 1UL);
+  assertEqual(count, 15ULL);
+}
+
+test(FrameJournal_ShouldFindRecordsWrittenAfterRestartWithEarlierTimes)
+{
+  // given
+  JournalDirectory directory;
+  RC433HQFrameJournalWriter journal;
+  const byte data[3] = { 0x38, 0xcb, 0xbe };
+
+  // the first run ends after 5000 s, the time extender of the second run starts over from 0
+  assertTrue(journal.Open(directory.prefix.c_str()));
+  WriteJournalFrames(journal, 10);
+  journal.Close();
+  assertTrue(journal.Open(directory.prefix.c_str()));
+  for (uint64_t i = 0; i < 10; i++) {
+    journal.Append(RC433HQExtendedMicroseconds(i * 1000000 + 1000000), 0, data, 24, 90.0);
+  }
+  journal.Close();
+  RC433HQFrameJournalReader reader;
+  assertTrue(reader.Open(directory.prefix.c_str()));
+
+  // when
+  JournalRecordCollector secondRunCollector, firstRunCollector;
+  unsigned long long secondRunCount = reader.Find(RC433HQExtendedMicroseconds(3000000ULL), RC433HQExtendedMicroseconds(6000000ULL), secondRunCollector);
+  unsigned long long firstRunCount = reader.Find(RC433HQExtendedMicroseconds(5000000000ULL), RC433HQExtendedMicroseconds(5000020000ULL), firstRunCollector);
+
+  // then
+  assertEqual(reader.GetSegmentsCount(), size_t(2));
+  assertEqual(secondRunCount, 3ULL);
+  assertEqual(secondRunCollector.records[0].time.GetUnsignedLongLong(), 3000000ULL);
+  assertEqual(firstRunCount, 2ULL);
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQLiveEdgeSource tests
+//////////////////////////////////////////////////////////////////////////////////
+
+// writes the edges as the events of the format into the descriptor in chunks of the given size (splitting the events)
+static void WriteLiveEdges(int fd, const RC433HQEdgeStream &edges, RC433HQLiveEdgeFormat format, size_t chunkSize, uint32_t skippedSequence = 0xffffffffUL)
+{
+  size_t edgeSize = RC433HQGetLiveEdgeSize(format);
+  std::vector<byte> events;
+  uint32_t sequence = 1;
+  for (size_t i = 0; i < edges.size(); i++, sequence++) {
+    if (sequence == skippedSequence) {
+      sequence++;
+    }
+    events.resize(events.size() + edgeSize);
+    RC433HQEncodeLiveEdge(format, edges[i].time, edges[i].direction, sequence, &events[events.size() - edgeSize]);
+  }
+  for (size_t offset = 0; offset < events.size(); ) {
+    size_t size = std::min(chunkSize, events.size() - offset);
+    ssize_t written = write(fd, &events[offset], size);
+    if (written <= 0) {
+      break;
+    }
+    offset += size_t(written);
+  }
+}
+
+// counts the timer calls and stops the loop after the given count
+class StoppingTimerHandler: public IRC433TimerHandler {
+public:
+  RC433HQEventLoop &loop;
+  size_t calls;
+  size_t stopAfter;
+
+  StoppingTimerHandler(RC433HQEventLoop &aloop, size_t astopAfter): loop(aloop), calls(0), stopAfter(astopAfter) {}
+
+  virtual void HandleTimer()
+  {
+    if (++calls == stopAfter) {
+      loop.Stop();
+    }
+  }
+};
+
+test(LiveEdgeSource_ShouldDecodeGpioEventsFromSimulatorPipe)
+{
+  // given
+  EmosTrafficProtocols protocols;
+  RC433HQTrafficGenerator generator(RC433HQTrafficGenerator::NoImpairments());
+  for (unsigned long transmission = 0; transmission < 20; transmission++) {
+    byte data[3] = { byte(transmission), 0xcb, 0xbe };
+    generator.AddTransmission(1000 + transmission * 500000, protocols.protocolA, data);
+  }
+  RC433HQEdgeStream edges;
+  RC433HQTrafficFrames groundTruth;
+  generator.Generate(edges, groundTruth);
+  EmosTrafficDecoders reference;
+  RC433HQSendEdges(edges, reference.filter);
+
+  EmosTrafficDecoders decoders;
+  int fds[2];
+  assertEqual(pipe(fds), 0);
+  RC433HQLiveEdgeSource source(decoders.filter, fds[0], RC433HQ_LIVE_EDGE_GPIO_V2);
+  RC433HQEventLoop loop;
+  assertTrue(loop.AddEdgeSource(source));
+
+  // when
+  // the simulator writes the events in chunks splitting them, then closes the pipe
+  std::thread simulator([&]() { WriteLiveEdges(fds[1], edges, RC433HQ_LIVE_EDGE_GPIO_V2, 1000); close(fds[1]); });
+  loop.Run();
+  simulator.join();
+  close(fds[0]);
+
+  // then
+  assertTrue(source.IsAtEnd());
+  assertFalse(source.HasFailed());
+  assertEqual(source.GetEdgesCount(), (unsigned long long)edges.size());
+  assertEqual(source.GetMissedEdgesCount(), 0UL);
+  assertMore(reference.decodedFrames.size(), size_t(0));
+  assertEqual(decoders.decodedFrames.size(), reference.decodedFrames.size());
+  for (size_t i = 0; i < decoders.decodedFrames.size(); i++) {
+    assertEqual(decoders.decodedFrames[i].time, reference.decodedFrames[i].time);
+    assertEqual(memcmp(decoders.decodedFrames[i].data, reference.decodedFrames[i].data, 3), 0);
+  }
+}
+
+test(LiveEdgeSource_ShouldReportSequenceGapAsMissedEdges)
+{
+  // given
+  EdgeCollector collector;
+  RC433HQEdgeStream edges;
+  for (unsigned long i = 0; i < 10; i++) {
+    RC433HQEdge edge = { RC433HQMicroseconds(i * 100), (i % 2) == 0 };
+    edges.push_back(edge);
+  }
+  int fds[2];
+  assertEqual(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  RC433HQLiveEdgeSource source(collector, fds[0], RC433HQ_LIVE_EDGE_COMPACT);
+  RC433HQEventLoop loop;
+  assertTrue(loop.AddEdgeSource(source));
+
+  // when
+  // the event with the sequence number 5 is lost
+  WriteLiveEdges(fds[1], edges, RC433HQ_LIVE_EDGE_COMPACT, 4096, 5);
+  close(fds[1]);
+  loop.Run();
+  close(fds[0]);
+
+  // then
+  collector.AssertEdges(edges);
+  assertEqual(collector.missedEdgesCalls, size_t(1));
+  assertEqual(source.GetMissedEdgesCount(), 1UL);
+}
+
+test(EventLoop_ShouldCallTimerWhileWaitingForEdges)
+{
+  // given
+  EdgeCollector collector;
+  int fds[2];
+  assertEqual(pipe(fds), 0);
+  RC433HQLiveEdgeSource source(collector, fds[0], RC433HQ_LIVE_EDGE_COMPACT);
+  RC433HQEventLoop loop;
+  StoppingTimerHandler timer(loop, 3);
+  assertTrue(loop.AddEdgeSource(source));
+  assertTrue(loop.AddTimer(timer, 2_ms));
+
+  // when
+  loop.Run();
+  close(fds[1]);
+  close(fds[0]);
+
+  // then
+  // the loop slept between the timer expirations instead of polling
+  assertEqual(timer.calls, size_t(3));
+  assertEqual(loop.GetWakeUpsCount(), 4UL);
+  assertFalse(source.IsAtEnd());
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Test driver infrastructure
+//////////////////////////////////////////////////////////////////////////////////
+
+void setup()
+{
+  Serial.begin(9600);
+  while(!Serial) {}
+
+  Test::min_verbosity |= TEST_VERBOSITY_ASSERTIONS_FAILED;
+}
+
+void loop()
+{
+  Test::run();
+}
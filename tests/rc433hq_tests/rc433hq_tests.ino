@@ -58,10 +58,12 @@ private:
   bool edges[8];
   size_t pos;
   bool handleMissedEdgesCalled;
+  size_t handleMissedEdgesPos;
 public:
 	PulseDecoderMock():
     pos(0),
-    handleMissedEdgesCalled(false)
+    handleMissedEdgesCalled(false),
+    handleMissedEdgesPos(0)
   {
   }
 
@@ -80,6 +82,7 @@ public:
   virtual void HandleMissedEdges()
   {
     handleMissedEdgesCalled = true;
+    handleMissedEdgesPos = pos;
   }
 
   void AssertHandleEdgeCalled(RC433HQMicroseconds expectedTimes[], bool expectedEdges[], size_t expectedEdgesCount)
@@ -100,6 +103,52 @@ public:
   {
     assertEqual(handleMissedEdgesCalled, true);
   }
+
+  void AssertHandleMissedEdgesCalledAfter(size_t expectedEdgesCount)
+  {
+    assertEqual(handleMissedEdgesCalled, true);
+    assertEqual(handleMissedEdgesPos, expectedEdgesCount);
+  }
+};
+
+class AlternatingEdgesChecker: public IRC433PulseProcessor {
+private:
+  RC433HQMicrosecondsDiff expectedDelay;
+  RC433HQMicroseconds lastTime;
+  size_t count;
+  bool valid;
+public:
+  AlternatingEdgesChecker(RC433HQMicrosecondsDiff aexpectedDelay):
+    expectedDelay(aexpectedDelay),
+    lastTime(0),
+    count(0),
+    valid(true)
+  {
+  }
+
+  virtual void HandleEdge(RC433HQMicroseconds time, bool direction)
+  {
+    // the edges must alternate starting with rising one and come the expected delay apart
+    if (direction != ((count % 2) == 0)) {
+      valid = false;
+    }
+    if ((0 < count) && ((time - lastTime).GetUnsignedLong() != expectedDelay.GetUnsignedLong())) {
+      valid = false;
+    }
+    lastTime = time;
+    count++;
+  }
+
+  virtual void HandleMissedEdges()
+  {
+    valid = false;
+  }
+
+  void AssertEdgesChecked(size_t expectedCount)
+  {
+    assertEqual(count, expectedCount);
+    assertEqual(valid, true);
+  }
 };
 
 class DataReceiverMock: public IRC433DataReceiver {
@@ -143,6 +192,86 @@ public:
   }
 };
 
+class ExtendedDataReceiverMock: public DataReceiverMock {
+private:
+  RC433HQExtendedMicroseconds storedExtendedTime;
+public:
+  virtual void HandleExtendedData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, double quality)
+  {
+    storedExtendedTime = time;
+    DataReceiverMock::HandleExtendedData(time, data, bits, quality);
+  }
+
+  void AssertExtendedTime(RC433HQExtendedMicroseconds expectedTime)
+  {
+    assertEqual(storedExtendedTime.GetUnsignedLongLong(), expectedTime.GetUnsignedLongLong());
+  }
+};
+
+class SoftDataReceiverMock: public DataReceiverMock {
+private:
+  RC433HQExtendedMicroseconds storedSoftTime;
+  byte storedConfidences[16 * 8];
+  size_t softDataCalls;
+public:
+  SoftDataReceiverMock():
+    softDataCalls(0)
+  {
+  }
+
+  virtual void HandleSoftData(RC433HQExtendedMicroseconds time, const byte *data, size_t bits, const byte *confidences, double quality)
+  {
+    softDataCalls++;
+    storedSoftTime = time;
+    if (confidences) {
+      memcpy(storedConfidences, confidences, (bits < sizeof(storedConfidences))? bits: sizeof(storedConfidences));
+    }
+    DataReceiverMock::HandleSoftData(time, data, bits, confidences, quality);
+  }
+
+  void AssertConfidences(const byte *expectedConfidences, size_t expectedBits)
+  {
+    for (size_t i = 0; i < expectedBits; i++) {
+      assertEqual(storedConfidences[i], expectedConfidences[i]);
+    }
+  }
+
+  void AssertSoftDataCalled(size_t expectedCalls, RC433HQExtendedMicroseconds expectedTime)
+  {
+    assertEqual(softDataCalls, expectedCalls);
+    assertEqual(storedSoftTime.GetUnsignedLongLong(), expectedTime.GetUnsignedLongLong());
+  }
+};
+
+class CaptureSinkMock: public IRC433CaptureSink {
+private:
+  byte storedData[64];
+  size_t storedSize;
+public:
+  CaptureSinkMock():
+    storedSize(0)
+  {
+  }
+
+  virtual void WriteCaptureData(const byte *data, size_t size)
+  {
+    for (size_t i = 0; i < size; i++) {
+      if (storedSize < sizeof(storedData)) {
+        storedData[storedSize] = data[i];
+      }
+      storedSize++;
+    }
+  }
+
+  void AssertDataWritten(const byte *expectedData, size_t expectedSize)
+  {
+    assertEqual(storedSize, expectedSize);
+    for (size_t i = 0; i < storedSize; i++) {
+      assertEqual(storedData[i], expectedData[i]);
+    }
+  }
+};
+
 class TransmitterMock: public RC433HQDataTransmitterBase {
 private:
   size_t bufferCapacity;
@@ -185,6 +314,238 @@ public:
   }
 };
 
+//////////////////////////////////////////////////////////////////////////////////
+// Time types tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(TimeTypes_ShouldEvaluateDurationLiteralsAtCompileTime)
+{
+  // given
+  constexpr RC433HQMicroseconds start = 0xfffffff0UL;
+  constexpr RC433HQMicroseconds end = start + 272_us + 2_ms;
+
+  // then
+  static_assert(end.GetUnsignedLong() == 2256, "the time wraps around at 32 bits");
+  static_assert((end - start) == 2272_us, "the difference is wrap-safe");
+  static_assert(start.IsBefore(end) && !end.IsBefore(start), "the ordering is wrap-safe");
+  static_assert(RC433HQExtendedMicroseconds(1, end).GetMicroseconds() == end, "");
+  assertEqual((end - start).GetUnsignedLong(), 2272UL);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQTimeExtender tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(TimeExtender_ShouldIncreaseEpochOnWrapAround)
+{
+  // given
+  RC433HQTimeExtender extender;
+
+  // when
+  extender.Update(0xfffffff0UL);
+  extender.Update(0x00000010UL);
+
+  // then
+  RC433HQExtendedMicroseconds extended = extender.Extend(0x00000020UL);
+  assertEqual(extended.GetEpoch(), 1);
+  assertEqual(extended.GetMicroseconds(), RC433HQMicroseconds(0x00000020UL));
+}
+
+test(TimeExtender_ShouldExtendTimeBeforeWrapAroundIntoPreviousEpoch)
+{
+  // given
+  RC433HQTimeExtender extender;
+
+  // when
+  extender.Update(0xfffffff0UL);
+  extender.Update(0x00000010UL);
+
+  // then
+  RC433HQExtendedMicroseconds extended = extender.Extend(0xffffff00UL);
+  assertEqual(extended.GetEpoch(), 0);
+  assertEqual(extended.GetMicroseconds(), RC433HQMicroseconds(0xffffff00UL));
+}
+
+test(TimeExtender_ShouldIgnoreOlderTimes)
+{
+  // given
+  RC433HQTimeExtender extender;
+
+  // when
+  extender.Update(0x00001000UL);
+  extender.Update(0x00000010UL);
+
+  // then
+  RC433HQExtendedMicroseconds extended = extender.Extend(0x00002000UL);
+  assertEqual(extended.GetEpoch(), 0);
+  assertEqual(extended.GetMicroseconds(), RC433HQMicroseconds(0x00002000UL));
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQDurationStatistics tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(DurationStatistics_ShouldKeepMinMaxAndAverage)
+{
+  // given
+  RC433HQDurationStatistics statistics;
+
+  // when
+  statistics.Add(30);
+  statistics.Add(10);
+  statistics.Add(20);
+
+  // then
+  assertEqual(statistics.GetCount(), 3);
+  assertEqual(statistics.GetMinTicks(), 10);
+  assertEqual(statistics.GetMaxTicks(), 30);
+  assertEqual(statistics.GetAverageTicks(), 20.0);
+}
+
+test(DurationStatistics_ShouldCountDurationsIntoLog2Buckets)
+{
+  // given
+  RC433HQDurationStatistics statistics;
+
+  // when
+  statistics.Add(0);
+  statistics.Add(1);
+  statistics.Add(4);
+  statistics.Add(7);
+  statistics.Add(0xffffffffUL);
+
+  // then
+  assertEqual(statistics.GetHistogramCount(0), 1);
+  assertEqual(statistics.GetHistogramCount(1), 1);
+  assertEqual(statistics.GetHistogramCount(3), 2);
+  assertEqual(statistics.GetHistogramCount(statistics.GetHistogramSize() - 1), 1);
+  assertEqual(statistics.GetBucketMinTicks(3), 4);
+}
+
+#if defined(RC433HQ_PROFILE)
+test(Profiler_ShouldMeasureSectionsWithDisabledInterrupts)
+{
+  // given
+  PulseDecoderMock mock;
+  RC433HQPulseBuffer buffer(mock, 6);
+  TestingPulseGenerator generator(buffer);
+  generator.SendEdge(true, 9);
+  generator.SendEdge(false, 10);
+  RC433HQProfiler::Reset();
+
+  // when
+  size_t reportedBufferUsedCount = 0;
+  size_t reportedProcessedCount = 0;
+  size_t reportedMissedCount = 0;
+  buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+
+  // then
+  RC433HQDurationStatistics statistics;
+  RC433HQProfiler::GetMaskedSectionStatistics(statistics);
+  assertEqual(statistics.GetCount(), 2);
+}
+#endif // defined(RC433HQ_PROFILE)
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPulseFanOut tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(PulseFanOut_ShouldPassEdgesToAllProcessors)
+{
+  // given
+  PulseDecoderMock mock1, mock2, mock3, mock4;
+  RC433HQPulseFanOut<3> fanOut;
+  assertTrue(fanOut.Add(mock1));
+  assertTrue(fanOut.Add(mock2));
+  assertTrue(fanOut.Add(mock3));
+  assertFalse(fanOut.Add(mock4));
+  TestingPulseGenerator generator(fanOut);
+
+  // when
+  generator.SendEdge(true, 10);
+  generator.SendEdge(false, 20);
+  fanOut.HandleMissedEdges();
+
+  // then
+  RC433HQMicroseconds expectedTimes[] = { 0, 10 };
+  bool expectedEdges[] = { true, false };
+  mock1.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 2);
+  mock2.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 2);
+  mock3.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 2);
+  mock1.AssertHandleMissedEdgesCalledAfter(2);
+  mock3.AssertHandleMissedEdgesCalledAfter(2);
+  assertEqual(fanOut.GetProcessorsCount(), 3);
+  assertFalse(fanOut.IsAttached(mock4));
+}
+
+test(PulseFanOut_ShouldResetReattachedProcessorBeforeItsNextEdge)
+{
+  // given
+  PulseDecoderMock mock1, mock2, mock3;
+  RC433HQPulseFanOut<2> fanOut;
+  fanOut.Add(mock1);
+  fanOut.Add(mock2, false);
+  TestingPulseGenerator generator(fanOut);
+
+  // when
+  generator.SendEdge(true, 10);
+  assertTrue(fanOut.Attach(mock2));
+  assertTrue(fanOut.Detach(mock1));
+  generator.SendEdge(false, 20);
+  generator.SendEdge(true, 30);
+
+  // then
+  RC433HQMicroseconds expectedTimes1[] = { 0 };
+  bool expectedEdges1[] = { true };
+  mock1.AssertHandleEdgeCalled(expectedTimes1, expectedEdges1, 1);
+  mock1.AssertHandleMissedEdgesNotCalled();
+  RC433HQMicroseconds expectedTimes2[] = { 10, 30 };
+  bool expectedEdges2[] = { false, true };
+  mock2.AssertHandleEdgeCalled(expectedTimes2, expectedEdges2, 2);
+  mock2.AssertHandleMissedEdgesCalledAfter(0);
+  assertFalse(fanOut.IsAttached(mock1));
+  assertTrue(fanOut.IsAttached(mock2));
+  assertFalse(fanOut.Attach(mock3));
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// Statically composed chain tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(StaticChain_ShouldFilterBufferAndSplitEdges)
+{
+  // given
+  typedef RC433HQStaticSplitter<PulseDecoderMock, PulseDecoderMock> Splitter;
+  typedef RC433HQStaticPulseBuffer<Splitter> Buffer;
+  PulseDecoderMock mock1, mock2;
+  Splitter splitter(mock1, mock2);
+  Buffer buffer(splitter, 3);
+  RC433HQStaticNoiseFilter<Buffer> filter(buffer, 50);
+  TestingPulseGenerator generator(filter);
+  size_t reportedBufferUsedCount = 0;
+  size_t reportedProcessedCount = 0;
+  size_t reportedMissedCount = 0;
+
+  // when
+  generator.SendEdge(true, 100);    // stored as the absolute time, fills the buffer
+  generator.SendEdge(false, 100);   // missed
+  generator.GeneratePulse(5, 100);  // noise
+  buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+  assertEqual(reportedProcessedCount, 1);
+  assertEqual(reportedMissedCount, 1);
+  generator.SendEdge(true, 100);
+  generator.SendEdge(false, 0);
+  buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+
+  // then
+  RC433HQMicroseconds expectedTimes[] = { 0, 305 };
+  bool expectedEdges[] = { true, true };
+  mock1.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 2);
+  mock2.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 2);
+  mock1.AssertHandleMissedEdgesCalledAfter(1);
+  mock2.AssertHandleMissedEdgesCalledAfter(1);
+}
+
 //////////////////////////////////////////////////////////////////////////////////
 // RC433HQPulseBuffer tests
 //////////////////////////////////////////////////////////////////////////////////
@@ -238,6 +599,33 @@ test(RC433HQPulseBuffer_ShouldRemember4EdgesInSize6Buffer)
   mock.AssertHandleMissedEdgesNotCalled();
 }
 
+test(RC433HQPulseBuffer_ShouldPassEdgesAcrossWrapOfSize6Buffer)
+{
+  // given
+  AlternatingEdgesChecker checker(9);
+  RC433HQPulseBuffer buffer(checker, 6);
+  TestingPulseGenerator generator(buffer);
+
+  // when
+  size_t reportedBufferUsedCount = 0;
+  size_t reportedProcessedCount = 0;
+  size_t reportedMissedCount = 0;
+  size_t processedCount = 0;
+  for (size_t i = 0; i < 10; i++) {
+    generator.SendEdge(true, 9);
+    generator.SendEdge(false, 9);
+    generator.SendEdge(true, 9);
+    generator.SendEdge(false, 9);
+    buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+    processedCount += reportedProcessedCount;
+    assertEqual(reportedMissedCount, 0);
+  }
+
+  // then
+  checker.AssertEdgesChecked(40);
+  assertEqual(processedCount, 40);
+}
+
 test(RC433HQPulseBuffer_ShouldForget4EdgesInSize6Buffer)
 {  
   // given
@@ -268,69 +656,251 @@ test(RC433HQPulseBuffer_ShouldForget4EdgesInSize6Buffer)
   mock.AssertHandleMissedEdgesCalled();
 }
 
-//////////////////////////////////////////////////////////////////////////////////
-// RC433HQNoiseFilter tests
-//////////////////////////////////////////////////////////////////////////////////
-
-test(NoiseFilter_ShouldForwardSlowPulse)
+test(RC433HQPulseBuffer_ShouldProcessAtMostMaxEdgesPerCall)
 {  
   // given
   PulseDecoderMock mock;
-  RC433HQNoiseFilter filter(mock, 3);
-  TestingPulseGenerator generator(filter);
+  RC433HQPulseBuffer buffer(mock, 6);
+  TestingPulseGenerator generator(buffer);
+  generator.SendEdge(true, 9);
+  generator.SendEdge(false, 9);
+  generator.SendEdge(true, 9);
+  generator.SendEdge(false, 9);
+  size_t reportedBufferUsedCount = 0;
+  size_t reportedProcessedCount = 0;
+  size_t reportedMissedCount = 0;
 
   // when
-  generator.GeneratePulses(10, 10, 2);
+  bool firstDataRemaining = buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount, 3, 0);
+  size_t firstProcessedCount = reportedProcessedCount;
+  bool secondDataRemaining = buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount, 3, 0);
 
   // then
-  RC433HQMicroseconds expectedTimes[] = { 0, 10, 20 };
-  bool expectedEdges[] = { true, false, true};
-  mock.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 3);
+  RC433HQMicroseconds expectedTimes[] = { 0, 9, 18, 27 };
+  bool expectedEdges[] = { true, false, true, false };
+  mock.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 4);
+  assertEqual(firstDataRemaining, true);
+  assertEqual(firstProcessedCount, 3);
+  assertEqual(secondDataRemaining, false);
+  assertEqual(reportedProcessedCount, 1);
 }
 
-test(NoiseFilter_ShouldElimitateNoiseBeforeDownEdge)
+test(RC433HQPulseBuffer_ShouldReportMissedEdgesInOrderAcrossLimitedCalls)
 {  
   // given
   PulseDecoderMock mock;
-  RC433HQNoiseFilter filter(mock, 3);
-  TestingPulseGenerator generator(filter);
+  RC433HQPulseBuffer buffer(mock, 6);
+  TestingPulseGenerator generator(buffer);
+  generator.SendEdge(true, 9);
+  generator.SendEdge(false, 9);
+  generator.SendEdge(true, 9);
+  generator.SendEdge(false, 9);
+  generator.SendEdge(true, 9);
+  size_t reportedBufferUsedCount = 0;
+  size_t reportedProcessedCount = 0;
+  size_t reportedMissedCount = 0;
 
   // when
-  generator.SendEdge(true, 9);
-  generator.SendEdge(false, 0); // noise 
-  generator.SendEdge(true, 1);  // noise 
-  generator.SendEdge(false, 10);
-  generator.GeneratePulse(10, 10);
+  buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount, 1, 0);
+  buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount, 1, 0);
+  size_t firstMissedCount = reportedMissedCount;
+  generator.SendEdge(false, 9);
+  buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount, 0, 0);
 
   // then
-  RC433HQMicroseconds expectedTimes[] = { 0, 10, 20 };
-  bool expectedEdges[] = { true, false, true};
-  mock.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 3);
+  RC433HQMicroseconds expectedTimes[] = { 0, 9, 18, 27, 45 };
+  bool expectedEdges[] = { true, false, true, false, false };
+  mock.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 5);
+  assertEqual(firstMissedCount, 0);
+  mock.AssertHandleMissedEdgesCalledAfter(4);
 }
 
-test(NoiseFilter_ShouldIgnoreTheSameDirectionEdge)
-{  
+test(RC433HQPulseBuffer_ShouldRecordOccupancyAndOverflowEpisodes)
+{
   // given
   PulseDecoderMock mock;
-  RC433HQNoiseFilter filter(mock, 3);
-  TestingPulseGenerator generator(filter);
+  RC433HQPulseBuffer buffer(mock, 6);
+  TestingPulseGenerator generator(buffer);
+  size_t reportedBufferUsedCount = 0;
+  size_t reportedProcessedCount = 0;
+  size_t reportedMissedCount = 0;
 
   // when
-  generator.SendEdge(true, 5);
-  generator.SendEdge(false, 5); // noise 
-  generator.SendEdge(false, 10);
-  generator.GeneratePulse(10, 10);
+  generator.SendEdge(true, 9);          // absolute time, 3 words
+  generator.SendEdge(false, 9);
+  generator.SendEdge(true, 9);
+  generator.SendEdge(false, 9);         // the buffer is full
+  generator.SendEdge(true, 9);          // lost at 36
+  generator.SendEdge(false, 9);         // lost
+  buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+  generator.SendEdge(true, 9);          // stored at 54, ends the overflow
+  buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+  RC433HQPulseBufferStatistics statistics;
+  buffer.TakeStatistics(statistics);
+  RC433HQPulseBufferStatistics nextStatistics;
+  buffer.TakeStatistics(nextStatistics);
 
   // then
-  RC433HQMicroseconds expectedTimes[] = { 0, 10, 20 };
-  bool expectedEdges[] = { true, false, true};
-  mock.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 3);
+  assertEqual(statistics.highWaterMark, 6);
+  assertEqual(statistics.relativeEdges, 3);
+  assertEqual(statistics.absoluteEdges, 2);
+  assertEqual(statistics.occupancyHistogram[7], 1);
+  assertEqual(statistics.occupancyHistogram[4], 1);
+  assertEqual(statistics.lostEdges, 2);
+  assertEqual(statistics.overflowEpisodesCount, 1);
+  assertEqual(statistics.GetStoredOverflowEpisodesCount(), 1);
+  assertEqual(statistics.overflowEpisodes[0].startTime, RC433HQMicroseconds(36));
+  assertEqual(statistics.overflowEpisodes[0].duration, RC433HQMicrosecondsDiff(18));
+  assertEqual(statistics.overflowEpisodes[0].lostEdges, 2);
+  assertEqual(nextStatistics.highWaterMark, 0);
+  assertEqual(nextStatistics.overflowEpisodesCount, 0);
+  assertEqual(nextStatistics.occupancyHistogram[4], 0);
 }
 
-//////////////////////////////////////////////////////////////////////////////////
-// RC433HQBasicSyncPulseDecoder tests
-//////////////////////////////////////////////////////////////////////////////////
-
+test(RC433HQPulseBuffer_ShouldCarryUnfinishedOverflowEpisodeIntoNextStatistics)
+{
+  // given
+  PulseDecoderMock mock;
+  RC433HQPulseBuffer buffer(mock, 6);
+  TestingPulseGenerator generator(buffer);
+  size_t reportedBufferUsedCount = 0;
+  size_t reportedProcessedCount = 0;
+  size_t reportedMissedCount = 0;
+
+  // when
+  generator.SendEdge(true, 9);          // absolute time, 3 words
+  generator.SendEdge(false, 9);
+  generator.SendEdge(true, 9);
+  generator.SendEdge(false, 9);         // the buffer is full
+  generator.SendEdge(true, 9);          // lost at 36
+  generator.SendEdge(false, 9);         // lost
+  RC433HQPulseBufferStatistics statistics;
+  buffer.TakeStatistics(statistics);
+  generator.SendEdge(true, 9);          // lost
+  buffer.ProcessData(reportedBufferUsedCount, reportedProcessedCount, reportedMissedCount);
+  generator.SendEdge(false, 9);         // stored at 63, ends the overflow
+  RC433HQPulseBufferStatistics nextStatistics;
+  buffer.TakeStatistics(nextStatistics);
+
+  // then
+  assertEqual(statistics.lostEdges, 2);
+  assertEqual(statistics.overflowEpisodesCount, 0);
+  assertEqual(nextStatistics.lostEdges, 1);
+  assertEqual(nextStatistics.overflowEpisodesCount, 1);
+  assertEqual(nextStatistics.overflowEpisodes[0].startTime, RC433HQMicroseconds(36));
+  assertEqual(nextStatistics.overflowEpisodes[0].duration, RC433HQMicrosecondsDiff(27));
+  assertEqual(nextStatistics.overflowEpisodes[0].lostEdges, 3);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQPulseRecorder tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(PulseRecorder_ShouldWriteHeaderAbsoluteAndRelativeEdges)
+{
+  // given
+  CaptureSinkMock sink;
+  RC433HQPulseRecorder recorder(sink, 4000);
+
+  // when
+  recorder.HandleEdge(0x00012345UL, true);
+  recorder.HandleEdge(0x00012345UL + 300, false);
+  recorder.Flush();
+
+  // then
+  const byte expected[] = {
+    'R', 'Q', 'E', 'C', 0x01, 0x00, 0x10, 0x00, 0xa0, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // header
+    0xff, 0xff, 0x45, 0x23, 0x01, 0x00,                                                             // rising edge, absolute time
+    0x2c, 0x01                                                                                      // falling edge after 300 us
+  };
+  sink.AssertDataWritten(expected, sizeof(expected));
+}
+
+test(PulseRecorder_ShouldMarkMissedEdgesAndStoreNextEdgeAsAbsolute)
+{
+  // given
+  CaptureSinkMock sink;
+  RC433HQPulseRecorder recorder(sink, 1000);
+
+  // when
+  recorder.HandleEdge(0x00000010UL, true);
+  recorder.HandleMissedEdges();
+  recorder.HandleEdge(0x00000020UL, false);
+  recorder.Flush();
+
+  // then
+  const byte expected[] = {
+    'R', 'Q', 'E', 'C', 0x01, 0x00, 0x10, 0x00, 0xe8, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // header
+    0xff, 0xff, 0x10, 0x00, 0x00, 0x00,                                                             // rising edge, absolute time
+    0xfe, 0x7f,                                                                                     // missed edges
+    0xff, 0x7f, 0x20, 0x00, 0x00, 0x00                                                              // falling edge, absolute time
+  };
+  sink.AssertDataWritten(expected, sizeof(expected));
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQNoiseFilter tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(NoiseFilter_ShouldForwardSlowPulse)
+{  
+  // given
+  PulseDecoderMock mock;
+  RC433HQNoiseFilter filter(mock, 3);
+  TestingPulseGenerator generator(filter);
+
+  // when
+  generator.GeneratePulses(10, 10, 2);
+
+  // then
+  RC433HQMicroseconds expectedTimes[] = { 0, 10, 20 };
+  bool expectedEdges[] = { true, false, true};
+  mock.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 3);
+}
+
+test(NoiseFilter_ShouldElimitateNoiseBeforeDownEdge)
+{  
+  // given
+  PulseDecoderMock mock;
+  RC433HQNoiseFilter filter(mock, 3);
+  TestingPulseGenerator generator(filter);
+
+  // when
+  generator.SendEdge(true, 9);
+  generator.SendEdge(false, 0); // noise 
+  generator.SendEdge(true, 1);  // noise 
+  generator.SendEdge(false, 10);
+  generator.GeneratePulse(10, 10);
+
+  // then
+  RC433HQMicroseconds expectedTimes[] = { 0, 10, 20 };
+  bool expectedEdges[] = { true, false, true};
+  mock.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 3);
+}
+
+test(NoiseFilter_ShouldIgnoreTheSameDirectionEdge)
+{  
+  // given
+  PulseDecoderMock mock;
+  RC433HQNoiseFilter filter(mock, 3);
+  TestingPulseGenerator generator(filter);
+
+  // when
+  generator.SendEdge(true, 5);
+  generator.SendEdge(false, 5); // noise 
+  generator.SendEdge(false, 10);
+  generator.GeneratePulse(10, 10);
+
+  // then
+  RC433HQMicroseconds expectedTimes[] = { 0, 10, 20 };
+  bool expectedEdges[] = { true, false, true};
+  mock.AssertHandleEdgeCalled(expectedTimes, expectedEdges, 3);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQBasicSyncPulseDecoder tests
+//////////////////////////////////////////////////////////////////////////////////
+
 test(BasicPulseDecoder_ShouldDecodePreciseOneBitFollowedBySyncForMaxLen1)
 {
   // given
@@ -551,6 +1121,788 @@ test(BasicPulseDecoder_ShouldInorePrecise2OneBitsFollowedByInvalidSignalForMinLe
   dataReceiverMock.AssertHandleDataCalled(expected, 0);
 }
 
+test(BasicPulseDecoder_ShouldDeliverExtendedTimeOfTheSync)
+{
+  // given
+  ExtendedDataReceiverMock dataReceiverMock;
+  RC433HQBasicSyncPulseDecoder decoder(dataReceiverMock, 40, 40, 10, 30, 30, 10, 2, true, 1, 1);
+  RC433HQTimeExtender extender;
+  decoder.SetTimeExtender(extender);
+  TestingPulseGenerator generator(decoder);
+
+  // when
+  extender.Update(0xffffffffUL);
+  extender.Update(0x00000100UL);
+  generator.GeneratePulse(40, 40);      // sync
+  generator.GeneratePulse(30, 10);      // bit 1
+  generator.SendEdge(true, 0);          // last rising edge to allow detection of previous pulse
+
+  // then
+  byte expected[] = { 0x01 };
+  dataReceiverMock.AssertHandleDataCalled(expected, 1);
+  dataReceiverMock.AssertExtendedTime(RC433HQExtendedMicroseconds(1, 0));
+}
+
+test(BasicPulseDecoder_ShouldForgetBitsBeforeNonDataPulseBelowMinLen)
+{
+  // given
+  DataReceiverMock dataReceiverMock;
+  RC433HQBasicSyncPulseDecoder decoder(dataReceiverMock, 40, 40, 10, 30, 30, 10, 2, true, 4, 8);
+  TestingPulseGenerator generator(decoder);
+
+  // when
+  generator.GeneratePulse(40, 40);      // sync
+  generator.GeneratePulses(30, 10, 2);  // 2x bit 1
+  generator.GeneratePulse(10, 10);      // invalid pulse ends the sync
+  generator.GeneratePulses(30, 10, 2);  // 2x bit 1 without a sync
+  generator.GeneratePulse(10, 10);      // invalid pulse
+  generator.SendEdge(true, 0);          // last rising edge to allow detection of previous pulse
+
+  // then
+  byte expected[] = { 0x00 };
+  dataReceiverMock.AssertHandleDataCalled(expected, 0);
+}
+
+test(BasicPulseDecoder_ShouldFinishDataAtLostFallingEdge)
+{
+  // given
+  DataReceiverMock dataReceiverMock;
+  RC433HQBasicSyncPulseDecoder decoder(dataReceiverMock, 40, 40, 10, 30, 30, 10, 2, true, 4, 8);
+  TestingPulseGenerator generator(decoder);
+
+  // when
+  generator.GeneratePulse(40, 40);      // sync
+  generator.GeneratePulses(30, 10, 4);  // 4x bit 1
+  generator.SendEdge(true, 40);         // rising edge, the falling edge is lost
+  generator.GeneratePulses(10, 30, 3);  // 3x bit 0 without a sync
+  generator.GeneratePulse(10, 10);      // invalid pulse
+  generator.SendEdge(true, 0);          // last rising edge to allow detection of previous pulse
+
+  // then
+  byte expected[] = { 0x0f };
+  dataReceiverMock.AssertHandleDataCalled(expected, 4);
+}
+
+test(BasicPulseDecoder_ShouldWaitForSyncAfterMissedEdges)
+{
+  // given
+  DataReceiverMock dataReceiverMock;
+  RC433HQBasicSyncPulseDecoder decoder(dataReceiverMock, 40, 40, 10, 30, 30, 10, 2, true, 4, 8);
+  TestingPulseGenerator generator(decoder);
+
+  // when
+  generator.GeneratePulse(40, 40);      // sync
+  generator.GeneratePulses(30, 10, 2);  // 2x bit 1
+  decoder.HandleMissedEdges();          // the reception is lost
+  generator.GeneratePulses(30, 10, 4);  // 4x bit 1 without a sync
+  generator.GeneratePulse(10, 10);      // invalid pulse
+  generator.SendEdge(true, 0);          // last rising edge to allow detection of previous pulse
+
+  // then
+  byte expected[] = { 0x00 };
+  dataReceiverMock.AssertHandleDataCalled(expected, 0);
+}
+
+
+// sync, bit 1 exact, bit 0 within the tolerance, bit 1 out of the tolerance, 5x bit 0 exact
+static void GenerateMarginalFrame(TestingPulseGenerator &generator)
+{
+  generator.GeneratePulse(100, 100);
+  generator.GeneratePulse(60, 20);
+  generator.GeneratePulse(25, 60);
+  generator.GeneratePulse(75, 20);
+  generator.GeneratePulses(20, 60, 5);
+  generator.SendEdge(true, 0);          // last rising edge to allow detection of previous pulse
+}
+
+test(BasicSyncPulseDecoder_ShouldReportBitConfidencesInSoftDecisionMode)
+{
+  // given
+  SoftDataReceiverMock dataReceiverMock;
+  RC433HQBasicSyncPulseDecoder decoder(dataReceiverMock, 100, 100, 20, 60, 60, 20, 10, true, 8, 8);
+  decoder.EnableSoftDecision();
+  TestingPulseGenerator generator(decoder);
+
+  // when
+  GenerateMarginalFrame(generator);
+
+  // then
+  byte expected[] = { 0xA0 };
+  dataReceiverMock.AssertHandleDataCalled(expected, 8, 60.0, 65.0);
+  dataReceiverMock.AssertSoftDataCalled(1, RC433HQExtendedMicroseconds(0));
+  byte expectedConfidences[] = { 255, 191, 63, 255, 255, 255, 255, 255 };
+  dataReceiverMock.AssertConfidences(expectedConfidences, 8);
+}
+
+test(BasicSyncPulseDecoder_ShouldDropFrameWithPulseOutOfToleranceWithoutSoftDecision)
+{
+  // given
+  SoftDataReceiverMock dataReceiverMock;
+  RC433HQBasicSyncPulseDecoder decoder(dataReceiverMock, 100, 100, 20, 60, 60, 20, 10, true, 8, 8);
+  TestingPulseGenerator generator(decoder);
+
+  // when
+  GenerateMarginalFrame(generator);
+
+  // then
+  dataReceiverMock.AssertHandleDataCalled(0, 0);
+  dataReceiverMock.AssertSoftDataCalled(0, RC433HQExtendedMicroseconds(0));
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQRepetitionCombiner tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(RepetitionCombiner_ShouldOutvoteBitCorruptedInOneRepetition)
+{
+  // given
+  SoftDataReceiverMock dataReceiverMock;
+  RC433HQRepetitionCombiner combiner(dataReceiverMock, 24, 50_ms);
+  byte frame[] = { 0xA0 };
+  byte corruptedFrame[] = { 0x80 };
+  byte confidences[] = { 200, 200, 200, 200, 200, 200, 200, 200 };
+  byte corruptedConfidences[] = { 200, 200, 50, 200, 200, 200, 200, 200 };
+
+  // when
+  combiner.HandleSoftData(RC433HQExtendedMicroseconds(0), frame, 8, confidences, 80.0);
+  combiner.HandleSoftData(RC433HQExtendedMicroseconds(40000), corruptedFrame, 8, corruptedConfidences, 50.0);
+  combiner.HandleExtendedData(RC433HQExtendedMicroseconds(80000), frame, 8, 100.0);
+  combiner.Update(120000);
+  dataReceiverMock.AssertSoftDataCalled(0, RC433HQExtendedMicroseconds(0));
+  combiner.Update(140000);
+
+  // then
+  dataReceiverMock.AssertSoftDataCalled(1, RC433HQExtendedMicroseconds(0));
+  dataReceiverMock.AssertHandleDataCalled(frame, 8, 75.0, 85.0);
+  byte expectedConfidences[] = { 218, 218, 135, 218, 218, 218, 218, 218 };
+  dataReceiverMock.AssertConfidences(expectedConfidences, 8);
+  assertEqual(combiner.GetLastRepetitionsCount(), 3);
+}
+
+test(RepetitionCombiner_ShouldSeparateFramesByGapLengthAndRepetitions)
+{
+  // given
+  SoftDataReceiverMock dataReceiverMock;
+  RC433HQRepetitionCombiner combiner(dataReceiverMock, 24, 50_ms, 2);
+  byte frame[] = { 0xA0, 0x0F };
+
+  // when
+  combiner.HandleExtendedData(RC433HQExtendedMicroseconds(0), frame, 8, 100.0);
+  combiner.HandleExtendedData(RC433HQExtendedMicroseconds(100000), frame, 8, 100.0);   // after the gap
+  dataReceiverMock.AssertSoftDataCalled(1, RC433HQExtendedMicroseconds(0));
+  combiner.HandleExtendedData(RC433HQExtendedMicroseconds(110000), frame, 16, 100.0);  // another length
+  dataReceiverMock.AssertSoftDataCalled(2, RC433HQExtendedMicroseconds(100000));
+  combiner.HandleExtendedData(RC433HQExtendedMicroseconds(150000), frame, 16, 100.0);  // expected repetitions
+
+  // then
+  dataReceiverMock.AssertSoftDataCalled(3, RC433HQExtendedMicroseconds(110000));
+  dataReceiverMock.AssertHandleDataCalled(frame, 16, 100.0, 100.0);
+  assertEqual(combiner.GetLastRepetitionsCount(), 2);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQDiversityCombiner tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(DiversityCombiner_ShouldDeliverFrameOnceFromBestReceiver)
+{
+  // given
+  SoftDataReceiverMock dataReceiverMock;
+  RC433HQDiversityCombiner combiner(dataReceiverMock, 2, 24, 2_ms, 100_ms);
+  RC433HQDiversityInput north(combiner, 0);
+  RC433HQDiversityInput south(combiner, 1);
+  byte frame[] = { 0xA5, 0x0F };
+
+  // when
+  north.HandleExtendedData(RC433HQExtendedMicroseconds(1000), frame, 12, 60.0);
+  dataReceiverMock.AssertSoftDataCalled(0, RC433HQExtendedMicroseconds(0));
+  south.HandleExtendedData(RC433HQExtendedMicroseconds(1200), frame, 12, 90.0);   // all the receivers contributed
+
+  // then
+  dataReceiverMock.AssertSoftDataCalled(1, RC433HQExtendedMicroseconds(1000));
+  dataReceiverMock.AssertHandleDataCalled(frame, 12, 90.0, 90.0);
+  assertEqual(combiner.GetDeliveredFramesCount(), 1UL);
+  assertEqual(combiner.GetSuppressedFramesCount(), 1UL);
+  assertEqual(combiner.GetStatistics(0).contributedFrames, 1UL);
+  assertEqual(combiner.GetStatistics(0).bestFrames, 0UL);
+  assertEqual(combiner.GetStatistics(1).contributedFrames, 1UL);
+  assertEqual(combiner.GetStatistics(1).bestFrames, 1UL);
+  assertEqual(combiner.GetStatistics(1).exclusiveFrames, 0UL);
+  assertEqual(combiner.GetStatistics(0).GetAverageQuality(), 60.0);
+}
+
+test(DiversityCombiner_ShouldDeliverFrameOfOneReceiverAfterMaxWait)
+{
+  // given
+  SoftDataReceiverMock dataReceiverMock;
+  RC433HQDiversityCombiner combiner(dataReceiverMock, 2, 24, 2_ms, 100_ms);
+  byte frame[] = { 0xA5 };
+  byte otherFrame[] = { 0x5A };
+
+  // when
+  combiner.HandleFrame(0, RC433HQExtendedMicroseconds(0), frame, 8, 0, 80.0);
+  combiner.HandleFrame(1, RC433HQExtendedMicroseconds(500), otherFrame, 8, 0, 80.0);  // another payload
+  combiner.HandleFrame(1, RC433HQExtendedMicroseconds(10000), frame, 8, 0, 80.0);     // out of the window
+  combiner.Update(50000);
+  dataReceiverMock.AssertSoftDataCalled(0, RC433HQExtendedMicroseconds(0));
+  combiner.Update(105000);
+
+  // then
+  dataReceiverMock.AssertSoftDataCalled(2, RC433HQExtendedMicroseconds(500));
+  dataReceiverMock.AssertHandleDataCalled(otherFrame, 8);
+  combiner.Flush();
+  dataReceiverMock.AssertSoftDataCalled(3, RC433HQExtendedMicroseconds(10000));
+  assertEqual(combiner.GetSuppressedFramesCount(), 0UL);
+  assertEqual(combiner.GetStatistics(0).exclusiveFrames, 1UL);
+  assertEqual(combiner.GetStatistics(1).exclusiveFrames, 2UL);
+}
+
+test(DiversityCombiner_ShouldMergeBitCorruptedInOneReceiver)
+{
+  // given
+  SoftDataReceiverMock dataReceiverMock;
+  RC433HQDiversityCombiner combiner(dataReceiverMock, 2, 24, 2_ms, 100_ms, RC433HQ_DIVERSITY_MERGE);
+  combiner.SetMaxDifferentBits(2);
+  byte frame[] = { 0xA0 };
+  byte corruptedFrame[] = { 0x80 };
+  byte confidences[] = { 200, 200, 200, 200, 200, 200, 200, 200 };
+  byte corruptedConfidences[] = { 200, 200, 50, 200, 200, 200, 200, 200 };
+
+  // when
+  combiner.HandleFrame(0, RC433HQExtendedMicroseconds(1000), corruptedFrame, 8, corruptedConfidences, 90.0);
+  combiner.HandleFrame(1, RC433HQExtendedMicroseconds(1100), frame, 8, confidences, 70.0);
+
+  // then
+  dataReceiverMock.AssertSoftDataCalled(1, RC433HQExtendedMicroseconds(1000));
+  dataReceiverMock.AssertHandleDataCalled(frame, 8, 70.0, 75.0);
+  byte expectedConfidences[] = { 200, 200, 75, 200, 200, 200, 200, 200 };
+  dataReceiverMock.AssertConfidences(expectedConfidences, 8);
+  assertEqual(combiner.GetStatistics(0).bestFrames, 1UL);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameQueue tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(FrameQueue_ShouldStoreFramesOfMoreDecodersInOrderOfTheirDecoding)
+{
+  // given
+  DataReceiverMock dataReceiverMock;
+  RC433HQFrameQueue frameQueue(4);
+  RC433HQBasicSyncPulseDecoder decoderA(dataReceiverMock, 40, 40, 10, 30, 30, 10, 2, true, 2, 2);
+  RC433HQBasicSyncPulseDecoder decoderB(dataReceiverMock, 80, 80, 10, 30, 30, 10, 2, true, 1, 1);
+  decoderA.SetFrameQueue(frameQueue, 1);
+  decoderB.SetFrameQueue(frameQueue, 2);
+  RC433PulseSignalSplitter splitter(decoderA, decoderB);
+  TestingPulseGenerator generator(splitter);
+
+  // when
+  generator.GeneratePulse(80, 80);      // sync B
+  generator.GeneratePulse(30, 10);      // bit 1 completes B
+  generator.GeneratePulse(40, 40);      // sync A
+  generator.GeneratePulse(30, 10);      // bit 1
+  generator.GeneratePulse(10, 30);      // bit 0 completes A
+  generator.SendEdge(true, 0);          // last rising edge to allow detection of previous pulse
+
+  // then
+  dataReceiverMock.AssertHandleDataCalled(0, 0);
+  assertEqual(frameQueue.GetCount(), 2);
+  RC433HQFrameView frame;
+  assertTrue(frameQueue.Peek(frame));
+  assertEqual(frame.GetProtocol(), 2);
+  assertEqual(frame.GetBits(), 1);
+  assertEqual(frame.GetData()[0], 0x01);
+  assertEqual(frame.GetTime(), RC433HQMicroseconds(0));
+  assertEqual(frame.GetQuality(), 100.0);
+  frameQueue.Pop();
+  assertTrue(frameQueue.Peek(frame));
+  assertEqual(frame.GetProtocol(), 1);
+  assertEqual(frame.GetBits(), 2);
+  assertEqual(frame.GetData()[0], 0x02);
+  assertEqual(frame.GetTime(), RC433HQMicroseconds(200));
+  frameQueue.Pop();
+  assertFalse(frameQueue.Peek(frame));
+  assertEqual(frameQueue.GetDroppedCount(), 0);
+}
+
+test(FrameQueue_ShouldDropFramesWithoutFreeSlot)
+{
+  // given
+  DataReceiverMock dataReceiverMock;
+  RC433HQFrameQueue frameQueue(1);
+  RC433HQBasicSyncPulseDecoder decoder(dataReceiverMock, 40, 40, 10, 30, 30, 10, 2, true, 1, 1);
+  decoder.SetFrameQueue(frameQueue, 1);
+  TestingPulseGenerator generator(decoder);
+  RC433HQFrameView frame;
+
+  // when
+  generator.GeneratePulse(40, 40);      // sync
+  generator.GeneratePulse(30, 10);      // bit 1 fills the queue
+  generator.GeneratePulse(40, 40);      // sync
+  generator.GeneratePulse(10, 30);      // bit 0 is dropped
+  generator.GeneratePulse(40, 40);      // sync
+  bool peekedBeforePop = frameQueue.Peek(frame);
+  frameQueue.Pop();
+  generator.GeneratePulse(40, 40);      // sync again, reserves the released slot
+  generator.GeneratePulse(10, 30);      // bit 0
+  generator.SendEdge(true, 0);          // last rising edge to allow detection of previous pulse
+
+  // then
+  assertTrue(peekedBeforePop);
+  assertEqual(frameQueue.GetDroppedCount(), 1);
+  assertEqual(frameQueue.GetCount(), 1);
+  assertTrue(frameQueue.Peek(frame));
+  assertEqual(frame.GetBits(), 1);
+  assertEqual(frame.GetData()[0], 0x00);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQFrameValidators tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(Crc_ShouldCalculateCheckValuesOfCrc8AndCrc16)
+{
+  // given
+  const byte data[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+  RC433HQCrc8 crc8;
+  RC433HQCrc16 crc16;
+
+  // when & then
+  assertEqual(crc8.Calculate(data, 72, 72), 0xf4);
+  assertEqual(crc16.Calculate(data, 72, 72), 0x29b1);
+}
+
+test(FrameValidatorChain_ShouldCountRejectionsOfEachValidator)
+{
+  // given
+  // 12 bits 0xac7 followed by their CRC-8 0xd9, 20 bits in the decoder layout
+  const byte validFrame[] = { 0xac, 0x7d, 0x09 };
+  const byte wrongPrefixFrame[] = { 0x5c, 0x7d, 0x09 };
+  const byte wrongParityFrame[] = { 0xac, 0x7d, 0x08 };
+  const byte wrongCrcFrame[] = { 0xac, 0x7d, 0x0a };
+  static const uint32_t knownPrefixes[] = { 0x3, 0xa };
+  RC433HQFieldValidator prefixValidator(0, 4, knownPrefixes, 2);
+  RC433HQParityValidator parityValidator(0, 20);
+  RC433HQCrc8 crc8;
+  RC433HQCrcValidator crcValidator(crc8);
+  RC433HQFrameValidatorChain<3> validator;
+  assertTrue(validator.Add(prefixValidator));
+  assertTrue(validator.Add(parityValidator));
+  assertTrue(validator.Add(crcValidator));
+
+  // when & then
+  assertTrue(validator.ValidateFrame(validFrame, 20));
+  assertFalse(validator.ValidateFrame(wrongPrefixFrame, 20));
+  assertFalse(validator.ValidateFrame(wrongParityFrame, 20));
+  assertFalse(validator.ValidateFrame(wrongCrcFrame, 20));
+  assertFalse(validator.ValidateFrame(validFrame, 19));
+  assertEqual(validator.GetRejectedCount(0), 1);
+  assertEqual(validator.GetRejectedCount(1), 2);
+  assertEqual(validator.GetRejectedCount(2), 1);
+  assertFalse(validator.Add(crcValidator));
+}
+
+static void GenerateByteFrame(TestingPulseGenerator &generator, byte value)
+{
+  generator.GeneratePulse(100, 100);
+  for (int i = 7; i >= 0; i--) {
+    if ((value >> i) & 1) {
+      generator.GeneratePulse(60, 20);
+    } else {
+      generator.GeneratePulse(20, 60);
+    }
+  }
+}
+
+test(BasicSyncPulseDecoder_ShouldDropFramesRejectedByValidator)
+{
+  // given
+  DataReceiverMock dataReceiverMock;
+  RC433HQFrameQueue frameQueue(1);
+  RC433HQBasicSyncPulseDecoder decoder(dataReceiverMock, 100, 100, 20, 60, 60, 20, 10, true, 8, 8);
+  RC433HQBasicSyncPulseDecoder queueDecoder(dataReceiverMock, 100, 100, 20, 60, 60, 20, 10, true, 8, 8);
+  RC433HQFieldValidator prefixValidator(0, 4, 0xa);
+  decoder.SetFrameValidator(prefixValidator);
+  queueDecoder.SetFrameValidator(prefixValidator);
+  queueDecoder.SetFrameQueue(frameQueue, 1);
+  RC433PulseSignalSplitter splitter(decoder, queueDecoder);
+  TestingPulseGenerator generator(splitter);
+
+  // when
+  GenerateByteFrame(generator, 0x35);
+  GenerateByteFrame(generator, 0xa5);
+  GenerateByteFrame(generator, 0x5a);
+  generator.SendEdge(true, 0);          // last rising edge to allow detection of previous pulse
+
+  // then
+  byte expected[] = { 0xa5 };
+  dataReceiverMock.AssertHandleDataCalled(expected, 8);
+  assertEqual(decoder.GetMetrics().deliveredFrames, 1);
+  assertEqual(decoder.GetMetrics().rejectedFrames, 2);
+  assertEqual(frameQueue.GetCount(), 1);
+  assertEqual(frameQueue.GetDroppedCount(), 0);
+  RC433HQFrameView frame;
+  assertTrue(frameQueue.Peek(frame));
+  assertEqual(frame.GetData()[0], 0xa5);
+}
+
+test(BasicSyncPulseDecoder_ShouldCountRejectionReasonsAndTakeMetrics)
+{
+  // given
+  DataReceiverMock dataReceiverMock;
+  RC433HQBasicSyncPulseDecoder decoder(dataReceiverMock, 100, 100, 20, 60, 60, 20, 10, true, 4, 8);
+  TestingPulseGenerator generator(decoder);
+
+  // when
+  GenerateByteFrame(generator, 0xa5);   // delivered
+  generator.GeneratePulse(100, 100);    // sync
+  generator.GeneratePulse(60, 20);      // bit 1
+  generator.GeneratePulse(40, 40);      // out of tolerance, too short frame
+  generator.GeneratePulse(100, 100);    // sync
+  generator.GeneratePulse(63, 23);      // bit 1, not decoded before the missed edges
+  decoder.HandleMissedEdges();          // the reception is lost
+  generator.SendEdge(true, 0);
+  generator.SendEdge(true, 0);          // broken pulse
+  RC433HQDecoderMetrics metrics;
+  decoder.TakeMetrics(metrics);
+
+  // then
+  assertEqual(metrics.syncs, 3);
+  assertEqual(metrics.oneBits, 5);
+  assertEqual(metrics.zeroBits, 4);
+  assertEqual(metrics.softBits, 0);
+  assertEqual(metrics.outOfTolerancePulses, 1);
+  assertEqual(metrics.shortFrames, 1);
+  assertEqual(metrics.missedEdges, 1);
+  assertEqual(metrics.brokenPulses, 1);
+  assertEqual(metrics.rejectedFrames, 0);
+  assertEqual(metrics.droppedFrames, 0);
+  assertEqual(metrics.deliveredFrames, 1);
+  assertEqual(metrics.GetAverageQuality(), 100.0);
+  assertEqual(decoder.GetMetrics().syncs, 0);
+  assertEqual(decoder.GetMetrics().deliveredFrames, 0);
+}
+
+
+test(BasicSyncPulseDecoder_ShouldDeliverFrameAtFallingEdgeOfLastPulseInEarlyDeliveryMode)
+{
+  // given
+  DataReceiverMock dataReceiverMock, earlyDataReceiverMock;
+  RC433HQBasicSyncPulseDecoder decoder(dataReceiverMock, 100, 100, 20, 60, 60, 20, 10, true, 8, 8);
+  RC433HQBasicSyncPulseDecoder earlyDecoder(earlyDataReceiverMock, 100, 100, 20, 60, 60, 20, 10, true, 8, 8);
+  earlyDecoder.EnableEarlyDelivery();
+  RC433PulseSignalSplitter splitter(decoder, earlyDecoder);
+  TestingPulseGenerator generator(splitter);
+
+  // when
+  GenerateByteFrame(generator, 0xa5);
+
+  // then
+  byte expected[] = { 0xa5 };
+  earlyDataReceiverMock.AssertHandleDataCalled(expected, 8);
+  dataReceiverMock.AssertHandleDataCalled(0, 0);
+
+  // when
+  generator.SendEdge(true, 0);          // the next rising edge completes the frame of the regular decoder
+
+  // then
+  dataReceiverMock.AssertHandleDataCalled(expected, 8);
+  assertEqual(earlyDecoder.GetMetrics().deliveredFrames, 1);
+  assertEqual(earlyDecoder.GetMetrics().oneBits, 4);
+  assertEqual(earlyDecoder.GetMetrics().outOfTolerancePulses, 0);
+}
+
+test(BasicSyncPulseDecoder_ShouldAddLatencyFromSyncCaptureToDelivery)
+{
+  // given
+  DataReceiverMock dataReceiverMock;
+  RC433HQLatencyStatistics latencyStatistics;
+  RC433HQBasicSyncPulseDecoder decoder(dataReceiverMock, 100, 100, 20, 60, 60, 20, 10, true, 8, 8);
+  decoder.SetLatencyStatistics(latencyStatistics);
+  TestingPulseGenerator generator(decoder);
+
+  // when
+  generator.SendEdge(false, RC433HQMicrosecondsDiff(0xfffff000UL));   // the sync starts 4096 us before the current time (0 in the tests)
+  GenerateByteFrame(generator, 0xa5);
+  generator.SendEdge(true, 0);
+
+  // then
+  byte expected[] = { 0xa5 };
+  dataReceiverMock.AssertHandleDataCalled(expected, 8);
+  RC433HQDurationStatistics snapshot;
+  latencyStatistics.GetSnapshot(snapshot);
+  assertEqual(snapshot.GetCount(), 1);
+  assertEqual(snapshot.GetMinTicks(), 4096);
+  assertEqual(snapshot.GetHistogramCount(3), 1);   // 4 ms
+}
+
+// EMOS frame of 24 bits ending by the rising edge at the current time (0 in the tests), returns its duration from the sync
+static unsigned long GenerateEmosFrameEndingNow(TestingPulseGenerator &generator, const word timing[6], uint32_t data)
+{
+  unsigned long duration = timing[0] + timing[1];
+  for (int i = 23; i >= 0; i--) {
+    duration += ((data >> i) & 1)? (timing[4] + timing[5]): (timing[2] + timing[3]);
+  }
+  generator.SendEdge(false, RC433HQMicrosecondsDiff(0UL - duration));
+  generator.GeneratePulse(timing[0], timing[1]);
+  for (int i = 23; i >= 0; i--) {
+    if ((data >> i) & 1) {
+      generator.GeneratePulse(timing[4], timing[5]);
+    } else {
+      generator.GeneratePulse(timing[2], timing[3]);
+    }
+  }
+  generator.SendEdge(true, 0);
+  return duration;
+}
+
+test(BasicSyncPulseDecoder_ShouldCountEmosLatenciesBelowLastHistogramBucket)
+{
+  // given
+  DataReceiverMock dataReceiverMockA, dataReceiverMockB;
+  RC433HQLatencyStatistics latencyStatisticsA, latencyStatisticsB;
+  const word timingA[6] = { 272, 2381, 299, 1235, 1076, 480 };
+  const word timingB[6] = { 2948, 7302, 401, 1134, 918, 617 };
+  RC433HQBasicSyncPulseDecoder decoderA(dataReceiverMockA, timingA[0], timingA[1], timingA[2], timingA[3], timingA[4], timingA[5], 50, true, 24, 24);
+  RC433HQBasicSyncPulseDecoder decoderB(dataReceiverMockB, timingB[0], timingB[1], timingB[2], timingB[3], timingB[4], timingB[5], 50, true, 24, 24);
+  decoderA.SetLatencyStatistics(latencyStatisticsA);
+  decoderB.SetLatencyStatistics(latencyStatisticsB);
+  TestingPulseGenerator generatorA(decoderA), generatorB(decoderB);
+
+  // when
+  unsigned long durationA = GenerateEmosFrameEndingNow(generatorA, timingA, 0x38cbbeUL);
+  unsigned long durationB = GenerateEmosFrameEndingNow(generatorB, timingB, 0x38cbbeUL);
+
+  // then
+  byte expected[] = { 0x38, 0xcb, 0xbe };
+  dataReceiverMockA.AssertHandleDataCalled(expected, 24);
+  dataReceiverMockB.AssertHandleDataCalled(expected, 24);
+  RC433HQDurationStatistics snapshotA, snapshotB;
+  latencyStatisticsA.GetSnapshot(snapshotA);
+  latencyStatisticsB.GetSnapshot(snapshotB);
+  assertEqual(durationA, 39777UL);
+  assertEqual(durationB, 47090UL);
+  assertEqual(snapshotA.GetMaxTicks(), durationA);
+  assertEqual(snapshotB.GetMaxTicks(), durationB);
+  assertEqual(snapshotA.GetHistogramCount(6), 1);   // 32 - 64 ms
+  assertEqual(snapshotB.GetHistogramCount(6), 1);
+  assertEqual(snapshotA.GetBucketMinTicks(6), 32768UL);
+  assertLess(size_t(6), snapshotA.GetHistogramSize() - 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQDeviceRouter tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(GetFrameBits_ShouldReadFieldAcrossBytesAndFromIncompleteLastByte)
+{
+  // given
+  // 12 bits 1010 1100 0111 as stored by the decoder (the last 4 bits in the lower half of the second byte)
+  byte data[] = { 0xac, 0x07 };
+  uint32_t value;
+
+  // when & then
+  assertTrue(RC433HQGetFrameBits(data, 12, 0, 12, value));
+  assertEqual(value, 0xac7UL);
+  assertTrue(RC433HQGetFrameBits(data, 12, 6, 5, value));
+  assertEqual(value, 0x03UL);
+  assertFalse(RC433HQGetFrameBits(data, 12, 6, 7, value));
+}
+
+test(DeviceRouter_ShouldDispatchFramesByAddressAndCountUnknownDevices)
+{
+  // given
+  DataReceiverMock firstDevice, secondDevice, unknownDevices;
+  RC433HQAddressField addressField = { 4, 8 };
+  RC433HQDeviceRouter<2> router(addressField);
+  assertTrue(router.AddDevice(0x12, firstDevice));
+  assertTrue(router.AddDevice(0x34, secondDevice));
+  assertFalse(router.AddDevice(0x56, unknownDevices));
+  router.SetUnknownDeviceReceiver(unknownDevices);
+  byte firstFrame[] = { 0xf1, 0x2f };
+  byte secondFrame[] = { 0x03, 0x40 };
+  byte unknownFrame[] = { 0x05, 0x60 };
+
+  // when
+  router.HandleData(0, firstFrame, 16, 90.0);
+  router.HandleData(0, secondFrame, 16, 80.0);
+  router.HandleData(0, unknownFrame, 16, 70.0);
+  router.HandleData(0, firstFrame, 8, 60.0);
+
+  // then
+  firstDevice.AssertHandleDataCalled(firstFrame, 16, 90.0, 90.0);
+  secondDevice.AssertHandleDataCalled(secondFrame, 16, 80.0, 80.0);
+  unknownDevices.AssertHandleDataCalled(firstFrame, 8, 60.0, 60.0);
+  assertEqual(router.GetDevicesCount(), 2);
+  assertEqual(router.GetUnknownFramesCount(), 2UL);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQLinkQualityTracker tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(LinkQualityTracker_ShouldAverageQualityOfRepetitionsOfOneTransmission)
+{
+  // given
+  DataReceiverMock receiver;
+  RC433HQLinkQualityTracker links(4);
+  RC433HQAddressField addressField = { 4, 8 };
+  RC433HQLinkQualityInput input(links, 1, addressField, receiver);
+  byte frame[] = { 0xf1, 0x2f };
+
+  // when
+  input.HandleExtendedData(RC433HQExtendedMicroseconds(uint64_t(1000000)), frame, 16, 100.0);
+  input.HandleExtendedData(RC433HQExtendedMicroseconds(uint64_t(1050000)), frame, 16, 0.0);
+  input.HandleExtendedData(RC433HQExtendedMicroseconds(uint64_t(1100000)), frame, 16, 0.0);
+  input.HandleExtendedData(RC433HQExtendedMicroseconds(uint64_t(1150000)), frame, 16, 0.0);
+
+  // then
+  RC433HQLinkQuality link;
+  assertFalse(links.FindLink(2, 0x12, link));
+  assertTrue(links.FindLink(1, 0x12, link));
+  assertEqual(link.framesCount, 4UL);
+  assertEqual(link.transmissionsCount, 1UL);
+  ASSERT_LE_3(66.9, link.quality, "quality averaged with the weight 1/8");
+  ASSERT_LE_3(link.quality, 67.1, "quality averaged with the weight 1/8");
+  assertEqual(link.framesPerMinute, 1200.0);
+  assertEqual(link.periodMs, 0UL);
+  receiver.AssertHandleDataCalled(frame, 16, 0.0, 0.0);
+}
+
+test(LinkQualityTracker_ShouldEstimateMissedTransmissionsOfPeriodicDevice)
+{
+  // given
+  RC433HQLinkQualityTracker links(4);
+  static const uint64_t PERIOD_US = 60000000;
+
+  // when
+  // the transmissions 4 and 5 are missed
+  for (uint64_t transmission = 0; transmission < 8; transmission++) {
+    if ((transmission != 4) && (transmission != 5)) {
+      links.Update(1, 0x12345, RC433HQExtendedMicroseconds(transmission * PERIOD_US), 80.0);
+      links.Update(1, 0x12345, RC433HQExtendedMicroseconds(transmission * PERIOD_US + 100000), 80.0);
+    }
+  }
+
+  // then
+  RC433HQLinkQuality link;
+  assertTrue(links.FindLink(1, 0x12345, link));
+  assertEqual(link.framesCount, 12UL);
+  assertEqual(link.transmissionsCount, 6UL);
+  assertEqual(link.periodMs, 60000UL);
+  assertEqual(link.missedTransmissionsCount, 2UL);
+  // 2/3 missed once (weight 1/8), then one regular transmission (weight 7/8)
+  ASSERT_LE_3(0.072, link.missRatio, "miss ratio averaged with the weight 1/8");
+  ASSERT_LE_3(link.missRatio, 0.074, "miss ratio averaged with the weight 1/8");
+  assertEqual(link.quality, 80.0);
+}
+
+test(LinkQualityTracker_ShouldEvictLeastRecentlyHeardDevice)
+{
+  // given
+  RC433HQLinkQualityTracker links(3);
+  RC433HQLinkQuality link;
+
+  // when
+  links.Update(1, 1, RC433HQExtendedMicroseconds(uint64_t(1000000)), 50.0);
+  links.Update(1, 2, RC433HQExtendedMicroseconds(uint64_t(2000000)), 50.0);
+  links.Update(2, 1, RC433HQExtendedMicroseconds(uint64_t(3000000)), 50.0);
+  links.Update(1, 1, RC433HQExtendedMicroseconds(uint64_t(4000000)), 50.0);
+  links.Update(1, 4, RC433HQExtendedMicroseconds(uint64_t(5000000)), 50.0);
+
+  // then
+  assertEqual(links.GetLinksCount(), 3);
+  assertEqual(links.GetEvictedCount(), 1UL);
+  assertFalse(links.FindLink(1, 2, link));
+  assertTrue(links.GetLink(0, link));
+  assertEqual(link.address, 4UL);
+  assertTrue(links.GetLink(1, link));
+  assertEqual(link.address, 1UL);
+  assertEqual(link.protocol, 1);
+  assertEqual(link.framesCount, 2UL);
+  assertTrue(links.GetLink(2, link));
+  assertEqual(link.address, 1UL);
+  assertEqual(link.protocol, 2);
+  assertFalse(links.GetLink(3, link));
+}
+
+test(LinkQualityTracker_ShouldKeepLastDevicesAfterManyEvictions)
+{
+  // given
+  RC433HQLinkQualityTracker links(8);
+  RC433HQLinkQuality link;
+
+  // when
+  for (uint32_t address = 0; address < 100; address++) {
+    links.Update(byte(address & 1), address * 7, RC433HQExtendedMicroseconds(uint64_t(address) * 1000000), 50.0);
+  }
+
+  // then
+  assertEqual(links.GetLinksCount(), 8);
+  assertEqual(links.GetEvictedCount(), 92UL);
+  for (uint32_t address = 0; address < 100; address++) {
+    assertEqual(links.FindLink(byte(address & 1), address * 7, link), (address >= 92));
+  }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// RC433HQProtocolAnalyzer tests
+//////////////////////////////////////////////////////////////////////////////////
+
+test(ProtocolAnalyzer_ShouldSuggestTimingOfRepeatedFrames)
+{
+  // given
+  RC433HQProtocolAnalyzer analyzer;
+  TestingPulseGenerator generator(analyzer);
+
+  // when
+  for (size_t frame = 0; frame < 8; frame++) {
+    generator.GeneratePulse(300, 2400);           // sync
+    for (size_t bit = 0; bit < 12; bit++) {
+      if ((bit + frame) % 3 == 0) {
+        generator.GeneratePulse(1000, 500);       // bit 1
+      } else {
+        generator.GeneratePulse(300, 1200);       // bit 0
+      }
+    }
+  }
+  generator.GeneratePulse(300, 2400);             // sync of the next frame ends the last one
+
+  // then
+  RC433HQProtocolSuggestion suggestion;
+  assertTrue(analyzer.GetSuggestion(suggestion));
+  assertEqual(suggestion.syncFirstUs, 300);
+  assertEqual(suggestion.syncSecondUs, 2400);
+  assertEqual(suggestion.zeroFirstUs, 300);
+  assertEqual(suggestion.zeroSecondUs, 1200);
+  assertEqual(suggestion.oneFirstUs, 1000);
+  assertEqual(suggestion.oneSecondUs, 500);
+  assertEqual(suggestion.toleranceUs, 10);
+  assertEqual(suggestion.minBits, 12);
+  assertEqual(suggestion.maxBits, 12);
+  assertMoreOrEqual(suggestion.framesCount, 6UL);   // the symbols are learned during the first frames
+}
+
+test(ProtocolAnalyzer_ShouldNotSuggestWithoutFrames)
+{
+  // given
+  RC433HQProtocolAnalyzer analyzer;
+  TestingPulseGenerator generator(analyzer);
+
+  // when
+  generator.GeneratePulses(300, 1200, 40);
+
+  // then
+  RC433HQProtocolSuggestion suggestion;
+  assertFalse(analyzer.GetSuggestion(suggestion));
+  assertEqual(analyzer.GetPulsesCount(), 39UL);
+  assertEqual(analyzer.GetHighHistogramCount(8), 39);    // 256 to 319 us
+  assertEqual(analyzer.GetHistogramBinMinUs(8), 256UL);
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////
 // TransmitterMock tests